@@ -311,6 +311,12 @@ uint8_t BSP_SD_ReadBlocks_DMA(uint32_t *pData, uint64_t ReadAddr, uint32_t Block
     sd_state = MSD_ERROR;
   }
 
+  /* Let the application sleep until the transfer complete interrupt */
+  if(sd_state == MSD_OK)
+  {
+    BSP_SD_DMA_Wait();
+  }
+
   /* Wait until transfer is complete */
   if(sd_state == MSD_OK)
   {
@@ -345,6 +351,12 @@ uint8_t BSP_SD_WriteBlocks_DMA(uint32_t *pData, uint64_t WriteAddr, uint32_t Blo
     sd_state = MSD_ERROR;
   }
 
+  /* Let the application sleep until the transfer complete interrupt */
+  if(sd_state == MSD_OK)
+  {
+    BSP_SD_DMA_Wait();
+  }
+
   /* Wait until transfer is complete */
   if(sd_state == MSD_OK)
   {
@@ -379,6 +391,16 @@ uint8_t BSP_SD_Erase(uint64_t StartAddr, uint64_t EndAddr)
   }
 }
 
+/**
+  * @brief  Waits for a DMA transfer started by BSP_SD_ReadBlocks_DMA() or
+  *         BSP_SD_WriteBlocks_DMA() before its completion is checked.
+  * @note   Default returns at once and the check polls, application can
+  *         block on the HAL_SD_DMA_xxCpltCallback() instead.
+  */
+__weak void BSP_SD_DMA_Wait(void)
+{
+}
+
 /**
   * @brief  Initializes the SD MSP.
   * @param  hsd: SD handle
@@ -134,6 +134,7 @@ uint8_t BSP_SD_IsDetected(void);
 void    BSP_SD_MspInit(SD_HandleTypeDef *hsd, void *Params);
 void    BSP_SD_Detect_MspInit(SD_HandleTypeDef *hsd, void *Params);
 void    BSP_SD_MspDeInit(SD_HandleTypeDef *hsd, void *Params);
+void    BSP_SD_DMA_Wait(void);
 
 /**
   * @}
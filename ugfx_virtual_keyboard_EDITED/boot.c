@@ -0,0 +1,75 @@
+#include "boot.h"
+#include "gfx.h"
+#include "stm32f4xx.h"
+#include "tm_stm32_rtc.h"
+#include "trace.h"
+#include "route.h"
+#include <string.h>
+
+osThreadId bootThreadID;
+
+static const char *const phaseNames[BOOT_PHASES] = {
+	"Start", "SDRAM", "Clock", "RTOS", "GFX", "GUI", "Frame", "Threads", "Prewarm", "RTC", "SD", "Route"
+};
+static boot_timeline_t timeline;
+static uint32_t baseCycles;
+static uint32_t baseUS;
+static uint32_t baseClock;
+
+void bootMark(boot_phase_t phase){
+	uint32_t now = DWT->CYCCNT;
+	uint32_t us;
+
+	if(phase == BOOT_START){
+		baseCycles = now;
+		baseUS = 0;
+		baseClock = SystemCoreClock;
+	}
+	us = baseUS + (now - baseCycles) / (baseClock / 1000000);
+
+	// Only main() changes the clock, later phases count from here at the new one
+	if(SystemCoreClock != baseClock){
+		baseCycles = now;
+		baseUS = us;
+		baseClock = SystemCoreClock;
+	}
+	timeline.US[phase] = us;
+
+	if(phase == BOOT_PREWARM && bootThreadID){
+		osSignalSet(bootThreadID, BOOT_SIGNAL_PREWARM);
+	}
+}
+
+void bootGetTimeline(boot_timeline_t *t){
+	memcpy(t, &timeline, sizeof(timeline));
+}
+
+// Runs alongside the first frame, nothing here is needed to draw it
+void runBoot(){
+	unsigned i;
+
+	/* Init RTC, a cold start waits for the 32 kHz oscillator */
+	if (TM_RTC_Init(TM_RTC_ClockSource_External)) {
+			/* RTC was already initialized and time is running */
+	} else {
+			/* RTC was now initialized */
+	}
+	setRTCReady();
+	bootMark(BOOT_RTC);
+
+	// Trace file is the first file access, it mounts the card. Traces before it are dropped.
+	openTraceFile();
+	bootMark(BOOT_SD);
+
+	/* Load route, the GPS thread parses sentences meanwhile */
+	if (gfileExists(ROUTE_FILE) && !routeLoad(ROUTE_FILE)) {
+		TRACE("BOOT:,ERROR: Loading route failed\n");
+	}
+	bootMark(BOOT_ROUTE);
+
+	osSignalWait(BOOT_SIGNAL_PREWARM, osWaitForever);
+	for(i = 0; i < BOOT_PHASES; i++){
+		TRACE("BOOT:,%s,%u us\n", phaseNames[i], timeline.US[i]);
+	}
+	TRACE("BOOT:,First frame in %u us, target %u us\n", timeline.US[BOOT_FRAME], BOOT_TARGET_US);
+}
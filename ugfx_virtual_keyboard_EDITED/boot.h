@@ -0,0 +1,40 @@
+#ifndef _BOOT_H_
+#define _BOOT_H_
+
+#include <stdint.h>
+#include "cmsis_os.h"
+
+#define BOOT_TARGET_US						500000			// Time to first useful frame we aim for
+#define BOOT_SIGNAL_PREWARM				0x01				// GUI has finished its part of boot
+
+// Boot timeline. Phases are stamped with the cycle counter from the start of main(), cycles
+// before the switch to the PLL count at the reset clock. The counter wraps after 23 s at
+// 180 MHz, phases are all well within that. The main thread brings up the display and draws
+// the first frame while the boot thread starts the RTC and SD card and loads the route.
+typedef enum {
+	BOOT_START,								// main() entered, time zero
+	BOOT_SDRAM,
+	BOOT_CLOCK,								// Core running from PLL
+	BOOT_RTOS,
+	BOOT_GFX,									// Display and GFX library up
+	BOOT_GUI,									// Data page widgets created
+	BOOT_FRAME,								// Data page drawn, the first useful frame
+	BOOT_THREADS,							// Worker threads started, event loop next
+	BOOT_PREWARM,							// Hidden pages built after the first frame
+	BOOT_RTC,									// Boot thread: RTC running
+	BOOT_SD,									// Boot thread: SD card mounted, trace file open
+	BOOT_ROUTE,								// Boot thread: route loaded, or not on card
+	BOOT_PHASES
+} boot_phase_t;
+
+typedef struct {
+	uint32_t US[BOOT_PHASES];		// Time from BOOT_START, 0 until the phase is reached
+} boot_timeline_t;
+
+extern osThreadId bootThreadID;
+
+void bootMark(boot_phase_t phase);
+void bootGetTimeline(boot_timeline_t *timeline);
+void runBoot(void);
+
+#endif /* _BOOT_H_ */
@@ -7,9 +7,76 @@
 
 #include "diskio.h"
 #include "stm32469i_discovery_sd.h"
+#include "sdcard.h"
 
 #if GFX_USE_GFILE && GFILE_NEED_FATFS
 
+#include <string.h>
+
+// SDIO DMA moves words and cannot reach core coupled memory, other buffers go through here
+#define SD_DMA_USABLE(p)	(!((uint32_t)(p) & 3) && ((uint32_t)(p) & 0xFFFF0000) != CCMDATARAM_BASE)
+
+static uint32_t sdBounce[SDCARD_BOUNCE_SECTORS * SD_BLOCK_SIZE / 4];
+static gfxSem sdDone;
+static bool_t sdReady;
+static sdcard_stats_t stats;
+
+static void sdDrain(void) {
+	// Late or doubled completion of a failed transfer must not wake the next one
+	while (gfxSemWaitI(&sdDone));
+}
+
+static uint32_t sdElapsedUS(uint32_t start) {
+	return (DWT->CYCCNT - start) / (SystemCoreClock / 1000000);
+}
+
+void BSP_SD_DMA_Wait(void) {
+	if (!gfxSemWait(&sdDone, SDCARD_DMA_TIMEOUT))
+		stats.Timeouts++;
+}
+
+void HAL_SD_DMA_RxCpltCallback(DMA_HandleTypeDef *hdma) {
+	(void)hdma;
+	gfxSemSignalI(&sdDone);
+}
+
+void HAL_SD_DMA_TxCpltCallback(DMA_HandleTypeDef *hdma) {
+	(void)hdma;
+	gfxSemSignalI(&sdDone);
+}
+
+void HAL_SD_DMA_RxErrorCallback(DMA_HandleTypeDef *hdma) {
+	(void)hdma;
+	gfxSemSignalI(&sdDone);
+}
+
+void HAL_SD_DMA_TxErrorCallback(DMA_HandleTypeDef *hdma) {
+	(void)hdma;
+	gfxSemSignalI(&sdDone);
+}
+
+void HAL_SD_XferErrorCallback(SD_HandleTypeDef *hsd) {
+	(void)hsd;
+	gfxSemSignalI(&sdDone);
+}
+
+void SDIO_IRQHandler(void) {
+	BSP_SD_IRQHandler();
+}
+
+void SD_DMAx_Rx_IRQHandler(void) {
+	BSP_SD_DMA_Rx_IRQHandler();
+}
+
+void SD_DMAx_Tx_IRQHandler(void) {
+	BSP_SD_DMA_Tx_IRQHandler();
+}
+
+void sdcardGetStats(sdcard_stats_t *s) {
+	*s = stats;
+	s->ReadKBps = stats.ReadUS ? (uint32_t)((uint64_t)stats.SectorsRead * SD_BLOCK_SIZE * 1000000 / 1024 / stats.ReadUS) : 0;
+}
+
 /*-----------------------------------------------------------------------*/
 /* Initialize a Drive                                                    */
 
@@ -23,6 +90,14 @@ DSTATUS disk_initialize (
 	if ( BSP_SD_IsDetected() == SD_NOT_PRESENT )
 		return STA_NODISK;
 
+	if ( !sdReady ) {
+		gfxSemInit(&sdDone, 0, 1);
+		// Cycle counter times the reads
+		CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+		DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+		sdReady = TRUE;
+	}
+
 	if ( BSP_SD_Init() == MSD_OK )
 		return 0;
 
@@ -72,14 +147,39 @@ DRESULT disk_read (
     UINT count        /* Number of sectors to read (1..255) */
 )
 {
-  DRESULT res;
+  uint8_t res = MSD_OK;
+	uint32_t start, us;
+	UINT n;
 	if ( drv || !count )
 		return RES_PARERR;
 
-	res = (DRESULT)BSP_SD_ReadBlocks((uint32_t *)buff, (uint64_t) (sector * SD_BLOCK_SIZE), SD_BLOCK_SIZE, count);
-	
-	if ( res == 0x00 )
+	stats.Reads++;
+	stats.SectorsRead += count;
+	start = DWT->CYCCNT;
+	if ( SD_DMA_USABLE(buff) ) {
+		// All sectors in one multi-block command straight into the caller's buffer
+		sdDrain();
+		res = BSP_SD_ReadBlocks_DMA((uint32_t *)buff, (uint64_t)sector * SD_BLOCK_SIZE, SD_BLOCK_SIZE, count);
+	} else {
+		stats.Bounced++;
+		for ( ; count && res == MSD_OK; sector += n, buff += n * SD_BLOCK_SIZE, count -= n ) {
+			n = count > SDCARD_BOUNCE_SECTORS ? SDCARD_BOUNCE_SECTORS : count;
+			sdDrain();
+			res = BSP_SD_ReadBlocks_DMA(sdBounce, (uint64_t)sector * SD_BLOCK_SIZE, SD_BLOCK_SIZE, n);
+			if ( res == MSD_OK )
+				memcpy(buff, sdBounce, n * SD_BLOCK_SIZE);
+		}
+	}
+	us = sdElapsedUS(start);
+
+	stats.ReadUS += us;
+	stats.LastReadUS = us;
+	if ( us > stats.MaxReadUS )
+		stats.MaxReadUS = us;
+
+	if ( res == MSD_OK )
 		return RES_OK;
+	stats.Errors++;
 	return RES_ERROR;
 }
 
@@ -96,14 +196,29 @@ DRESULT disk_write (
     UINT count            /* Number of sectors to write (1..255) */
 )
 {
-  DRESULT res;
+  uint8_t res = MSD_OK;
+	UINT n;
 	if ( drv || !count )
 		return RES_PARERR;
 
-	res = (DRESULT)BSP_SD_WriteBlocks((uint32_t *)buff, (uint64_t) (sector * SD_BLOCK_SIZE), SD_BLOCK_SIZE, count);
+	stats.Writes++;
+	stats.SectorsWritten += count;
+	if ( SD_DMA_USABLE(buff) ) {
+		sdDrain();
+		res = BSP_SD_WriteBlocks_DMA((uint32_t *)buff, (uint64_t)sector * SD_BLOCK_SIZE, SD_BLOCK_SIZE, count);
+	} else {
+		stats.Bounced++;
+		for ( ; count && res == MSD_OK; sector += n, buff += n * SD_BLOCK_SIZE, count -= n ) {
+			n = count > SDCARD_BOUNCE_SECTORS ? SDCARD_BOUNCE_SECTORS : count;
+			memcpy(sdBounce, buff, n * SD_BLOCK_SIZE);
+			sdDrain();
+			res = BSP_SD_WriteBlocks_DMA(sdBounce, (uint64_t)sector * SD_BLOCK_SIZE, SD_BLOCK_SIZE, n);
+		}
+	}
 
-	if ( res == 0 )
+	if ( res == MSD_OK )
 		return RES_OK;
+	stats.Errors++;
 	return RES_ERROR;
 }
 #endif /* _READONLY */
@@ -0,0 +1,191 @@
+#include "fusion.h"
+#include "gfx.h"
+#include <math.h>
+#include <string.h>
+
+#define FUSION_PI						3.14159265f
+#define FUSION_METERS_PER_E7			0.011131949f	// Meters per 1e-7 degree of latitude
+
+// Filter state, position is kept in meters in a local east/north frame around origin
+static int32_t originLatE7;
+static int32_t originLonE7;
+static float metersPerE7Lon;
+static float east;
+static float north;
+static float variance;
+static float distance;
+static float headingSin;
+static float headingCos = 1.0f;
+static uint16_t headingE2;
+static bool initialized;
+
+// Inputs
+static uint32_t wheelSpeed;
+static uint32_t wheelTime;
+static uint32_t gpsSpeed;
+static uint32_t fixTime;
+static uint32_t stepTime;
+
+static fusion_estimate_t estimate;
+static fusion_stats_t stats;
+
+osMutexDef(fusionMutex);
+static osMutexId fusionMutexID;
+
+static void fusionSetOrigin(int32_t latE7, int32_t lonE7);
+static void fusionToLocal(int32_t latE7, int32_t lonE7, float *e, float *n);
+static void fusionPredict(uint32_t now);
+static void fusionPublish(uint32_t now);
+
+void fusionInit(){
+	fusionMutexID = osMutexCreate(osMutex(fusionMutex));
+	stepTime = HAL_GetTick();
+}
+
+void runFusion(){
+	while(1){
+		osDelay(1000 / FUSION_RATE_HZ);
+
+		osMutexWait(fusionMutexID, osWaitForever);
+		uint32_t now = HAL_GetTick();
+		fusionPredict(now);
+		fusionPublish(now);
+		osMutexRelease(fusionMutexID);
+	}
+}
+
+void fusionGPSUpdate(TM_GPS_t* gpsData){
+	float fixEast, fixNorth, r, gain;
+	uint32_t now = HAL_GetTick();
+
+	osMutexWait(fusionMutexID, osWaitForever);
+	if(!gpsData->Validity || gpsData->Fix == 0){
+		stats.InvalidFixes++;
+		osMutexRelease(fusionMutexID);
+		return;
+	}
+
+	// Bring estimate up to time of fix
+	fusionPredict(now);
+
+	// Course over ground is only meaningful when moving
+	gpsSpeed = gpsData->SpeedMMS;
+	if(gpsData->SpeedMMS >= FUSION_MIN_HEADING_SPEED){
+		headingE2 = gpsData->DirectionE2;
+		headingSin = sinf(headingE2 * (FUSION_PI / 18000.0f));
+		headingCos = cosf(headingE2 * (FUSION_PI / 18000.0f));
+	}
+
+	if(!initialized){
+		fusionSetOrigin(gpsData->LatitudeE7, gpsData->LongitudeE7);
+	}
+	fusionToLocal(gpsData->LatitudeE7, gpsData->LongitudeE7, &fixEast, &fixNorth);
+
+	// Measurement noise from HDOP, at least 1 HDOP
+	r = (gpsData->HDOPE2 > 100 ? gpsData->HDOPE2 * 0.01f : 1.0f) * FUSION_R_PER_HDOP;
+	r = r * r;
+
+	if(!initialized || fabsf(fixEast - east) + fabsf(fixNorth - north) > FUSION_RESET_DISTANCE){
+		// First fix or estimate drifted away, jump to fix
+		east = fixEast;
+		north = fixNorth;
+		variance = r;
+		initialized = true;
+		stats.Resets++;
+	}else{
+		// Scalar Kalman update, same gain for both axes
+		gain = variance / (variance + r);
+		east += gain * (fixEast - east);
+		north += gain * (fixNorth - north);
+		variance *= 1.0f - gain;
+	}
+
+	if(now - fixTime > stats.LongestOutageMS && stats.Fixes){
+		stats.LongestOutageMS = now - fixTime;
+	}
+	fixTime = now;
+	stats.Fixes++;
+	osMutexRelease(fusionMutexID);
+}
+
+void fusionWheelSpeed(uint32_t speedMMS){
+	osMutexWait(fusionMutexID, osWaitForever);
+	fusionPredict(HAL_GetTick());
+	wheelSpeed = speedMMS;
+	wheelTime = HAL_GetTick();
+	osMutexRelease(fusionMutexID);
+}
+
+void fusionGetEstimate(fusion_estimate_t* est){
+	osMutexWait(fusionMutexID, osWaitForever);
+	*est = estimate;
+	osMutexRelease(fusionMutexID);
+}
+
+void fusionGetStats(fusion_stats_t* st){
+	osMutexWait(fusionMutexID, osWaitForever);
+	*st = stats;
+	osMutexRelease(fusionMutexID);
+}
+
+static void fusionSetOrigin(int32_t latE7, int32_t lonE7){
+	originLatE7 = latE7;
+	originLonE7 = lonE7;
+	metersPerE7Lon = FUSION_METERS_PER_E7 * cosf(latE7 * (FUSION_PI / 1800000000.0f));
+}
+
+static void fusionToLocal(int32_t latE7, int32_t lonE7, float *e, float *n){
+	// Differences are small, so they keep full precision in float
+	*e = (float)(lonE7 - originLonE7) * metersPerE7Lon;
+	*n = (float)(latE7 - originLatE7) * FUSION_METERS_PER_E7;
+}
+
+static void fusionPredict(uint32_t now){
+	float dt = (now - stepTime) * 0.001f;
+	uint32_t speed;
+	float step;
+
+	stepTime = now;
+	if(!initialized || dt <= 0.0f){
+		return;
+	}
+
+	// Wheel speed is preferred, GPS speed is used only without sensor and while fix is fresh
+	if(now - wheelTime < FUSION_WHEEL_TIMEOUT_MS){
+		speed = wheelSpeed;
+		variance += FUSION_Q_WHEEL * dt;
+	}else if(now - fixTime < FUSION_WHEEL_TIMEOUT_MS){
+		speed = gpsSpeed;
+		variance += FUSION_Q_GPS_SPEED * dt;
+	}else{
+		speed = 0;
+		variance += FUSION_Q_GPS_SPEED * dt;
+	}
+
+	step = speed * 0.001f * dt;
+	east += step * headingSin;
+	north += step * headingCos;
+	distance += step;
+	estimate.SpeedMMS = speed;
+	stats.Predictions++;
+
+	// Move local frame with rider to keep float precision
+	if(fabsf(east) > FUSION_ORIGIN_DISTANCE || fabsf(north) > FUSION_ORIGIN_DISTANCE){
+		int32_t latE7 = originLatE7 + (int32_t)(north / FUSION_METERS_PER_E7);
+		int32_t lonE7 = originLonE7 + (int32_t)(east / metersPerE7Lon);
+		fusionSetOrigin(latE7, lonE7);
+		east = 0.0f;
+		north = 0.0f;
+	}
+}
+
+static void fusionPublish(uint32_t now){
+	estimate.LatitudeE7 = originLatE7 + (int32_t)(north / FUSION_METERS_PER_E7);
+	estimate.LongitudeE7 = originLonE7 + (int32_t)(east / metersPerE7Lon);
+	estimate.HeadingE2 = headingE2;
+	estimate.DistanceM = (uint32_t)distance;
+	estimate.Accuracy = sqrtf(variance);
+	estimate.SinceFixMS = now - fixTime;
+	estimate.DeadReckoning = estimate.SinceFixMS > FUSION_OUTAGE_MS;
+	estimate.Valid = initialized && estimate.SinceFixMS < FUSION_MAX_DEAD_RECKON_MS;
+}
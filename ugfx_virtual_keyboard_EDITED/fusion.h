@@ -0,0 +1,48 @@
+#ifndef _FUSION_H_
+#define _FUSION_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "tm_stm32_gps.h"
+
+#define FUSION_RATE_HZ					20			// Estimate publish rate
+#define FUSION_MAX_DEAD_RECKON_MS		60000		// Estimate is invalid after this long without a fix
+#define FUSION_WHEEL_TIMEOUT_MS			3000		// Wheel speed older than this is not used
+#define FUSION_OUTAGE_MS				2000		// Estimate is dead reckoning after this long without a fix
+#define FUSION_MIN_HEADING_SPEED		1500		// mm/s, GPS course below this speed is noise
+#define FUSION_RESET_DISTANCE			200.0f	// m, fix further than this from estimate resets the filter
+#define FUSION_ORIGIN_DISTANCE			5000.0f	// m, local frame is moved when estimate gets this far from origin
+
+// Process noise of dead reckoning and measurement noise of one unit of HDOP
+#define FUSION_Q_WHEEL					0.5f		// m^2/s
+#define FUSION_Q_GPS_SPEED			4.0f		// m^2/s, GPS speed is only as fresh as last fix
+#define FUSION_R_PER_HDOP				5.0f		// m
+
+typedef struct {
+	int32_t LatitudeE7;				// 1e-7 degrees
+	int32_t LongitudeE7;			// 1e-7 degrees
+	uint32_t SpeedMMS;				// Speed used for dead reckoning, mm/s
+	uint16_t HeadingE2;				// Heading used for dead reckoning, 0.01 degree
+	uint32_t DistanceM;				// Distance travelled since boot, m
+	float Accuracy;						// Estimated 1 sigma position error, m
+	uint32_t SinceFixMS;			// Time since last accepted GPS fix, ms
+	bool Valid;								// Estimate has had a fix and is not dead reckoning for too long
+	bool DeadReckoning;				// GPS is invalid, position comes from wheel speed and heading only
+} fusion_estimate_t;
+
+typedef struct {
+	uint32_t Predictions;			// Number of filter steps
+	uint32_t Fixes;						// Number of GPS fixes merged into estimate
+	uint32_t Resets;					// Number of times the filter jumped to the GPS fix
+	uint32_t InvalidFixes;		// Number of GPS updates without valid fix
+	uint32_t LongestOutageMS;	// Longest dead reckoning period
+} fusion_stats_t;
+
+void fusionInit(void);
+void runFusion(void);
+void fusionGPSUpdate(TM_GPS_t* gpsData);
+void fusionWheelSpeed(uint32_t speedMMS);
+void fusionGetEstimate(fusion_estimate_t* estimate);
+void fusionGetStats(fusion_stats_t* stats);
+
+#endif /* _FUSION_H_ */
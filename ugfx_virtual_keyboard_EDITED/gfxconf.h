@@ -43,7 +43,7 @@
 #define GDISP_NEED_VALIDATION TRUE
 #define GDISP_NEED_CLIP TRUE
 #define GDISP_NEED_ARC TRUE
-#define GDISP_NEED_SCROLL FALSE
+#define GDISP_NEED_SCROLL TRUE
 #define GDISP_NEED_CONVEX_POLYGON TRUE
 #define GDISP_NEED_IMAGE TRUE
 	#define GDISP_NEED_IMAGE_BMP TRUE
@@ -59,7 +59,7 @@
 #define GDISP_NEED_PIXELREAD TRUE
 #define GDISP_DEFAULT_ORIENTATION GDISP_ROTATE_0
 #define GDISP_STARTUP_COLOR WHITE
-#define GDISP_NEED_PIXMAP FALSE
+#define GDISP_NEED_PIXMAP TRUE
 
 /********************************************************/
 /* Font stuff                                           */
@@ -86,6 +86,7 @@
 
 #define GWIN_NEED_WIDGET TRUE
     #define GWIN_NEED_LABEL TRUE
+		#define GWIN_LABEL_NUMBER TRUE
 		#define GWIN_NEED_BUTTON TRUE
 				#define GWIN_BUTTON_LAZY_RELEASE FALSE
 #define GWIN_FOCUS_HIGHLIGHT_WIDTH                   3
@@ -93,6 +94,7 @@
     #define GWIN_NEED_LIST TRUE
 		#define GWIN_NEED_IMAGE TRUE
         #define GWIN_NEED_LIST_IMAGES FALSE
+        #define GWIN_LIST_VIRTUAL TRUE
     #define GWIN_FLAT_STYLING TRUE
 
     #define GWIN_NEED_KEYBOARD TRUE
@@ -107,6 +109,8 @@
 #define GWIN_CONSOLE_USE_HISTORY TRUE
 #define GWIN_CONSOLE_ESCSEQ TRUE
 
+#define GWIN_NEED_CHART TRUE
+
 /********************************************************/
 /* GTIMER stuff                                         */
 /********************************************************/
@@ -114,6 +118,7 @@
 
 #define GTIMER_THREAD_PRIORITY NORMAL_PRIORITY
 #define GTIMER_THREAD_WORKAREA_SIZE 2048
+#define GTIMER_NEED_STATS TRUE
 
 
 /********************************************************/
@@ -142,6 +147,7 @@
 #define GFX_USE_GQUEUE TRUE
 
 #define GQUEUE_NEED_ASYNC TRUE
+#define GQUEUE_NEED_RING TRUE
 
 
 /********************************************************/
@@ -156,7 +162,25 @@
 #define GFILE_NEED_NATIVEFS FALSE
 #define GFILE_NEED_ROMFS TRUE
 #define GFILE_NEED_MEMFS TRUE
+#define GFILE_NEED_DIRECTPOINTER TRUE
 #define GFILE_MAX_GFILES 4
+#define GFILE_NEED_CACHE TRUE
+#define GFILE_CACHE_BLOCK_SIZE 4096
+#define GFILE_CACHE_MAX_BLOCKS 64
+#define GFILE_CACHE_READAHEAD 2
+#define GFILE_NEED_RAMFS TRUE
+#define GFILE_RAMFS_CHUNK_SIZE 2048
+#define GFILE_RAMFS_MAX_FILES 128
+#define GFILE_RAMFS_MAX_FILE 65536
+
+
+/********************************************************/
+/* GMISC stuff                                          */
+/********************************************************/
+#define GFX_USE_GMISC TRUE
+
+#define GMISC_NEED_FIXEDTRIG TRUE
+#define GMISC_NEED_MATRIXFIXED2D TRUE
 
 
 
@@ -29,14 +29,36 @@
 //			It requires the active area of the touch panel to exactly match the display size.
 #define GMOUSE_FT6x06_SELF_CALIBRATE			TRUE
 
+// The controller's INT line wakes the mouse, it is only read after a report and while a touch is down
+#define GMOUSE_FT6x06_INTERRUPT					TRUE
+
 #define FT6x06_SLAVE_ADDR 0x54
 
+#include "latency.h"
+
+static GMouse *touchMouse;
+// One BSP read gets the touch count and position, the driver's register reads come from here
+static TS_StateTypeDef touchState;
+
 static bool_t init_board(GMouse* m, unsigned driverinstance) {
-	(void)m;
+	(void)driverinstance;
 	
-	TS_StateTypeDef ts_state;
-	
-	return TS_OK == BSP_TS_Init(BSP_LCD_GetXSize(), BSP_LCD_GetYSize());
+	if (TS_OK != BSP_TS_Init(BSP_LCD_GetXSize(), BSP_LCD_GetYSize()))
+		return FALSE;
+	#if GMOUSE_FT6x06_INTERRUPT
+		touchMouse = m;
+		if (TS_OK != BSP_TS_ITConfig())
+			return FALSE;
+	#else
+		(void)m;
+	#endif
+	return TRUE;
+}
+
+// From the EXTI handler for the controller's INT line
+void touchInterrupt(void) {
+	if (touchMouse)
+		_gmouseWakeupI(touchMouse);
 }
 /*
 static GFXINLINE void aquire_bus(GMouse* m) {
@@ -57,14 +79,16 @@ static uint8_t read_byte(GMouse* m, uint8_t reg) {
   /*uint8_t data;
 	TM_I2C_Read(I2C1, FT6x06_SLAVE_ADDR, reg, &data);
 	return data;*/
-	TS_StateTypeDef ts_state;
 	if(reg == FT6x06_TOUCH_POINTS){
-		if (TS_OK != BSP_TS_GetState(&ts_state))
+		// The driver reads the touch count first, then the position words of the same report
+		if (TS_OK != BSP_TS_GetState(&touchState))
     {
-        return FALSE;
+        touchState.touchDetected = 0;
     }
-		return ts_state.touchDetected;
+		latencyMark(LATENCY_READ);
+		return touchState.touchDetected;
 	}
+	return 0;
 }
 
 static uint16_t read_word(GMouse* m, uint8_t reg) {
@@ -74,15 +98,12 @@ static uint16_t read_word(GMouse* m, uint8_t reg) {
 	TM_I2C_ReadMulti(I2C1, FT6x06_SLAVE_ADDR, reg, data, 2);
 	return (data[1]<<8 | data[0]);*/
 	
-	TS_StateTypeDef ts_state;
-	if (TS_OK == BSP_TS_GetState(&ts_state))
-	{
-		if(reg == FT6x06_TOUCH1_XH){
-			return (coord_t)ts_state.touchX[0];
-		}else if(reg == FT6x06_TOUCH1_YH){
-			return (coord_t)ts_state.touchY[0];
-		}
+	if(reg == FT6x06_TOUCH1_XH){
+		return (coord_t)touchState.touchX[0];
+	}else if(reg == FT6x06_TOUCH1_YH){
+		return (coord_t)touchState.touchY[0];
 	}
+	return 0;
 }
 
 #endif /* _GINPUT_LLD_MOUSE_BOARD_H */
@@ -1,64 +1,92 @@
-#include <cmath>
 #include "trace.h"
 #include "tm_stm32_gps.h"
 #include "tm_stm32_delay.h"
-
-#define M_PI (3.141592653589793)
+#include "fusion.h"
+#include "projection.h"
+#include "track.h"
+#include "route.h"
 
 static TM_GPS_Data_t GPS_Data;
 static TM_GPS_Float_t GPS_Float_Lat;
 static TM_GPS_Float_t GPS_Float_Lon;
 static TM_GPS_Float_t GPS_Float_Alt;
-static TM_GPS_Distance_t GPS_Distance;
 bool isRTCSet;
 
+/* Receiver starts at 9600 baud and is not reconfigured, the module fitted is not known to be u-blox.
+ * Its 1 Hz NMEA output uses about half of the line, and the 1024 byte DMA buffer holds about
+ * a second of data, so the GPS thread has that long before a line it parses is overwritten. */
+#define GPS_BAUDRATE 9600
+
+/* Signal set from USART DMA interrupt when complete NMEA sentence is received */
+#define GPS_SIGNAL_SENTENCE 0x01
+static osThreadId gpsThreadID;
+
 void retrieveGPS();
 
-int long2tilex(double lon, int zoomlevel, int *tileOffset) 
+// Tile helpers on top of fixed-point projection, coordinates are in 1e-7 degrees
+int long2tilex(int32_t lonE7, int zoomlevel, int *tileOffset) 
 { 
-	double tmp = (lon + 180.0) / 360.0 * pow(2.0, zoomlevel);
-	int ret = (int)(floor(tmp));
-	*tileOffset = (int)((tmp - ret)*256);
-	return ret; 
+	proj_world_t world;
+	
+	projToWorld(0, lonE7, &world);
+	*tileOffset = PROJ_TILE_OFFSET(world.x, zoomlevel);
+	return PROJ_TILE(world.x, zoomlevel); 
 }
 
-int lat2tiley(double lat, int zoomlevel, int *tileOffset)
+int lat2tiley(int32_t latE7, int zoomlevel, int *tileOffset)
 { 
-	double tmp = (1.0 - log( tan(lat * M_PI/180.0) + 1.0 / cos(lat * M_PI/180.0)) / M_PI) / 2.0 * pow(2.0, zoomlevel);
-	int ret = (int)(floor(tmp));
-	*tileOffset = (int)((tmp - ret)*256);
-	return ret; 
+	proj_world_t world;
+	
+	projToWorld(latE7, 0, &world);
+	*tileOffset = PROJ_TILE_OFFSET(world.y, zoomlevel);
+	return PROJ_TILE(world.y, zoomlevel); 
 }
 
-double tilex2long(int x, int z) 
+int32_t tilex2long(int x, int z) 
 {
-	return x / pow(2.0, z) * 360.0 - 180;
+	proj_world_t world = { (uint32_t)((uint64_t)x << PROJ_TILE_SHIFT(z)), 0 };
+	proj_latlon_t latlon;
+	
+	projToLatLon(&world, &latlon);
+	return latlon.LongitudeE7;
 }
 
-double tiley2lat(int y, int z) 
+int32_t tiley2lat(int y, int z) 
 {
-	double n = M_PI - 2.0 * M_PI * y / pow(2.0, z);
-	return 180.0 / M_PI * atan(0.5 * (exp(n) - exp(-n)));
+	proj_world_t world = { 0, (uint32_t)((uint64_t)y << PROJ_TILE_SHIFT(z)) };
+	proj_latlon_t latlon;
+	
+	projToLatLon(&world, &latlon);
+	return latlon.LatitudeE7;
 }
 
 void runGPS(){	
-		/* Delay init */
-	TM_DELAY_Init();
+	/* Route is loaded by the boot thread, sentences are parsed here meanwhile */
 	
-	/* Initialize GPS on 9600 baudrate */
-	TM_GPS_Init(&GPS_Data, 9600);
+	/* Initialize GPS */
+	TM_GPS_Init(&GPS_Data, GPS_BAUDRATE);
 	
 	isRTCSet = false;
+	gpsThreadID = osThreadGetId();
 		
 	while(1) {
-		
+		/* Sleep until DMA receives complete sentence, then parse everything waiting */
+		osSignalWait(GPS_SIGNAL_SENTENCE, osWaitForever);
+		do {
+			retrieveGPS();
+		} while (TM_USART_DMA_SentenceCount(GPS_USART));
+	}
+}
+
+void TM_USART_DMA_SentenceCallback(USART_TypeDef* USARTx){
+	if (USARTx == GPS_USART && gpsThreadID != NULL) {
+		osSignalSet(gpsThreadID, GPS_SIGNAL_SENTENCE);
 	}
 }
 
 void retrieveGPS(){
 	TM_GPS_Result_t result, current;
-	char buffer[40];
-	float temp;
+	route_status_t route;
 	
 	TM_DELAY_SetTime(0);
 	
@@ -77,11 +105,13 @@ void retrieveGPS(){
 		current = TM_GPS_Result_NewData;
 		
 		saveGPS(&GPS_Data);
+		fusionGPSUpdate(&GPS_Data);
 		
 		/* Is GPS signal valid? */
 		if (GPS_Data.Validity) {
 			/* If you want to make a GPS tracker, now is the time to save your data on SD card */
-			if(!isRTCSet){
+			// Compared with the RTC once it has started, a fix before that is not lost
+			if(!isRTCSet && isRTCReady()){
 				TM_RTC_t rtcd;
 				getRTC(&rtcd, TM_RTC_Format_BIN);
 				uint32_t rtcTime = TM_RTC_GetUnixTimeStamp(&rtcd);
@@ -105,6 +135,15 @@ void retrieveGPS(){
 				isRTCSet = true;
 			}
 			
+			/* Breadcrumb for map overlay and progress along route */
+			trackAddPoint(GPS_Data.LatitudeE7, GPS_Data.LongitudeE7);
+			routeUpdate(GPS_Data.LatitudeE7, GPS_Data.LongitudeE7);
+			routeGetStatus(&route);
+			if (route.Loaded) {
+				TRACE("ROUTE:,Along=%u,Remaining=%u,FromRoute=%u,NextTurn=%u,TurnAngle=%d,OffRoute=%d\n", route.DistanceAlongM,
+				route.DistanceRemainingM, route.DistanceFromRouteM, route.NextTurnM, route.NextTurnAngle, route.OffRoute);
+			}
+			
 			/* We have valid GPS signal */
 			TRACE("GPS:,New GPS Data Received\n");
 #ifndef GPS_DISABLE_GPGGA
@@ -1,12 +1,14 @@
 #ifndef _GPS_H_
 #define _GPS_H_
 
+#include <stdint.h>
+
 #define ZOOM_LEVEL 16
 
-int lat2tiley(double lat, int zoomlevel, int *tileOffset);
-int long2tilex(double lon, int zoomlevel, int *tileOffset);
-double tilex2long(int x, int z);
-double tiley2lat(int y, int z);
+int lat2tiley(int32_t latE7, int zoomlevel, int *tileOffset);
+int long2tilex(int32_t lonE7, int zoomlevel, int *tileOffset);
+int32_t tilex2long(int x, int z);
+int32_t tiley2lat(int y, int z);
 void runGPS();
 
 #endif /* _GPS_H_ */
\ No newline at end of file
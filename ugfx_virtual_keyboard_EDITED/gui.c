@@ -9,9 +9,16 @@
 #include "gui.h"
 #include "trace.h"
 #include "gps.h"
+#include "fusion.h"
+#include "track.h"
+#include "tiles.h"
+#include "vmap.h"
 #include <stdio.h>
 #include <string.h>
 #include "msg.h"
+#include "latency.h"
+#include "boot.h"
+#include "sdram.h"
 #include "romfs_files.h"
 
 //#define MAP_TILE_TEST_CANAL
@@ -20,6 +27,9 @@
 
 #define MAP_CENTERX 552
 #define MAP_CENTERY 240
+#define MAP_HEADING_THRESHOLD 5		// Degrees heading has to turn before heading-up map is drawn again
+#define MAP_UPDATE_MS (1000 / FUSION_RATE_HZ)	// Map follows every fused estimate
+#define MAP_EVENT_WAIT_MS 3			// Event wait while map is shown, keeps loop from spinning
 
 #define MAIN_CONTAINER 0
 #define DATA_CONTAINER 1
@@ -36,11 +46,18 @@
 #define CADENCE_CONTAINER 12
 #define DISTANCE_CONTAINER 13
 #define HEART_RATE_CONTAINER 14
+#define HISTORY_CONTAINER 15
+
+#define HISTORY_SAMPLES 1800			// Thirty minutes at one sample a second
+#define HISTORY_PER_COLUMN 4				// Seconds per pixel column, the plot spans about half an hour
+#define HISTORY_GRID 15						// Columns between vertical grid lines, one a minute
+
+#define GUI_PREWARM TRUE					// Build hidden pages right after the first frame, otherwise on first use
 
 // GListeners
 GListener glistener;
 
-GHandle containers[15];
+GHandle containers[16];
 GHandle labels[6];
 GHandle buttons[8];
 GHandle lists[2];
@@ -51,10 +68,14 @@ gdispImage settingsImage;
 gdispImage returnImage;
 static gdispImage dataIcons;
 
+// Speed, cadence and heart rate history
+static GHandle historyChart;
+static uint8_t historySeconds;
+
 GHandle ghImage1[10];
 
 uint8_t devicesCount;
-uint8_t devicesMAC[10][6];
+uint8_t devicesMAC[MAXIMUM_BLUETOOTH][6];
 char bluetoothDevices[18];
 
 // GEAR STATUS SPECIALS
@@ -91,7 +112,6 @@ char gearBuffer[5];
 char gearsStatus[26];
 
 char timeBuffer[23];
-char gpsOutput[70];
 
 uint8_t currentGearSide;
 uint8_t currentGearTeethWindow;
@@ -104,31 +124,31 @@ uint8_t cadenceSetPointOutput;
 uint8_t distanceOutput;
 uint8_t heartrateOutput;
 uint8_t batteryOutput;
-char dataOutput[10];
 
-static gdispImage myImage[9];
 static gdispImage marker;
+static uint8_t mapZoom = ZOOM_LEVEL;
+static uint8_t oldMapZoom = 0;
+static bool mapPending = false;
+static bool mapHeadingUp = false;
+static int16_t mapRotation = 0;
+static systemticks_t mapTime;
 //gdispImageError result;
 //int x = 0;
 //int y = 0;
 //static GDisplay* pixmap;
 //static pixel_t* surface;
 
-osMessageQDef(guiQueue, 16, message_t);
-osMessageQId  guiQueue;
-
 int oldtilex=0;
 int oldtiley=0;
 int oldtilexOffset=0;
 int oldtileyOffset=0;
 
 my_GPS gpsData;
-static TM_GPS_Float_t GPS_Float_Lat;
-static TM_GPS_Float_t GPS_Float_Lon;
 	
 uint8_t previousSeconds;
 
 void drawTile(int tilex, int tiley, int tilexOffset, int tileyOffset);
+void newGPSData();
 void button0Call();
 void button1Call();
 void button2Call();
@@ -142,13 +162,18 @@ void displayBattery(uint8_t currentBatt);
 void showCurrentGears();
 void connectBluetooth();
 void displayDataIcons();
+void touchInterrupt(void);
 	
-bool interrupted;
 // INTERRUPT
 void TM_EXTI_Handler(uint16_t GPIO_Pin) {
 	/* Handle external line 7 interrupts */
 	if (GPIO_Pin == GPIO_Pin_7) {
-		interrupted = true;
+		msgSendI(MSG_TO_SPI, GET_AVAILABILITY_MSG, 0);
+	}
+	/* Touch controller has a new report */
+	if (GPIO_Pin == GPIO_Pin_5) {
+		latencyMark(LATENCY_IRQ);
+		touchInterrupt();
 	}
 }
 	
@@ -262,6 +287,10 @@ static void createmainContainer(void)
 	// create container widget: containers[CLOCK_CONTAINER]
 	wi.text = "containers[CLOCK_CONTAINER]";
 	containers[CLOCK_CONTAINER] = gwinContainerCreate(0, &wi, GWIN_CONTAINER_BORDER);
+	
+	// create container widget: containers[HISTORY_CONTAINER]
+	wi.text = "containers[HISTORY_CONTAINER]";
+	containers[HISTORY_CONTAINER] = gwinContainerCreate(0, &wi, GWIN_CONTAINER_BORDER);
 }
 
 static void createMap(void)
@@ -306,7 +335,6 @@ static void createData(void)
 	gwinWidgetClearInit(&wi);
 	
 	speedOutput = 0;
-	formatString(dataOutput, sizeof(dataOutput), "%d", speedOutput);
 	// Create label widget: labels[0]
 	wi.g.show = TRUE;
 	wi.g.x = 113;
@@ -314,17 +342,17 @@ static void createData(void)
 	wi.g.width = 192;
 	wi.g.height = 113;
 	wi.g.parent = containers[SPEED_CONTAINER];
-	wi.text = dataOutput;
+	wi.text = "";
 	wi.customDraw = gwinLabelDrawJustifiedCenter;
 	wi.customParam = 0;
 	wi.customStyle = &dataLabels;
 	labels[0] = gwinLabelCreate(0, &wi);
 	gwinLabelSetBorder(labels[0], TRUE);
 	gwinSetFont(labels[0], gdispOpenFont("LatoRegular60"));
+	gwinLabelSetNumber(labels[0], speedOutput);
 	gwinRedraw(labels[0]);
 
 	cadenceOutput = 0;
-	formatString(dataOutput, sizeof(dataOutput), "%d", cadenceOutput);
 	// Create label widget: labels[1]
 	wi.g.show = TRUE;
 	wi.g.x = 113;
@@ -332,17 +360,17 @@ static void createData(void)
 	wi.g.width = 192;
 	wi.g.height = 100;
 	wi.g.parent = containers[CADENCE_CONTAINER];
-	wi.text = dataOutput;
+	wi.text = "";
 	wi.customDraw = gwinLabelDrawJustifiedCenter;
 	wi.customParam = 0;
 	wi.customStyle = &dataLabels;
 	labels[1] = gwinLabelCreate(0, &wi);
 	gwinLabelSetBorder(labels[1], TRUE);
 	gwinSetFont(labels[1], gdispOpenFont("LatoRegular40"));
+	gwinLabelSetNumber(labels[1], cadenceOutput);
 	gwinRedraw(labels[1]);
 
 	distanceOutput = 0;
-	formatString(dataOutput, sizeof(dataOutput), "%d", distanceOutput);
 	// Create label widget: labels[2]
 	wi.g.show = TRUE;
 	wi.g.x = 113;
@@ -350,17 +378,17 @@ static void createData(void)
 	wi.g.width = 192;
 	wi.g.height = 82;
 	wi.g.parent = containers[DISTANCE_CONTAINER];
-	wi.text = dataOutput;
+	wi.text = "";
 	wi.customDraw = gwinLabelDrawJustifiedCenter;
 	wi.customParam = 0;
 	wi.customStyle = &dataLabels;
 	labels[2] = gwinLabelCreate(0, &wi);
 	gwinLabelSetBorder(labels[2], TRUE);
 	gwinSetFont(labels[2], gdispOpenFont("LatoRegular40"));
+	gwinLabelSetNumber(labels[2], distanceOutput);
 	gwinRedraw(labels[2]);
 	
 	heartrateOutput = 0;
-	formatString(dataOutput, sizeof(dataOutput), "%d", heartrateOutput);
 	// Create label widget: labels[3]
 	wi.g.show = TRUE;
 	wi.g.x = 113;
@@ -368,13 +396,14 @@ static void createData(void)
 	wi.g.width = 192;
 	wi.g.height = 71;
 	wi.g.parent = containers[HEART_RATE_CONTAINER];
-	wi.text = dataOutput;
+	wi.text = "";
 	wi.customDraw = gwinLabelDrawJustifiedCenter;
 	wi.customParam = 0;
 	wi.customStyle = &dataLabels;
 	labels[3] = gwinLabelCreate(0, &wi);
 	gwinLabelSetBorder(labels[3], TRUE);
 	gwinSetFont(labels[3], gdispOpenFont("LatoRegular40"));
+	gwinLabelSetNumber(labels[3], heartrateOutput);
 	gwinRedraw(labels[3]);
 
 	gdispImageOpenMemory(&settingsImage, settingImageArray);
@@ -392,6 +421,50 @@ static void createData(void)
 	buttons[0] = gwinButtonCreate(0, &wi);
 }
 
+static void createHistory(void)
+{
+	TRACE("createHistory\n");
+	GWindowInit wi;
+	gwinClearInit(&wi);
+	
+	// Create chart window: historyChart
+	// The plot lives in SDRAM, the samples and columns on the heap
+	wi.show = TRUE;
+	wi.x = 10;
+	wi.y = 10;
+	wi.width = 475;
+	wi.height = 460;
+	wi.parent = containers[HISTORY_CONTAINER];
+	historyChart = gwinChartCreate(0, &wi, HISTORY_SAMPLES, (void *)SDRAM_CHART_ADDR);
+	gwinChartAddSeries(historyChart, blue_studio);
+	gwinChartAddSeries(historyChart, orange_studio);
+	gwinChartAddSeries(historyChart, red_studio);
+	gwinChartSetGridColor(historyChart, silver_studio);
+	gwinChartSetRange(historyChart, 0, 200, 50);
+	gwinChartSetSpan(historyChart, HISTORY_PER_COLUMN, HISTORY_GRID);
+}
+
+// Once a second whichever page is showing
+static void recordHistory(void)
+{
+	int16_t values[3];
+	
+	if(historyChart == NULL){
+		createHistory();
+	}
+	values[0] = speedOutput == INVALID_DATA ? GWIN_CHART_NODATA : speedOutput;
+	values[1] = cadenceOutput == INVALID_DATA ? GWIN_CHART_NODATA : cadenceOutput;
+	values[2] = heartrateOutput == INVALID_DATA ? GWIN_CHART_NODATA : heartrateOutput;
+	gwinChartAddSamples(historyChart, values);
+	
+	// The data page asks for new readings itself while it is showing
+	if(!gwinGetVisible(containers[DATA_CONTAINER])){
+		msgSend(MSG_TO_SPI, GET_SPEED_MSG, 0);
+		msgSend(MSG_TO_SPI, GET_CADENCE_MSG, 0);
+		msgSend(MSG_TO_SPI, GET_HEARTRATE_MSG, 0);
+	}
+}
+
 static void createMenu(void)
 {
 	TRACE("createMenu\n");
@@ -417,11 +490,13 @@ static void createMenu(void)
 	gwinListAddItem(lists[0], "Teeth Settings", FALSE);
 	gwinListAddItem(lists[0], "Gears Status", FALSE);
 	gwinListAddItem(lists[0], "Clock Settings", FALSE);
+	gwinListAddItem(lists[0], "Ride History", FALSE);
 	gwinListSetSelected(lists[0], 0, TRUE);
 	gwinListSetSelected(lists[0], 1, FALSE);
 	gwinListSetSelected(lists[0], 2, FALSE);
 	gwinListSetSelected(lists[0], 3, FALSE);
   gwinListSetSelected(lists[0], 4, FALSE);
+	gwinListSetSelected(lists[0], 5, FALSE);
 	oldMenuSelectedItem = -1;
 	
 	gdispImageOpenMemory(&returnImage, returnImageArray);
@@ -490,6 +565,36 @@ static void createBluetooth(void)
 	gwinSetFont(buttons[2], gdispOpenFont("LatoRegular40"));
 }
 
+// Rows of the Bluetooth list are formatted as they come into view
+static const char *bluetoothItem(GHandle gh, int item, void *param){
+	(void)gh;
+	(void)param;
+	
+	if(devicesCount == 0){
+		return "N/A";
+	}
+	formatString(bluetoothDevices, sizeof(bluetoothDevices), "%02X:%02X:%02X:%02X:%02X:%02X", devicesMAC[item][0],
+																																									devicesMAC[item][1],
+																																									devicesMAC[item][2],
+																																									devicesMAC[item][3],
+																																									devicesMAC[item][4],
+																																									devicesMAC[item][5]);
+	return bluetoothDevices;
+}
+
+static void showBluetoothDevices(void){
+	for(uint8_t count = 0; count < devicesCount; count++){
+		TRACE("GUI:, Device %d, %02X:%02X:%02X:%02X:%02X:%02X\n", count, devicesMAC[count][0],
+																																	devicesMAC[count][1],
+																																	devicesMAC[count][2],
+																																	devicesMAC[count][3],
+																																	devicesMAC[count][4],
+																																	devicesMAC[count][5]);
+	}
+	// One row says N/A when nothing was found
+	gwinListSetVirtual(lists[1], bluetoothItem, 0, devicesCount > 0 ? devicesCount : 1);
+}
+
 static void createBluetoothList(void){
 	GWidgetInit wi;
 	gwinWidgetClearInit(&wi);
@@ -508,27 +613,7 @@ static void createBluetoothList(void){
 	lists[1] = gwinListCreate(0, &wi, TRUE);
 	gwinSetFont(lists[1], gdispOpenFont("LatoRegular40"));
 	gwinListSetScroll(lists[1], scrollSmooth);
-	if(devicesCount > 0){
-		for(uint8_t count = 0; count < devicesCount; count++){
-			TRACE("GUI:, Device %d, %02X:%02X:%02X:%02X:%02X:%02X\n", count, devicesMAC[count][0],
-																																		devicesMAC[count][1],
-																																		devicesMAC[count][2],
-																																		devicesMAC[count][3],
-																																		devicesMAC[count][4],
-																																		devicesMAC[count][5]);
-			formatString(bluetoothDevices, sizeof(bluetoothDevices), "%02X:%02X:%02X:%02X:%02X:%02X", devicesMAC[count][0],
-																																												devicesMAC[count][1],
-																																												devicesMAC[count][2],
-																																												devicesMAC[count][3],
-																																												devicesMAC[count][4],
-																																												devicesMAC[count][5]);
-			gwinListAddItem(lists[1], bluetoothDevices, TRUE);
-			gwinListSetSelected(lists[1], count, FALSE);
-		}
-	}else{
-		gwinListAddItem(lists[1], "N/A", FALSE);
-		gwinListSetSelected(lists[1], 0, FALSE);
-	}
+	showBluetoothDevices();
 }
 
 static void createGearsSettings(void)
@@ -1424,6 +1509,10 @@ static void destroyOldMenuSelectedItem(void)
 	case 4:
 		destroyClockSsettings();
 		break;
+	case 5:
+		// The chart keeps recording while it is hidden
+		gwinHide(containers[HISTORY_CONTAINER]);
+		break;
 	default:
 		break;
 	}
@@ -1521,8 +1610,6 @@ void guiShowPage(unsigned pageIndex)
 
 void guiCreate(void)
 {
-	openTraceFile();
-	
 	GWidgetInit wi;
 
 	// GWIN settings
@@ -1539,15 +1626,17 @@ void guiCreate(void)
 	currentGearTeethWindow = 1;
 	currentTeethTeethWindow = 25;
 	
-	// Create all the display pages
+	// Create the pages of the first frame, the rest are built later
 	createmainContainer();
 	createMap();
 	createData();
+	bootMark(BOOT_GUI);
 	
 	// Select the default display page
 	guiShowPage(0);
 	
 	displayDataIcons();
+	bootMark(BOOT_FRAME);
 }
 
 void guiEventLoop(void)
@@ -1556,57 +1645,60 @@ void guiEventLoop(void)
 	int count = 0;
 	previousSeconds = 0;
 	previousBatt = 1;
-	interrupted = false;
-	
-	guiQueue = osMessageCreate(osMessageQ(guiQueue), NULL);
 	
 	char temp[20];
-	message_t *messageReceived;
-	message_t *messageSent;
+	msg_t messageReceived;
+	fusion_estimate_t estimate;
+	
+#if GUI_PREWARM
+	// The history chart keeps recording while hidden, it is needed within a second anyway
+	if(historyChart == NULL){
+		createHistory();
+	}
+#endif
+	bootMark(BOOT_PREWARM);
+	
 	while (1) {		
-		osEvent evt = osMessageGet(guiQueue, 0);
-		if (evt.status == osEventMessage) {
-			messageReceived = (message_t*)evt.value.p;
-			if(messageReceived->msg_ID == GET_SPEED_MSG){
-				speedOutput = messageReceived->value;
-			}else if(messageReceived->msg_ID == GET_CADENCE_MSG){
-				cadenceOutput = messageReceived->value;
-			}else if(messageReceived->msg_ID == GET_DISTANCE_MSG){
-				distanceOutput = messageReceived->value;
-			}else if(messageReceived->msg_ID == GET_HEARTRATE_MSG){
-				heartrateOutput = messageReceived->value;
-			}else if(messageReceived->msg_ID == GET_CADENCE_SETPOINT_MSG){
-				cadenceSetPointOutput = messageReceived->value;
-			}else if(messageReceived->msg_ID == GET_BATTERY_MSG){
-				batteryOutput = messageReceived->value;
-			}else if(messageReceived->msg_ID == GET_GEAR_COUNT_MSG){
+		while(msgReceive(MSG_TO_GUI, &messageReceived, TIME_IMMEDIATE)){
+			if(messageReceived.id == GET_SPEED_MSG){
+				speedOutput = messageReceived.value;
+			}else if(messageReceived.id == GET_CADENCE_MSG){
+				cadenceOutput = messageReceived.value;
+			}else if(messageReceived.id == GET_DISTANCE_MSG){
+				distanceOutput = messageReceived.value;
+			}else if(messageReceived.id == GET_HEARTRATE_MSG){
+				heartrateOutput = messageReceived.value;
+			}else if(messageReceived.id == GET_CADENCE_SETPOINT_MSG){
+				cadenceSetPointOutput = messageReceived.value;
+			}else if(messageReceived.id == GET_BATTERY_MSG){
+				batteryOutput = messageReceived.value;
+			}else if(messageReceived.id == GET_GEAR_COUNT_MSG){
+				msg_gears_t *gears = (msg_gears_t *)messageReceived.payload;
 				// Update Current Front Gears
-				gearFrontCurrent[0] = messageReceived->frontGears[0];
+				gearFrontCurrent[0] = gears->frontGears[0];
 				for(int count = 1; count <= gearFrontCurrent[0]; count++){
-					gearFrontCurrent[count] = messageReceived->frontGears[count];
+					gearFrontCurrent[count] = gears->frontGears[count];
 				}
 				// Update Current Back Gears
-				gearBackCurrent[0] = messageReceived->backGears[0];
+				gearBackCurrent[0] = gears->backGears[0];
 				for(int count = 1; count <= gearBackCurrent[0]; count++){
-					gearBackCurrent[count] = messageReceived->backGears[count];
+					gearBackCurrent[count] = gears->backGears[count];
 				}
 				showCurrentGears();
-			}else if(messageReceived->msg_ID == NRF_SCAN_MSG){
-				gwinDestroy(lists[1]);
-				lists[1] = NULL;
-				devicesCount = messageReceived->value;
-				createBluetoothList();
+			}else if(messageReceived.id == NRF_SCAN_MSG){
+				msg_devices_t *devices = (msg_devices_t *)messageReceived.payload;
+				devicesCount = devices->count;
+				memcpy(devicesMAC, devices->mac, sizeof(devicesMAC));
+				// The list is refilled in place rather than recreated
+				if(lists[1] == NULL){
+					createBluetoothList();
+				}else{
+					showBluetoothDevices();
+				}
 				gwinHide(containers[BLUETOOTH_SEARCH_CONTAINER]);
 				gwinShow(containers[BLUETOOTH_DEVICE_CONTAINER]);
 			}
-			osPoolFree(mpool, messageReceived);
-		}
-		
-		if(interrupted == true){
-			messageSent = (message_t*)osPoolAlloc(mpool);
-			messageSent->msg_ID = GET_AVAILABILITY_MSG;
-			osMessagePut(spiQueue, (uint32_t)messageSent, 0);
-			interrupted = false;
+			msgRelease(MSG_TO_GUI, &messageReceived);
 		}
 		
 		// MUST STAY THIS IS THE MAIN THING FOR THIS
@@ -1617,34 +1709,41 @@ void guiEventLoop(void)
 //			openTraceFile();
 //		}
 		
+		if(RTCD.Seconds != historySeconds){
+			recordHistory();
+			historySeconds = RTCD.Seconds;
+		}
+		
 		if(gwinGetVisible(containers[DATA_CONTAINER])){
 			if(RTCD.Seconds != previousSeconds){
 				if(speedOutput == INVALID_DATA){
 					gwinSetText(labels[0], "--", TRUE);
 				}else{
-					formatString(dataOutput, sizeof(dataOutput), "%d", speedOutput);
-					gwinSetText(labels[0], dataOutput, TRUE);
+					gwinLabelSetNumber(labels[0], speedOutput);
 				}
 				
 				if(cadenceOutput == INVALID_DATA){
 					gwinSetText(labels[1], "--", TRUE);
 				}else{
-					formatString(dataOutput, sizeof(dataOutput), "%d", cadenceOutput);
-					gwinSetText(labels[1], dataOutput, TRUE);
+					gwinLabelSetNumber(labels[1], cadenceOutput);
 				}
 				
 				if(distanceOutput == INVALID_DATA){
-					gwinSetText(labels[2], "--", TRUE);
+					// Without a wheel sensor distance the fused GPS distance is shown, in km as well
+					fusionGetEstimate(&estimate);
+					if(estimate.Valid){
+						gwinLabelSetNumber(labels[2], estimate.DistanceM / 1000);
+					}else{
+						gwinSetText(labels[2], "--", TRUE);
+					}
 				}else{
-					formatString(dataOutput, sizeof(dataOutput), "%d", distanceOutput);
-					gwinSetText(labels[2], dataOutput, TRUE);
+					gwinLabelSetNumber(labels[2], distanceOutput);
 				}
 				
 				if(heartrateOutput == INVALID_DATA){
 					gwinSetText(labels[3], "--", TRUE);
 				}else{
-					formatString(dataOutput, sizeof(dataOutput), "%d", heartrateOutput);
-					gwinSetText(labels[3], dataOutput, TRUE);
+					gwinLabelSetNumber(labels[3], heartrateOutput);
 				}
 				
 				if(batteryOutput == INVALID_DATA){
@@ -1653,26 +1752,11 @@ void guiEventLoop(void)
 					displayBattery(batteryOutput);
 				}
 								
-				messageSent = (message_t*)osPoolAlloc(mpool);
-				messageSent->msg_ID = GET_SPEED_MSG;
-				osMessagePut(spiQueue, (uint32_t)messageSent, 0);
-				
-				messageSent = (message_t*)osPoolAlloc(mpool);
-				messageSent->msg_ID = GET_CADENCE_MSG;
-				osMessagePut(spiQueue, (uint32_t)messageSent, 0);
-				
-				messageSent = (message_t*)osPoolAlloc(mpool);
-				messageSent->msg_ID = GET_DISTANCE_MSG;
-				osMessagePut(spiQueue, (uint32_t)messageSent, 0);
-				
-				messageSent = (message_t*)osPoolAlloc(mpool);
-				messageSent->msg_ID = GET_HEARTRATE_MSG;
-				osMessagePut(spiQueue, (uint32_t)messageSent, 0);
-				
-				messageSent = (message_t*)osPoolAlloc(mpool);
-				messageSent->msg_ID = GET_BATTERY_MSG;
-				osMessagePut(spiQueue, (uint32_t)messageSent, 0);
-				
+				msgSend(MSG_TO_SPI, GET_SPEED_MSG, 0);
+				msgSend(MSG_TO_SPI, GET_CADENCE_MSG, 0);
+				msgSend(MSG_TO_SPI, GET_DISTANCE_MSG, 0);
+				msgSend(MSG_TO_SPI, GET_HEARTRATE_MSG, 0);
+				msgSend(MSG_TO_SPI, GET_BATTERY_MSG, 0);
 				previousSeconds = RTCD.Seconds;
 			}
 		}
@@ -1689,17 +1773,20 @@ void guiEventLoop(void)
 			}
 		}
 		
-    if(gwinGetVisible(containers[MAP_CONTAINER])){
-			gfxSleepMilliseconds(3);
-			// ---------------------------------------
-			// DO GPS STUFF
+		// Map has its own rate, it follows fused estimate rather than RTC seconds
+		if(gwinGetVisible(containers[MAP_CONTAINER])){
+			if(gfxSystemTicks() - mapTime >= gfxMillisecondsToTicks(MAP_UPDATE_MS)){
+				mapTime = gfxSystemTicks();
+				newGPSData();
+			}
 		}
 		
-		// Get an event
-		pe = geventEventWait(&glistener, 0);
-		switch (pe->type) {
+		// Get an event, there may be none
+		pe = geventEventWait(&glistener, gwinGetVisible(containers[MAP_CONTAINER]) ? MAP_EVENT_WAIT_MS : 0);
+		switch (pe ? pe->type : GEVENT_NULL) {
 			case GEVENT_GWIN_BUTTON:
 			{
+				latencyMark(LATENCY_CALLBACK);
 				if (((GEventGWinButton*)pe)->gwin == buttons[0]) {
 					button0Call();
 				}else if (((GEventGWinButton*)pe)->gwin == buttons[1]) {
@@ -1717,6 +1804,8 @@ void guiEventLoop(void)
 				}else if (((GEventGWinButton*)pe)->gwin == buttons[7]) {
 					button7Call();
 				}
+				// Redraws are immediate so the result is on screen by now
+				latencyMark(LATENCY_DRAWN);
 				break;
 			}
 			default:
@@ -1731,6 +1820,7 @@ void guiEventLoop(void)
 
 void button0Call(){
 	if(gwinGetVisible(containers[DATA_CONTAINER])){
+		trackClearView();
 		destroyMap();
 		destroyData();
 		gwinHide(containers[DATA_CONTAINER]);
@@ -1757,13 +1847,12 @@ void button0Call(){
 }
 
 void button1Call(){
-	message_t *messageSent;
+	msg_gears_t *gears;
 	if(gwinGetVisible(containers[BLUETOOTH_CONTAINER])){
 		// BLUETOOTH SEARCH
 		gwinHide(containers[BLUETOOTH_DEVICE_CONTAINER]);
 		gwinShow(containers[BLUETOOTH_SEARCH_CONTAINER]);
-		messageSent = (message_t*)osPoolAlloc(mpool);
-		messageSent->msg_ID = NRF_SCAN_MSG;
+		msgSend(MSG_TO_SPI, NRF_SCAN_MSG, 0);
 	}else if(gwinGetVisible(containers[GEARS_CONTAINER])){
 		// FRONT GEARS PLUS
 		if(gearFrontSettings[0] != MAXIMUM_FRONT_GEARS){
@@ -1786,13 +1875,15 @@ void button1Call(){
 		gwinSetText(labels[3], gearBuffer, TRUE);
 	}else if(gwinGetVisible(containers[STATUS_CONTAINER])){
 		// SUBMIT
-		messageSent = (message_t*)osPoolAlloc(mpool);
-		messageSent->msg_ID = SET_GEAR_COUNT_MSG;
-		for(int count = 0; count <= gearFrontSettings[0]; count++){
-			messageSent->frontGears[count] = gearFrontSettings[count];
-		}
-		for(int count = 0; count <= gearBackSettings[0]; count++){
-			messageSent->backGears[count] = gearBackSettings[count];
+		gears = (msg_gears_t *)msgAlloc(MSG_TO_SPI, SET_GEAR_COUNT_MSG);
+		if(gears != NULL){
+			for(int count = 0; count <= gearFrontSettings[0]; count++){
+				gears->frontGears[count] = gearFrontSettings[count];
+			}
+			for(int count = 0; count <= gearBackSettings[0]; count++){
+				gears->backGears[count] = gearBackSettings[count];
+			}
+			msgSendPayload(MSG_TO_SPI, SET_GEAR_COUNT_MSG, gears);
 		}
 		TRACE("Submit Gears\n");
 	}else if(gwinGetVisible(containers[CLOCK_CONTAINER])){
@@ -1808,7 +1899,6 @@ void button1Call(){
 		closeTraceFile();
 		openTraceFile();
 	}
-	osMessagePut(spiQueue, (uint32_t)messageSent, 0);
 }
 
 void button2Call(){
@@ -1828,16 +1918,16 @@ void button2Call(){
 		gwinSetText(labels[3], gearBuffer, TRUE);
 	}else if(gwinGetVisible(containers[STATUS_CONTAINER])){
 		// READ
-		message_t *messageSent;
-		messageSent = (message_t*)osPoolAlloc(mpool);
-		messageSent->msg_ID = GET_GEAR_COUNT_MSG;
-		osMessagePut(spiQueue, (uint32_t)messageSent, 0);
+		msgSend(MSG_TO_SPI, GET_GEAR_COUNT_MSG, 0);
 		TRACE("Read Gears\n");
 	}else if(gwinGetVisible(containers[CLOCK_CONTAINER])){
 		// Clock Changes Selection Up
 		if(clockChangeSelectedItem != 0){clockChangeSelectedItem--;}
 	}else if(gwinGetVisible(containers[BLUETOOTH_CONTAINER])){
 		connectBluetooth();
+	}else if(gwinGetVisible(containers[DATA_CONTAINER])){
+		// MAP ZOOM OUT
+		if(mapZoom != TILES_MIN_ZOOM){mapZoom--;}
 	}
 }
 
@@ -1859,7 +1949,10 @@ void button3Call(){
 	}else if(gwinGetVisible(containers[CLOCK_CONTAINER])){
 		// Clock Changes Selection Down
 		if(clockChangeSelectedItem != 4){clockChangeSelectedItem++;}
-	}	
+	}else if(gwinGetVisible(containers[DATA_CONTAINER])){
+		// MAP ZOOM IN
+		if(mapZoom != TILES_MAX_ZOOM){mapZoom++;}
+	}
 }
 
 void button4Call(){
@@ -1903,7 +1996,10 @@ void button4Call(){
 				break;
 		}
 		gwinSetText(clockChangesValue[clockChangeSelectedItem], timeBuffer, TRUE);
-	}	
+	}else if(gwinGetVisible(containers[DATA_CONTAINER])){
+		// MAP HEADING UP / NORTH UP
+		mapHeadingUp = !mapHeadingUp;
+	}
 }
 
 void button5Call(){
@@ -1990,6 +2086,12 @@ void handleMenuSwitches(){
 				createClockSettings();
 				gwinShow(containers[CLOCK_CONTAINER]);
 				break;
+			case 5:
+				if(historyChart == NULL){
+					createHistory();
+				}
+				gwinShow(containers[HISTORY_CONTAINER]);
+				break;
 			default:
 				break;
 		}
@@ -2029,14 +2131,10 @@ void displayBattery(uint8_t currentBatt){
 }
 
 void connectBluetooth(){
-	message_t *messageSent;
 	if(lists[1] != NULL){
 		for(uint8_t count = 0; count < devicesCount; count++){
 			if(gwinListItemIsSelected(lists[1], count)){
-				messageSent = (message_t*)osPoolAlloc(mpool);
-				messageSent->msg_ID = NRF_CONNECT_MSG;
-				messageSent->value = count;
-				osMessagePut(spiQueue, (uint32_t)messageSent, 0);
+				msgSend(MSG_TO_SPI, NRF_CONNECT_MSG, count);
 			}
 		}
 	}
@@ -2067,90 +2165,30 @@ void drawTile(int tilex, int tiley, int tilexOffset, int tileyOffset)
 	if (status != osOK){
 		// handle failure code
 	}
-    /*coord_t	swidth, sheight;
-    swidth = gdispGetWidth();
-	sheight = gdispGetHeight();
-    gdispImageOpenFile(&myImage, "maptile_bmp.bmp");
-	gdispImageDraw(&myImage, xx, yy, swidth, sheight, 0, 0);
-    gdispImageClose(&myImage);*/
 	coord_t leftX = 305;
-	coord_t centerX = MAP_CENTERX-tilexOffset;
-	coord_t rightX = MAP_CENTERX-tilexOffset+256;
 	coord_t topY = 0;
-	coord_t middleY = MAP_CENTERY-tileyOffset;
-	coord_t bottomY = MAP_CENTERY-tileyOffset+256;
-	coord_t xTileStartOffset = 256-247+tilexOffset;
-	coord_t yTileStartOffset = 256-240+tileyOffset;
-	coord_t xShowMap = 256 - xTileStartOffset;
-	coord_t yShowMap = 256 - yTileStartOffset;
-	
-	// X11
-	formatString(gpsOutput, sizeof(gpsOutput), "Tiles/%d/%d/%d.png", ZOOM_LEVEL, tilex-1, tiley-1);
-	gdispImageOpenFile(&myImage[0], gpsOutput);
-	gdispImageDraw(&myImage[0], leftX, topY, xShowMap, yShowMap, xTileStartOffset, yTileStartOffset);
-	gdispImageClose(&myImage[0]);
-	//gdispImageCache(&myImage[0]);
-	
-	// X9
-	formatString(gpsOutput, sizeof(gpsOutput), "Tiles/%d/%d/%d.png", ZOOM_LEVEL, tilex-1, tiley);
-	gdispImageOpenFile(&myImage[1], gpsOutput);
-	gdispImageDraw(&myImage[1], leftX, middleY, xShowMap, 256, xTileStartOffset, 0);
-	gdispImageClose(&myImage[1]);
-	//gdispImageCache(&myImage[1]);
-	
-	// X10
-	formatString(gpsOutput, sizeof(gpsOutput), "Tiles/%d/%d/%d.png", ZOOM_LEVEL, tilex-1, tiley+1);
-	gdispImageOpenFile(&myImage[2], gpsOutput);
-	gdispImageDraw(&myImage[2], leftX, bottomY, xShowMap, yTileStartOffset, xTileStartOffset, 0);
-	gdispImageClose(&myImage[2]);
-	//gdispImageCache(&myImage[2]);
-	
-	// X5
-	formatString(gpsOutput, sizeof(gpsOutput), "Tiles/%d/%d/%d.png", ZOOM_LEVEL, tilex, tiley-1);
-	gdispImageOpenFile(&myImage[3], gpsOutput);
-	gdispImageDraw(&myImage[3], centerX, topY, 256, yShowMap, 0, yTileStartOffset);
-	gdispImageClose(&myImage[3]);
-	//gdispImageCache(&myImage[3]);
-	
-	// X1
-	formatString(gpsOutput, sizeof(gpsOutput), "Tiles/%d/%d/%d.png", ZOOM_LEVEL, tilex, tiley);
-	gdispImageOpenFile(&myImage[4], gpsOutput);
-	gdispImageDraw(&myImage[4], centerX, middleY, 256, 256, 0, 0);
-	gdispImageClose(&myImage[4]);
-	//gdispImageCache(&myImage[4]);
-	
-	// X2
-	formatString(gpsOutput, sizeof(gpsOutput), "Tiles/%d/%d/%d.png", ZOOM_LEVEL, tilex, tiley+1);
-	gdispImageOpenFile(&myImage[5], gpsOutput);
-	gdispImageDraw(&myImage[5], centerX, bottomY, 256, yTileStartOffset, 0, 0);
-	gdispImageClose(&myImage[5]);
-	//gdispImageCache(&myImage[5]);
-	
-	// X7
-	formatString(gpsOutput, sizeof(gpsOutput), "Tiles/%d/%d/%d.png", ZOOM_LEVEL, tilex+1, tiley-1);
-	gdispImageOpenFile(&myImage[6], gpsOutput);
-	gdispImageDraw(&myImage[6], rightX, topY, xTileStartOffset, yShowMap, 0, yTileStartOffset);
-	gdispImageClose(&myImage[6]);
-	//gdispImageCache(&myImage[6]);
-
-	// X3
-	formatString(gpsOutput, sizeof(gpsOutput), "Tiles/%d/%d/%d.png", ZOOM_LEVEL, tilex+1, tiley);
-	gdispImageOpenFile(&myImage[7], gpsOutput);
-	gdispImageDraw(&myImage[7], rightX, middleY, xTileStartOffset, gdispGetHeight(), 0, 0);
-	gdispImageClose(&myImage[7]);
-	//gdispImageCache(&myImage[7]);
-	
-	// X4
-	formatString(gpsOutput, sizeof(gpsOutput), "Tiles/%d/%d/%d.png", ZOOM_LEVEL, tilex+1, tiley+1);
-	gdispImageOpenFile(&myImage[8], gpsOutput);
-	gdispImageDraw(&myImage[8], rightX, bottomY, xTileStartOffset, yTileStartOffset, 0, 0);
-	gdispImageClose(&myImage[8]);
-	//gdispImageCache(&myImage[8]);
-	
-	gdispImageOpenFile(&marker, "Tiles/marker32.png");
+	proj_world_t origin;
+	origin.x = ((uint32_t)tilex << PROJ_TILE_SHIFT(mapZoom)) + ((uint32_t)tilexOffset << PROJ_PIXEL_SHIFT(mapZoom));
+	origin.y = ((uint32_t)tiley << PROJ_TILE_SHIFT(mapZoom)) + ((uint32_t)tileyOffset << PROJ_PIXEL_SHIFT(mapZoom));
+	
+	if(!gdispImageIsOpen(&marker)){
+		gdispImageOpenFile(&marker, "Tiles/marker32.png");
+		gdispImageCache(&marker);
+	}
+	
+	// Vector map when converted tiles are on SD card, heading-up map turns about marker
+	// Tiles not yet loaded at this zoom are left out or scaled from cached neighbours, next draws load them
+	if(vmapAvailable()){
+		mapPending = !vmapDraw(&origin, mapZoom, mapRotation, MAP_CENTERX, MAP_CENTERY, leftX, topY, gdispGetWidth()-leftX, gdispGetHeight());
+	}else{
+		mapPending = !tilesDraw(&origin, mapZoom, mapRotation, MAP_CENTERX, MAP_CENTERY, leftX, topY, gdispGetWidth()-leftX, gdispGetHeight());
+	}
+	
+	// Track goes over tiles and under marker
+	trackSetView(&origin, mapZoom, mapRotation, MAP_CENTERX, MAP_CENTERY, leftX, topY, gdispGetWidth()-leftX, gdispGetHeight());
+	trackDraw();
+	
 	gdispImageDraw(&marker, MAP_CENTERX-16, MAP_CENTERY-32, gdispGetWidth(), gdispGetHeight(), 0, 0);
-	gdispImageCache(&marker);
-	//gdispImageClose(&marker);
 	
 	status = osMutexRelease(traceMutex);
 	if (status != osOK)  {
@@ -2163,44 +2201,74 @@ void newGPSData(){
 	int tiley;
 	int tilexOffset;
 	int tileyOffset;
-	
-	gpsData = getGPS();	
+	int32_t latE7;
+	int32_t lonE7;
+	int16_t rotation;
+	int16_t turn;
+	fusion_estimate_t estimate;
+	
+	// Fused estimate keeps moving between fixes and through short GPS outages
+	fusionGetEstimate(&estimate);
+	gpsData.Validity = estimate.Valid;
+	latE7 = estimate.LatitudeE7;
+	lonE7 = estimate.LongitudeE7;
 #ifdef MAP_TILE_TEST_CANAL
 	gpsData.Validity = true;
-	gpsData.Latitude = 45.384365;
-	gpsData.Longitude = -75.698600;
+	latE7 = 453843650;
+	lonE7 = -756986000;
 #endif
 #ifdef MAP_TILE_TEST_MAYTHAM
 	gpsData.Validity = true;
-	gpsData.Latitude = 45.378962;
-	gpsData.Longitude = -75.667347;
+	latE7 = 453789620;
+	lonE7 = -756673470;
 #endif
 #ifdef MAP_TILE_TEST_JON
 	gpsData.Validity = true;
-	gpsData.Latitude = 45.409269;
-	gpsData.Longitude = -75.706862;
+	latE7 = 454092690;
+	lonE7 = -757068620;
 #endif
+	gpsData.Latitude = latE7 * 0.0000001f;
+	gpsData.Longitude = lonE7 * 0.0000001f;
 	if(!gpsData.Validity){
-		if(RTCD.Seconds != previousSeconds){
-			formatString(gpsOutput, sizeof(gpsOutput),"GPS Data is Invalid");
-			//TRACE("GPS Data is Invalid\n");
-			gwinSetText(labels[5], gpsOutput, TRUE);
-			previousSeconds = RTCD.Seconds;
+		// Message covers map until estimate is valid again, then map is drawn in full
+		if(!gwinGetVisible(labels[5])){
+			gwinShow(labels[5]);
 		}
+		gwinSetText(labels[5], "GPS Data is Invalid", TRUE);
 	}else{
-		if(RTCD.Seconds != previousSeconds){
-			gwinHide(labels[3]);
-			tilex = long2tilex(gpsData.Longitude, ZOOM_LEVEL, &tilexOffset);
-			tiley = lat2tiley(gpsData.Latitude, ZOOM_LEVEL, &tileyOffset);
-			TRACE("Zoom=%d,TileX=%d,TileY=%d\n", ZOOM_LEVEL, tilex, tiley);
-			if((tilex != oldtilex) && (tiley != oldtiley)){
-				drawTile(tilex, tiley, tilexOffset, tileyOffset);
-				oldtilex=tilex;
-				oldtiley=tiley;
-				oldtilexOffset=tilexOffset;
-				oldtileyOffset=tileyOffset;
-			}
-			previousSeconds = RTCD.Seconds;
+		if(gwinGetVisible(labels[5])){
+			gwinHide(labels[5]);
+			mapPending = true;
+		}
+		tilex = long2tilex(lonE7, mapZoom, &tilexOffset);
+		tiley = lat2tiley(latE7, mapZoom, &tileyOffset);
+		// Heading-up map is turned again only after heading changes by more than threshold
+		rotation = mapHeadingUp ? estimate.HeadingE2 / 100 : 0;
+		turn = rotation - mapRotation;
+		if(turn > 180){
+			turn -= 360;
+		}else if(turn < -180){
+			turn += 360;
+		}
+		if(turn > MAP_HEADING_THRESHOLD || turn < -MAP_HEADING_THRESHOLD || (!mapHeadingUp && mapRotation != 0)){
+			mapRotation = rotation;
+			mapPending = true;
+		}
+		if((tilex != oldtilex) || (tiley != oldtiley) || (mapZoom != oldMapZoom)){
+			TRACE("Zoom=%d,TileX=%d,TileY=%d\n", mapZoom, tilex, tiley);
+		}
+		// Map is centred on marker, so it is drawn again whenever marker moves by a pixel
+		if((tilex != oldtilex) || (tiley != oldtiley) || (mapZoom != oldMapZoom) ||
+			(tilexOffset != oldtilexOffset) || (tileyOffset != oldtileyOffset) || mapPending){
+			drawTile(tilex, tiley, tilexOffset, tileyOffset);
+			oldtilex=tilex;
+			oldtiley=tiley;
+			oldMapZoom=mapZoom;
+			oldtilexOffset=tilexOffset;
+			oldtileyOffset=tileyOffset;
+		}else if(trackDrawNew()){
+			// Newest track segment ends under marker
+			gdispImageDraw(&marker, MAP_CENTERX-16, MAP_CENTERY-32, gdispGetWidth(), gdispGetHeight(), 0, 0);
 		}
 	}
 }
\ No newline at end of file
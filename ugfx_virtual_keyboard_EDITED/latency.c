@@ -0,0 +1,71 @@
+#include "latency.h"
+#include "gfx.h"
+#include "stm32f4xx.h"
+#include <string.h>
+
+static volatile uint32_t irqTime;
+static volatile bool_t irqPending;
+static uint32_t start;
+static uint32_t stage[LATENCY_STAGES];
+static bool_t tracing;
+static latency_stats_t stats;
+
+static uint32_t latencyUS(uint32_t from, uint32_t to){
+	return (to - from) / (SystemCoreClock / 1000000);
+}
+
+void latencyInit(void){
+	// Cycle counter times the stages
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+void latencyMark(latency_stage_t s){
+	uint32_t now = DWT->CYCCNT;
+	unsigned i;
+
+	switch(s){
+	case LATENCY_IRQ:
+		// Only the latest interrupt before a read counts, the controller interrupts for every report
+		irqTime = now;
+		irqPending = TRUE;
+		stats.Interrupts++;
+		return;
+	case LATENCY_READ:
+		stats.Reads++;
+		if(irqPending){
+			irqPending = FALSE;
+			start = irqTime;
+		}else{
+			stats.PolledReads++;
+			start = now;
+		}
+		stage[LATENCY_IRQ] = start;
+		stage[LATENCY_READ] = now;
+		tracing = TRUE;
+		return;
+	case LATENCY_CALLBACK:
+		stage[LATENCY_CALLBACK] = now;
+		return;
+	case LATENCY_DRAWN:
+		// The trace belongs to the last read, further events from it are not traced again
+		if(!tracing)
+			return;
+		tracing = FALSE;
+		stage[LATENCY_DRAWN] = now;
+		stats.Traces++;
+		for(i = 0; i < LATENCY_STAGES; i++){
+			stats.LastUS[i] = latencyUS(start, stage[i]);
+			stats.TotalUS[i] += stats.LastUS[i];
+			if(stats.LastUS[i] > stats.MaxUS[i])
+				stats.MaxUS[i] = stats.LastUS[i];
+		}
+		return;
+	default:
+		return;
+	}
+}
+
+void latencyGetStats(latency_stats_t *s){
+	memcpy(s, &stats, sizeof(stats));
+}
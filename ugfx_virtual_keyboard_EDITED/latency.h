@@ -0,0 +1,32 @@
+#ifndef _LATENCY_H_
+#define _LATENCY_H_
+
+#include <stdint.h>
+
+// Time from a touch to the screen showing its result. A trace starts at the touch controller
+// interrupt, or at the reading itself when the reading came from polling (a release is
+// usually seen that way), and ends when the button callback has returned. Redraws are
+// immediate so by then the pixels are in the frame buffer.
+typedef enum {
+	LATENCY_IRQ,							// Touch controller interrupt, from interrupt context
+	LATENCY_READ,							// Touch position read over I2C
+	LATENCY_CALLBACK,					// Button callback started
+	LATENCY_DRAWN,						// Button callback returned
+	LATENCY_STAGES
+} latency_stage_t;
+
+typedef struct {
+	uint32_t Interrupts;
+	uint32_t Reads;
+	uint32_t PolledReads;				// Reads with no interrupt since the previous read
+	uint32_t Traces;						// Traces that got to LATENCY_DRAWN
+	uint32_t LastUS[LATENCY_STAGES];	// Time from the start of the last trace to each stage
+	uint32_t MaxUS[LATENCY_STAGES];
+	uint32_t TotalUS[LATENCY_STAGES];	// Divide by Traces for the average
+} latency_stats_t;
+
+void latencyInit(void);
+void latencyMark(latency_stage_t stage);
+void latencyGetStats(latency_stats_t *stats);
+
+#endif /* _LATENCY_H_ */
@@ -12,6 +12,15 @@
 #include "spi.h"
 #include "tm_stm32_spi.h"
 #include "msg.h"
+#include "latency.h"
+#include "fusion.h"
+#include "projection.h"
+#include "track.h"
+#include "route.h"
+#include "tiles.h"
+#include "vmap.h"
+#include "sdram.h"
+#include "boot.h"
 
 #ifdef RTE_CMSIS_RTOS_RTX
 extern uint32_t os_time;
@@ -143,8 +152,18 @@ void gpsThread (void const *arg)
 }
 osThreadDef (gpsThread, osPriorityNormal, 1, 0);            // define gpsThread
 
-osPoolDef(mpool, 32, message_t);
-osPoolId mpool;
+void fusionThread (void const *arg)
+{
+	runFusion();
+}
+osThreadDef (fusionThread, osPriorityAboveNormal, 1, 0);     // define fusionThread
+
+void bootThread (void const *arg)
+{
+	runBoot();
+	osThreadTerminate(osThreadGetId());
+}
+osThreadDef (bootThread, osPriorityNormal, 1, 0);            // define bootThread, same priority as GUI so both progress
 
 int main (void)
 {			
@@ -153,13 +172,32 @@ int main (void)
 	// Cached enabled in stm32f4xx_hal_conf.h
     // CPU_CACHE_Enable();			// Enable the CPU Cache
     
+	TM_DELAY_Init();			// Start the cycle counter, it times the boot and delays
+	bootMark(BOOT_START);
 	HAL_Init();					// Initialize the HAL Library
 	BSP_SDRAM_Init();			// Initialize BSP SDRAM
+	bootMark(BOOT_SDRAM);
 	SystemClock_Config();		// Configure the System Clock
+	bootMark(BOOT_CLOCK);
         
 	osKernelInitialize();		// Initialize the KEIL RTX operating system
 	osKernelStart();			// Start the scheduler
+	bootMark(BOOT_RTOS);
 	gfxInit();					// Initialize the uGFX library
+	gfileCacheInit((void *)SDRAM_GFILE_CACHE_ADDR, SDRAM_GFILE_CACHE_SIZE);	// SD card reads go through block cache in SDRAM
+	gfileRamfsInit((void *)SDRAM_RAMFS_ADDR, SDRAM_RAMFS_SIZE);	// Map files are copied into SDRAM on first open
+	gfileMount('R', TILES_DIR "/");
+	gfileMount('R', VMAP_DIR "/");
+	bootMark(BOOT_GFX);
+	
+	osMutexDef (MutexIsr);
+	traceMutex = osMutexCreate  (osMutex (MutexIsr));
+  if (traceMutex != NULL)  {
+    // Mutex object created
+  }
+	
+	routeInit();
+	bootThreadID = osThreadCreate (osThread (bootThread), NULL);	// RTC, SD card and route come up while the first frame is drawn
 	
 	geventListenerInit(&glistener);
 	gwinAttachListener(&glistener);
@@ -173,27 +211,18 @@ int main (void)
 	TM_USART_Puts(USART3, "UART PC Output\n");
 #endif
 	
-	/* Init RTC */
-	if (TM_RTC_Init(TM_RTC_ClockSource_External)) {
-			/* RTC was already initialized and time is running */
-			/* No need to set clock now */
-	} else {
-			/* RTC was now initialized */
-			/* If you need to set new time, now is the time to do it */
-	}
-
-	osMutexDef (MutexIsr);
-	traceMutex = osMutexCreate  (osMutex (MutexIsr));
-  if (traceMutex != NULL)  {
-    // Mutex object created
-  }
-	
-	mpool = osPoolCreate(osPool(mpool));
+	msgInit();
+	latencyInit();
+	fusionInit();
+	projInit();
+	trackInit();
+	tilesInit();
+	vmapInit();
   
-	osThreadId spiThreadID;
-	//osThreadId gpsThreadID;
-	spiThreadID = osThreadCreate (osThread (spiThread), NULL);
-	//gpsThreadID = osThreadCreate (osThread (gpsThread), NULL);
+	osThreadCreate (osThread (spiThread), NULL);
+	osThreadCreate (osThread (gpsThread), NULL);					// Takes its own ID for the sentence signal
+	osThreadCreate (osThread (fusionThread), NULL);
+	bootMark(BOOT_THREADS);
 	
 	guiEventLoop();
 }
@@ -8209,7 +8209,7 @@ static const char maptile_bmp[] = {
 };
 
 #ifdef ROMFS_DIRENTRY_HEAD
-	static const ROMFS_DIRENTRY maptile_bmp_dir = { 0, 0, ROMFS_DIRENTRY_HEAD, "maptile_bmp.bmp", 131210, maptile_bmp };
+	static const ROMFS_DIRENTRY maptile_bmp_dir = { 0, 0, ROMFS_DIRENTRY_HEAD, "maptile_bmp.bmp", 131210, maptile_bmp, 0x3D1EB6A8 };
 	#undef ROMFS_DIRENTRY_HEAD
 	#define ROMFS_DIRENTRY_HEAD &maptile_bmp_dir
 #endif
@@ -0,0 +1,244 @@
+#include "msg.h"
+#include <string.h>
+
+// A ring entry is one word: channel index, inline value, payload block index
+#define MSG_WORD(chan, value, block)		((void *)(uintptr_t)((chan) | ((uint32_t)(value) << 8) | ((uint32_t)(block) << 16)))
+#define MSG_CHAN(w)							((uint32_t)(uintptr_t)(w) & 0xFF)
+#define MSG_VALUE(w)						(((uint32_t)(uintptr_t)(w) >> 8) & 0xFF)
+#define MSG_BLOCK(w)						(((uint32_t)(uintptr_t)(w) >> 16) & 0xFF)
+
+typedef struct {
+	uint8_t id;
+	uint8_t policy;							// msg_policy_t
+	uint16_t size;							// Payload block size, 0 when the value travels inline
+} msg_type_t;
+
+typedef struct {
+	const msg_type_t *type;
+	volatile bool pending;			// Coalesced message is waiting in the ring
+	volatile uint8_t value;			// Latest value of a coalesced message
+	uint8_t *pool;
+	gfxQueueRing free;					// Payload blocks not in use, got by the sender and put back by the receiver
+	gfxQueueRingSlot freeSlots[MSG_POOL_BLOCKS];
+	msg_stats_t stats;
+} msg_chan_t;
+
+typedef struct {
+	const msg_type_t *types;
+	uint8_t count;
+	msg_chan_t *chans;
+	gfxQueueRing ring;
+	gfxQueueRingSlot slots[MSG_QUEUE_SIZE];
+} msg_box_t;
+
+// Requests polled every second are coalesced so a slow nRF link never builds a backlog of them,
+// user actions block briefly rather than getting lost
+static const msg_type_t toSPI[] = {
+	{ GET_AVAILABILITY_MSG,			MSG_COALESCE,	0 },
+	{ GET_SPEED_MSG,						MSG_COALESCE,	0 },
+	{ GET_CADENCE_MSG,					MSG_COALESCE,	0 },
+	{ GET_DISTANCE_MSG,					MSG_COALESCE,	0 },
+	{ GET_HEARTRATE_MSG,				MSG_COALESCE,	0 },
+	{ GET_CADENCE_SETPOINT_MSG,	MSG_COALESCE,	0 },
+	{ GET_BATTERY_MSG,					MSG_COALESCE,	0 },
+	{ GET_GEAR_COUNT_MSG,				MSG_COALESCE,	0 },
+	{ SET_GEAR_COUNT_MSG,				MSG_BLOCK,		sizeof(msg_gears_t) },
+	{ NRF_SCAN_MSG,							MSG_COALESCE,	0 },
+	{ NRF_CONNECT_MSG,					MSG_BLOCK,		0 },
+	{ NRF_FORGET_MSG,						MSG_BLOCK,		0 },
+};
+
+// Readings only matter at their latest value
+static const msg_type_t toGUI[] = {
+	{ GET_SPEED_MSG,						MSG_COALESCE,	0 },
+	{ GET_CADENCE_MSG,					MSG_COALESCE,	0 },
+	{ GET_DISTANCE_MSG,					MSG_COALESCE,	0 },
+	{ GET_HEARTRATE_MSG,				MSG_COALESCE,	0 },
+	{ GET_CADENCE_SETPOINT_MSG,	MSG_COALESCE,	0 },
+	{ GET_BATTERY_MSG,					MSG_COALESCE,	0 },
+	{ GET_GEAR_COUNT_MSG,				MSG_REJECT,		sizeof(msg_gears_t) },
+	{ NRF_SCAN_MSG,							MSG_REJECT,		sizeof(msg_devices_t) },
+};
+
+#define COUNT_OF(a)		(sizeof(a) / sizeof((a)[0]))
+
+static msg_chan_t spiChans[COUNT_OF(toSPI)];
+static msg_chan_t guiChans[COUNT_OF(toGUI)];
+// The ring and its slots are set up by msgInit()
+static msg_box_t boxes[MSG_DESTS] = {
+	[MSG_TO_SPI] = { .types = toSPI, .count = COUNT_OF(toSPI), .chans = spiChans },
+	[MSG_TO_GUI] = { .types = toGUI, .count = COUNT_OF(toGUI), .chans = guiChans },
+};
+
+static unsigned msgFind(msg_box_t *box, uint8_t id);
+static bool msgPut(msg_box_t *box, unsigned chan, void *word, bool isr);
+
+void msgInit(void){
+	msg_box_t *box;
+	msg_chan_t *c;
+	void *block;
+	unsigned i, b;
+
+	for(box = boxes; box < &boxes[MSG_DESTS]; box++){
+		gfxQueueRingInit(&box->ring, box->slots, MSG_QUEUE_SIZE, TRUE);
+		for(i = 0; i < box->count; i++){
+			c = &box->chans[i];
+			c->type = &box->types[i];
+			if(!c->type->size){
+				continue;
+			}
+			gfxQueueRingInit(&c->free, c->freeSlots, MSG_POOL_BLOCKS, TRUE);
+			c->pool = gfxAlloc(c->type->size * MSG_POOL_BLOCKS);
+			for(b = 0; c->pool && b < MSG_POOL_BLOCKS; b++){
+				block = c->pool + b * c->type->size;
+				gfxQueueRingPut(&c->free, &block, 1);
+			}
+		}
+	}
+}
+
+static unsigned msgFind(msg_box_t *box, uint8_t id){
+	unsigned i;
+
+	for(i = 0; i < box->count && box->types[i].id != id; i++);
+	return i;
+}
+
+static bool msgPut(msg_box_t *box, unsigned chan, void *word, bool isr){
+	msg_chan_t *c = &box->chans[chan];
+	uint32_t waited;
+
+	if(isr ? gfxQueueRingPutI(&box->ring, &word, 1) : gfxQueueRingPut(&box->ring, &word, 1)){
+		c->stats.Sent++;
+		return true;
+	}
+	if(c->type->policy == MSG_BLOCK && !isr){
+		c->stats.Blocked++;
+		for(waited = 0; waited < MSG_BLOCK_MS; waited++){
+			gfxSleepMilliseconds(1);
+			if(gfxQueueRingPut(&box->ring, &word, 1)){
+				c->stats.Sent++;
+				return true;
+			}
+		}
+	}
+	c->stats.Rejected++;
+	return false;
+}
+
+static bool msgSendValue(msg_dest_t to, uint8_t id, uint8_t value, bool isr){
+	msg_box_t *box = &boxes[to];
+	msg_chan_t *c;
+	unsigned chan;
+
+	if((chan = msgFind(box, id)) >= box->count || box->types[chan].size){
+		return false;
+	}
+	c = &box->chans[chan];
+	if(c->type->policy == MSG_COALESCE){
+		c->value = value;
+		if(c->pending){
+			c->stats.Coalesced++;
+			return true;
+		}
+		c->pending = true;
+		if(!msgPut(box, chan, MSG_WORD(chan, 0, 0), isr)){
+			c->pending = false;
+			return false;
+		}
+		return true;
+	}
+	return msgPut(box, chan, MSG_WORD(chan, value, 0), isr);
+}
+
+bool msgSend(msg_dest_t to, uint8_t id, uint8_t value){
+	return msgSendValue(to, id, value, false);
+}
+
+// From interrupt routines, never waits
+bool msgSendI(msg_dest_t to, uint8_t id, uint8_t value){
+	return msgSendValue(to, id, value, true);
+}
+
+// Payload block for a message that travels by reference, NULL when the pool is empty
+void *msgAlloc(msg_dest_t to, uint8_t id){
+	msg_box_t *box = &boxes[to];
+	msg_chan_t *c;
+	unsigned chan;
+	void *block;
+
+	if((chan = msgFind(box, id)) >= box->count || !box->types[chan].size){
+		return NULL;
+	}
+	c = &box->chans[chan];
+	if(!gfxQueueRingGet(&c->free, &block, 1, TIME_IMMEDIATE)){
+		c->stats.Rejected++;
+		return NULL;
+	}
+	return block;
+}
+
+// Ownership of payload passes to the receiver, or back to the pool if it is not sent
+bool msgSendPayload(msg_dest_t to, uint8_t id, void *payload){
+	msg_box_t *box = &boxes[to];
+	msg_chan_t *c;
+	unsigned chan;
+
+	if(!payload || (chan = msgFind(box, id)) >= box->count || !box->types[chan].size){
+		return false;
+	}
+	c = &box->chans[chan];
+	if(msgPut(box, chan, MSG_WORD(chan, 0, ((uint8_t *)payload - c->pool) / c->type->size), false)){
+		return true;
+	}
+	gfxQueueRingPut(&c->free, &payload, 1);
+	return false;
+}
+
+bool msgReceive(msg_dest_t to, msg_t *msg, delaytime_t ms){
+	msg_box_t *box = &boxes[to];
+	msg_chan_t *c;
+	void *word;
+
+	if(!gfxQueueRingGet(&box->ring, &word, 1, ms)){
+		return false;
+	}
+	c = &box->chans[MSG_CHAN(word)];
+	msg->id = c->type->id;
+	if(c->type->policy == MSG_COALESCE){
+		// Cleared before the value is read so a send from now on queues again
+		c->pending = false;
+		msg->value = c->value;
+	}else{
+		msg->value = MSG_VALUE(word);
+	}
+	msg->payload = c->type->size ? c->pool + MSG_BLOCK(word) * c->type->size : NULL;
+	c->stats.Received++;
+	return true;
+}
+
+void msgRelease(msg_dest_t to, msg_t *msg){
+	msg_box_t *box = &boxes[to];
+	unsigned chan;
+
+	if(!msg->payload || (chan = msgFind(box, msg->id)) >= box->count){
+		return;
+	}
+	gfxQueueRingPut(&box->chans[chan].free, &msg->payload, 1);
+	msg->payload = NULL;
+}
+
+bool msgGetStats(msg_dest_t to, uint8_t id, msg_stats_t *stats){
+	msg_box_t *box = &boxes[to];
+	unsigned chan;
+
+	if((chan = msgFind(box, id)) >= box->count){
+		return false;
+	}
+	*stats = box->chans[chan].stats;
+	return true;
+}
+
+void msgGetQueueStats(msg_dest_t to, gfxQueueRingStats *stats){
+	gfxQueueRingGetStats(&boxes[to].ring, stats);
+}
@@ -1,6 +1,11 @@
 #ifndef _MSG_H_
 #define _MSG_H_
 
+#include <stdbool.h>
+#include <stdint.h>
+#include "gfx.h"
+#include "gui.h"
+
 //#define DEBUG
 
 #define INVALID_DATA 0xFF
@@ -37,17 +42,63 @@
 
 #define MAXIMUM_BLUETOOTH					0x0A
 
+// GUI and SPI threads talk over typed channels. Each receiver has a lock free ring of
+// small messages, one byte values travel inline. Gear tables and device lists travel by
+// reference in blocks from a pool per message type, the receiver owns a block until
+// msgRelease. Each message type has its own back-pressure policy, see msg.c.
+#define MSG_QUEUE_SIZE						32					// Messages waiting per receiver, power of two
+#define MSG_POOL_BLOCKS						2						// Payload blocks per message type
+#define MSG_BLOCK_MS							100					// Longest a blocking send waits for room
+
+typedef enum {
+	MSG_TO_SPI,
+	MSG_TO_GUI,
+	MSG_DESTS
+} msg_dest_t;
+
+typedef enum {
+	MSG_REJECT,										// Drop the message when the queue or pool is full
+	MSG_COALESCE,									// One waiting at a time, a new send only updates its value
+	MSG_BLOCK											// Wait up to MSG_BLOCK_MS for room
+} msg_policy_t;
+
 typedef struct {
-  uint8_t msg_ID;
+	uint8_t id;
 	uint8_t value;
+	void *payload;								// Owned by the receiver until msgRelease, NULL for inline messages
+} msg_t;
+
+// SET_GEAR_COUNT_MSG to SPI, GET_GEAR_COUNT_MSG to GUI
+typedef struct {
 	uint8_t frontGears[MAXIMUM_FRONT_GEARS+1];
 	uint8_t backGears[MAXIMUM_BACK_GEARS+1];
-} message_t;
+} msg_gears_t;
+
+// NRF_SCAN_MSG to GUI
+typedef struct {
+	uint8_t count;
+	uint8_t mac[MAXIMUM_BLUETOOTH][6];
+} msg_devices_t;
 
-extern osPoolId mpool;
-extern osMessageQId  spiQueue;
-extern osMessageQId  guiQueue;
+// Per message counters for tuning, approximate: msgSendI() and the threads increment them without
+// locking, so a count can be lost when an interrupt lands in the middle of a thread's increment.
+// msgGetQueueStats() totals are kept atomically.
+typedef struct {
+	uint32_t Sent;								// Messages put in the receiver's queue
+	uint32_t Received;
+	uint32_t Coalesced;						// Sends folded into a message already waiting
+	uint32_t Rejected;						// Sends dropped because the queue or payload pool was full
+	uint32_t Blocked;							// Sends that had to wait for room
+} msg_stats_t;
 
-extern uint8_t devicesMAC[10][6];
+void msgInit(void);
+bool msgSend(msg_dest_t to, uint8_t id, uint8_t value);
+bool msgSendI(msg_dest_t to, uint8_t id, uint8_t value);
+void *msgAlloc(msg_dest_t to, uint8_t id);
+bool msgSendPayload(msg_dest_t to, uint8_t id, void *payload);
+bool msgReceive(msg_dest_t to, msg_t *msg, delaytime_t ms);
+void msgRelease(msg_dest_t to, msg_t *msg);
+bool msgGetStats(msg_dest_t to, uint8_t id, msg_stats_t *stats);
+void msgGetQueueStats(msg_dest_t to, gfxQueueRingStats *stats);
 
 #endif /* _MSG_H_ */
@@ -0,0 +1,144 @@
+#include "projection.h"
+#include <math.h>
+
+// Mercator y is tabulated every 1/16 degree of latitude and interpolated with a quadratic,
+// which keeps error well below one pixel at z18 for latitudes where people ride bicycles
+#define PROJ_STEP_E7				625000
+#define PROJ_TABLE_SIZE				(2 * PROJ_MAX_LATITUDE_E7 / PROJ_STEP_E7 + 1)
+#define PROJ_T_SCALE				1801439851u		// 2^50 / PROJ_STEP_E7, remainder to Q30 fraction
+#define PROJ_X_SCALE				2562047788u		// 2^63 / 3600000000, longitude to world x in Q31
+#define PROJ_HALF					0x80000000u
+#define PROJ_ONE_Q30				(1 << 30)
+
+#ifndef M_PI
+#define M_PI						3.14159265358979323846
+#endif
+
+// World y minus 2^31, so whole range fits into int32
+static int32_t mercatorTable[PROJ_TABLE_SIZE];
+
+static inline uint32_t projLongitude(int32_t lonE7);
+static inline uint32_t projLatitude(int32_t latE7);
+
+void projInit(){
+	double lat, y;
+	int i;
+
+	for(i = 0; i < PROJ_TABLE_SIZE; i++){
+		lat = (-PROJ_MAX_LATITUDE_E7 + (double)i * PROJ_STEP_E7) * (M_PI / 1800000000.0);
+		y = (0.5 - log(tan(M_PI / 4.0 + lat / 2.0)) / (2.0 * M_PI)) * 4294967296.0 - 2147483648.0;
+		if(y > 2147483647.0){
+			y = 2147483647.0;
+		}else if(y < -2147483648.0){
+			y = -2147483648.0;
+		}
+		mercatorTable[i] = (int32_t)floor(y + 0.5);
+	}
+}
+
+void projToWorld(int32_t latE7, int32_t lonE7, proj_world_t *world){
+	world->x = projLongitude(lonE7);
+	world->y = projLatitude(latE7);
+}
+
+void projToLatLon(const proj_world_t *world, proj_latlon_t *latlon){
+	int64_t y = (int64_t)world->y - PROJ_HALF;
+	int64_t lat, err, step;
+	int lo = 0, hi = PROJ_TABLE_SIZE - 1, mid;
+
+	// Arithmetic is done in 64 bits, results fit int32 once they are in range
+	latlon->LongitudeE7 = (int32_t)((int64_t)(((uint64_t)world->x * 3600000000u) >> 32) - 1800000000);
+
+	// Table is decreasing, find mercatorTable[lo] >= y > mercatorTable[lo + 1]
+	if(y >= mercatorTable[0]){
+		latlon->LatitudeE7 = -PROJ_MAX_LATITUDE_E7;
+		return;
+	}
+	if(y <= mercatorTable[PROJ_TABLE_SIZE - 1]){
+		lo = PROJ_TABLE_SIZE - 2;
+	}
+	while(hi - lo > 1){
+		mid = (lo + hi) / 2;
+		if(mercatorTable[mid] >= y){
+			lo = mid;
+		}else{
+			hi = mid;
+		}
+	}
+
+	// Linear guess, then one Newton step on the interpolated curve
+	step = (int64_t)mercatorTable[lo] - mercatorTable[lo + 1];
+	lat = -PROJ_MAX_LATITUDE_E7 + (int64_t)lo * PROJ_STEP_E7 + (mercatorTable[lo] - y) * PROJ_STEP_E7 / step;
+	if(lat > PROJ_MAX_LATITUDE_E7){
+		lat = PROJ_MAX_LATITUDE_E7;
+	}
+	err = ((int64_t)projLatitude((int32_t)lat) - PROJ_HALF) - y;
+	lat += err * PROJ_STEP_E7 / step;
+	if(lat > PROJ_MAX_LATITUDE_E7){
+		lat = PROJ_MAX_LATITUDE_E7;
+	}else if(lat < -PROJ_MAX_LATITUDE_E7){
+		lat = -PROJ_MAX_LATITUDE_E7;
+	}
+	latlon->LatitudeE7 = (int32_t)lat;
+}
+
+void projToWorldBatch(const proj_latlon_t *in, proj_world_t *out, uint32_t count){
+	while(count--){
+		out->x = projLongitude(in->LongitudeE7);
+		out->y = projLatitude(in->LatitudeE7);
+		in++;
+		out++;
+	}
+}
+
+void projToScreenBatch(const proj_world_t *in, proj_screen_t *out, uint32_t count, const proj_world_t *origin, uint8_t zoom, coord_t centerX, coord_t centerY){
+	uint8_t shift = PROJ_PIXEL_SHIFT(zoom);
+	uint32_t ox = origin->x;
+	uint32_t oy = origin->y;
+
+	// Differences wrap correctly around the antimeridian, so they are taken in signed 32 bits,
+	// below PROJ_MAX_ZOOM they are shifted down far enough that adding the center can not overflow
+	while(count--){
+		out->x = centerX + ((int32_t)(in->x - ox) >> shift);
+		out->y = centerY + ((int32_t)(in->y - oy) >> shift);
+		in++;
+		out++;
+	}
+}
+
+static inline uint32_t projLongitude(int32_t lonE7){
+	return (uint32_t)(((uint64_t)((uint32_t)lonE7 + 1800000000u) * PROJ_X_SCALE) >> 31);
+}
+
+static inline uint32_t projLatitude(int32_t latE7){
+	uint32_t pos, idx;
+	int64_t t, u, y0, d1, d2, y;
+
+	if(latE7 > PROJ_MAX_LATITUDE_E7){
+		latE7 = PROJ_MAX_LATITUDE_E7;
+	}else if(latE7 < -PROJ_MAX_LATITUDE_E7){
+		latE7 = -PROJ_MAX_LATITUDE_E7;
+	}
+
+	// Table index and Q30 fraction between entries, last interval reuses previous three entries
+	pos = (uint32_t)(latE7 + PROJ_MAX_LATITUDE_E7);
+	idx = pos / PROJ_STEP_E7;
+	if(idx > PROJ_TABLE_SIZE - 3){
+		idx = PROJ_TABLE_SIZE - 3;
+	}
+	t = (int64_t)(((uint64_t)(pos - idx * PROJ_STEP_E7) * PROJ_T_SCALE) >> 20);
+	u = (t * (PROJ_ONE_Q30 - t)) >> 30;
+
+	// Quadratic through three entries: y0 + t*d1 - t*(1-t)/2*d2
+	y0 = mercatorTable[idx];
+	d1 = mercatorTable[idx + 1] - y0;
+	d2 = mercatorTable[idx + 2] - 2 * (int64_t)mercatorTable[idx + 1] + y0;
+	y = y0 + ((d1 * t) >> 30) - ((d2 * u) >> 31);
+
+	if(y > 2147483647){
+		y = 2147483647;
+	}else if(y < -2147483647 - 1){
+		y = -2147483647 - 1;
+	}
+	return (uint32_t)y + PROJ_HALF;
+}
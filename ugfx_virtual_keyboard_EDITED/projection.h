@@ -0,0 +1,40 @@
+#ifndef _PROJECTION_H_
+#define _PROJECTION_H_
+
+#include <stdint.h>
+#include "gfx.h"
+
+// World coordinates are Web-Mercator x/y scaled so that the whole world is 2^32 units wide,
+// at zoom z one pixel is 2^(24-z) units and one 256px tile is 2^(32-z) units
+#define PROJ_MIN_ZOOM				0
+#define PROJ_MAX_ZOOM				24
+#define PROJ_MAX_LATITUDE_E7		850511287		// Mercator is cut at +-85.0511287 degrees
+
+#define PROJ_PIXEL_SHIFT(zoom)		(24 - (zoom))
+#define PROJ_TILE_SHIFT(zoom)		(32 - (zoom))
+#define PROJ_TILE(w, zoom)			((int)((uint64_t)(w) >> PROJ_TILE_SHIFT(zoom)))
+#define PROJ_TILE_OFFSET(w, zoom)	((int)(((w) >> PROJ_PIXEL_SHIFT(zoom)) & 0xFF))
+
+typedef struct {
+	int32_t LatitudeE7;
+	int32_t LongitudeE7;
+} proj_latlon_t;
+
+typedef struct {
+	uint32_t x;
+	uint32_t y;
+} proj_world_t;
+
+// Screen position in pixels, points off screen can be further away than coord_t holds
+typedef struct {
+	int32_t x;
+	int32_t y;
+} proj_screen_t;
+
+void projInit(void);
+void projToWorld(int32_t latE7, int32_t lonE7, proj_world_t *world);
+void projToLatLon(const proj_world_t *world, proj_latlon_t *latlon);
+void projToWorldBatch(const proj_latlon_t *in, proj_world_t *out, uint32_t count);
+void projToScreenBatch(const proj_world_t *in, proj_screen_t *out, uint32_t count, const proj_world_t *origin, uint8_t zoom, coord_t centerX, coord_t centerY);
+
+#endif /* _PROJECTION_H_ */
@@ -0,0 +1,467 @@
+#include "route.h"
+#include "sdram.h"
+#include "gfx.h"
+#include "stm32fxxx_hal.h"
+#include <math.h>
+#include <string.h>
+
+#define ROUTE_PI						3.14159265f
+#define ROUTE_EARTH_M				40075016.686f
+#define ROUTE_NO_SEGMENT		0xFFFFFFFF
+
+typedef struct {
+	uint16_t Point;
+	int16_t Angle;
+} route_turn_t;
+
+// Route in SDRAM: points, distance from start of each point, hashed grid in CSR layout and turns
+static proj_world_t * const points = (proj_world_t *)SDRAM_ROUTE_ADDR;
+static uint32_t * const distances = (uint32_t *)(SDRAM_ROUTE_ADDR + ROUTE_MAX_POINTS * sizeof(proj_world_t));
+static uint32_t * const bucketStart = (uint32_t *)(SDRAM_ROUTE_ADDR + ROUTE_MAX_POINTS * (sizeof(proj_world_t) + sizeof(uint32_t)));
+static uint16_t * const bucketEntries = (uint16_t *)(SDRAM_ROUTE_ADDR + ROUTE_MAX_POINTS * (sizeof(proj_world_t) + sizeof(uint32_t)) +
+	(ROUTE_BUCKETS + 1) * sizeof(uint32_t));
+static route_turn_t * const turns = (route_turn_t *)(SDRAM_ROUTE_ADDR + ROUTE_MAX_POINTS * (sizeof(proj_world_t) + sizeof(uint32_t)) +
+	(ROUTE_BUCKETS + 1) * sizeof(uint32_t) + ROUTE_MAX_ENTRIES * sizeof(uint16_t));
+
+static uint32_t count;
+static uint32_t turnCount;
+static uint8_t cellShift;
+static uint32_t offFixes;
+
+static char readBuffer[ROUTE_READ_SIZE + ROUTE_MAX_TAG + 1];
+
+static route_status_t status;
+static route_stats_t stats;
+
+osMutexDef(routeMutex);
+static osMutexId routeMutexID;
+
+static bool routeParse(GFILE *file);
+static bool routeTag(char *tag, int32_t *latE7, int32_t *lonE7);
+static bool routeAttribute(const char *tag, const char *name, int32_t *valueE7);
+static float routeMetersPerUnit(int32_t latE7);
+static bool routeIndex(void);
+static void routeTurns(void);
+static inline uint32_t routeBucket(uint32_t cx, uint32_t cy);
+static float routeSegmentDistance(uint32_t segment, const proj_world_t *p, float *t);
+static uint32_t routeNearest(const proj_world_t *p, float metersPerUnit, float *distance, float *t);
+
+void routeInit(){
+	routeMutexID = osMutexCreate(osMutex(routeMutex));
+}
+
+bool routeLoad(const char *filename){
+	GFILE *file;
+	uint32_t start = HAL_GetTick();
+	bool ok;
+
+	routeClear();
+
+	file = gfileOpen(filename, "r");
+	if(file == NULL){
+		return false;
+	}
+	ok = routeParse(file);
+	gfileClose(file);
+
+	// Route is built outside mutex, status only shows it once complete
+	if(!ok || count < 2 || !routeIndex()){
+		count = 0;
+		return false;
+	}
+	routeTurns();
+
+	osMutexWait(routeMutexID, osWaitForever);
+	status.Loaded = true;
+	status.Segment = 0;
+	status.DistanceRemainingM = distances[count - 1] / 100;
+	stats.Points = count;
+	stats.Turns = turnCount;
+	stats.CellShift = cellShift;
+	stats.LoadMS = HAL_GetTick() - start;
+	osMutexRelease(routeMutexID);
+	return true;
+}
+
+void routeClear(){
+	osMutexWait(routeMutexID, osWaitForever);
+	memset(&status, 0, sizeof(status));
+	memset(&stats, 0, sizeof(stats));
+	count = 0;
+	turnCount = 0;
+	offFixes = 0;
+	osMutexRelease(routeMutexID);
+}
+
+void routeUpdate(int32_t latE7, int32_t lonE7){
+	proj_world_t p;
+	float metersPerUnit = routeMetersPerUnit(latE7);
+	float distance, t = 0.0f, d, u;
+	uint32_t segment, along, i, lo, hi, mid;
+
+	projToWorld(latE7, lonE7, &p);
+
+	osMutexWait(routeMutexID, osWaitForever);
+	if(!status.Loaded){
+		osMutexRelease(routeMutexID);
+		return;
+	}
+	stats.Queries++;
+
+	// Rider usually is on same or one of next segments, spatial query only when that fails
+	segment = ROUTE_NO_SEGMENT;
+	distance = ROUTE_ON_M;
+	for(i = status.Segment; i < count - 1 && i < status.Segment + ROUTE_FOLLOW_SEGMENTS; i++){
+		d = routeSegmentDistance(i, &p, &u) * metersPerUnit;
+		if(d <= distance){
+			segment = i;
+			distance = d;
+			t = u;
+		}
+	}
+	if(segment != ROUTE_NO_SEGMENT){
+		stats.FollowHits++;
+	}else{
+		segment = routeNearest(&p, metersPerUnit, &distance, &t);
+	}
+
+	// Hysteresis, leaving route needs several far fixes, coming back needs one close fix
+	if(segment == ROUTE_NO_SEGMENT || distance > ROUTE_OFF_M){
+		if(offFixes < ROUTE_OFF_FIXES && ++offFixes == ROUTE_OFF_FIXES && !status.OffRoute){
+			status.OffRoute = true;
+			stats.OffRouteEvents++;
+		}
+	}else{
+		offFixes = 0;
+		if(distance <= ROUTE_ON_M){
+			status.OffRoute = false;
+		}
+	}
+	if(segment == ROUTE_NO_SEGMENT){
+		status.DistanceFromRouteM = (uint32_t)ROUTE_SEARCH_M;
+		osMutexRelease(routeMutexID);
+		return;
+	}
+
+	along = distances[segment] + (uint32_t)(t * (distances[segment + 1] - distances[segment]));
+	status.Segment = segment;
+	status.DistanceFromRouteM = (uint32_t)distance;
+	status.DistanceAlongM = along / 100;
+	status.DistanceRemainingM = (distances[count - 1] - along) / 100;
+
+	// First turn after matched point
+	lo = 0;
+	hi = turnCount;
+	while(lo < hi){
+		mid = (lo + hi) / 2;
+		if(distances[turns[mid].Point] <= along){
+			lo = mid + 1;
+		}else{
+			hi = mid;
+		}
+	}
+	if(lo < turnCount){
+		status.NextTurnM = (distances[turns[lo].Point] - along) / 100;
+		status.NextTurnAngle = turns[lo].Angle;
+	}else{
+		status.NextTurnM = 0;
+		status.NextTurnAngle = 0;
+	}
+	osMutexRelease(routeMutexID);
+}
+
+void routeGetStatus(route_status_t *st){
+	osMutexWait(routeMutexID, osWaitForever);
+	*st = status;
+	osMutexRelease(routeMutexID);
+}
+
+void routeGetStats(route_stats_t *st){
+	osMutexWait(routeMutexID, osWaitForever);
+	*st = stats;
+	osMutexRelease(routeMutexID);
+}
+
+static bool routeParse(GFILE *file){
+	size_t length = 0, n;
+	char *pos, *open, *close;
+	int32_t latE7, lonE7;
+	proj_world_t p;
+	float dx, dy, meters, metersPerUnit;
+
+	while((n = gfileRead(file, readBuffer + length, ROUTE_READ_SIZE)) > 0){
+		length += n;
+		readBuffer[length] = 0;
+		pos = readBuffer;
+
+		// Complete tags are handled, unfinished tag is moved to start of buffer for next read
+		while((open = strchr(pos, '<')) != NULL){
+			close = strchr(open, '>');
+			if(close == NULL){
+				break;
+			}
+			*close = 0;
+			pos = close + 1;
+			if(!routeTag(open + 1, &latE7, &lonE7)){
+				continue;
+			}
+
+			projToWorld(latE7, lonE7, &p);
+			metersPerUnit = routeMetersPerUnit(latE7);
+			if(count == 0){
+				distances[0] = 0;
+			}else{
+				dx = (float)(int32_t)(p.x - points[count - 1].x);
+				dy = (float)(int32_t)(p.y - points[count - 1].y);
+				meters = sqrtf(dx * dx + dy * dy) * metersPerUnit;
+				if(meters < ROUTE_MIN_SPACING_M){
+					continue;
+				}
+				if(count == ROUTE_MAX_POINTS){
+					return false;
+				}
+				distances[count] = distances[count - 1] + (uint32_t)(meters * 100.0f + 0.5f);
+			}
+			points[count++] = p;
+		}
+
+		if(open == NULL){
+			length = 0;
+		}else{
+			length = readBuffer + length - open;
+			if(length > ROUTE_MAX_TAG){
+				length = 0;
+			}
+			memmove(readBuffer, open, length);
+		}
+	}
+	return true;
+}
+
+static bool routeTag(char *tag, int32_t *latE7, int32_t *lonE7){
+	if(strncmp(tag, "trkpt", 5) != 0 && strncmp(tag, "rtept", 5) != 0){
+		return false;
+	}
+	return routeAttribute(tag + 5, "lat", latE7) && routeAttribute(tag + 5, "lon", lonE7);
+}
+
+static bool routeAttribute(const char *tag, const char *name, int32_t *valueE7){
+	const char *s = tag;
+	size_t length = strlen(name);
+	int32_t value = 0;
+	int decimals = 0;
+	bool negative = false, digits = false;
+
+	// Attribute name has to follow whitespace and be followed by =
+	while((s = strstr(s, name)) != NULL){
+		if((s[-1] == ' ' || s[-1] == '\t' || s[-1] == '\r' || s[-1] == '\n') && s[length] == '='){
+			break;
+		}
+		s += length;
+	}
+	if(s == NULL || (s[length + 1] != '"' && s[length + 1] != '\'')){
+		return false;
+	}
+	s += length + 2;
+
+	if(*s == '-'){
+		negative = true;
+		s++;
+	}
+	while((*s >= '0' && *s <= '9') || (*s == '.' && decimals == 0)){
+		if(*s == '.'){
+			decimals = 1;
+		}else if(decimals <= 7){
+			value = value * 10 + (*s - '0');
+			digits = true;
+			if(decimals){
+				decimals++;
+			}
+		}
+		s++;
+	}
+	if(!digits){
+		return false;
+	}
+	for(decimals = decimals ? decimals - 1 : 0; decimals < 7; decimals++){
+		value *= 10;
+	}
+	*valueE7 = negative ? -value : value;
+	return true;
+}
+
+static float routeMetersPerUnit(int32_t latE7){
+	return ROUTE_EARTH_M / 4294967296.0f * cosf(latE7 * (ROUTE_PI / 1800000000.0f));
+}
+
+static bool routeIndex(){
+	proj_world_t min = points[0], max = points[0];
+	proj_latlon_t start;
+	uint32_t i, b, cx, cy, x0, x1, y0, y1, entries = 0;
+	uint32_t cell;
+
+	for(i = 1; i < count; i++){
+		if(points[i].x < min.x) min.x = points[i].x;
+		if(points[i].x > max.x) max.x = points[i].x;
+		if(points[i].y < min.y) min.y = points[i].y;
+		if(points[i].y > max.y) max.y = points[i].y;
+	}
+
+	// Cell at least twice search radius, so query never looks at more than 2x2 cells
+	projToLatLon(&points[0], &start);
+	cell = (uint32_t)(2.0f * ROUTE_SEARCH_M / routeMetersPerUnit(start.LatitudeE7));
+	for(cellShift = 0; ((uint32_t)1 << cellShift) < cell; cellShift++);
+
+	// Count segment references per bucket, long segments go into every cell of their bounding box
+	for(; cellShift < 32; cellShift++){
+		memset(bucketStart, 0, (ROUTE_BUCKETS + 1) * sizeof(uint32_t));
+		entries = 0;
+		for(i = 0; i < count - 1 && entries <= ROUTE_MAX_ENTRIES; i++){
+			x0 = (points[i].x < points[i + 1].x ? points[i].x : points[i + 1].x) >> cellShift;
+			x1 = (points[i].x < points[i + 1].x ? points[i + 1].x : points[i].x) >> cellShift;
+			y0 = (points[i].y < points[i + 1].y ? points[i].y : points[i + 1].y) >> cellShift;
+			y1 = (points[i].y < points[i + 1].y ? points[i + 1].y : points[i].y) >> cellShift;
+			for(cx = x0; cx <= x1; cx++){
+				for(cy = y0; cy <= y1; cy++){
+					bucketStart[routeBucket(cx, cy) + 1]++;
+					entries++;
+				}
+			}
+		}
+		if(entries <= ROUTE_MAX_ENTRIES){
+			break;
+		}
+	}
+	if(cellShift == 32){
+		return false;
+	}
+
+	for(b = 0; b < ROUTE_BUCKETS; b++){
+		bucketStart[b + 1] += bucketStart[b];
+	}
+
+	// Fill advances each start to end of its bucket, shifting back restores starts
+	for(i = 0; i < count - 1; i++){
+		x0 = (points[i].x < points[i + 1].x ? points[i].x : points[i + 1].x) >> cellShift;
+		x1 = (points[i].x < points[i + 1].x ? points[i + 1].x : points[i].x) >> cellShift;
+		y0 = (points[i].y < points[i + 1].y ? points[i].y : points[i + 1].y) >> cellShift;
+		y1 = (points[i].y < points[i + 1].y ? points[i + 1].y : points[i].y) >> cellShift;
+		for(cx = x0; cx <= x1; cx++){
+			for(cy = y0; cy <= y1; cy++){
+				bucketEntries[bucketStart[routeBucket(cx, cy)]++] = (uint16_t)i;
+			}
+		}
+	}
+	for(b = ROUTE_BUCKETS; b > 0; b--){
+		bucketStart[b] = bucketStart[b - 1];
+	}
+	bucketStart[0] = 0;
+
+	stats.IndexEntries = entries;
+	return true;
+}
+
+static void routeTurns(){
+	uint32_t i, back = 0, ahead = 0;
+	float ax, ay, bx, by, angle;
+	uint32_t span = (uint32_t)(ROUTE_TURN_SPAN_M * 100.0f);
+
+	turnCount = 0;
+	for(i = 1; i < count - 1; i++){
+		// Direction before and after point over a fixed distance, so dense GPS points on a curve still add up to a turn
+		while(distances[i] - distances[back + 1] >= span){
+			back++;
+		}
+		if(ahead < i){
+			ahead = i;
+		}
+		while(ahead < count - 1 && distances[ahead] - distances[i] < span){
+			ahead++;
+		}
+
+		ax = (float)(int32_t)(points[i].x - points[back].x);
+		ay = (float)(int32_t)(points[i].y - points[back].y);
+		bx = (float)(int32_t)(points[ahead].x - points[i].x);
+		by = (float)(int32_t)(points[ahead].y - points[i].y);
+		// y grows south, so positive cross product is clockwise, a right turn
+		angle = atan2f(ax * by - ay * bx, ax * bx + ay * by) * (180.0f / ROUTE_PI);
+		if(fabsf(angle) < ROUTE_TURN_ANGLE){
+			continue;
+		}
+
+		// Neighbouring points of same turn are merged into sharpest one
+		if(turnCount && distances[i] - distances[turns[turnCount - 1].Point] < span){
+			if(fabsf(angle) > fabsf((float)turns[turnCount - 1].Angle)){
+				turns[turnCount - 1].Point = i;
+				turns[turnCount - 1].Angle = (int16_t)angle;
+			}
+		}else if(turnCount < ROUTE_MAX_TURNS){
+			turns[turnCount].Point = i;
+			turns[turnCount].Angle = (int16_t)angle;
+			turnCount++;
+		}
+	}
+}
+
+static inline uint32_t routeBucket(uint32_t cx, uint32_t cy){
+	return ((cx * 73856093u) ^ (cy * 19349663u)) & (ROUTE_BUCKETS - 1);
+}
+
+static float routeSegmentDistance(uint32_t segment, const proj_world_t *p, float *t){
+	// Relative to fix, so floats keep their precision
+	float ax = (float)(int32_t)(points[segment].x - p->x);
+	float ay = (float)(int32_t)(points[segment].y - p->y);
+	float dx = (float)(int32_t)(points[segment + 1].x - points[segment].x);
+	float dy = (float)(int32_t)(points[segment + 1].y - points[segment].y);
+	float len2 = dx * dx + dy * dy;
+	float u = len2 > 0.0f ? -(ax * dx + ay * dy) / len2 : 0.0f;
+
+	if(u < 0.0f){
+		u = 0.0f;
+	}else if(u > 1.0f){
+		u = 1.0f;
+	}
+	*t = u;
+	ax += u * dx;
+	ay += u * dy;
+	return sqrtf(ax * ax + ay * ay);
+}
+
+static uint32_t routeNearest(const proj_world_t *p, float metersPerUnit, float *distance, float *t){
+	uint32_t radius = (uint32_t)(ROUTE_SEARCH_M / metersPerUnit);
+	uint32_t x0 = (p->x - radius) >> cellShift, x1 = (p->x + radius) >> cellShift;
+	uint32_t y0 = (p->y - radius) >> cellShift, y1 = (p->y + radius) >> cellShift;
+	uint32_t cx, cy, b, e, segment, best = ROUTE_NO_SEGMENT, tested = 0;
+	uint32_t gap, bestGap = ROUTE_NO_SEGMENT;
+	float d, u, bestDistance = ROUTE_SEARCH_M;
+
+	for(cx = x0; cx <= x1; cx++){
+		for(cy = y0; cy <= y1; cy++){
+			b = routeBucket(cx, cy);
+			for(e = bucketStart[b]; e < bucketStart[b + 1]; e++){
+				segment = bucketEntries[e];
+				d = routeSegmentDistance(segment, p, &u) * metersPerUnit;
+				tested++;
+				if(d > ROUTE_SEARCH_M){
+					continue;
+				}
+
+				// Where route passes by several times, segment closest after last match wins over slightly nearer one
+				gap = segment >= status.Segment ? segment - status.Segment : (status.Segment - segment) * 4;
+				if((d <= ROUTE_ON_M && bestDistance <= ROUTE_ON_M) ? gap < bestGap : d < bestDistance){
+					best = segment;
+					bestGap = gap;
+					bestDistance = d;
+					*t = u;
+				}
+			}
+		}
+	}
+
+	stats.Candidates += tested;
+	if(tested > stats.MaxCandidates){
+		stats.MaxCandidates = tested;
+	}
+	*distance = bestDistance;
+	return best;
+}
@@ -0,0 +1,59 @@
+#ifndef _ROUTE_H_
+#define _ROUTE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "projection.h"
+
+#define ROUTE_FILE							"route.gpx"	// Loaded by boot thread when present
+#define ROUTE_MAX_POINTS				65536				// Route points kept in SDRAM
+#define ROUTE_MAX_ENTRIES				262144			// Segment references in spatial index
+#define ROUTE_MAX_TURNS					8192
+#define ROUTE_BUCKETS						65536				// Hashed grid cells, power of 2
+#define ROUTE_MIN_SPACING_M			2.0f				// Closer points in file are merged
+#define ROUTE_READ_SIZE					512					// File is parsed this many bytes at a time
+#define ROUTE_MAX_TAG						256					// Longest <trkpt> tag that can be parsed
+
+// Matching
+#define ROUTE_SEARCH_M					200.0f			// Radius of spatial query around fix
+#define ROUTE_FOLLOW_SEGMENTS		8						// Segments after last match tried before spatial query
+#define ROUTE_ON_M							25.0f				// Closer than this is back on route
+#define ROUTE_OFF_M							50.0f				// Further than this counts toward off route
+#define ROUTE_OFF_FIXES					3						// Consecutive far fixes before off route is reported
+
+// Turn detection
+#define ROUTE_TURN_SPAN_M				20.0f				// Direction is measured over this distance before and after point
+#define ROUTE_TURN_ANGLE				45					// Degrees of direction change that make a turn
+
+typedef struct {
+	bool Loaded;
+	bool OffRoute;
+	uint32_t Segment;								// Segment matched to last fix
+	uint32_t DistanceAlongM;				// Distance from start of route to matched point
+	uint32_t DistanceRemainingM;		// Distance from matched point to end of route
+	uint32_t DistanceFromRouteM;		// Distance from fix to matched point
+	uint32_t NextTurnM;							// Distance along route to next turn, 0 if none
+	int16_t NextTurnAngle;					// Degrees, positive is right
+} route_status_t;
+
+typedef struct {
+	uint32_t Points;
+	uint32_t Turns;
+	uint32_t IndexEntries;					// Segment references in hashed grid
+	uint8_t CellShift;							// Grid cell is 2^CellShift world units
+	uint32_t LoadMS;
+	uint32_t Queries;								// Fixes matched
+	uint32_t FollowHits;						// Fixes matched near last segment without spatial query
+	uint32_t Candidates;						// Segments tested by spatial queries
+	uint32_t MaxCandidates;					// Most segments tested by one query
+	uint32_t OffRouteEvents;
+} route_stats_t;
+
+void routeInit(void);
+bool routeLoad(const char *filename);
+void routeClear(void);
+void routeUpdate(int32_t latE7, int32_t lonE7);
+void routeGetStatus(route_status_t *status);
+void routeGetStats(route_stats_t *stats);
+
+#endif /* _ROUTE_H_ */
@@ -0,0 +1,27 @@
+#ifndef _SDCARD_H_
+#define _SDCARD_H_
+
+#include <stdint.h>
+
+// SD card sector reads and writes of diskio.c. Transfers run on SDIO DMA while the calling
+// thread sleeps on a semaphore, buffers the DMA cannot use go through a bounce buffer.
+#define SDCARD_DMA_TIMEOUT			1000				// ms to wait for transfer complete interrupt
+#define SDCARD_BOUNCE_SECTORS		8						// Sectors per DMA transfer through bounce buffer
+
+typedef struct {
+	uint32_t Reads;							// disk_read calls, each is one multi-block command
+	uint32_t Writes;
+	uint32_t SectorsRead;
+	uint32_t SectorsWritten;
+	uint32_t Bounced;						// Transfers through bounce buffer for unaligned or CCM buffers
+	uint32_t Errors;
+	uint32_t Timeouts;					// Transfer complete interrupt not seen in SDCARD_DMA_TIMEOUT
+	uint32_t ReadUS;						// Total time spent in reads
+	uint32_t LastReadUS;
+	uint32_t MaxReadUS;
+	uint32_t ReadKBps;					// SectorsRead over ReadUS, filled in by sdcardGetStats
+} sdcard_stats_t;
+
+void sdcardGetStats(sdcard_stats_t *stats);
+
+#endif /* _SDCARD_H_ */
@@ -0,0 +1,26 @@
+#ifndef _SDRAM_H_
+#define _SDRAM_H_
+
+#include "stm32469i_discovery_sdram.h"
+
+// External SDRAM layout, frame buffer of LTDC is fixed in board_STM32LTDC.h
+// 0x000000 - 0x1FFFFF	free for application buffers below
+// 0x200000 - 0x33FFFF	LTDC frame buffer, room for RGB888
+// 0x340000 - 0x3FFFFF	free for application buffers below
+// 0x400000 - 0x7FFFFF	free for application buffers below
+#define SDRAM_TRACK_ADDR			(SDRAM_DEVICE_ADDR + 0x00000000)
+#define SDRAM_TRACK_SIZE			0x00040000
+#define SDRAM_TILES_ADDR			(SDRAM_DEVICE_ADDR + 0x00040000)
+#define SDRAM_TILES_SIZE			0x001C0000
+#define SDRAM_CHART_ADDR			(SDRAM_DEVICE_ADDR + 0x00340000)
+#define SDRAM_CHART_SIZE			0x00080000
+#define SDRAM_ROUTE_ADDR			(SDRAM_DEVICE_ADDR + 0x00400000)
+#define SDRAM_ROUTE_SIZE			0x00200000
+#define SDRAM_VMAP_ADDR				(SDRAM_DEVICE_ADDR + 0x00600000)
+#define SDRAM_VMAP_SIZE				0x00080000
+#define SDRAM_GFILE_CACHE_ADDR	(SDRAM_DEVICE_ADDR + 0x00680000)
+#define SDRAM_GFILE_CACHE_SIZE	0x00040000
+#define SDRAM_RAMFS_ADDR			(SDRAM_DEVICE_ADDR + 0x006C0000)
+#define SDRAM_RAMFS_SIZE			0x00140000
+
+#endif /* _SDRAM_H_ */
@@ -0,0 +1,12 @@
+/*
+ * Host simulator run time environment.
+ *
+ * No Keil RTX, the CMSIS-RTOS calls go to the pthread shim and HAL_GetTick() comes from sim_hal.c.
+ */
+
+#ifndef RTE_COMPONENTS_H
+#define RTE_COMPONENTS_H
+
+#define CMSIS_device_header "stm32f4xx.h"
+
+#endif /* RTE_COMPONENTS_H */
@@ -0,0 +1,245 @@
+/*
+ * GFILE block cache statistics per file.
+ *
+ * Runs the read patterns of the application through gfile.c, first without the cache and
+ * then with gfileCacheInit(), on a stand-in for the SD card that counts the reads reaching
+ * it. Per file it reports the gfileCacheGetStats() counters, the reads issued to the card
+ * with and without the cache and the card time of both under a simple SD card model.
+ *
+ *	PNG tile		8 byte reads with a seek at every chunk, as gdisp_image_png.c reads
+ *	16 bit BMP		header reads, then 2 byte pixel reads, drawn twice for two page visits
+ *	GPX route		ROUTE_READ_SIZE reads, as routeLoad() parses it
+ *	vector tile		one read of the whole file, as vmapLoad() reads it
+ *	BMP with route	the BMP drawn while the route loads, both files in the cache at once
+ *
+ * Every byte read is compared with the file. Exits with 1 when data is wrong, when the
+ * card counts disagree with the cache statistics or when the cache reads the card more
+ * often than the same pattern without it.
+ */
+
+#include "gfx.h"
+#include "src/gfile/gfile_fs.h"
+#include "route.h"
+#include "vmap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_SD_COMMAND_US		250				// Card model, cost of each read command
+#define BENCH_SD_NS_PER_BYTE	50				// and of each byte, 20 MB/s on 4 bit SDIO
+#define BENCH_CACHE_SIZE		(GFILE_CACHE_MAX_BLOCKS * GFILE_CACHE_BLOCK_SIZE)
+#define BENCH_PNG_CHUNK			8192
+#define BENCH_BMP_HEADER		70
+#define BENCH_BMP_PIXELS		(240 * 240)
+#define BENCH_BMP_PIXELS_PER_ROUTE_READ	200
+#define BENCH_VMAP_SIZE			12345			// A vector tile, at most VMAP_TILE_BYTES
+
+typedef struct benchFile {
+	const char *	name;
+	long int		size;
+	long int		pos;			// Position of the card side
+	uint32_t		reads;			// Reads reaching the card
+	uint32_t		bytes;
+} benchFile;
+
+static benchFile files[] = {
+	{ .name = "tile.png",	.size = 21437 },
+	{ .name = "icons.bmp",	.size = BENCH_BMP_HEADER + BENCH_BMP_PIXELS * 2 },
+	{ .name = "route.gpx",	.size = 311296 + 117 },
+	{ .name = "vmap.bin",	.size = BENCH_VMAP_SIZE },
+};
+#define BENCH_FILES		(sizeof(files) / sizeof(files[0]))
+
+static uint32_t errors;
+
+static uint8_t content(const benchFile *file, long int pos) {
+	return (uint8_t)((pos * 2654435761u >> 13) ^ pos ^ (file - files) * 37);
+}
+
+// The SD card stand-in, registered as FatFS so gfile.c caches it as on the board
+static bool_t sdOpen(GFILE *f, const char *fname) {
+	unsigned	i;
+
+	for(i = 0; i < BENCH_FILES; i++) {
+		if (!strcmp(files[i].name, fname)) {
+			files[i].pos = 0;
+			f->obj = &files[i];
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+static int sdRead(GFILE *f, void *buf, int size) {
+	benchFile *	file = f->obj;
+	int			i;
+
+	if (size > file->size - file->pos)
+		size = file->size - file->pos;
+	for(i = 0; i < size; i++)
+		((uint8_t *)buf)[i] = content(file, file->pos + i);
+	file->pos += size;
+	file->reads++;
+	file->bytes += size;
+	return size;
+}
+
+static bool_t sdSetPos(GFILE *f, long int pos) {
+	((benchFile *)f->obj)->pos = pos;
+	return TRUE;
+}
+
+static long int sdGetSize(GFILE *f) {
+	return ((benchFile *)f->obj)->size;
+}
+
+static bool_t sdEOF(GFILE *f) {
+	return ((benchFile *)f->obj)->pos >= ((benchFile *)f->obj)->size;
+}
+
+const GFILEVMT FsFatFSVMT = {
+	GFSFLG_SEEKABLE,				// Not GFSFLG_FAST, reads are cached
+	'F',
+	0, 0, 0, 0,
+	sdOpen, 0, sdRead, 0, sdSetPos, sdGetSize, sdEOF,
+	0, 0, 0,
+};
+
+// Reads and checks len bytes at the current position
+static void readCheck(GFILE *f, int len) {
+	uint8_t		buf[ROUTE_READ_SIZE > BENCH_VMAP_SIZE ? ROUTE_READ_SIZE : BENCH_VMAP_SIZE];
+	long int	pos = gfileGetPos(f);
+	size_t		n;
+	int			i;
+
+	n = gfileRead(f, buf, len);
+	if (n != (size_t)len && pos + len <= gfileGetSize(f))
+		errors++;
+	for(i = 0; i < (int)n; i++) {
+		if (buf[i] != content(f->obj, pos + i)) {
+			errors++;
+			break;
+		}
+	}
+}
+
+static void png(GFILE *f) {
+	long int	chunk;
+
+	readCheck(f, 8);
+	for(chunk = 8; chunk < gfileGetSize(f); chunk += 12 + BENCH_PNG_CHUNK) {
+		gfileSetPos(f, chunk);
+		while (gfileGetPos(f) < chunk + 8 + BENCH_PNG_CHUNK && !gfileEOF(f))
+			readCheck(f, 8);
+	}
+}
+
+static void bmpHeader(GFILE *f) {
+	gfileSetPos(f, 0);
+	readCheck(f, 2);
+	readCheck(f, 8);
+	readCheck(f, 4);
+	readCheck(f, 4);
+	readCheck(f, 36);
+	gfileSetPos(f, 54);
+	readCheck(f, 4);
+	readCheck(f, 4);
+	readCheck(f, 4);
+	gfileSetPos(f, BENCH_BMP_HEADER);
+}
+
+static void bmp(GFILE *f) {
+	int		i, pass;
+
+	for(pass = 0; pass < 2; pass++) {
+		bmpHeader(f);
+		for(i = 0; i < BENCH_BMP_PIXELS; i++)
+			readCheck(f, 2);
+	}
+}
+
+static void gpx(GFILE *f) {
+	while (!gfileEOF(f))
+		readCheck(f, ROUTE_READ_SIZE);
+}
+
+static void vmap(GFILE *f) {
+	readCheck(f, BENCH_VMAP_SIZE);
+}
+
+static void report(const char *name, GFILE *f, bool_t cached, uint32_t *uncachedReads) {
+	benchFile *			file = f->obj;
+	gfileCacheStats		st;
+	double				ms = (file->reads * BENCH_SD_COMMAND_US + file->bytes * BENCH_SD_NS_PER_BYTE / 1000.0) / 1000.0;
+
+	if (!cached) {
+		*uncachedReads = file->reads;
+		printf("%-10s %7.1f ms card, %6u reads uncached\n", name, ms, (unsigned)file->reads);
+		return;
+	}
+	gfileCacheGetStats(f, &st);
+	printf("%-10s %7.1f ms card, %6u reads cached: %u calls, %u hits, %u misses, %u ahead, %u direct, %u bytes\n",
+		name, ms, (unsigned)st.FsReads, (unsigned)st.Reads, (unsigned)st.Hits, (unsigned)st.Misses,
+		(unsigned)st.ReadAheads, (unsigned)st.DirectReads, (unsigned)st.Bytes);
+	if (st.FsReads != file->reads || st.FsReads > *uncachedReads)
+		errors++;
+}
+
+static void run(bool_t cached) {
+	static uint32_t	uncached[BENCH_FILES + 2];
+	GFILE *			f;
+	GFILE *			r;
+	unsigned		i;
+
+	printf("%s\n", cached ? "With cache" : "Without cache");
+	for(i = 0; i < BENCH_FILES; i++) {
+		files[i].reads = files[i].bytes = 0;
+		if (!(f = gfileOpen(files[i].name, "r"))) {
+			errors++;
+			continue;
+		}
+		if (i == 0)
+			png(f);
+		else if (i == 1)
+			bmp(f);
+		else if (i == 2)
+			gpx(f);
+		else
+			vmap(f);
+		report(files[i].name, f, cached, &uncached[i]);
+		gfileClose(f);
+	}
+
+	// Page with the BMP drawn while the boot thread loads the route
+	files[1].reads = files[1].bytes = files[2].reads = files[2].bytes = 0;
+	f = gfileOpen(files[1].name, "r");
+	r = gfileOpen(files[2].name, "r");
+	bmpHeader(f);
+	for(i = 0; i < BENCH_BMP_PIXELS; i++) {
+		readCheck(f, 2);
+		if (i % BENCH_BMP_PIXELS_PER_ROUTE_READ == 0 && !gfileEOF(r))
+			readCheck(r, ROUTE_READ_SIZE);
+	}
+	gpx(r);
+	report("bmp+route", f, cached, &uncached[BENCH_FILES]);
+	report("route+bmp", r, cached, &uncached[BENCH_FILES + 1]);
+	gfileClose(f);
+	gfileClose(r);
+}
+
+int main(void) {
+	static uint8_t	memory[BENCH_CACHE_SIZE];
+	gfileCacheStats	st;
+
+	run(FALSE);
+	if (!gfileCacheInit(memory, sizeof(memory))) {
+		fprintf(stderr, "Cache can not be started\n");
+		return 2;
+	}
+	run(TRUE);
+	gfileCacheGetStats(0, &st);
+	printf("Cache of %u blocks of %u bytes: %u hits, %u misses, %u read ahead, %u direct, %u card reads, %u errors\n",
+		GFILE_CACHE_MAX_BLOCKS, GFILE_CACHE_BLOCK_SIZE, (unsigned)st.Hits, (unsigned)st.Misses,
+		(unsigned)st.ReadAheads, (unsigned)st.DirectReads, (unsigned)st.FsReads, (unsigned)errors);
+	return errors != 0;
+}
@@ -0,0 +1,249 @@
+/*
+ * GPS and wheel speed fusion replay.
+ *
+ * Runs runFusion() on a simulated millisecond clock: every osDelay() of the fusion thread
+ * advances the clock and delivers the GPS fixes and wheel speed readings that fall due, so
+ * the filter steps exactly as it does on the board. Each step the published estimate is
+ * projected at the map zoom to count how often the map would be drawn again.
+ *
+ *	fusion_replay				generated ride with known track, checks the position error
+ *	fusion_replay <log.nmea>	replays an NMEA log, one fix per reported data set
+ *
+ * The generated ride goes 300 s east and 300 s north at 7 m/s. Fixes have up to 4 m of
+ * noise and are invalid for 30 s in a tunnel on the second leg, the wheel speed is exact.
+ * The course is only known at the fix after the corner, so the ten seconds after it have
+ * their own bound. Exits with 1 when an error is over its bound.
+ */
+
+#include "fusion.h"
+#include "projection.h"
+#include "gps.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REPLAY_SPEED_MMS		7000
+#define REPLAY_LEG_S			300
+#define REPLAY_TUNNEL_START_S	420
+#define REPLAY_TUNNEL_S			30
+#define REPLAY_CORNER_S			10
+#define REPLAY_NOISE_M			4
+#define REPLAY_MAX_FIX_ERROR_M	5.0
+#define REPLAY_MAX_TUNNEL_ERROR_M 10.0
+#define REPLAY_MAX_CORNER_ERROR_M 12.0
+#define REPLAY_METERS_PER_E7	0.011131949
+
+USART_TypeDef simUSART[8];
+
+static uint32_t now;
+static FILE *nmea;
+static TM_GPS_t gps;
+static int32_t startLatE7 = 510776000, startLonE7 = -1141318000;
+static double fixError, fixErrorMax, tunnelErrorMax, cornerErrorMax, innovation, innovationMax, fixPath;
+static uint32_t steps, fixSteps, redraws, fixes;
+static proj_world_t lastWorld;
+static int32_t lastFixLatE7, lastFixLonE7;
+
+// Clock and RTOS calls used by fusion.c, the fusion thread is the only thread
+uint32_t HAL_GetTick(void) {
+	return now;
+}
+
+osMutexId osMutexCreate(const osMutexDef_t *mutex_def) {
+	(void)mutex_def;
+	return (osMutexId)1;
+}
+
+osStatus osMutexWait(osMutexId mutex_id, uint32_t millisec) {
+	(void)mutex_id; (void)millisec;
+	return osOK;
+}
+
+osStatus osMutexRelease(osMutexId mutex_id) {
+	(void)mutex_id;
+	return osOK;
+}
+
+// The USART is not used, log lines are handed to the parser directly
+TM_USART_DMA_t* TM_USART_DMA_Init(USART_TypeDef* USARTx, TM_USART_PinsPack_t pinspack, uint32_t baudrate, uint8_t* Buffer, uint16_t Size) {
+	(void)USARTx; (void)pinspack; (void)baudrate; (void)Buffer; (void)Size;
+	return 0;
+}
+
+uint8_t TM_USART_DMA_GetSentence(USART_TypeDef* USARTx, TM_USART_DMA_Sentence_t* Sentence, uint8_t* Linear, uint16_t LinearSize) {
+	(void)USARTx; (void)Sentence; (void)Linear; (void)LinearSize;
+	return 0;
+}
+
+uint8_t TM_USART_DMA_SentenceValid(USART_TypeDef* USARTx, const TM_USART_DMA_Sentence_t* Sentence) {
+	(void)USARTx; (void)Sentence;
+	return 1;
+}
+
+static double distanceM(int32_t latE7, int32_t lonE7, int32_t lat2E7, int32_t lon2E7) {
+	double n = (latE7 - lat2E7) * REPLAY_METERS_PER_E7;
+	double e = (lonE7 - lon2E7) * REPLAY_METERS_PER_E7 * cos(latE7 * M_PI / 1800000000.0);
+
+	return sqrt(n * n + e * e);
+}
+
+// Position of the generated ride after ms
+static void ride(uint32_t ms, int32_t *latE7, int32_t *lonE7, uint16_t *courseE2) {
+	double m = (double)ms * REPLAY_SPEED_MMS / 1000000.0, leg = REPLAY_LEG_S * REPLAY_SPEED_MMS / 1000.0;
+	double perE7Lon = REPLAY_METERS_PER_E7 * cos(startLatE7 * M_PI / 1800000000.0);
+
+	if (m <= leg) {
+		*latE7 = startLatE7;
+		*lonE7 = startLonE7 + (int32_t)lround(m / perE7Lon);
+		*courseE2 = 9000;
+	} else {
+		*latE7 = startLatE7 + (int32_t)lround((m - leg) / REPLAY_METERS_PER_E7);
+		*lonE7 = startLonE7 + (int32_t)lround(leg / perE7Lon);
+		*courseE2 = 0;
+	}
+}
+
+// Deterministic noise in -1..1
+static double noise(void) {
+	static uint32_t seed = 12345;
+
+	seed = seed * 1103515245u + 12345u;
+	return (double)(seed >> 8) / (1u << 23) - 1.0;
+}
+
+static void fix(void) {
+	fusion_estimate_t est;
+
+	fusionGetEstimate(&est);
+	if (gps.Validity && gps.Fix && est.Valid) {
+		innovation = distanceM(est.LatitudeE7, est.LongitudeE7, gps.LatitudeE7, gps.LongitudeE7);
+		if (innovation > innovationMax)
+			innovationMax = innovation;
+	}
+	if (gps.Validity && gps.Fix) {
+		if (fixes)
+			fixPath += distanceM(gps.LatitudeE7, gps.LongitudeE7, lastFixLatE7, lastFixLonE7);
+		lastFixLatE7 = gps.LatitudeE7;
+		lastFixLonE7 = gps.LongitudeE7;
+		fixes++;
+	}
+	fusionGPSUpdate(&gps);
+}
+
+// Parses log lines until the next data set is reported, 0 at end of log
+static int logFix(void) {
+	char line[128];
+
+	while (fgets(line, sizeof(line), nmea)) {
+		if (TM_GPS_UpdateSentence(&gps, line, strlen(line)) == TM_GPS_Result_NewData) {
+			fix();
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static void generatedFix(void) {
+	int32_t latE7, lonE7;
+	uint16_t courseE2;
+	uint32_t s = now / 1000;
+
+	ride(now, &latE7, &lonE7, &courseE2);
+	gps.LatitudeE7 = latE7 + (int32_t)(noise() * REPLAY_NOISE_M / REPLAY_METERS_PER_E7);
+	gps.LongitudeE7 = lonE7 + (int32_t)(noise() * REPLAY_NOISE_M / REPLAY_METERS_PER_E7);
+	gps.SpeedMMS = REPLAY_SPEED_MMS;
+	gps.DirectionE2 = courseE2;
+	gps.HDOPE2 = 90;
+	gps.Validity = !(s >= REPLAY_TUNNEL_START_S && s < REPLAY_TUNNEL_START_S + REPLAY_TUNNEL_S);
+	gps.Fix = gps.Validity;
+	fix();
+	fusionWheelSpeed(REPLAY_SPEED_MMS);
+}
+
+static void report(void) {
+	fusion_estimate_t est;
+	fusion_stats_t st;
+
+	fusionGetEstimate(&est);
+	fusionGetStats(&st);
+	printf("%u steps in %u s, %u fixes, %u resets, %u invalid, longest outage %u ms\n", (unsigned)steps,
+		(unsigned)(now / 1000), (unsigned)st.Fixes, (unsigned)st.Resets, (unsigned)st.InvalidFixes, (unsigned)st.LongestOutageMS);
+	printf("Distance %u m, fix to fix %.0f m\n", (unsigned)est.DistanceM, fixPath);
+	printf("Estimate to next fix %.2f m max\n", innovationMax);
+	printf("Map at z%d drawn again on %u of %u steps, %.1f per second\n", ZOOM_LEVEL, (unsigned)redraws,
+		(unsigned)steps, redraws * 1000.0 / now);
+	if (nmea)
+		exit(0);
+	printf("Error with fixes %.2f m mean, %.2f m max, in tunnel %.2f m max, after corner %.2f m max\n",
+		fixError / fixSteps, fixErrorMax, tunnelErrorMax, cornerErrorMax);
+	exit(fixErrorMax > REPLAY_MAX_FIX_ERROR_M || tunnelErrorMax > REPLAY_MAX_TUNNEL_ERROR_M ||
+		cornerErrorMax > REPLAY_MAX_CORNER_ERROR_M);
+}
+
+// Fusion thread sleeps between steps, fixes and wheel readings are delivered meanwhile
+osStatus osDelay(uint32_t millisec) {
+	fusion_estimate_t est;
+	proj_world_t world;
+	int32_t latE7, lonE7;
+	uint16_t courseE2;
+	uint32_t s;
+	double e;
+
+	// Estimate published by the step before
+	if (now) {
+		fusionGetEstimate(&est);
+		projToWorld(est.LatitudeE7, est.LongitudeE7, &world);
+		if (est.Valid && (world.x >> PROJ_PIXEL_SHIFT(ZOOM_LEVEL) != lastWorld.x >> PROJ_PIXEL_SHIFT(ZOOM_LEVEL) ||
+			world.y >> PROJ_PIXEL_SHIFT(ZOOM_LEVEL) != lastWorld.y >> PROJ_PIXEL_SHIFT(ZOOM_LEVEL))) {
+			redraws++;
+		}
+		lastWorld = world;
+		steps++;
+
+		if (!nmea && est.Valid) {
+			ride(now, &latE7, &lonE7, &courseE2);
+			e = distanceM(est.LatitudeE7, est.LongitudeE7, latE7, lonE7);
+			s = now / 1000;
+			if (s >= REPLAY_TUNNEL_START_S && s < REPLAY_TUNNEL_START_S + REPLAY_TUNNEL_S) {
+				if (e > tunnelErrorMax)
+					tunnelErrorMax = e;
+			} else if (s >= REPLAY_LEG_S && s < REPLAY_LEG_S + REPLAY_CORNER_S) {
+				if (e > cornerErrorMax)
+					cornerErrorMax = e;
+			} else if (s > 5) {
+				fixError += e;
+				fixSteps++;
+				if (e > fixErrorMax)
+					fixErrorMax = e;
+			}
+		}
+	}
+
+	for (s = 0; s < millisec; s++) {
+		now++;
+		if (now % 1000 == 0) {
+			if (nmea) {
+				if (!logFix())
+					report();
+			} else if (now / 1000 > 2 * REPLAY_LEG_S) {
+				report();
+			} else {
+				generatedFix();
+			}
+		}
+	}
+	return osOK;
+}
+
+int main(int argc, char **argv) {
+	if (argc > 1 && !(nmea = fopen(argv[1], "r"))) {
+		fprintf(stderr, "%s can not be opened\n", argv[1]);
+		return 2;
+	}
+	projInit();
+	TM_GPS_Init(&gps, 9600);
+	fusionInit();
+	runFusion();
+	return 0;
+}
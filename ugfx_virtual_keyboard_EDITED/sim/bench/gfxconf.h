@@ -0,0 +1,39 @@
+/*
+ * Benchmark configuration for programs that build parts of uGFX themselves.
+ *
+ * file_cache.c: the simulator configuration with GFILE on FatFS only, so gfile.c is built
+ * as on the board. The benchmark provides FsFatFSVMT itself as a stand-in for the SD card.
+ *
+ * heap_replay.c, built with BENCH_HEAP: the firmware configuration on the bare metal port,
+ * so gos_x_heap.c is built with the heap size of the board.
+ */
+
+#ifndef _BENCH_GFXCONF_H
+#define _BENCH_GFXCONF_H
+
+#ifdef BENCH_HEAP
+	#include "../../gfxconf.h"
+
+	#undef GFX_USE_OS_KEIL
+	#undef GFX_COMPILER
+	#undef GFX_CPU
+	#undef GFX_CPU_ENDIAN
+	#define GFX_USE_OS_RAW32						TRUE
+#else
+	#include "../gfxconf.h"
+
+	#undef GFILE_NEED_FATFS
+	#undef GFILE_NEED_NATIVEFS
+	#undef GFILE_NEED_ROMFS
+	#undef GFILE_NEED_MEMFS
+	#undef GFILE_NEED_RAMFS
+	#undef GFILE_NEED_DIRECTPOINTER
+	#define GFILE_NEED_FATFS						TRUE
+	#define GFILE_NEED_NATIVEFS						FALSE
+	#define GFILE_NEED_ROMFS						FALSE
+	#define GFILE_NEED_MEMFS						FALSE
+	#define GFILE_NEED_RAMFS						FALSE
+	#define GFILE_NEED_DIRECTPOINTER				FALSE
+#endif
+
+#endif /* _BENCH_GFXCONF_H */
@@ -0,0 +1,182 @@
+/*
+ * GPS parser benchmark.
+ *
+ * Feeds generated NMEA epochs (RMC, GGA, GSA and two GSV) and UBX NAV-PVT frames through
+ * TM_GPS_UpdateSentence() a line at a time, as TM_GPS_Update() does with DMA lines, and
+ * reports time per line and per byte. Every reported position is compared with the one
+ * that was sent, one line in BENCH_BAD_EVERY has a broken checksum and must be dropped.
+ *
+ * Exits with 1 when a position or a counter is wrong.
+ */
+
+#include "tm_stm32_gps.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_EPOCHS		200000
+#define BENCH_BAD_EVERY		97
+#define BENCH_LINES			6
+#define BENCH_LINE_SIZE		128
+
+USART_TypeDef simUSART[8];
+
+// The USART is not used, lines are handed to the parser directly
+TM_USART_DMA_t* TM_USART_DMA_Init(USART_TypeDef* USARTx, TM_USART_PinsPack_t pinspack, uint32_t baudrate, uint8_t* Buffer, uint16_t Size) {
+	(void)USARTx; (void)pinspack; (void)baudrate; (void)Buffer; (void)Size;
+	return 0;
+}
+
+uint8_t TM_USART_DMA_GetSentence(USART_TypeDef* USARTx, TM_USART_DMA_Sentence_t* Sentence, uint8_t* Linear, uint16_t LinearSize) {
+	(void)USARTx; (void)Sentence; (void)Linear; (void)LinearSize;
+	return 0;
+}
+
+uint8_t TM_USART_DMA_SentenceValid(USART_TypeDef* USARTx, const TM_USART_DMA_Sentence_t* Sentence) {
+	(void)USARTx; (void)Sentence;
+	return 1;
+}
+
+typedef struct {
+	char data[BENCH_LINE_SIZE];
+	uint16_t length;
+} line_t;
+
+static uint64_t nanoseconds(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static void nmea(line_t *l, int broken, const char *fmt, ...) {
+	char body[BENCH_LINE_SIZE - 8];
+	uint8_t crc = 0;
+	va_list ap;
+	char *p;
+
+	va_start(ap, fmt);
+	vsnprintf(body, sizeof(body), fmt, ap);
+	va_end(ap);
+	for (p = body; *p; p++)
+		crc ^= *p;
+	l->length = snprintf(l->data, sizeof(l->data), "$%s*%02X\r\n", body, crc ^ (broken ? 0x5A : 0));
+}
+
+// ddmm.mmmm from 1e-7 degrees, the position parsed back is rounded to 1e-7 degrees
+static void coordinate(char *buf, size_t size, int32_t e7, int width, char pos, char neg, char *hemi) {
+	uint32_t a = e7 < 0 ? -e7 : e7;
+	uint32_t m = (uint32_t)(((uint64_t)(a % 10000000) * 600000 + 5000000) / 10000000);
+
+	snprintf(buf, size, "%0*u%02u.%04u", width, a / 10000000, m / 10000, m % 10000);
+	*hemi = e7 < 0 ? neg : pos;
+}
+
+static int32_t minutesE7(int32_t e7) {
+	uint32_t a = e7 < 0 ? -e7 : e7;
+	uint32_t m = (uint32_t)(((uint64_t)(a % 10000000) * 600000 + 5000000) / 10000000);
+	int32_t r = a / 10000000 * 10000000 + (int32_t)(((uint64_t)m * 10000000 + 300000) / 600000);
+
+	return e7 < 0 ? -r : r;
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+	p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+static void navPvt(line_t *l, int32_t latE7, int32_t lonE7, int n) {
+	uint8_t *f = (uint8_t *)l->data, *p = f + 6, a = 0, b = 0;
+	int i;
+
+	memset(f, 0, 100);
+	f[0] = 0xB5; f[1] = 0x62; f[2] = 0x01; f[3] = 0x07; f[4] = 92;
+	p[4] = 2026 & 0xFF; p[5] = 2026 >> 8; p[6] = 10; p[7] = 19;
+	p[8] = n / 3600 % 24; p[9] = n / 60 % 60; p[10] = n % 60;
+	p[20] = 3; p[21] = 0x01; p[23] = 12;
+	put32(&p[24], lonE7);
+	put32(&p[28], latE7);
+	put32(&p[36], 1045000);
+	put32(&p[60], 7000);
+	put32(&p[64], 9000000);
+	p[76] = 160;
+	for (i = 2; i < 98; i++) {
+		a += f[i];
+		b += a;
+	}
+	f[98] = a;
+	f[99] = b;
+	l->length = 100;
+}
+
+int main(void) {
+	static line_t lines[BENCH_LINES];
+	static TM_GPS_t gps;
+	uint64_t t, nmeaNs = 0, ubxNs = 0, nmeaBytes = 0, ubxBytes = 0;
+	unsigned nmeaLines = 0, ubxLines = 0, reported = 0, wrong = 0, bad = 0, expect = 0;
+	int32_t latE7, lonE7;
+	char la[16], lo[16], ns, ew, hms[16];
+	int n, i, ubx, broken;
+
+	TM_GPS_Init(&gps, 9600);
+	for (n = 0; n < BENCH_EPOCHS; n++) {
+		latE7 = 510776000 + (n % 10000) * 37;
+		lonE7 = -1141318000 - (n % 10000) * 53;
+		ubx = (n & 1);
+		broken = !ubx && (n % BENCH_BAD_EVERY) == 0;
+
+		if (ubx) {
+			navPvt(&lines[0], latE7, lonE7, n);
+			t = nanoseconds();
+			if (TM_GPS_UpdateSentence(&gps, lines[0].data, lines[0].length) == TM_GPS_Result_NewData) {
+				reported++;
+				if (gps.LatitudeE7 != latE7 || gps.LongitudeE7 != lonE7)
+					wrong++;
+			}
+			ubxNs += nanoseconds() - t;
+			ubxBytes += lines[0].length;
+			ubxLines++;
+			expect++;
+			continue;
+		}
+
+		// GN talker every other NMEA epoch, as multi-GNSS receivers send
+		coordinate(la, sizeof(la), latE7, 2, 'N', 'S', &ns);
+		coordinate(lo, sizeof(lo), lonE7, 3, 'E', 'W', &ew);
+		snprintf(hms, sizeof(hms), "%02d%02d%02d.00", n / 3600 % 24, n / 60 % 60, n % 60);
+		nmea(&lines[0], 0, "%sRMC,%s,A,%s,%c,%s,%c,13.607,270.00,191026,,,A", n & 2 ? "GN" : "GP", hms, la, ns, lo, ew);
+		nmea(&lines[1], broken, "%sGGA,%s,%s,%c,%s,%c,1,08,0.9,1045.0,M,-17.0,M,,", n & 2 ? "GN" : "GP", hms, la, ns, lo, ew);
+		nmea(&lines[2], 0, "GPGSA,A,3,02,05,07,13,15,20,24,30,,,,,1.6,0.9,1.3");
+		nmea(&lines[3], 0, "GPGSV,2,1,08,02,65,110,42,05,41,280,38,07,22,045,35,13,18,190,31");
+		nmea(&lines[4], 0, "GPGSV,2,2,08,15,72,300,44,20,30,080,36,24,12,230,29,30,55,150,40");
+		for (i = 0; i < 5; i++) {
+			t = nanoseconds();
+			if (TM_GPS_UpdateSentence(&gps, lines[i].data, lines[i].length) == TM_GPS_Result_NewData) {
+				reported++;
+				if (gps.LatitudeE7 != minutesE7(latE7) || gps.LongitudeE7 != minutesE7(lonE7))
+					wrong++;
+			}
+			nmeaNs += nanoseconds() - t;
+			nmeaBytes += lines[i].length;
+			nmeaLines++;
+		}
+		if (broken)
+			bad++;
+		else
+			expect++;
+	}
+
+	printf("NMEA: %u lines, %u bytes, %.1f ns/line, %.2f ns/byte\n", nmeaLines, (unsigned)nmeaBytes,
+		(double)nmeaNs / nmeaLines, (double)nmeaNs / nmeaBytes);
+	printf("UBX:  %u frames, %u bytes, %.1f ns/frame, %.2f ns/byte\n", ubxLines, (unsigned)ubxBytes,
+		(double)ubxNs / ubxLines, (double)ubxNs / ubxBytes);
+	printf("Stats: Sentences=%u ChecksumErrors=%u Unknown=%u UBXFrames=%u UBXErrors=%u\n",
+		(unsigned)gps.Stats.Sentences, (unsigned)gps.Stats.ChecksumErrors, (unsigned)gps.Stats.Unknown,
+		(unsigned)gps.Stats.UBXFrames, (unsigned)gps.Stats.UBXErrors);
+	printf("Reported %u of %u epochs, %u wrong positions\n", reported, expect, wrong);
+
+	if (wrong || gps.Stats.ChecksumErrors != bad || gps.Stats.UBXFrames != ubxLines || gps.Stats.UBXErrors || gps.Stats.Unknown)
+		return 1;
+	return 0;
+}
@@ -0,0 +1,301 @@
+/*
+ * uGFX heap allocation trace replay.
+ *
+ * Replays a trace of gfxAlloc(), gfxRealloc() and gfxFree() calls on gos_x_heap.c built with
+ * the firmware GFX_OS_HEAP_SIZE, then the same trace on the host malloc() for reference.
+ * Every block is filled when allocated and checked when freed, and heap use, the largest
+ * free block and the fragmentation are sampled once per simulated minute and at the end.
+ *
+ *	heap_replay					generated two hour ride
+ *	heap_replay <trace>			trace file, one call per line:
+ *									a <id> <size>	gfxAlloc
+ *									r <id> <size>	gfxRealloc
+ *									f <id>			gfxFree
+ *									t				a second has passed
+ *
+ * The generated ride has the widgets of a page and their texts, label texts changing every
+ * second, a PNG tile decoded every second, a GIF icon every ten seconds and a page change
+ * every thirty seconds. On the 64 bit host the slot header and alignment are 16 bytes
+ * instead of the board's 8, so heap use is somewhat higher than on the board.
+ *
+ * Exits with 1 when an allocation fails, a block is misaligned or its contents change.
+ */
+
+#include "gfx.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define REPLAY_SECONDS			7200
+#define REPLAY_MAX_IDS			4096
+#define REPLAY_MAX_OPS			2000000
+#define REPLAY_ALIGN			8
+#define REPLAY_LABELS			6
+#define REPLAY_PAGE_WIDGETS		16
+#define REPLAY_PAGE_SECONDS		30
+#define REPLAY_GIF_SECONDS		10
+#define REPLAY_PNG_PRIVATE		196				// gdisp_image_png.c private area
+#define REPLAY_PNG_DECODE		(32768 + 64)	// and its inflate window with state
+#define REPLAY_PNG_PALETTE		768
+#define REPLAY_GIF_PRIVATE		240
+#define REPLAY_GIF_DECODE		(4096 * 2 + 300)
+
+typedef struct replayOp {
+	char		op;
+	uint16_t	id;
+	uint32_t	size;
+} replayOp;
+
+static replayOp ops[REPLAY_MAX_OPS];
+static unsigned opCount;
+static uint16_t nextId;
+static uint16_t freeIds[REPLAY_MAX_IDS];
+static unsigned freeIdCount;
+static uint8_t *blocks[REPLAY_MAX_IDS];
+static uint32_t sizes[REPLAY_MAX_IDS];
+static unsigned errors;
+
+// Single thread, the heap mutex has nothing to guard
+void gfxMutexInit(gfxMutex *pmutex) {
+	(void)pmutex;
+}
+
+void gfxMutexEnter(gfxMutex *pmutex) {
+	(void)pmutex;
+}
+
+void gfxMutexExit(gfxMutex *pmutex) {
+	(void)pmutex;
+}
+
+void _gosHeapInit(void);
+
+static uint64_t nanoseconds(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+// Deterministic random number below n
+static uint32_t pick(uint32_t n) {
+	static uint32_t seed = 12345;
+
+	seed = seed * 1103515245u + 12345u;
+	return (seed >> 8) % n;
+}
+
+static void emit(char op, uint16_t id, uint32_t size) {
+	if (opCount == REPLAY_MAX_OPS) {
+		fprintf(stderr, "More than %u calls in trace\n", REPLAY_MAX_OPS);
+		exit(2);
+	}
+	ops[opCount].op = op;
+	ops[opCount].id = id;
+	ops[opCount].size = size;
+	opCount++;
+}
+
+static uint16_t alloc(uint32_t size) {
+	uint16_t id = freeIdCount ? freeIds[--freeIdCount] : nextId++;
+
+	emit('a', id, size);
+	return id;
+}
+
+static void release(uint16_t id) {
+	emit('f', id, 0);
+	freeIds[freeIdCount++] = id;
+}
+
+static void generate(void) {
+	uint16_t page[REPLAY_PAGE_WIDGETS * 2], labels[REPLAY_LABELS], priv, decode, palette;
+	unsigned s, i, n = 0;
+
+	// Fonts, the display and the widgets that stay on every page
+	for (i = 0; i < 3; i++)
+		alloc(180 + 40 * i);
+	for (i = 0; i < 8; i++)
+		alloc(96 + pick(160));
+	for (i = 0; i < REPLAY_LABELS; i++)
+		labels[i] = alloc(4 + pick(20));
+
+	for (s = 0; s < REPLAY_SECONDS; s++) {
+		// Page change, widgets and their texts are destroyed and the next page's created
+		if (s % REPLAY_PAGE_SECONDS == 0) {
+			while (n)
+				release(page[--n]);
+			for (i = 0; i < REPLAY_PAGE_WIDGETS; i++) {
+				page[n++] = alloc(80 + pick(320));
+				if (pick(2))
+					page[n++] = alloc(4 + pick(28));
+			}
+		}
+
+		// Labels get new text
+		for (i = 0; i < REPLAY_LABELS; i++) {
+			release(labels[i]);
+			labels[i] = alloc(4 + pick(20));
+		}
+
+		// Map tile, the decoder is opened, drawn and closed
+		priv = alloc(REPLAY_PNG_PRIVATE);
+		palette = pick(4) ? 0xFFFF : alloc(REPLAY_PNG_PALETTE);
+		decode = alloc(REPLAY_PNG_DECODE);
+		release(decode);
+		if (palette != 0xFFFF)
+			release(palette);
+		release(priv);
+
+		if (s % REPLAY_GIF_SECONDS == 0) {
+			priv = alloc(REPLAY_GIF_PRIVATE);
+			decode = alloc(REPLAY_GIF_DECODE);
+			emit('r', priv, REPLAY_GIF_PRIVATE + 64);
+			release(decode);
+			release(priv);
+		}
+		emit('t', 0, 0);
+	}
+}
+
+static void load(const char *name) {
+	FILE *f = fopen(name, "r");
+	char line[64], op;
+	unsigned id, size;
+
+	if (!f) {
+		fprintf(stderr, "%s can not be opened\n", name);
+		exit(2);
+	}
+	while (fgets(line, sizeof(line), f)) {
+		size = 0;
+		if (sscanf(line, " %c %u %u", &op, &id, &size) < 1 || id >= REPLAY_MAX_IDS)
+			continue;
+		emit(op, (uint16_t)id, size);
+	}
+	fclose(f);
+}
+
+static void fill(uint16_t id, uint32_t from) {
+	uint32_t i;
+
+	for (i = from; i < sizes[id]; i++)
+		blocks[id][i] = (uint8_t)(id * 31 + i);
+}
+
+static void check(uint16_t id) {
+	uint32_t i;
+
+	for (i = 0; i < sizes[id]; i++) {
+		if (blocks[id][i] != (uint8_t)(id * 31 + i)) {
+			errors++;
+			return;
+		}
+	}
+}
+
+static void sample(gfxHeapStats *worst, unsigned *worstFragmentation) {
+	gfxHeapStats st;
+
+	gfxHeapGetStats(&st);
+	if (!worst->LargestFree || st.LargestFree < worst->LargestFree)
+		worst->LargestFree = st.LargestFree;
+	if (st.FreeBlocks > worst->FreeBlocks)
+		worst->FreeBlocks = st.FreeBlocks;
+	if (st.Fragmentation > *worstFragmentation)
+		*worstFragmentation = st.Fragmentation;
+}
+
+// Replays the trace, on the uGFX heap when heap is set, otherwise on malloc()
+static uint64_t replay(bool_t heap, gfxHeapStats *worst, unsigned *worstFragmentation, unsigned *failures) {
+	uint64_t ns = 0, t;
+	unsigned i, seconds = 0;
+	uint32_t keep;
+	uint8_t *p;
+
+	memset(blocks, 0, sizeof(blocks));
+	for (i = 0; i < opCount; i++) {
+		replayOp *o = &ops[i];
+
+		if (o->op == 't') {
+			if (heap && ++seconds % 60 == 0)
+				sample(worst, worstFragmentation);
+			continue;
+		}
+		if (o->op == 'f' || o->op == 'r') {
+			if (!blocks[o->id])
+				continue;
+			if (heap)
+				check(o->id);
+		}
+
+		t = nanoseconds();
+		if (o->op == 'a')
+			p = heap ? gfxAlloc(o->size) : malloc(o->size);
+		else if (o->op == 'r')
+			p = heap ? gfxRealloc(blocks[o->id], sizes[o->id], o->size) : realloc(blocks[o->id], o->size);
+		else if (o->op == 'f') {
+			if (heap)
+				gfxFree(blocks[o->id]);
+			else
+				free(blocks[o->id]);
+			p = 0;
+		} else
+			continue;
+		ns += nanoseconds() - t;
+
+		if (o->op == 'f') {
+			blocks[o->id] = 0;
+			continue;
+		}
+		if (!p) {
+			(*failures)++;
+			continue;
+		}
+		if ((uintptr_t)p % REPLAY_ALIGN)
+			errors++;
+		// Contents up to the smaller size move along with a reallocation
+		keep = o->op == 'r' && o->size < sizes[o->id] ? o->size : o->op == 'r' ? sizes[o->id] : 0;
+		blocks[o->id] = p;
+		if (heap && keep) {
+			sizes[o->id] = keep;
+			check(o->id);
+		}
+		sizes[o->id] = o->size;
+		if (heap)
+			fill(o->id, keep);
+	}
+	return ns;
+}
+
+int main(int argc, char **argv) {
+	gfxHeapStats st, worst;
+	unsigned worstFragmentation = 0, failures = 0, mallocFailures = 0, calls = 0, i;
+	uint64_t heapNs, mallocNs;
+
+	if (argc > 1)
+		load(argv[1]);
+	else
+		generate();
+	for (i = 0; i < opCount; i++)
+		calls += ops[i].op != 't';
+
+	_gosHeapInit();
+	memset(&worst, 0, sizeof(worst));
+	heapNs = replay(TRUE, &worst, &worstFragmentation, &failures);
+	sample(&worst, &worstFragmentation);
+	gfxHeapGetStats(&st);
+	mallocNs = replay(FALSE, 0, 0, &mallocFailures);
+
+	printf("%u calls, heap of %u bytes, %.1f ns per call, malloc %.1f ns\n", calls, (unsigned)st.Size,
+		(double)heapNs / calls, (double)mallocNs / calls);
+	printf("High water %u bytes, %u small allocations from %u runs, %u runs given back\n", (unsigned)st.HighWater,
+		(unsigned)st.SmallAllocs, (unsigned)st.SmallRuns, (unsigned)st.RunReleases);
+	printf("Per minute: largest free at least %u bytes, at most %u free blocks, fragmentation at most %u%%\n",
+		(unsigned)worst.LargestFree, worst.FreeBlocks, worstFragmentation);
+	printf("At end: %u bytes used, largest free %u bytes, %u free blocks, %u failures, %u errors\n", (unsigned)st.Used,
+		(unsigned)st.LargestFree, st.FreeBlocks, failures, errors);
+	return failures || errors;
+}
@@ -0,0 +1,112 @@
+/*
+ * Fixed-point projection accuracy check.
+ *
+ * Compares projToWorld() with the double precision Web-Mercator formula and projToLatLon()
+ * with the position it started from, over a grid of latitudes to the Mercator limit and all
+ * longitudes including both ends. Errors are given in z18 pixels and 1e-7 degrees, and the
+ * time per call is reported.
+ *
+ * Exits with 1 when the z18 error reaches half a pixel or the round trip is off by more than
+ * PROJ_CHECK_MAX_E7 within +-80 degrees latitude.
+ */
+
+#include "projection.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define PROJ_CHECK_ZOOM			18
+#define PROJ_CHECK_LAT_STEP		123457			// 1e-7 degrees, not a multiple of the table step
+#define PROJ_CHECK_LON_STEP		1234567
+#define PROJ_CHECK_LIMIT_E7		800000000
+#define PROJ_CHECK_MAX_PX		0.5
+#define PROJ_CHECK_MAX_E7		10
+
+static double worldX(int32_t lonE7) {
+	return (lonE7 / 1e7 + 180.0) / 360.0 * 4294967296.0;
+}
+
+static double worldY(int32_t latE7) {
+	double lat = latE7 / 1e7 * M_PI / 180.0;
+
+	return (0.5 - log(tan(M_PI / 4.0 + lat / 2.0)) / (2.0 * M_PI)) * 4294967296.0;
+}
+
+static uint64_t nanoseconds(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+int main(void) {
+	const double pixel = (double)(1u << PROJ_PIXEL_SHIFT(PROJ_CHECK_ZOOM));
+	double e, maxX = 0, maxY = 0, maxYAll = 0;
+	int64_t d, maxLat = 0, maxLon = 0, maxLatAll = 0;
+	uint64_t t, forwardNs, inverseNs;
+	unsigned calls = 0;
+	volatile uint32_t sink = 0;
+	proj_world_t world;
+	proj_latlon_t back;
+	int64_t lat, lon;
+	int inside;
+
+	projInit();
+
+	for (lat = -PROJ_MAX_LATITUDE_E7; lat <= PROJ_MAX_LATITUDE_E7; lat += PROJ_CHECK_LAT_STEP) {
+		inside = lat >= -PROJ_CHECK_LIMIT_E7 && lat <= PROJ_CHECK_LIMIT_E7;
+		for (lon = -1800000000; lon <= 1800000000; lon += lon == 1799999999 ? 1 : PROJ_CHECK_LON_STEP) {
+			if (lon > 1799999999 && lon < 1800000000)
+				lon = 1799999999;
+			projToWorld((int32_t)lat, (int32_t)lon, &world);
+
+			// World x wraps to 0 at +180 degrees
+			e = fabs(fmod(world.x - worldX((int32_t)lon) + 6442450944.0, 4294967296.0) - 2147483648.0) / pixel;
+			if (e > maxX)
+				maxX = e;
+			e = fabs(world.y - worldY((int32_t)lat)) / pixel;
+			if (e > maxYAll)
+				maxYAll = e;
+			if (inside && e > maxY)
+				maxY = e;
+
+			projToLatLon(&world, &back);
+			d = llabs(back.LatitudeE7 - lat);
+			if (d > maxLatAll)
+				maxLatAll = d;
+			if (inside && d > maxLat)
+				maxLat = d;
+			d = llabs(back.LongitudeE7 - lon);
+			if (d > 1800000000)
+				d = 3600000000 - d;
+			if (d > maxLon)
+				maxLon = d;
+			calls++;
+		}
+	}
+
+	t = nanoseconds();
+	for (lat = -PROJ_MAX_LATITUDE_E7; lat <= PROJ_MAX_LATITUDE_E7; lat += 1237) {
+		projToWorld((int32_t)lat, (int32_t)(lat * 2), &world);
+		sink += world.x ^ world.y;
+	}
+	forwardNs = nanoseconds() - t;
+	t = nanoseconds();
+	for (lat = -PROJ_MAX_LATITUDE_E7; lat <= PROJ_MAX_LATITUDE_E7; lat += 1237) {
+		world.x = (uint32_t)lat * 5;
+		world.y = (uint32_t)lat * 3;
+		projToLatLon(&world, &back);
+		sink += back.LatitudeE7 ^ back.LongitudeE7;
+	}
+	inverseNs = nanoseconds() - t;
+
+	printf("%u points, world x %.4f px, world y %.4f px within +-80 degrees, %.4f px to +-85.05 at z%d\n",
+		calls, maxX, maxY, maxYAll, PROJ_CHECK_ZOOM);
+	printf("Round trip latitude %lld within +-80 degrees, %lld to +-85.05, longitude %lld in 1e-7 degrees\n",
+		(long long)maxLat, (long long)maxLatAll, (long long)maxLon);
+	printf("projToWorld %.1f ns, projToLatLon %.1f ns\n", forwardNs / (2.0 * PROJ_MAX_LATITUDE_E7 / 1237),
+		inverseNs / (2.0 * PROJ_MAX_LATITUDE_E7 / 1237));
+
+	return maxX >= PROJ_CHECK_MAX_PX || maxY >= PROJ_CHECK_MAX_PX || maxLat > PROJ_CHECK_MAX_E7 || maxLon > PROJ_CHECK_MAX_E7;
+}
@@ -0,0 +1,174 @@
+/*
+ * GQUEUE ring queue stress test.
+ *
+ * RING_STRESS_PRODUCERS threads put numbered items to one multi producer ring queue as fast
+ * as they can, in batches of 1 to RING_STRESS_BATCH items, some with gfxQueueRingPut() and
+ * some with gfxQueueRingPutI(). When the queue is full the batch is tried again. The main
+ * thread is the single getter, it takes up to RING_STRESS_GET items at a time and sleeps
+ * on the queue when it is empty.
+ *
+ *	ring_stress					RING_STRESS_ITEMS items per producer
+ *	ring_stress <items>			items per producer
+ *
+ * The queue is small so that it fills often, and every RING_STRESS_PAUSE_EVERY batches a
+ * producer sleeps so that the getter also finds it empty and has to be woken.
+ *
+ * Exits with 1 when an item is lost, duplicated or out of order for its producer, when a
+ * batch is split up, or when gfxQueueRingGetStats() disagrees with the counts of the test.
+ */
+
+#include "gfx.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define RING_STRESS_PRODUCERS		4
+#define RING_STRESS_ITEMS			2000000
+#define RING_STRESS_SLOTS			64				// Power of two
+#define RING_STRESS_BATCH			4
+#define RING_STRESS_GET				16
+#define RING_STRESS_PAUSE_EVERY		50000
+#define RING_STRESS_WAIT_MS			1000			// A getter timeout means a lost wake up
+#define RING_STRESS_SEQ_BITS		24
+#define RING_STRESS_LEFT_BITS		2				// Holds RING_STRESS_BATCH-1
+
+// Items are the producer number, the items left in its batch and its sequence number from 1
+#define RING_STRESS_ITEM(p, left, seq)	((void *)(((uintptr_t)(p) << (RING_STRESS_SEQ_BITS + RING_STRESS_LEFT_BITS)) \
+									| ((uintptr_t)(left) << RING_STRESS_SEQ_BITS) | (seq)))
+#define RING_STRESS_PRODUCER(item)	((unsigned)((uintptr_t)(item) >> (RING_STRESS_SEQ_BITS + RING_STRESS_LEFT_BITS)))
+#define RING_STRESS_LEFT(item)		((unsigned)((uintptr_t)(item) >> RING_STRESS_SEQ_BITS) & ((1u << RING_STRESS_LEFT_BITS) - 1))
+#define RING_STRESS_SEQ(item)		((uint32_t)((uintptr_t)(item) & ((1u << RING_STRESS_SEQ_BITS) - 1)))
+
+typedef struct ringProducer {
+	pthread_t	thread;
+	unsigned	id;
+	uint32_t	refused;		// Items of batches that found the queue full
+	uint32_t	batches;
+} ringProducer;
+
+static gfxQueueRing queue;
+static gfxQueueRingSlot slots[RING_STRESS_SLOTS];
+static ringProducer producers[RING_STRESS_PRODUCERS];
+static uint32_t itemsEach = RING_STRESS_ITEMS;
+static volatile bool_t stop;					// The getter has given up
+
+static uint64_t nanoseconds(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static void *produce(void *param) {
+	ringProducer *	pr = param;
+	void *			batch[RING_STRESS_BATCH];
+	uint32_t		seed = 12345 + pr->id, seq = 1;
+	unsigned		n, i;
+
+	while (seq <= itemsEach && !stop) {
+		// Deterministic batch size
+		seed = seed * 1103515245u + 12345u;
+		n = 1 + (seed >> 8) % RING_STRESS_BATCH;
+		if (n > itemsEach + 1 - seq)
+			n = itemsEach + 1 - seq;
+		for (i = 0; i < n; i++)
+			batch[i] = RING_STRESS_ITEM(pr->id, n - 1 - i, seq + i);
+
+		// Odd producers stand in for interrupt routines
+		while (!((pr->id & 1) ? gfxQueueRingPutI(&queue, batch, n) : gfxQueueRingPut(&queue, batch, n))) {
+			pr->refused += n;
+			if (stop)
+				return 0;
+			sched_yield();
+		}
+		seq += n;
+		if (++pr->batches % RING_STRESS_PAUSE_EVERY == 0)
+			gfxSleepMilliseconds(2);
+	}
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	uint32_t			expect[RING_STRESS_PRODUCERS], total, got = 0, refused = 0, batches = 0, errors = 0;
+	uint32_t			split = 0, timeouts = 0;
+	void *				items[RING_STRESS_GET];
+	gfxQueueRingStats	st;
+	unsigned			n, i, p, left = 0, last = RING_STRESS_PRODUCERS;
+	uint64_t			t;
+
+	if (argc > 1)
+		itemsEach = (uint32_t)strtoul(argv[1], 0, 0);
+	if (!itemsEach || itemsEach >= (1u << RING_STRESS_SEQ_BITS)) {
+		fprintf(stderr, "Items per producer must be 1 to %u\n", (1u << RING_STRESS_SEQ_BITS) - 1);
+		return 2;
+	}
+	total = itemsEach * RING_STRESS_PRODUCERS;
+
+	gfxQueueRingInit(&queue, slots, RING_STRESS_SLOTS, TRUE);
+	for (p = 0; p < RING_STRESS_PRODUCERS; p++)
+		expect[p] = 1;
+
+	t = nanoseconds();
+	for (p = 0; p < RING_STRESS_PRODUCERS; p++) {
+		producers[p].id = p;
+		if (pthread_create(&producers[p].thread, 0, produce, &producers[p])) {
+			fprintf(stderr, "Producer %u can not be started\n", p);
+			return 2;
+		}
+	}
+
+	while (got < total) {
+		if (!(n = gfxQueueRingGet(&queue, items, RING_STRESS_GET, RING_STRESS_WAIT_MS))) {
+			if (++timeouts == 3)
+				break;
+			continue;
+		}
+		for (i = 0; i < n; i++) {
+			p = RING_STRESS_PRODUCER(items[i]);
+
+			// A batch is in consecutive slots, its items must come one after the other
+			if (left && (p != last || RING_STRESS_LEFT(items[i]) != left - 1))
+				split++;
+			left = RING_STRESS_LEFT(items[i]);
+			last = p;
+
+			if (p >= RING_STRESS_PRODUCERS || RING_STRESS_SEQ(items[i]) != expect[p]) {
+				errors++;
+				if (p >= RING_STRESS_PRODUCERS)
+					continue;
+				expect[p] = RING_STRESS_SEQ(items[i]);
+			}
+			expect[p]++;
+		}
+		got += n;
+	}
+	t = nanoseconds() - t;
+	stop = TRUE;
+
+	for (p = 0; p < RING_STRESS_PRODUCERS; p++) {
+		pthread_join(producers[p].thread, 0);
+		refused += producers[p].refused;
+		batches += producers[p].batches;
+		if (expect[p] != itemsEach + 1)
+			errors++;
+	}
+
+	// Nothing may be left over
+	if (gfxQueueRingGetI(&queue, items, RING_STRESS_GET))
+		errors++;
+	gfxQueueRingGetStats(&queue, &st);
+	gfxQueueRingDeinit(&queue);
+
+	printf("%u producers, %u items in %u batches, %.1f ns per item, %u getter timeouts\n", RING_STRESS_PRODUCERS,
+		(unsigned)got, (unsigned)batches, (double)t / (got ? got : 1), (unsigned)timeouts);
+	printf("Stats: %u puts, %u gets, %u refused (%u counted), %u waits, depth %u, high water %u of %u\n",
+		(unsigned)st.Puts, (unsigned)st.Gets, (unsigned)st.Full, (unsigned)refused, (unsigned)st.Waits,
+		(unsigned)st.Depth, (unsigned)st.HighWater, RING_STRESS_SLOTS);
+	printf("%u batches split, %u errors\n", (unsigned)split, (unsigned)errors);
+
+	return errors || split || left || timeouts || got != total || st.Puts != total || st.Gets != total || st.Full != refused
+		|| st.Depth || st.HighWater > RING_STRESS_SLOTS;
+}
@@ -0,0 +1,248 @@
+/*
+ * Route matching benchmark.
+ *
+ * Loads a route with routeLoad() and times routeUpdate() for fixes that follow the route,
+ * where the segments after the last match are tried first, and for fixes that jump to a
+ * random place on it, which need the spatial query of the hashed grid.
+ *
+ *	route_query					generated route, checks the matched position
+ *	route_query <route.gpx>		times the queries on a route file
+ *
+ * The generated route zigzags over ROUTE_BENCH_LEGS legs of 1 km east or west joined by
+ * 200 m north, so it turns every leg and passes close to itself. Fixes have up to
+ * ROUTE_BENCH_NOISE_M of noise across the route. Exits with 1 when a matched distance,
+ * the next turn or the off route state is wrong.
+ */
+
+#include "route.h"
+#include "sdram.h"
+#include "gfx.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#define ROUTE_BENCH_LEGS			24
+#define ROUTE_BENCH_LEG_M			1000.0
+#define ROUTE_BENCH_STEP_M			200.0
+#define ROUTE_BENCH_SPACING_M		10.0
+#define ROUTE_BENCH_SPEED_M			7.0				// Distance between following fixes
+#define ROUTE_BENCH_NOISE_M			8.0
+#define ROUTE_BENCH_JUMPS			200000
+#define ROUTE_BENCH_MAX_ERROR_M		(2 * ROUTE_BENCH_NOISE_M + 1)	// Noise can put a fix past a corner on the other leg
+#define ROUTE_BENCH_OFF_M			400.0
+#define ROUTE_BENCH_FILE			"/tmp/route_query.gpx"
+#define ROUTE_BENCH_METERS_PER_DEG	111319.49
+
+static int32_t startLatE7 = 510776000, startLonE7 = -1141318000;
+static double routeLength;
+
+// Clock, RTOS and file calls used by route.c, files are read with stdio
+uint32_t HAL_GetTick(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+osMutexId osMutexCreate(const osMutexDef_t *mutex_def) {
+	(void)mutex_def;
+	return (osMutexId)1;
+}
+
+osStatus osMutexWait(osMutexId mutex_id, uint32_t millisec) {
+	(void)mutex_id; (void)millisec;
+	return osOK;
+}
+
+osStatus osMutexRelease(osMutexId mutex_id) {
+	(void)mutex_id;
+	return osOK;
+}
+
+GFILE *gfileOpen(const char *fname, const char *mode) {
+	return (GFILE *)fopen(fname, mode);
+}
+
+size_t gfileRead(GFILE *f, void *buf, size_t len) {
+	return fread(buf, 1, len, (FILE *)f);
+}
+
+void gfileClose(GFILE *f) {
+	fclose((FILE *)f);
+}
+
+static uint64_t nanoseconds(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+// Deterministic noise in -1..1
+static double noise(void) {
+	static uint32_t seed = 12345;
+
+	seed = seed * 1103515245u + 12345u;
+	return (double)(seed >> 8) / (1u << 23) - 1.0;
+}
+
+// Position at distance m along the generated route, offset across it, and distance to the next corner,
+// returns distance from the corner before
+static double routeAt(double m, double across, int32_t *latE7, int32_t *lonE7, double *nextTurn) {
+	double leg = ROUTE_BENCH_LEG_M + ROUTE_BENCH_STEP_M, east, north, in;
+	int i = (int)(m / leg);
+
+	in = m - i * leg;
+	north = i * ROUTE_BENCH_STEP_M;
+	if (in < ROUTE_BENCH_LEG_M) {
+		east = (i & 1) ? ROUTE_BENCH_LEG_M - in : in;
+		north += across;
+		*nextTurn = ROUTE_BENCH_LEG_M - in;
+	} else {
+		east = (i & 1) ? -across : ROUTE_BENCH_LEG_M + across;
+		north += in - ROUTE_BENCH_LEG_M;
+		*nextTurn = leg - in;
+	}
+	*latE7 = startLatE7 + (int32_t)lround(north / ROUTE_BENCH_METERS_PER_DEG * 1e7);
+	*lonE7 = startLonE7 + (int32_t)lround(east / (ROUTE_BENCH_METERS_PER_DEG * cos(*latE7 * M_PI / 1800000000.0)) * 1e7);
+	return in < ROUTE_BENCH_LEG_M ? in : in - ROUTE_BENCH_LEG_M;
+}
+
+static void writeRoute(void) {
+	FILE *f = fopen(ROUTE_BENCH_FILE, "w");
+	int32_t latE7, lonE7;
+	double m, turn;
+
+	if (!f) {
+		fprintf(stderr, "%s can not be written\n", ROUTE_BENCH_FILE);
+		exit(2);
+	}
+	routeLength = ROUTE_BENCH_LEGS * (ROUTE_BENCH_LEG_M + ROUTE_BENCH_STEP_M) - ROUTE_BENCH_STEP_M;
+	fprintf(f, "<?xml version=\"1.0\"?>\n<gpx version=\"1.1\"><trk><trkseg>\n");
+	for (m = 0; m <= routeLength + 0.001; m += ROUTE_BENCH_SPACING_M) {
+		routeAt(m, 0, &latE7, &lonE7, &turn);
+		fprintf(f, "<trkpt lat=\"%.7f\" lon=\"%.7f\"></trkpt>\n", latE7 / 1e7, lonE7 / 1e7);
+	}
+	fprintf(f, "</trkseg></trk></gpx>\n");
+	fclose(f);
+}
+
+// Fix at segment of the loaded route, generated ones with noise across the route
+static double segmentFix(uint32_t segment, bool generated, int32_t *latE7, int32_t *lonE7, double *m, double *turn) {
+	// Points are at the start of the route area as laid out by route.c
+	const proj_world_t *points = (const proj_world_t *)(uintptr_t)SDRAM_ROUTE_ADDR;
+	proj_world_t mid;
+	proj_latlon_t at;
+
+	*m = (segment + 0.5) * ROUTE_BENCH_SPACING_M;
+	if (generated)
+		return routeAt(*m, noise() * ROUTE_BENCH_NOISE_M, latE7, lonE7, turn);
+	mid.x = points[segment].x + (int32_t)(points[segment + 1].x - points[segment].x) / 2;
+	mid.y = points[segment].y + (int32_t)(points[segment + 1].y - points[segment].y) / 2;
+	projToLatLon(&mid, &at);
+	*latE7 = at.LatitudeE7;
+	*lonE7 = at.LongitudeE7;
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	const char *file = argc > 1 ? argv[1] : ROUTE_BENCH_FILE;
+	bool generated = argc == 1, offRoute, backOn = true;
+	double m, turn, since, error, errorMax = 0, turnErrorMax = 0, jumpErrorMax = 0;
+	uint64_t t, followNs, jumpNs;
+	uint32_t i, segments, hits, candidates, spatial;
+	route_status_t status;
+	route_stats_t stats;
+	int32_t latE7, lonE7;
+
+	// Route is kept at its SDRAM address as on the board
+	if (mmap((void *)(uintptr_t)SDRAM_DEVICE_ADDR, SDRAM_DEVICE_SIZE, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) != (void *)(uintptr_t)SDRAM_DEVICE_ADDR) {
+		fprintf(stderr, "SDRAM can not be mapped at 0x%08X\n", (unsigned)SDRAM_DEVICE_ADDR);
+		return 2;
+	}
+	if (generated)
+		writeRoute();
+
+	projInit();
+	routeInit();
+	if (!routeLoad(file)) {
+		fprintf(stderr, "%s can not be loaded\n", file);
+		return 2;
+	}
+	routeGetStats(&stats);
+	segments = stats.Points - 1;
+	printf("%u points, %u turns, %u index entries, cell 2^%u, loaded in %u ms\n", (unsigned)stats.Points,
+		(unsigned)stats.Turns, (unsigned)stats.IndexEntries, stats.CellShift, (unsigned)stats.LoadMS);
+
+	// Riding along, one fix per segment
+	t = nanoseconds();
+	for (i = 0; i < segments; i++) {
+		since = segmentFix(i, generated, &latE7, &lonE7, &m, &turn);
+		routeUpdate(latE7, lonE7);
+		if (!generated)
+			continue;
+		routeGetStatus(&status);
+		error = fabs(status.DistanceAlongM - m);
+		if (error > errorMax)
+			errorMax = error;
+		// Last corner is the end of the route, turns are only known a span before, just after
+		// a corner the fix may still match the leg before it
+		if (turn > ROUTE_TURN_SPAN_M && since > ROUTE_BENCH_NOISE_M && m + turn < routeLength - 1) {
+			error = fabs(status.NextTurnM - turn);
+			if (error > turnErrorMax)
+				turnErrorMax = error;
+		}
+	}
+	followNs = nanoseconds() - t;
+	routeGetStats(&stats);
+	hits = stats.FollowHits;
+	candidates = stats.Candidates;
+	printf("Following: %.0f ns per fix, %u of %u matched without spatial query\n", (double)followNs / segments,
+		(unsigned)hits, (unsigned)segments);
+
+	// Jumping to random segments, nearly all need the spatial query. Of the segments within
+	// ROUTE_ON_M the one after the last match wins, so only a wrong pass of the route is an error
+	t = nanoseconds();
+	for (i = 0; i < ROUTE_BENCH_JUMPS; i++) {
+		segmentFix((uint32_t)((noise() + 1.0) / 2.0 * (segments - 1) + 0.5), generated, &latE7, &lonE7, &m, &turn);
+		routeUpdate(latE7, lonE7);
+		if (!generated)
+			continue;
+		routeGetStatus(&status);
+		error = fabs(status.DistanceAlongM - m);
+		if (error > jumpErrorMax)
+			jumpErrorMax = error;
+	}
+	jumpNs = nanoseconds() - t;
+	routeGetStats(&stats);
+	spatial = ROUTE_BENCH_JUMPS - (stats.FollowHits - hits);
+	printf("Jumping: %.0f ns per fix, %u spatial queries, %.1f segments tested per query, %u most\n",
+		(double)jumpNs / ROUTE_BENCH_JUMPS, (unsigned)spatial, (double)(stats.Candidates - candidates) / spatial,
+		(unsigned)stats.MaxCandidates);
+	if (!generated)
+		return 0;
+
+	// Far from the route for ROUTE_OFF_FIXES fixes, then back on it
+	for (i = 0; i < ROUTE_OFF_FIXES; i++) {
+		routeGetStatus(&status);
+		if (status.OffRoute)
+			backOn = false;
+		routeAt(ROUTE_BENCH_LEG_M / 2, -ROUTE_BENCH_OFF_M, &latE7, &lonE7, &turn);
+		routeUpdate(latE7, lonE7);
+	}
+	routeGetStatus(&status);
+	offRoute = status.OffRoute;
+	routeAt(ROUTE_BENCH_LEG_M / 2, 0, &latE7, &lonE7, &turn);
+	routeUpdate(latE7, lonE7);
+	routeGetStatus(&status);
+	backOn = backOn && !status.OffRoute;
+
+	printf("Distance along %.1f m max error following, %.1f m jumping, next turn %.1f m, off route %s, back on %s\n",
+		errorMax, jumpErrorMax, turnErrorMax, offRoute ? "yes" : "no", backOn ? "yes" : "no");
+	return errorMax > ROUTE_BENCH_MAX_ERROR_M || turnErrorMax > ROUTE_BENCH_MAX_ERROR_M ||
+		jumpErrorMax > ROUTE_ON_M + ROUTE_BENCH_MAX_ERROR_M || !offRoute || !backOn;
+}
@@ -0,0 +1,270 @@
+/*
+ * Rotated map blitter benchmark and check.
+ *
+ * Draws the heading up map through tilesDraw() of tiles.c into a screen buffer, with the map
+ * area and marker of the data screen, at headings all around the circle and with the marker
+ * moving by fractions of a pixel. The tile cache holds the 3x3 tiles around the marker at
+ * BENCH_ZOOM except one corner, which comes from its cached parent, the rest are holes.
+ *
+ *	tiles_rotate				nearest pixel, the firmware default
+ *
+ * Built with -DTILES_ROTATE_BILINEAR=TRUE it measures the bilinear path with its two pixels
+ * per multiply blend instead. Every pixel is compared with a reference computed in double
+ * precision from the same generated map, exactly for nearest pixel and within BENCH_TOLERANCE
+ * per colour for bilinear. Times are host times, the board is many times slower, but the
+ * ratio between the two builds shows what the blend costs.
+ *
+ * Exits with 1 when a pixel differs from the reference.
+ */
+
+#include "tiles.c"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_ZOOM				16
+#define BENCH_TILE_X			11500			// Marker tile
+#define BENCH_TILE_Y			22300
+#define BENCH_X					305				// Map area and marker of the data screen
+#define BENCH_Y					0
+#define BENCH_CX				(GDISP_SCREEN_WIDTH - BENCH_X)
+#define BENCH_CY				GDISP_SCREEN_HEIGHT
+#define BENCH_CENTER_X			552
+#define BENCH_CENTER_Y			240
+#define BENCH_HEADING_STEP		7
+#define BENCH_REPEAT			20
+#define BENCH_TOLERANCE			2				// Bilinear error per colour in its own units
+
+static pixel_t screen[GDISP_SCREEN_HEIGHT][GDISP_SCREEN_WIDTH];
+static pixel_t tileBits[10][TILES_SIZE * TILES_SIZE];
+static uint32_t wrong, checked, worst;
+
+// Single thread and no display, tiles.c only needs these to link, tilesInit() is not used
+GDisplay *GDISP;
+
+GDisplay *gdispPixmapCreateFrom(coord_t width, coord_t height, void *mem) {
+	(void)width; (void)height; (void)mem;
+	return 0;
+}
+
+pixel_t *gdispPixmapGetBits(GDisplay *g) {
+	(void)g;
+	return 0;
+}
+
+void gdispGGetClip(GDisplay *g, coord_t *x, coord_t *y, coord_t *cx, coord_t *cy) {
+	(void)g; *x = *y = *cx = *cy = 0;
+}
+
+void gdispGSetClip(GDisplay *g, coord_t x, coord_t y, coord_t cx, coord_t cy) {
+	(void)g; (void)x; (void)y; (void)cx; (void)cy;
+}
+
+uint32_t HAL_GetTick(void) {
+	return 0;
+}
+
+int formatString(char *str, int sizeOfString, const char *format, ...) {
+	va_list ap;
+	int n;
+
+	va_start(ap, format);
+	n = vsnprintf(str, sizeOfString, format, ap);
+	va_end(ap);
+	return n;
+}
+
+bool_t gfileRamfsPin(const char *fname) {
+	(void)fname;
+	return TRUE;
+}
+
+void gfileRamfsUnpinAll(void) {
+}
+
+// Tiles that are not cached are not on the card either
+GFILE *gfileOpen(const char *fname, const char *mode) {
+	(void)fname; (void)mode;
+	return 0;
+}
+
+gdispImageError gdispImageOpenGFile(gdispImage *img, GFILE *f) {
+	(void)img; (void)f;
+	return GDISP_IMAGE_ERR_NOSUCHFILE;
+}
+
+void gdispImageClose(gdispImage *img) {
+	(void)img;
+}
+
+gdispImageError gdispGImageDraw(GDisplay *g, gdispImage *img, coord_t x, coord_t y, coord_t cx, coord_t cy, coord_t sx, coord_t sy) {
+	(void)g; (void)img; (void)x; (void)y; (void)cx; (void)cy; (void)sx; (void)sy;
+	return GDISP_IMAGE_ERR_OK;
+}
+
+void gdispGFillArea(GDisplay *g, coord_t x, coord_t y, coord_t cx, coord_t cy, color_t color) {
+	(void)g; (void)x; (void)y; (void)cx; (void)cy; (void)color;
+}
+
+void gdispGBlitArea(GDisplay *g, coord_t x, coord_t y, coord_t cx, coord_t cy, coord_t srcx, coord_t srcy, coord_t srccx, const pixel_t *buffer) {
+	coord_t i;
+
+	(void)g;
+	for (i = 0; i < cy; i++)
+		memcpy(&screen[y + i][x], buffer + (srcy + i) * srccx + srcx, cx * sizeof(pixel_t));
+}
+
+// Generated map in global pixels of BENCH_ZOOM, smooth ramps crossed by sharp stripes
+static pixel_t mapPixel(int64_t gx, int64_t gy) {
+	uint32_t r = (uint32_t)(gx >> 2) & 31, g = (uint32_t)(gy * 3 >> 2) & 63, b = ((gx ^ gy) & 16) ? 31 : 4;
+
+	return (pixel_t)(r << 11 | g << 5 | b);
+}
+
+// The tiles of the cache, the corner below right of the marker tile only through its parent
+static bool tileCached(int64_t tx, int64_t ty) {
+	return tx >= BENCH_TILE_X - 1 && tx <= BENCH_TILE_X + 1 && ty >= BENCH_TILE_Y - 1 && ty <= BENCH_TILE_Y + 1 &&
+		!(tx == BENCH_TILE_X + 1 && ty == BENCH_TILE_Y + 1);
+}
+
+static bool parentCached(int64_t tx, int64_t ty) {
+	return tx >> 1 == (BENCH_TILE_X + 1) >> 1 && ty >> 1 == (BENCH_TILE_Y + 1) >> 1;
+}
+
+// What the blitter should find at a global pixel, background outside the cached tiles and parent
+static int32_t referencePixel(int64_t gx, int64_t gy) {
+	if (tileCached(gx >> TILES_SHIFT, gy >> TILES_SHIFT))
+		return mapPixel(gx, gy);
+	if (parentCached(gx >> TILES_SHIFT, gy >> TILES_SHIFT))
+		return mapPixel(gx & ~1, gy & ~1);
+	return TILES_BACKGROUND;
+}
+
+static void cacheTile(unsigned n, uint8_t zoom, uint32_t tx, uint32_t ty) {
+	uint32_t levels = BENCH_ZOOM - zoom, px, py;
+
+	for (py = 0; py < TILES_SIZE; py++) {
+		for (px = 0; px < TILES_SIZE; px++)
+			tileBits[n][py * TILES_SIZE + px] = mapPixel(((int64_t)tx * TILES_SIZE + px) << levels,
+				((int64_t)ty * TILES_SIZE + py) << levels);
+	}
+	slots[n].bits = tileBits[n];
+	slots[n].zoom = zoom;
+	slots[n].x = tx;
+	slots[n].y = ty;
+	slots[n].state = TILE_READY;
+}
+
+static void fillCache(void) {
+	unsigned n = 0;
+	int32_t dx, dy;
+
+	for (dy = -1; dy <= 1; dy++) {
+		for (dx = -1; dx <= 1; dx++) {
+			if (tileCached(BENCH_TILE_X + dx, BENCH_TILE_Y + dy))
+				cacheTile(n++, BENCH_ZOOM, BENCH_TILE_X + dx, BENCH_TILE_Y + dy);
+		}
+	}
+	cacheTile(n, BENCH_ZOOM - 1, (BENCH_TILE_X + 1) >> 1, (BENCH_TILE_Y + 1) >> 1);
+}
+
+#if TILES_ROTATE_BILINEAR
+static uint32_t channelError(uint32_t got, double want, uint32_t shift, uint32_t bits) {
+	double e = fabs((double)((got >> shift) & ((1u << bits) - 1)) - want);
+
+	return (uint32_t)(e + 0.5);
+}
+#endif
+
+// Screen pixels against the map sampled at the same 16.16 positions as the blitter
+static void checkDraw(const proj_world_t *center, int16_t heading) {
+	fixed c = ffcos(heading), s = ffsin(heading);
+	int64_t mu = ((int64_t)center->x << 16) >> PROJ_PIXEL_SHIFT(BENCH_ZOOM);
+	int64_t mv = ((int64_t)center->y << 16) >> PROJ_PIXEL_SHIFT(BENCH_ZOOM);
+	int64_t u, v;
+	int32_t x, y, ox, oy;
+	pixel_t got;
+#if TILES_ROTATE_BILINEAR
+	int32_t corner[4], k;
+	double fu, fv, w[4], want[3];
+	uint32_t e;
+#else
+	int32_t ref;
+#endif
+
+	for (y = BENCH_Y; y < BENCH_Y + BENCH_CY; y++) {
+		for (x = BENCH_X; x < BENCH_X + BENCH_CX; x++) {
+			ox = x - BENCH_CENTER_X;
+			oy = y - BENCH_CENTER_Y;
+			u = mu + (int64_t)c * ox - (int64_t)s * oy;
+			v = mv + (int64_t)s * ox + (int64_t)c * oy;
+			got = screen[y][x];
+			checked++;
+#if TILES_ROTATE_BILINEAR
+			u -= FIXED0_5;
+			v -= FIXED0_5;
+			for (k = 0; k < 4; k++)
+				corner[k] = referencePixel((u >> 16) + (k & 1), (v >> 16) + (k >> 1));
+			fu = (double)(u & 0xFFFF) / 65536;
+			fv = (double)(v & 0xFFFF) / 65536;
+			w[0] = (1 - fu) * (1 - fv);
+			w[1] = fu * (1 - fv);
+			w[2] = (1 - fu) * fv;
+			w[3] = fu * fv;
+			want[0] = want[1] = want[2] = 0;
+			for (k = 0; k < 4; k++) {
+				want[0] += w[k] * (corner[k] >> 11);
+				want[1] += w[k] * ((corner[k] >> 5) & 63);
+				want[2] += w[k] * (corner[k] & 31);
+			}
+			e = channelError(got, want[0], 11, 5);
+			e = channelError(got, want[1], 5, 6) > e ? channelError(got, want[1], 5, 6) : e;
+			e = channelError(got, want[2], 0, 5) > e ? channelError(got, want[2], 0, 5) : e;
+			worst = e > worst ? e : worst;
+			wrong += e > BENCH_TOLERANCE;
+#else
+			ref = referencePixel(u >> 16, v >> 16);
+			wrong += got != (pixel_t)ref;
+#endif
+		}
+	}
+}
+
+static uint64_t nanoseconds(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+int main(void) {
+	proj_world_t center;
+	uint64_t t, total = 0;
+	uint32_t draws = 0, r;
+	int16_t heading;
+
+	fillCache();
+	for (heading = 1; heading < 360; heading += BENCH_HEADING_STEP) {
+		// Marker somewhere in its tile with a fraction of a pixel that changes with the heading
+		center.x = ((uint32_t)BENCH_TILE_X << PROJ_TILE_SHIFT(BENCH_ZOOM)) + ((uint32_t)(heading * 37 % 256) << PROJ_PIXEL_SHIFT(BENCH_ZOOM)) +
+			heading * 1237 % (1 << PROJ_PIXEL_SHIFT(BENCH_ZOOM));
+		center.y = ((uint32_t)BENCH_TILE_Y << PROJ_TILE_SHIFT(BENCH_ZOOM)) + ((uint32_t)(heading * 91 % 256) << PROJ_PIXEL_SHIFT(BENCH_ZOOM)) +
+			heading * 3571 % (1 << PROJ_PIXEL_SHIFT(BENCH_ZOOM));
+		t = nanoseconds();
+		for (r = 0; r < BENCH_REPEAT; r++)
+			tilesDraw(&center, BENCH_ZOOM, heading, BENCH_CENTER_X, BENCH_CENTER_Y, BENCH_X, BENCH_Y, BENCH_CX, BENCH_CY);
+		total += nanoseconds() - t;
+		draws += BENCH_REPEAT;
+		checkDraw(&center, heading);
+	}
+
+	printf("%s, %u draws of %ux%u, %.3f ms per draw, %.2f ns per pixel\n", TILES_ROTATE_BILINEAR ? "Bilinear" : "Nearest pixel",
+		(unsigned)draws, BENCH_CX, BENCH_CY, total / 1e6 / draws, (double)total / draws / (BENCH_CX * BENCH_CY));
+	printf("Parent fallbacks %u, holes %u\n", (unsigned)stats.ParentFallbacks, (unsigned)stats.Holes);
+	printf("%u pixels checked, %u wrong", (unsigned)checked, (unsigned)wrong);
+	if (TILES_ROTATE_BILINEAR)
+		printf(", largest error %u", (unsigned)worst);
+	printf("\n");
+	return wrong != 0;
+}
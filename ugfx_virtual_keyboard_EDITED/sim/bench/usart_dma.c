@@ -0,0 +1,231 @@
+/*
+ * GPS USART DMA receive check.
+ *
+ * Runs tm_stm32_usart_dma.c and tm_stm32_gps.c on a simulated circular DMA stream. Bytes are
+ * written into the DMA buffer with the stream counter going down as on the board, the stream
+ * interrupt is raised at half and full buffer and the IDLE line interrupt after every burst.
+ * After each burst the GPS thread parses what TM_GPS_Update() hands it.
+ *
+ *	NMEA			RMC, GGA, GSA and GSV per epoch, lines end with a line feed
+ *	UBX				one NAV-PVT frame per epoch and nothing else, no line ends at all
+ *	UBX with SAT	a NAV-PVT frame and a NAV-SAT frame, which is longer than the line buffer and
+ *					is skipped by the parser without being counted
+ *	mixed			NMEA lines and a NAV-PVT frame in the same burst
+ *
+ * Payload bytes are random, so some are line feeds and cut frames apart, and the buffer
+ * length is not a multiple of any burst so frames wrap at every place of the buffer.
+ *
+ * Exits with 1 when an epoch is not reported or its position is wrong.
+ */
+
+#include "tm_stm32_gps.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_EPOCHS			20000
+#define BENCH_SAT_LENGTH		(8 + 12 * 32)	// NAV-SAT with 32 satellites
+#define BENCH_BURST_SIZE		600
+
+USART_TypeDef simUSART[8];
+DMA_Stream_TypeDef simDMA[16];
+
+// Register level stand-ins, the DMA transfer itself is done by receive()
+void TM_USART_Init(USART_TypeDef* USARTx, TM_USART_PinsPack_t pinspack, uint32_t baudrate) {
+	(void)USARTx; (void)pinspack; (void)baudrate;
+}
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma) {
+	(void)hdma;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef *hdma) {
+	(void)hdma;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_Start(DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t DstAddress, uint32_t DataLength) {
+	(void)SrcAddress; (void)DstAddress;
+	hdma->Instance->NDTR = DataLength;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef *hdma) {
+	(void)hdma;
+	return HAL_OK;
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority) {
+	(void)IRQn; (void)PreemptPriority; (void)SubPriority;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn) {
+	(void)IRQn;
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn) {
+	(void)IRQn;
+}
+
+void HAL_NVIC_ClearPendingIRQ(IRQn_Type IRQn) {
+	(void)IRQn;
+}
+
+static TM_GPS_t gps;
+static unsigned reported, wrong;
+
+// Deterministic random byte
+static uint8_t pick(void) {
+	static uint32_t seed = 12345;
+
+	seed = seed * 1103515245u + 12345u;
+	return (uint8_t)(seed >> 16);
+}
+
+// DMA writes the bytes, the stream interrupt comes at half and at full buffer
+static void receive(const uint8_t *data, unsigned len) {
+	TM_USART_DMA_t *d = TM_USART_DMA_Get(GPS_USART);
+	DMA_Stream_TypeDef *s = d->DMA_Handle.Instance;
+
+	while (len--) {
+		d->Buffer[d->Size - s->NDTR] = *data++;
+		if (--s->NDTR == 0)
+			s->NDTR = d->Size;
+		if (s->NDTR == d->Size || s->NDTR == d->Size / 2)
+			TM_USART_DMA_IRQHandler(GPS_USART);
+	}
+}
+
+// Sender goes quiet, then the GPS thread takes what was received
+static void burstEnd(int32_t latE7, int32_t lonE7) {
+	unsigned n = 0;
+
+	TM_USART_IdleLineCallback(GPS_USART);
+	while (TM_GPS_Update(&gps) == TM_GPS_Result_NewData) {
+		n++;
+		if (gps.LatitudeE7 != latE7 || gps.LongitudeE7 != lonE7)
+			wrong++;
+	}
+	reported += n != 0;
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+	p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+static unsigned ubx(uint8_t *f, uint8_t id, unsigned payload) {
+	uint8_t a = 0, b = 0;
+	unsigned i;
+
+	f[0] = 0xB5; f[1] = 0x62; f[2] = 0x01; f[3] = id; f[4] = payload; f[5] = payload >> 8;
+	for (i = 2; i < payload + 6; i++) {
+		a += f[i];
+		b += a;
+	}
+	f[payload + 6] = a;
+	f[payload + 7] = b;
+	return payload + 8;
+}
+
+static unsigned navPvt(uint8_t *f, int32_t latE7, int32_t lonE7, int n) {
+	uint8_t *p = f + 6;
+	unsigned i;
+
+	for (i = 0; i < 92; i++)
+		p[i] = pick();
+	p[4] = 2026 & 0xFF; p[5] = 2026 >> 8; p[6] = 10; p[7] = 19;
+	p[8] = n / 3600 % 24; p[9] = n / 60 % 60; p[10] = n % 60;
+	p[11] = 0x07;
+	p[20] = 3; p[21] = 0x01; p[23] = 12;
+	put32(&p[24], lonE7);
+	put32(&p[28], latE7);
+	return ubx(f, 0x07, 92);
+}
+
+static unsigned navSat(uint8_t *f) {
+	unsigned i;
+
+	for (i = 0; i < BENCH_SAT_LENGTH; i++)
+		f[6 + i] = pick();
+	return ubx(f, 0x35, BENCH_SAT_LENGTH);
+}
+
+static unsigned nmea(uint8_t *buf, const char *fmt, ...) {
+	char body[100];
+	uint8_t crc = 0;
+	va_list ap;
+	char *p;
+
+	va_start(ap, fmt);
+	vsnprintf(body, sizeof(body), fmt, ap);
+	va_end(ap);
+	for (p = body; *p; p++)
+		crc ^= *p;
+	return (unsigned)sprintf((char *)buf, "$%s*%02X\r\n", body, crc);
+}
+
+// ddmm.mmmm, positions are chosen so that they are exact in it
+static unsigned nmeaEpoch(uint8_t *buf, int32_t latE7, int32_t lonE7, int n) {
+	char hms[16], la[16], lo[16];
+	unsigned len;
+
+	snprintf(hms, sizeof(hms), "%02d%02d%02d.00", n / 3600 % 24, n / 60 % 60, n % 60);
+	snprintf(la, sizeof(la), "%02d%02d.%04d", latE7 / 10000000, latE7 % 10000000 * 60 / 10000000,
+		latE7 % 10000000 * 60 / 1000 % 10000);
+	snprintf(lo, sizeof(lo), "%03d%02d.%04d", -lonE7 / 10000000, -lonE7 % 10000000 * 60 / 10000000,
+		-lonE7 % 10000000 * 60 / 1000 % 10000);
+	len = nmea(buf, "GPRMC,%s,A,%s,N,%s,W,13.607,270.00,191026,,,A", hms, la, lo);
+	len += nmea(buf + len, "GPGGA,%s,%s,N,%s,W,1,08,0.9,1045.0,M,-17.0,M,,", hms, la, lo);
+	len += nmea(buf + len, "GPGSA,A,3,02,05,07,13,15,20,24,30,,,,,1.6,0.9,1.3");
+	len += nmea(buf + len, "GPGSV,2,1,08,02,65,110,42,05,41,280,38,07,22,045,35,13,18,190,31");
+	len += nmea(buf + len, "GPGSV,2,2,08,15,72,300,44,20,30,080,36,24,12,230,29,30,55,150,40");
+	return len;
+}
+
+static int run(const char *name, int kind) {
+	uint8_t burst[BENCH_BURST_SIZE];
+	TM_USART_DMA_t *d;
+	int32_t latE7, lonE7;
+	unsigned len, ubxFrames;
+	int n;
+
+	memset(&gps, 0, sizeof(gps));
+	TM_GPS_Init(&gps, 115200);
+	d = TM_USART_DMA_Get(GPS_USART);
+	reported = wrong = 0;
+	for (n = 0; n < BENCH_EPOCHS; n++) {
+		// Whole minutes of 1e-7 degrees divided by 60 are exact in ddmm.mmmm
+		latE7 = 510000000 + (n % 5000) * 6000 / 60 * 10;
+		lonE7 = -1140000000 - (n % 7000) * 6000 / 60 * 10;
+		len = 0;
+		if (kind == 0 || kind == 3)
+			len += nmeaEpoch(burst + len, latE7, lonE7, n);
+		if (kind != 0)
+			len += navPvt(burst + len, latE7, lonE7, n);
+		if (kind == 2)
+			len += navSat(burst + len);
+		receive(burst, len);
+		burstEnd(latE7, lonE7);
+	}
+
+	ubxFrames = kind == 0 ? 0 : BENCH_EPOCHS;
+	printf("%-12s %u of %u epochs reported, %u wrong, %u UBX frames, %u UBX errors, %u checksum errors, "
+		"%u lines, %u overruns\n", name, reported, BENCH_EPOCHS, wrong, (unsigned)gps.Stats.UBXFrames,
+		(unsigned)gps.Stats.UBXErrors, (unsigned)gps.Stats.ChecksumErrors, (unsigned)d->Lines,
+		(unsigned)d->Overruns);
+	return reported != BENCH_EPOCHS || wrong || gps.Stats.UBXFrames != ubxFrames || gps.Stats.UBXErrors ||
+		d->Overruns;
+}
+
+int main(void) {
+	int failed = 0;
+
+	printf("DMA buffer %u bytes, line buffer %u bytes\n", GPS_USART_DMA_BUFFER_SIZE, GPS_SENTENCE_MAX_LENGTH);
+	failed |= run("NMEA", 0);
+	failed |= run("UBX", 1);
+	failed |= run("UBX with SAT", 2);
+	failed |= run("mixed", 3);
+	return failed;
+}
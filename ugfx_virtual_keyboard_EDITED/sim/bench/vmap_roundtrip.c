@@ -0,0 +1,602 @@
+/*
+ * Vector map tile round trip check.
+ *
+ * Generates an OpenStreetMap extract around the default simulated ride with concave areas,
+ * roads, rivers, a serpentine path with more points than one feature holds and nodes out of
+ * order, converts it with sim/tools/vmt_convert.c and reads every tile back with vmapLoad()
+ * and vmapDecode() of vmap.c, the code that runs on the board. Each data zoom is compared
+ * with the extract in tile units:
+ *
+ *	areas		pieces must be convex, and on a grid over each tile a point must be in an area
+ *				of a class exactly when it is in a source area of that class, unless it is
+ *				closer to the source outline than the simplification tolerance allows
+ *	lines		decoded points must lie on a source line of their class and source lines must
+ *				be covered by decoded lines, both within that tolerance
+ *
+ * Features, header counts, min zooms and coordinates must also be within what vmap.h allows.
+ * The tiles are written to a directory under /tmp, which is removed afterwards.
+ *
+ * Exits with 1 when a tile is not read or does not match.
+ */
+
+#include "vmap.c"
+#include "sim/tools/vmt_convert.h"
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define CHECK_LAT_E7			510776000		// SIM_GPS default
+#define CHECK_LON_E7			-1141318000
+#define CHECK_SPAN_M			5000			// Features start within this of the centre
+#define CHECK_AREAS				60
+#define CHECK_LINES				150
+#define CHECK_SERPENTINE		2000			// Points of the serpentine path
+#define CHECK_GRID				48				// Area samples per tile side
+#define CHECK_TOLERANCE			10.0			// Half a pixel of simplification, rounding and some slack
+#define CHECK_MARGIN			(VMAP_EXTENT / 8)
+#define CHECK_M_PER_DEGREE		111320.0
+
+typedef struct {
+	const char *	key;
+	const char *	value;
+	uint8_t			cls;
+	uint8_t			area;
+	uint8_t			zoom;					// First display zoom of the class in vmt_convert.c
+} checkTag;
+
+typedef struct {
+	const checkTag *	tag;
+	uint32_t			first;
+	uint32_t			count;
+	proj_world_t		min, max;
+	uint32_t			local;				// Its points in tile units when it touches the tile
+} checkWay;
+
+typedef struct {
+	double			x, y;
+} checkPoint;
+
+typedef struct {
+	uint8_t			cls;
+	uint8_t			area;
+	uint32_t		first;
+	uint32_t		count;
+} checkFeature;
+
+static const checkTag areaTags[] = {
+	{"natural", "water", VMAP_CLASS_WATER, 1, 12},
+	{"leisure", "park", VMAP_CLASS_PARK, 1, 12},
+	{"landuse", "forest", VMAP_CLASS_FOREST, 1, 12},
+	{"landuse", "residential", VMAP_CLASS_RESIDENTIAL, 1, 14}
+};
+
+static const checkTag lineTags[] = {
+	{"highway", "motorway", VMAP_CLASS_MOTORWAY, 0, 12},
+	{"highway", "primary", VMAP_CLASS_PRIMARY, 0, 12},
+	{"highway", "secondary", VMAP_CLASS_SECONDARY, 0, 12},
+	{"highway", "residential", VMAP_CLASS_MINOR, 0, 13},
+	{"highway", "cycleway", VMAP_CLASS_CYCLEWAY, 0, 13},
+	{"highway", "footway", VMAP_CLASS_PATH, 0, 15},
+	{"waterway", "river", VMAP_CLASS_RIVER, 0, 12}
+};
+
+static int32_t latE7[CHECK_AREAS * 40 + CHECK_LINES * 80 + CHECK_SERPENTINE];
+static int32_t lonE7[sizeof(latE7) / sizeof(latE7[0])];
+static proj_world_t world[sizeof(latE7) / sizeof(latE7[0])];
+static uint32_t nodeCount;
+static checkWay ways[CHECK_AREAS + CHECK_LINES + 1];
+static uint32_t wayCount;
+static uint32_t nearWays[sizeof(ways) / sizeof(ways[0])];	// Those touching the tile being checked
+static uint32_t nearCount;
+
+static checkFeature decoded[8192];
+static point decodedPoints[1 << 20];
+static uint32_t decodedCount, decodedPointCount;
+static checkPoint local[sizeof(latE7) / sizeof(latE7[0])];
+static uint8_t tileBuffer[VMAP_TILE_BYTES];
+
+static uint32_t errors, tiles, featuresRead, pointsRead;
+
+// GFILE on host files, vmapLoad() opens tiles relative to the current directory
+bool_t gfileExists(const char *fname) {
+	return access(fname, F_OK) == 0;
+}
+
+GFILE *gfileOpen(const char *fname, const char *mode) {
+	(void)mode;
+	return (GFILE *)fopen(fname, "rb");
+}
+
+void gfileClose(GFILE *f) {
+	fclose((FILE *)f);
+}
+
+size_t gfileRead(GFILE *f, void *buf, size_t len) {
+	return fread(buf, 1, len, (FILE *)f);
+}
+
+long int gfileGetSize(GFILE *f) {
+	long int pos = ftell((FILE *)f), size;
+
+	fseek((FILE *)f, 0, SEEK_END);
+	size = ftell((FILE *)f);
+	fseek((FILE *)f, pos, SEEK_SET);
+	return size;
+}
+
+int formatString(char *str, int sizeOfString, const char *format, ...) {
+	va_list ap;
+	int n;
+
+	va_start(ap, format);
+	n = vsnprintf(str, sizeOfString, format, ap);
+	va_end(ap);
+	return n;
+}
+
+void TRACE(const char *fmt, ...) {
+	va_list ap;
+
+	va_start(ap, fmt);
+	vprintf(fmt, ap);
+	va_end(ap);
+}
+
+uint32_t HAL_GetTick(void) {
+	return 0;
+}
+
+// vmapDraw() is not used here, drawing only has to link
+GDisplay *GDISP;
+
+void gdispGGetClip(GDisplay *g, coord_t *x, coord_t *y, coord_t *cx, coord_t *cy) {
+	(void)g; *x = *y = *cx = *cy = 0;
+}
+
+void gdispGSetClip(GDisplay *g, coord_t x, coord_t y, coord_t cx, coord_t cy) {
+	(void)g; (void)x; (void)y; (void)cx; (void)cy;
+}
+
+void gdispGFillArea(GDisplay *g, coord_t x, coord_t y, coord_t cx, coord_t cy, color_t color) {
+	(void)g; (void)x; (void)y; (void)cx; (void)cy; (void)color;
+}
+
+void gdispGFillConvexPoly(GDisplay *g, coord_t tx, coord_t ty, const point *pntarray, unsigned cnt, color_t color) {
+	(void)g; (void)tx; (void)ty; (void)pntarray; (void)cnt; (void)color;
+}
+
+void gdispGDrawLine(GDisplay *g, coord_t x0, coord_t y0, coord_t x1, coord_t y1, color_t color) {
+	(void)g; (void)x0; (void)y0; (void)x1; (void)y1; (void)color;
+}
+
+void gdispGDrawThickLine(GDisplay *g, coord_t x0, coord_t y0, coord_t x1, coord_t y1, color_t color, coord_t width, bool_t round) {
+	(void)g; (void)x0; (void)y0; (void)x1; (void)y1; (void)color; (void)width; (void)round;
+}
+
+// Deterministic random number from 0 to 1
+static double uniform(void) {
+	static uint32_t seed = 12345;
+
+	seed = seed * 1103515245u + 12345u;
+	return (seed >> 8) / 16777216.0;
+}
+
+static uint32_t addNode(double northM, double eastM) {
+	double lat = CHECK_LAT_E7 / 1e7 + northM / CHECK_M_PER_DEGREE;
+
+	latE7[nodeCount] = (int32_t)lround(lat * 1e7);
+	lonE7[nodeCount] = (int32_t)lround((CHECK_LON_E7 / 1e7 + eastM / (CHECK_M_PER_DEGREE * cos(lat * M_PI / 180.0))) * 1e7);
+	projToWorld(latE7[nodeCount], lonE7[nodeCount], &world[nodeCount]);
+	return nodeCount++;
+}
+
+static void addWay(const checkTag *tag, uint32_t first) {
+	checkWay *w = &ways[wayCount++];
+	uint32_t i;
+
+	w->tag = tag;
+	w->first = first;
+	w->count = nodeCount - first;
+	w->min = w->max = world[first];
+	for (i = first + 1; i < nodeCount; i++) {
+		w->min.x = world[i].x < w->min.x ? world[i].x : w->min.x;
+		w->min.y = world[i].y < w->min.y ? world[i].y : w->min.y;
+		w->max.x = world[i].x > w->max.x ? world[i].x : w->max.x;
+		w->max.y = world[i].y > w->max.y ? world[i].y : w->max.y;
+	}
+}
+
+static void generate(void) {
+	double cn, ce, r, a, heading, n, e, step;
+	uint32_t i, j, k, first;
+
+	// Stars, every second corner pulled in so they are concave
+	for (i = 0; i < CHECK_AREAS; i++) {
+		cn = (uniform() * 2 - 1) * CHECK_SPAN_M;
+		ce = (uniform() * 2 - 1) * CHECK_SPAN_M;
+		r = 150 + uniform() * 1350;
+		k = 6 + (uint32_t)(uniform() * 34);
+		first = nodeCount;
+		for (j = 0; j < k; j++) {
+			a = 2 * M_PI * j / k;
+			addNode(cn + r * (j & 1 ? 0.45 + 0.2 * uniform() : 0.8 + 0.2 * uniform()) * sin(a),
+				ce + r * (j & 1 ? 0.45 + 0.2 * uniform() : 0.8 + 0.2 * uniform()) * cos(a));
+		}
+		addWay(&areaTags[i % (sizeof(areaTags) / sizeof(areaTags[0]))], first);
+	}
+
+	// Roads and rivers wander, long steps need the escape of vmap.h at data zoom 16
+	for (i = 0; i < CHECK_LINES; i++) {
+		n = (uniform() * 2 - 1) * CHECK_SPAN_M;
+		e = (uniform() * 2 - 1) * CHECK_SPAN_M;
+		heading = uniform() * 2 * M_PI;
+		k = 4 + (uint32_t)(uniform() * 76);
+		first = nodeCount;
+		for (j = 0; j < k; j++) {
+			addNode(n, e);
+			step = 40 + uniform() * 360;
+			heading += (uniform() - 0.5) * M_PI / 3;
+			n += step * cos(heading);
+			e += step * sin(heading);
+		}
+		addWay(&lineTags[i % (sizeof(lineTags) / sizeof(lineTags[0]))], first);
+	}
+
+	// Zigzag rows 300 m long in one place, too many points at data zoom 16 for one feature
+	first = nodeCount;
+	for (j = 0; j < CHECK_SERPENTINE; j++) {
+		k = j / 300;
+		addNode(100 + 20.0 * k + (j & 1 ? 3 : -3), k & 1 ? 400 - (j % 300) : 100 + (j % 300));
+	}
+	addWay(&lineTags[5], first);
+}
+
+static int writeOsm(const char *path) {
+	FILE *f = fopen(path, "w");
+	uint32_t i, j;
+
+	if (!f)
+		return 1;
+	fprintf(f, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<osm version=\"0.6\" generator=\"vmap_roundtrip\">\n");
+	// Newest first, the converter has to sort them
+	for (i = nodeCount; i-- > 0; ) {
+		fprintf(f, " <node id=\"%u\" lat=\"%s%d.%07d\" lon=\"%s%d.%07d\"/>\n", i + 1,
+			latE7[i] < 0 ? "-" : "", abs(latE7[i]) / 10000000, abs(latE7[i]) % 10000000,
+			lonE7[i] < 0 ? "-" : "", abs(lonE7[i]) / 10000000, abs(lonE7[i]) % 10000000);
+	}
+	for (i = 0; i < wayCount; i++) {
+		fprintf(f, " <way id=\"%u\">\n", i + 1);
+		for (j = 0; j < ways[i].count; j++)
+			fprintf(f, "  <nd ref=\"%u\"/>\n", ways[i].first + j + 1);
+		if (ways[i].tag->area)
+			fprintf(f, "  <nd ref=\"%u\"/>\n", ways[i].first + 1);
+		fprintf(f, "  <tag k=\"name\" v=\"Way %u\"/>\n  <tag k=\"%s\" v=\"%s\"/>\n </way>\n", i + 1,
+			ways[i].tag->key, ways[i].tag->value);
+	}
+	fprintf(f, "</osm>\n");
+	return fclose(f) != 0;
+}
+
+// Reads one tile with the firmware code into decoded[], false when there is no tile
+static bool readTile(uint8_t zoom, uint32_t x, uint32_t y, uint8_t last) {
+	const uint8_t *feature, *p, *end;
+	vmap_slot_t *slot;
+	uint32_t count, i, j, features, pass;
+
+	decodedCount = decodedPointCount = 0;
+	slots[0].data = tileBuffer;
+	slots[0].state = VMAP_EMPTY;
+	formatString(tilePath, sizeof(tilePath), VMAP_PATH, zoom, x, y);
+	if (!gfileExists(tilePath))
+		return false;
+	if (!(slot = vmapLoad(zoom, x, y))) {
+		printf("Tile %u/%u/%u not loaded\n", zoom, x, y);
+		errors++;
+		return false;
+	}
+	tiles++;
+
+	// Same walk as vmapDrawFeatures()
+	for (pass = 0; pass < 2; pass++) {
+		features = (uint16_t)vmapRead16(slot->data + (pass ? 6 : 4));
+		p = slot->data + (pass ? vmapRead32(slot->data + 8) : VMAP_HEADER_BYTES);
+		end = pass ? slot->data + slot->size : slot->data + vmapRead32(slot->data + 8);
+		for (; features > 0; features--) {
+			feature = p;
+			p += VMAP_FEATURE_BYTES + (uint16_t)vmapRead16(feature + 4);
+			if (feature + VMAP_FEATURE_BYTES > end || p > end) {
+				printf("Tile %u/%u/%u feature runs past its section\n", zoom, x, y);
+				errors++;
+				break;
+			}
+			count = (uint16_t)vmapRead16(feature + 2);
+			if (feature[0] >= VMAP_CLASSES || feature[1] < zoom || feature[1] > last || count > VMAP_MAX_POINTS ||
+				vmapDecode(feature + VMAP_FEATURE_BYTES, p, count) != count || count < (pass ? 2u : 3u)) {
+				printf("Tile %u/%u/%u feature of class %u, min zoom %u, %u points is not valid\n", zoom, x, y,
+					feature[0], feature[1], count);
+				errors++;
+				continue;
+			}
+			decoded[decodedCount].cls = feature[0];
+			decoded[decodedCount].area = !pass;
+			decoded[decodedCount].first = decodedPointCount;
+			decoded[decodedCount].count = count;
+			for (i = 0; i < count; i++) {
+				if (points[i].x < -CHECK_MARGIN || points[i].x > VMAP_EXTENT + CHECK_MARGIN ||
+					points[i].y < -CHECK_MARGIN || points[i].y > VMAP_EXTENT + CHECK_MARGIN) {
+					printf("Tile %u/%u/%u point %d,%d outside its margin\n", zoom, x, y, points[i].x, points[i].y);
+					errors++;
+					break;
+				}
+				decodedPoints[decodedPointCount + i] = points[i];
+			}
+			decodedPointCount += count;
+			decodedCount++;
+			featuresRead++;
+			pointsRead += count;
+
+			// Pieces are drawn with gdispFillConvexPoly()
+			if (!pass) {
+				int64_t cross, sign = 0;
+
+				for (j = 0; j < count; j++) {
+					const point *a = &points[j], *b = &points[(j + 1) % count], *c = &points[(j + 2) % count];
+
+					cross = (int64_t)(b->x - a->x) * (c->y - b->y) - (int64_t)(b->y - a->y) * (c->x - b->x);
+					if (cross && sign && (cross > 0) != (sign > 0))
+						break;
+					sign = cross ? cross : sign;
+				}
+				if (j < count || !sign) {
+					printf("Tile %u/%u/%u area piece of %u points is not convex\n", zoom, x, y, count);
+					errors++;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+// Only distances up to CHECK_TOLERANCE matter, segments further off in x or y are not measured
+static double segmentDistance(double px, double py, double ax, double ay, double bx, double by) {
+	double dx = bx - ax, dy = by - ay, len2, t = 0;
+
+	if ((ax < px - CHECK_TOLERANCE && bx < px - CHECK_TOLERANCE) || (ax > px + CHECK_TOLERANCE && bx > px + CHECK_TOLERANCE) ||
+		(ay < py - CHECK_TOLERANCE && by < py - CHECK_TOLERANCE) || (ay > py + CHECK_TOLERANCE && by > py + CHECK_TOLERANCE))
+		return 1e30;
+	len2 = dx * dx + dy * dy;
+	if (len2 > 0) {
+		t = ((px - ax) * dx + (py - ay) * dy) / len2;
+		t = t < 0 ? 0 : t > 1 ? 1 : t;
+	}
+	dx = ax + t * dx - px;
+	dy = ay + t * dy - py;
+	return sqrt(dx * dx + dy * dy);
+}
+
+static bool insideSource(double px, double py, const checkPoint *l, uint32_t n) {
+	uint32_t i, j;
+	bool in = false;
+
+	for (i = 0, j = n - 1; i < n; j = i++) {
+		if ((l[i].y > py) != (l[j].y > py) && px < (l[j].x - l[i].x) * (py - l[i].y) / (l[j].y - l[i].y) + l[i].x)
+			in = !in;
+	}
+	return in;
+}
+
+static bool insideDecoded(double px, double py, uint8_t cls) {
+	uint32_t f, i, n;
+	const point *p;
+	double cross;
+	int sign;
+
+	for (f = 0; f < decodedCount; f++) {
+		if (!decoded[f].area || decoded[f].cls != cls)
+			continue;
+		p = &decodedPoints[decoded[f].first];
+		n = decoded[f].count;
+		sign = 0;
+		for (i = 0; i < n; i++) {
+			cross = (double)(p[(i + 1) % n].x - p[i].x) * (py - p[i].y) - (double)(p[(i + 1) % n].y - p[i].y) * (px - p[i].x);
+			if (cross == 0)
+				continue;
+			if (sign && (cross > 0) != (sign > 0))
+				break;
+			sign = cross > 0 ? 1 : -1;
+		}
+		if (i == n)
+			return true;
+	}
+	return false;
+}
+
+static double decodedLineDistance(double px, double py, uint8_t cls) {
+	double best = 1e30, d;
+	uint32_t f, i;
+	const point *p;
+
+	for (f = 0; f < decodedCount; f++) {
+		if (decoded[f].area || decoded[f].cls != cls)
+			continue;
+		p = &decodedPoints[decoded[f].first];
+		for (i = 0; i + 1 < decoded[f].count; i++) {
+			d = segmentDistance(px, py, p[i].x, p[i].y, p[i + 1].x, p[i + 1].y);
+			best = d < best ? d : best;
+		}
+	}
+	return best;
+}
+
+// Lists the ways touching the tile and puts their points into tile units
+static void toLocal(int64_t ox, int64_t oy, int64_t tile, int64_t margin, double scale) {
+	uint32_t i, j, n = 0;
+	checkWay *w;
+
+	nearCount = 0;
+	for (i = 0; i < wayCount; i++) {
+		w = &ways[i];
+		if (w->max.x < ox - margin || w->min.x > ox + tile + margin || w->max.y < oy - margin ||
+			w->min.y > oy + tile + margin)
+			continue;
+		nearWays[nearCount++] = i;
+		w->local = n;
+		for (j = 0; j < w->count; j++, n++) {
+			local[n].x = ((int64_t)world[w->first + j].x - ox) * scale;
+			local[n].y = ((int64_t)world[w->first + j].y - oy) * scale;
+		}
+	}
+}
+
+static void checkTile(uint8_t zoom, uint32_t tx, uint32_t ty, uint8_t last) {
+	uint8_t unitShift = 32 - zoom - VMAP_EXTENT_SHIFT;
+	int64_t tile = (int64_t)1 << (32 - zoom), ox = (int64_t)tx << (32 - zoom), oy = (int64_t)ty << (32 - zoom);
+	int64_t margin = (int64_t)CHECK_MARGIN << unitShift;
+	double scale = 1.0 / ((int64_t)1 << unitShift), px, py, d, best, len, t;
+	uint32_t f, i, j, n, s, gx, gy, mismatch = 0, uncovered = 0, stray = 0;
+	const checkPoint *l;
+	uint8_t cls;
+	bool src, dec;
+
+	readTile(zoom, tx, ty, last);
+	toLocal(ox, oy, tile, margin, scale);
+
+	// Area classes on a grid, a class with no areas near the tile has nothing to compare
+	for (cls = 0; cls < VMAP_CLASSES; cls++) {
+		for (n = 0; n < nearCount; n++) {
+			if (ways[nearWays[n]].tag->area && ways[nearWays[n]].tag->cls == cls)
+				break;
+		}
+		for (f = 0; n == nearCount && f < decodedCount; f++) {
+			if (decoded[f].area && decoded[f].cls == cls)
+				break;
+		}
+		if (n == nearCount && f == decodedCount)
+			continue;
+		for (gy = 0; gy < CHECK_GRID; gy++) {
+			for (gx = 0; gx < CHECK_GRID; gx++) {
+				px = (gx + 0.5) * VMAP_EXTENT / CHECK_GRID;
+				py = (gy + 0.5) * VMAP_EXTENT / CHECK_GRID;
+				src = false;
+				best = 1e30;
+				for (n = 0; n < nearCount; n++) {
+					i = nearWays[n];
+					if (!ways[i].tag->area || ways[i].tag->cls != cls || ways[i].tag->zoom > last)
+						continue;
+					l = &local[ways[i].local];
+					src |= insideSource(px, py, l, ways[i].count);
+					for (j = 0; j < ways[i].count; j++) {
+						d = segmentDistance(px, py, l[j].x, l[j].y, l[(j + 1) % ways[i].count].x, l[(j + 1) % ways[i].count].y);
+						best = d < best ? d : best;
+					}
+				}
+				dec = insideDecoded(px, py, cls);
+				if (src != dec && best > CHECK_TOLERANCE)
+					mismatch++;
+			}
+		}
+	}
+
+	// Source lines are covered by decoded lines of their class
+	for (n = 0; n < nearCount; n++) {
+		i = nearWays[n];
+		if (ways[i].tag->area || ways[i].tag->zoom > last)
+			continue;
+		l = &local[ways[i].local];
+		for (j = 0; j + 1 < ways[i].count; j++) {
+			if ((l[j].x < 0 && l[j + 1].x < 0) || (l[j].x >= VMAP_EXTENT && l[j + 1].x >= VMAP_EXTENT) ||
+				(l[j].y < 0 && l[j + 1].y < 0) || (l[j].y >= VMAP_EXTENT && l[j + 1].y >= VMAP_EXTENT))
+				continue;
+			len = hypot(l[j + 1].x - l[j].x, l[j + 1].y - l[j].y);
+			for (s = 0; s <= len / 8; s++) {
+				t = len > 0 ? s * 8 / len : 0;
+				px = l[j].x + t * (l[j + 1].x - l[j].x);
+				py = l[j].y + t * (l[j + 1].y - l[j].y);
+				if (px < 0 || px >= VMAP_EXTENT || py < 0 || py >= VMAP_EXTENT)
+					continue;
+				if (decodedLineDistance(px, py, ways[i].tag->cls) > CHECK_TOLERANCE)
+					uncovered++;
+			}
+		}
+	}
+
+	// Decoded lines lie on source lines of their class
+	for (f = 0; f < decodedCount; f++) {
+		if (decoded[f].area)
+			continue;
+		for (j = 0; j < decoded[f].count; j++) {
+			const point *p = &decodedPoints[decoded[f].first + j];
+
+			if (p->x < 0 || p->x >= VMAP_EXTENT || p->y < 0 || p->y >= VMAP_EXTENT)
+				continue;
+			best = 1e30;
+			for (n = 0; n < nearCount; n++) {
+				i = nearWays[n];
+				if (ways[i].tag->area || ways[i].tag->cls != decoded[f].cls)
+					continue;
+				l = &local[ways[i].local];
+				for (s = 0; s + 1 < ways[i].count; s++) {
+					d = segmentDistance(p->x, p->y, l[s].x, l[s].y, l[s + 1].x, l[s + 1].y);
+					best = d < best ? d : best;
+				}
+			}
+			if (best > CHECK_TOLERANCE)
+				stray++;
+		}
+	}
+
+	if (mismatch || uncovered || stray) {
+		printf("Tile %u/%u/%u: %u area samples wrong, %u line samples not covered, %u line points off\n",
+			zoom, tx, ty, mismatch, uncovered, stray);
+		errors++;
+	}
+}
+
+int main(void) {
+	char dir[] = "/tmp/vmap_roundtripXXXXXX", command[64];
+	proj_world_t min, max;
+	uint32_t i, tx, ty, serpentine = 0;
+	uint8_t zoom, last;
+	int failed;
+
+	projInit();
+	generate();
+	if (!mkdtemp(dir) || chdir(dir) || writeOsm("map.osm")) {
+		fprintf(stderr, "Can not write to %s\n", dir);
+		return 2;
+	}
+	if (vmtConvert("map.osm", ".")) {
+		fprintf(stderr, "Conversion failed\n");
+		return 1;
+	}
+
+	min = max = world[0];
+	for (i = 1; i < nodeCount; i++) {
+		min.x = world[i].x < min.x ? world[i].x : min.x;
+		min.y = world[i].y < min.y ? world[i].y : min.y;
+		max.x = world[i].x > max.x ? world[i].x : max.x;
+		max.y = world[i].y > max.y ? world[i].y : max.y;
+	}
+	for (zoom = VMAP_MIN_ZOOM; zoom <= VMAP_MAX_DATA_ZOOM; zoom += 2) {
+		last = zoom == VMAP_MAX_DATA_ZOOM ? VMAP_MAX_ZOOM : zoom + 1;
+		for (ty = min.y >> (32 - zoom); ty <= max.y >> (32 - zoom); ty++) {
+			for (tx = min.x >> (32 - zoom); tx <= max.x >> (32 - zoom); tx++) {
+				checkTile(zoom, tx, ty, last);
+				for (i = 0; zoom == VMAP_MAX_DATA_ZOOM && i < decodedCount; i++)
+					serpentine += decoded[i].cls == VMAP_CLASS_PATH && decoded[i].count == VMAP_MAX_POINTS;
+			}
+		}
+	}
+
+	printf("%u tiles read, %u features, %u points, %u full length path features, %u errors\n", tiles, featuresRead,
+		pointsRead, serpentine, errors);
+	failed = errors || !tiles || !serpentine;
+
+	snprintf(command, sizeof(command), "rm -r %s", dir);
+	if (chdir("/") || system(command))
+		fprintf(stderr, "%s not removed\n", dir);
+	return failed;
+}
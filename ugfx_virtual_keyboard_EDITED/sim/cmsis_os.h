@@ -0,0 +1,97 @@
+/*
+ * Host simulator CMSIS-RTOS shim.
+ *
+ * The part of the CMSIS-RTOS API the application uses, on top of pthreads.
+ * Thread priorities and stack sizes are kept but not used, the host schedules the threads.
+ */
+
+#ifndef _SIM_CMSIS_OS_H
+#define _SIM_CMSIS_OS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define osCMSIS						0x10002
+#define osWaitForever				0xFFFFFFFF
+
+typedef enum {
+	osPriorityIdle			= -3,
+	osPriorityLow			= -2,
+	osPriorityBelowNormal	= -1,
+	osPriorityNormal		= 0,
+	osPriorityAboveNormal	= +1,
+	osPriorityHigh			= +2,
+	osPriorityRealtime		= +3,
+	osPriorityError			= 0x84
+} osPriority;
+
+typedef enum {
+	osOK					= 0,
+	osEventSignal			= 0x08,
+	osEventTimeout			= 0x40,
+	osErrorParameter		= 0x80,
+	osErrorResource			= 0x81,
+	osErrorTimeoutResource	= 0xC1,
+	osErrorISR				= 0x82,
+	osErrorOS				= 0xFF
+} osStatus;
+
+typedef void (*os_pthread)(void const *argument);
+
+typedef struct os_thread_cb *osThreadId;
+typedef struct os_mutex_cb *osMutexId;
+
+typedef struct os_thread_def {
+	os_pthread				pthread;
+	osPriority				tpriority;
+	uint32_t				instances;
+	uint32_t				stacksize;
+} osThreadDef_t;
+
+typedef struct os_mutex_def {
+	uint32_t				dummy;
+} osMutexDef_t;
+
+typedef struct {
+	osStatus				status;
+	union {
+		uint32_t			v;
+		void *				p;
+		int32_t				signals;
+	} value;
+} osEvent;
+
+#define osThreadDef(name, priority, instances, stacksz)  \
+	const osThreadDef_t os_thread_def_##name = { (name), (priority), (instances), (stacksz) }
+#define osThread(name)				&os_thread_def_##name
+
+#define osMutexDef(name)			const osMutexDef_t os_mutex_def_##name = { 0 }
+#define osMutex(name)				&os_mutex_def_##name
+
+osStatus osKernelInitialize(void);
+osStatus osKernelStart(void);
+int32_t osKernelRunning(void);
+
+osThreadId osThreadCreate(const osThreadDef_t *thread_def, void *argument);
+osThreadId osThreadGetId(void);
+osStatus osThreadTerminate(osThreadId thread_id);
+osStatus osThreadYield(void);
+osStatus osDelay(uint32_t millisec);
+
+int32_t osSignalSet(osThreadId thread_id, int32_t signals);
+int32_t osSignalClear(osThreadId thread_id, int32_t signals);
+osEvent osSignalWait(int32_t signals, uint32_t millisec);
+
+osMutexId osMutexCreate(const osMutexDef_t *mutex_def);
+osStatus osMutexWait(osMutexId mutex_id, uint32_t millisec);
+osStatus osMutexRelease(osMutexId mutex_id);
+osStatus osMutexDelete(osMutexId mutex_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SIM_CMSIS_OS_H */
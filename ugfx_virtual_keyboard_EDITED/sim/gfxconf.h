@@ -0,0 +1,36 @@
+/*
+ * Host simulator configuration.
+ *
+ * The firmware configuration is used as it is, only the operating system, the display
+ * size and the SD card file system are changed for Linux.
+ */
+
+#ifndef _SIM_GFXCONF_H
+#define _SIM_GFXCONF_H
+
+#include "../gfxconf.h"
+
+// CMSIS-RTOS calls in the application go to the pthread shim
+#include "cmsis_os.h"
+
+#undef GFX_USE_OS_KEIL
+#undef GFX_COMPILER
+#undef GFX_CPU
+#undef GFX_CPU_ENDIAN
+#undef GFX_OS_HEAP_SIZE
+#undef GFX_OS_NO_INIT
+#define GFX_USE_OS_LINUX						TRUE
+#define GFX_OS_HEAP_SIZE						0
+
+// The STM32F469I discovery panel, with the pixels of the LTDC driver
+#define GDISP_SCREEN_WIDTH						800
+#define GDISP_SCREEN_HEIGHT						480
+#define GDISP_PIXELFORMAT						GDISP_PIXELFORMAT_RGB565
+
+// The SD card is a host directory, see SIM_SD in readme.txt
+#undef GFILE_NEED_FATFS
+#undef GFILE_NEED_NATIVEFS
+#define GFILE_NEED_FATFS						FALSE
+#define GFILE_NEED_NATIVEFS						TRUE
+
+#endif /* _SIM_GFXCONF_H */
@@ -0,0 +1,40 @@
+/*
+ * Host simulator headless frame buffer board.
+ *
+ * The frame buffer driver draws into the SDRAM frame buffer of the LTDC board and nothing
+ * shows it, so drawing costs what it does on the target apart from the missing LTDC reads.
+ */
+
+#include "stm32469i_discovery_sdram.h"
+
+#define GDISP_LLD_PIXELFORMAT		GDISP_PIXELFORMAT_RGB565
+
+#ifdef GDISP_DRIVER_VMT
+
+	static void board_init(GDisplay *g, fbInfo *fbi) {
+		g->g.Width = GDISP_SCREEN_WIDTH;
+		g->g.Height = GDISP_SCREEN_HEIGHT;
+		g->g.Backlight = 100;
+		g->g.Contrast = 50;
+		fbi->linelen = g->g.Width * sizeof(LLDCOLOR_TYPE);
+		fbi->pixels = (void *)(uintptr_t)(SDRAM_DEVICE_ADDR + 0x00200000);
+	}
+
+	#if GDISP_NEED_CONTROL
+		static void board_backlight(GDisplay *g, uint8_t percent) {
+			(void) g;
+			(void) percent;
+		}
+
+		static void board_contrast(GDisplay *g, uint8_t percent) {
+			(void) g;
+			(void) percent;
+		}
+
+		static void board_power(GDisplay *g, powermode_t pwr) {
+			(void) g;
+			(void) pwr;
+		}
+	#endif
+
+#endif /* GDISP_DRIVER_VMT */
@@ -0,0 +1,16 @@
+/*
+ * Host simulator internals shared by the simulated devices.
+ */
+
+#ifndef _SIM_H_
+#define _SIM_H_
+
+#include <stdint.h>
+
+// Monotonic host time
+uint64_t simNanoseconds(void);
+
+// Runs TM_EXTI_Handler() for an enabled line, as the EXTI interrupt would
+void simInterrupt(uint16_t GPIO_Pin);
+
+#endif /* _SIM_H_ */
@@ -0,0 +1,211 @@
+/*
+ * Host simulator GPS receiver on the GPS USART.
+ *
+ * Stands in for the USART DMA line reception. Sentences come from the NMEA log named by
+ * SIM_NMEA, paced by the time field and replayed from the start at its end. Without a log
+ * a fix is generated every second for a ride around a 500m circle centred on SIM_GPS
+ * ("latitude,longitude" in degrees).
+ */
+
+#include "tm_stm32_usart_dma.h"
+#include "tm_stm32_gps.h"
+#include "sim.h"
+#include <math.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define GPS_LINES				TM_USART_DMA_SPAN_COUNT
+#define GPS_LINE_SIZE			GPS_SENTENCE_MAX_LENGTH
+#define GPS_RADIUS_M			500.0
+#define GPS_SPEED_MS			7.0
+
+static TM_USART_DMA_t dma;
+static char lines[GPS_LINES][GPS_LINE_SIZE];
+static uint16_t lengths[GPS_LINES];
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Queue a received line and call back as the DMA interrupt does
+static void receive(const char *line) {
+	size_t len = strlen(line);
+
+	if (len >= GPS_LINE_SIZE)
+		return;
+	pthread_mutex_lock(&lock);
+	if ((uint8_t)(dma.SpanIn - dma.SpanOut) >= GPS_LINES) {
+		dma.Overruns++;
+	} else {
+		memcpy(lines[dma.SpanIn % GPS_LINES], line, len);
+		lengths[dma.SpanIn % GPS_LINES] = len;
+		dma.SpanIn++;
+		dma.Lines++;
+		dma.Received += len;
+	}
+	dma.Interrupts++;
+	pthread_mutex_unlock(&lock);
+	TM_USART_DMA_SentenceCallback(dma.USARTx);
+}
+
+// Adds the checksum and line end to a sentence body and receives it
+static void sentence(const char *fmt, ...) {
+	char body[GPS_LINE_SIZE - 8], line[GPS_LINE_SIZE];
+	uint8_t crc = 0;
+	va_list ap;
+	char *p;
+
+	va_start(ap, fmt);
+	vsnprintf(body, sizeof(body), fmt, ap);
+	va_end(ap);
+	for(p = body; *p; p++)
+		crc ^= *p;
+	snprintf(line, sizeof(line), "$%s*%02X\r\n", body, crc);
+	receive(line);
+}
+
+static void coordinate(char *buf, size_t size, double deg, int width, char pos, char neg, char *hemi) {
+	double a = fabs(deg);
+	int d = (int)a, m = (int)lround((a - d) * 600000);
+
+	// Minutes to four decimals
+	if (m >= 600000) {
+		d++;
+		m -= 600000;
+	}
+	snprintf(buf, size, "%0*d%02d.%04d", width, d, m / 10000, m % 10000);
+	*hemi = deg < 0 ? neg : pos;
+}
+
+static void generate(void) {
+	double lat0 = 51.0776, lon0 = -114.1318, t, a, lat, lon, course;
+	char la[16], lo[16], ns, ew, hms[12], dmy[8];
+	const char *s;
+	struct tm tm;
+	time_t now;
+
+	if ((s = getenv("SIM_GPS")))
+		sscanf(s, "%lf,%lf", &lat0, &lon0);
+	for(t = 0;; t++) {
+		a = t * GPS_SPEED_MS / GPS_RADIUS_M;
+		lat = lat0 + GPS_RADIUS_M * sin(a) / 111320.0;
+		lon = lon0 + GPS_RADIUS_M * cos(a) / (111320.0 * cos(lat0 * M_PI / 180));
+		course = fmod(360 - a * 180 / M_PI, 360);
+		coordinate(la, sizeof(la), lat, 2, 'N', 'S', &ns);
+		coordinate(lo, sizeof(lo), lon, 3, 'E', 'W', &ew);
+		now = time(0);
+		gmtime_r(&now, &tm);
+		strftime(hms, sizeof(hms), "%H%M%S.00", &tm);
+		strftime(dmy, sizeof(dmy), "%d%m%y", &tm);
+
+		sentence("GPRMC,%s,A,%s,%c,%s,%c,%.3f,%.2f,%s,,,A", hms, la, ns, lo, ew, GPS_SPEED_MS * 3600 / 1852, course, dmy);
+		sentence("GPGGA,%s,%s,%c,%s,%c,1,08,0.9,%.1f,M,-17.0,M,,", hms, la, ns, lo, ew, 1045.0 + 5 * sin(a));
+		sentence("GPGSA,A,3,02,05,07,13,15,20,24,30,,,,,1.6,0.9,1.3");
+		sentence("GPGSV,2,1,08,02,65,110,42,05,41,280,38,07,22,045,35,13,18,190,31");
+		sentence("GPGSV,2,2,08,15,72,300,44,20,30,080,36,24,12,230,29,30,55,150,40");
+		sleep(1);
+	}
+}
+
+static void replay(const char *name) {
+	char line[GPS_LINE_SIZE], stamp[16] = "", *p, *e;
+	FILE *f;
+
+	if (!(f = fopen(name, "r"))) {
+		fprintf(stderr, "sim: NMEA log %s can not be opened\n", name);
+		return;
+	}
+	for(;;) {
+		if (!fgets(line, sizeof(line), f)) {
+			rewind(f);
+			continue;
+		}
+		if (line[0] != '$')
+			continue;
+
+		// A new time field starts the next second of the log
+		if ((p = strchr(line, ',')) && (e = strchr(++p, ',')) && e - p > 0 && e - p < (int)sizeof(stamp)
+				&& (strncmp(line + 3, "RMC", 3) == 0 || strncmp(line + 3, "GGA", 3) == 0)) {
+			if (stamp[0] && strncmp(stamp, p, e - p))
+				sleep(1);
+			memcpy(stamp, p, e - p);
+			stamp[e - p] = 0;
+		}
+		receive(line);
+	}
+}
+
+static void *gpsReceiver(void *arg) {
+	const char *s;
+
+	(void)arg;
+	if ((s = getenv("SIM_NMEA")))
+		replay(s);
+	else
+		generate();
+	return 0;
+}
+
+TM_USART_DMA_t* TM_USART_DMA_Init(USART_TypeDef* USARTx, TM_USART_PinsPack_t pinspack, uint32_t baudrate, uint8_t* Buffer, uint16_t Size) {
+	pthread_t thread;
+
+	(void)pinspack;
+	(void)baudrate;
+	if (dma.USARTx)
+		return dma.USARTx == USARTx ? &dma : NULL;
+	dma.USARTx = USARTx;
+	dma.Buffer = Buffer;
+	dma.Size = Size;
+	dma.StringDelimiter = '\n';
+	if (!pthread_create(&thread, 0, gpsReceiver, 0))
+		pthread_detach(thread);
+	return &dma;
+}
+
+TM_USART_DMA_t* TM_USART_DMA_Get(USART_TypeDef* USARTx) {
+	return dma.USARTx == USARTx ? &dma : NULL;
+}
+
+uint8_t TM_USART_DMA_GetSentence(USART_TypeDef* USARTx, TM_USART_DMA_Sentence_t* Sentence, uint8_t* Linear, uint16_t LinearSize) {
+	uint16_t len;
+
+	if (dma.USARTx != USARTx)
+		return 0;
+	pthread_mutex_lock(&lock);
+	while (dma.SpanOut != dma.SpanIn) {
+		len = lengths[dma.SpanOut % GPS_LINES];
+		if (len <= LinearSize) {
+			// Lines are always copied, the receiver thread reuses its slots
+			memcpy(Linear, lines[dma.SpanOut % GPS_LINES], len);
+			dma.SpanOut++;
+			pthread_mutex_unlock(&lock);
+			Sentence->Data = Linear;
+			Sentence->Length = len;
+			Sentence->Copied = 1;
+			Sentence->Start = 0;
+			return 1;
+		}
+		dma.SpanOut++;
+		dma.Overruns++;
+	}
+	pthread_mutex_unlock(&lock);
+	return 0;
+}
+
+uint8_t TM_USART_DMA_SentenceValid(USART_TypeDef* USARTx, const TM_USART_DMA_Sentence_t* Sentence) {
+	(void)USARTx;
+	return Sentence->Copied;
+}
+
+uint16_t TM_USART_DMA_SentenceCount(USART_TypeDef* USARTx) {
+	uint16_t n;
+
+	if (dma.USARTx != USARTx)
+		return 0;
+	pthread_mutex_lock(&lock);
+	n = (uint8_t)(dma.SpanIn - dma.SpanOut);
+	pthread_mutex_unlock(&lock);
+	return n;
+}
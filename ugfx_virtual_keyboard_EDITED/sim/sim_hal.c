@@ -0,0 +1,205 @@
+/*
+ * Host simulator HAL shim.
+ *
+ * HAL core, clocks, SDRAM, the delay and GPIO libraries and external interrupts.
+ * A tick thread stands in for SysTick, the DWT cycle counter follows the host clock.
+ * SIM_SD names the host directory that stands in for the SD card.
+ */
+
+#include "stm32f4xx_hal.h"
+#include "stm32469i_discovery_sdram.h"
+#include "tm_stm32_delay.h"
+#include "tm_stm32_gpio.h"
+#include "tm_stm32_exti.h"
+#include "tm_stm32_usart.h"
+#include "sim.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+uint32_t SystemCoreClock = 180000000;
+
+GPIO_TypeDef simGPIO[11];
+SPI_TypeDef simSPI[6];
+USART_TypeDef simUSART[8];
+I2C_TypeDef simI2C[3];
+EXTI_TypeDef simEXTI;
+CoreDebug_Type simCoreDebug;
+
+__IO uint32_t TM_Time;
+__IO uint32_t TM_Time2;
+
+static volatile uint32_t uwTick;
+static pthread_mutex_t irqMutex = PTHREAD_MUTEX_INITIALIZER;
+
+uint64_t simNanoseconds(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+DWT_Type *simDWT(void) {
+	static DWT_Type dwt;
+
+	if (dwt.CTRL & DWT_CTRL_CYCCNTENA_Msk)
+		dwt.CYCCNT = (uint32_t)(simNanoseconds() * (SystemCoreClock / 1000000) / 1000);
+	return &dwt;
+}
+
+void simInterrupt(uint16_t GPIO_Pin) {
+	if (!(EXTI->IMR & GPIO_Pin))
+		return;
+
+	// One handler at a time, as on a single core
+	pthread_mutex_lock(&irqMutex);
+	EXTI->PR |= GPIO_Pin;
+	TM_EXTI_Handler(GPIO_Pin);
+	EXTI->PR &= ~GPIO_Pin;
+	pthread_mutex_unlock(&irqMutex);
+}
+
+static void *sysTick(void *arg) {
+	struct timespec next;
+
+	(void)arg;
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	for(;;) {
+		next.tv_nsec += 1000000;
+		if (next.tv_nsec >= 1000000000) {
+			next.tv_sec++;
+			next.tv_nsec -= 1000000000;
+		}
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, 0);
+		HAL_IncTick();
+	}
+	return 0;
+}
+
+HAL_StatusTypeDef HAL_Init(void) {
+	static pthread_t thread;
+	const char *s;
+
+	setvbuf(stdout, 0, _IOLBF, 0);
+
+	// The SD card is a host directory, files are opened relative to it
+	if ((s = getenv("SIM_SD")) && chdir(s)) {
+		fprintf(stderr, "sim: SD directory %s can not be used\n", s);
+		exit(1);
+	}
+	if (pthread_create(&thread, 0, sysTick, 0))
+		return HAL_ERROR;
+	pthread_detach(thread);
+	return HAL_OK;
+}
+
+void HAL_IncTick(void) {
+	uwTick++;
+	TM_Time++;
+	if (TM_Time2)
+		TM_Time2--;
+}
+
+uint32_t HAL_GetTick(void) {
+	return uwTick;
+}
+
+void HAL_Delay(uint32_t Delay) {
+	usleep(Delay * 1000);
+}
+
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct) {
+	(void)RCC_OscInitStruct;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef *RCC_ClkInitStruct, uint32_t FLatency) {
+	(void)RCC_ClkInitStruct;
+	(void)FLatency;
+	return HAL_OK;
+}
+
+uint32_t HAL_RCC_GetHCLKFreq(void) {
+	return SystemCoreClock;
+}
+
+void HAL_RCCEx_GetPeriphCLKConfig(RCC_PeriphCLKInitTypeDef *PeriphClkInit) {
+	memset(PeriphClkInit, 0, sizeof(*PeriphClkInit));
+}
+
+HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef *PeriphClkInit) {
+	(void)PeriphClkInit;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_PWREx_EnableOverDrive(void) {
+	return HAL_OK;
+}
+
+uint8_t BSP_SDRAM_Init(void) {
+	void *p;
+
+	// Buffers are at fixed SDRAM addresses, the host memory must be at the same place
+	p = mmap((void *)(uintptr_t)SDRAM_DEVICE_ADDR, SDRAM_DEVICE_SIZE, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+	if (p != (void *)(uintptr_t)SDRAM_DEVICE_ADDR) {
+		fprintf(stderr, "sim: SDRAM can not be mapped at 0x%08X\n", (unsigned)SDRAM_DEVICE_ADDR);
+		exit(1);
+	}
+	return SDRAM_OK;
+}
+
+uint32_t TM_DELAY_Init(void) {
+	// The cycle counter is what Delay() uses
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	return 1;
+}
+
+void TM_GPIO_Init(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, TM_GPIO_Mode_t GPIO_Mode, TM_GPIO_OType_t GPIO_OType, TM_GPIO_PuPd_t GPIO_PuPd, TM_GPIO_Speed_t GPIO_Speed) {
+	(void)GPIO_OType;
+	(void)GPIO_PuPd;
+	(void)GPIO_Speed;
+	GPIOx->MODER = GPIO_Mode == TM_GPIO_Mode_OUT ? GPIOx->MODER | GPIO_Pin : GPIOx->MODER & ~GPIO_Pin;
+}
+
+void TM_GPIO_InitAlternate(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, TM_GPIO_OType_t GPIO_OType, TM_GPIO_PuPd_t GPIO_PuPd, TM_GPIO_Speed_t GPIO_Speed, uint8_t Alternate) {
+	(void)GPIOx;
+	(void)GPIO_Pin;
+	(void)GPIO_OType;
+	(void)GPIO_PuPd;
+	(void)GPIO_Speed;
+	(void)Alternate;
+}
+
+TM_EXTI_Result_t TM_EXTI_Attach(GPIO_TypeDef* GPIOx, uint16_t GPIO_Line, TM_EXTI_Trigger_t trigger) {
+	(void)GPIOx;
+	(void)trigger;
+	EXTI->IMR |= GPIO_Line;
+	return TM_EXTI_Result_Ok;
+}
+
+TM_EXTI_Result_t TM_EXTI_Detach(uint16_t GPIO_Line) {
+	EXTI->IMR &= ~GPIO_Line;
+	return TM_EXTI_Result_Ok;
+}
+
+// The debug USART is the terminal
+void TM_USART_Init(USART_TypeDef* USARTx, TM_USART_PinsPack_t pinspack, uint32_t baudrate) {
+	(void)pinspack;
+	(void)baudrate;
+	USARTx->CR1 |= USART_CR1_UE;
+	USARTx->SR |= USART_SR_TXE;
+}
+
+void TM_USART_Puts(USART_TypeDef* USARTx, char* str) {
+	(void)USARTx;
+	fputs(str, stdout);
+}
+
+// The X mouse driver wakes itself, the scripted touch in sim_touch.c replaces this
+__attribute__((weak)) void touchInterrupt(void) {
+}
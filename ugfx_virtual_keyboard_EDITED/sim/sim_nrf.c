@@ -0,0 +1,160 @@
+/*
+ * Host simulator NRF51822 peer on SPI2.
+ *
+ * Answers the command protocol of spi.c from a simulated ride. A command transfer is
+ * acknowledged in the first byte, its response is clocked out by the transfers that follow.
+ * The NRF interrupt line (PA7) is raised every SIM_NRF_PERIOD milliseconds, 1000 by default.
+ */
+
+#include "tm_stm32_spi.h"
+#include "tm_stm32_exti.h"
+#include "spi.h"
+#include "sim.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define NRF_ACK					0x00
+#define NRF_DEVICES				3
+
+static uint8_t response[8];
+static uint8_t responseLen, responsePos;
+static uint8_t gearCount[2] = { 2, 9 };
+static uint8_t teeth[2][MAXIMUM_BACK_GEARS] = {
+	{ 22, 34 },
+	{ 11, 12, 13, 15, 17, 19, 21, 24, 28 }
+};
+static uint8_t wheelDiameter = 70;
+static uint8_t cadenceSetPoint = 90;
+static const uint8_t macs[NRF_DEVICES][6] = {
+	{ 0xC1, 0x5E, 0x23, 0x10, 0x4A, 0x01 },
+	{ 0xD4, 0x36, 0x39, 0x8B, 0x02, 0x7F },
+	{ 0xE8, 0x1C, 0x75, 0x44, 0x9D, 0x12 }
+};
+static uint64_t startNS;
+
+// The ride, in seconds since the SPI bus was started
+static double rideTime(void) {
+	return (double)(simNanoseconds() - startNS) / 1e9;
+}
+
+static uint8_t rideSpeed(double t) {
+	return (uint8_t)(25 + 6 * sin(t / 23));
+}
+
+static void respond1(uint8_t v) {
+	response[0] = v;
+	responseLen = 1;
+}
+
+static void command(const uint8_t *cmd, uint32_t len) {
+	double t = rideTime();
+	uint8_t side;
+
+	responseLen = responsePos = 0;
+	switch(cmd[0]) {
+	case GET_AVAILABILITY_MSG:
+		memset(response, 0, 4);
+		response[0] = FLAG_SPEED|FLAG_CADENCE|FLAG_DISTANCE|FLAG_HEARTRATE|FLAG_BATTERY;
+		responseLen = 4;
+		break;
+	case GET_DEVICE_NAME_MSG:
+		memcpy(response, "NRF", 3);
+		responseLen = 3;
+		break;
+	case GET_SPEED_MSG:				respond1(rideSpeed(t));										break;
+	case GET_CADENCE_MSG:			respond1((uint8_t)(85 + 10 * sin(t / 17)));					break;
+	case GET_DISTANCE_MSG:			respond1((uint8_t)((uint32_t)(t * 25 / 3600) % MAXIMUM_DISTANCE));	break;
+	case GET_HEARTRATE_MSG:			respond1((uint8_t)(135 + 20 * sin(t / 41)));				break;
+	case GET_CADENCE_SETPOINT_MSG:	respond1(cadenceSetPoint);									break;
+	case GET_BATTERY_MSG:			respond1(t < 97 * 60 ? (uint8_t)(100 - t / 60) : 3);		break;
+	case GET_WHEEL_DIAMETER_MSG:	respond1(wheelDiameter);									break;
+	case GET_ADVERTISING_COUNT_MSG:	respond1(NRF_DEVICES);										break;
+	case GET_GEAR_COUNT_MSG:
+		response[0] = gearCount[0];
+		response[1] = gearCount[1];
+		responseLen = 2;
+		break;
+	case GET_TEETH_COUNT_MSG:
+		if (len >= 3) {
+			side = cmd[1] == GEAR_COMMAND_FRONT ? 0 : 1;
+			respond1(cmd[2] < MAXIMUM_BACK_GEARS ? teeth[side][cmd[2]] : 0);
+		}
+		break;
+	case GET_MAC_ADDRESS_MSG:
+		if (len >= 2 && cmd[1] < NRF_DEVICES) {
+			memcpy(response, macs[cmd[1]], 6);
+			responseLen = 6;
+		}
+		break;
+	case SET_GEAR_COUNT_MSG:
+		if (len >= 3 && cmd[1] <= MAXIMUM_FRONT_GEARS && cmd[2] <= MAXIMUM_BACK_GEARS) {
+			gearCount[0] = cmd[1];
+			gearCount[1] = cmd[2];
+		}
+		break;
+	case SET_TEETH_COUNT_MSG:
+		if (len >= 4 && cmd[2] < MAXIMUM_BACK_GEARS)
+			teeth[cmd[1] == GEAR_COMMAND_FRONT ? 0 : 1][cmd[2]] = cmd[3];
+		break;
+	case SET_WHEEL_DIAMETER_MSG:
+		if (len >= 2)
+			wheelDiameter = cmd[1];
+		break;
+	case SET_CADENCE_SETPOINT_MSG:
+		if (len >= 2)
+			cadenceSetPoint = cmd[1];
+		break;
+	default:
+		// Scan, connect and forget need no answer
+		break;
+	}
+}
+
+static void *nrfInterrupts(void *arg) {
+	const char *s;
+	unsigned period = 1000;
+
+	(void)arg;
+	if ((s = getenv("SIM_NRF_PERIOD")) && atoi(s) > 0)
+		period = atoi(s);
+	for(;;) {
+		usleep(period * 1000);
+		simInterrupt(GPIO_PIN_7);
+	}
+	return 0;
+}
+
+void TM_SPI_Init(SPI_TypeDef* SPIx, TM_SPI_PinsPack_t pinspack) {
+	pthread_t thread;
+
+	(void)pinspack;
+	SPIx->CR1 |= SPI_CR1_SPE;
+	SPIx->SR |= SPI_SR_TXE;
+	if (SPIx != SPI2 || startNS)
+		return;
+	startNS = simNanoseconds();
+	if (!pthread_create(&thread, 0, nrfInterrupts, 0))
+		pthread_detach(thread);
+}
+
+void TM_SPI_SendMulti(SPI_TypeDef* SPIx, uint8_t* dataOut, uint8_t* dataIn, uint32_t count) {
+	uint32_t i;
+
+	if (SPIx != SPI2 || !count) {
+		memset(dataIn, 0, count);
+		return;
+	}
+
+	// A waiting response is read with dummy bytes, only the first is looked at
+	if (responsePos < responseLen) {
+		for(i = 0; i < count; i++)
+			dataIn[i] = responsePos < responseLen ? response[responsePos++] : 0;
+		return;
+	}
+	command(dataOut, count);
+	memset(dataIn, 0, count);
+	dataIn[0] = NRF_ACK;
+}
@@ -0,0 +1,206 @@
+/*
+ * Host simulator CMSIS-RTOS shim on pthreads.
+ *
+ * Threads run at host priority, RTX priorities are not simulated. Signals are a flag word
+ * per thread protected by a mutex and a condition, as RTX keeps them in the thread control block.
+ */
+
+#include "cmsis_os.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+
+struct os_thread_cb {
+	pthread_t					thread;
+	const osThreadDef_t *		def;
+	void *						argument;
+	pthread_mutex_t				lock;
+	pthread_cond_t				cond;
+	int32_t						signals;
+};
+
+struct os_mutex_cb {
+	pthread_mutex_t				mutex;
+};
+
+static __thread osThreadId self;
+static int32_t running;
+
+static osThreadId newThread(const osThreadDef_t *def, void *argument) {
+	osThreadId t;
+
+	if (!(t = calloc(1, sizeof(*t))))
+		return 0;
+	t->def = def;
+	t->argument = argument;
+	pthread_mutex_init(&t->lock, 0);
+	pthread_cond_init(&t->cond, 0);
+	return t;
+}
+
+// Absolute time for a timed wait, osWaitForever gives no limit
+static struct timespec *deadline(struct timespec *ts, uint32_t millisec) {
+	if (millisec == osWaitForever)
+		return 0;
+	clock_gettime(CLOCK_REALTIME, ts);
+	ts->tv_sec += millisec / 1000;
+	ts->tv_nsec += (long)(millisec % 1000) * 1000000;
+	if (ts->tv_nsec >= 1000000000) {
+		ts->tv_sec++;
+		ts->tv_nsec -= 1000000000;
+	}
+	return ts;
+}
+
+static void *threadStart(void *arg) {
+	osThreadId t = arg;
+
+	self = t;
+	t->def->pthread(t->argument);
+	return 0;
+}
+
+osStatus osKernelInitialize(void) {
+	return osOK;
+}
+
+osStatus osKernelStart(void) {
+	running = 1;
+	return osOK;
+}
+
+int32_t osKernelRunning(void) {
+	return running;
+}
+
+osThreadId osThreadCreate(const osThreadDef_t *thread_def, void *argument) {
+	osThreadId t;
+
+	if (!thread_def || !(t = newThread(thread_def, argument)))
+		return 0;
+	if (pthread_create(&t->thread, 0, threadStart, t)) {
+		free(t);
+		return 0;
+	}
+	pthread_detach(t->thread);
+	return t;
+}
+
+osThreadId osThreadGetId(void) {
+	// The main thread and uGFX threads get a control block on first use
+	if (!self && (self = newThread(0, 0)))
+		self->thread = pthread_self();
+	return self;
+}
+
+// Only a thread ending itself, the control block stays for signals still sent to it
+osStatus osThreadTerminate(osThreadId thread_id) {
+	if (!thread_id || thread_id != self)
+		return osErrorParameter;
+	pthread_exit(0);
+}
+
+osStatus osThreadYield(void) {
+	sched_yield();
+	return osOK;
+}
+
+osStatus osDelay(uint32_t millisec) {
+	usleep(millisec * 1000);
+	return osOK;
+}
+
+int32_t osSignalSet(osThreadId thread_id, int32_t signals) {
+	int32_t old;
+
+	if (!thread_id)
+		return (int32_t)0x80000000;
+	pthread_mutex_lock(&thread_id->lock);
+	old = thread_id->signals;
+	thread_id->signals |= signals;
+	pthread_cond_broadcast(&thread_id->cond);
+	pthread_mutex_unlock(&thread_id->lock);
+	return old;
+}
+
+int32_t osSignalClear(osThreadId thread_id, int32_t signals) {
+	int32_t old;
+
+	if (!thread_id)
+		return (int32_t)0x80000000;
+	pthread_mutex_lock(&thread_id->lock);
+	old = thread_id->signals;
+	thread_id->signals &= ~signals;
+	pthread_mutex_unlock(&thread_id->lock);
+	return old;
+}
+
+osEvent osSignalWait(int32_t signals, uint32_t millisec) {
+	osThreadId t = osThreadGetId();
+	struct timespec ts, *pts;
+	osEvent ev;
+
+	pts = deadline(&ts, millisec);
+	pthread_mutex_lock(&t->lock);
+	for(;;) {
+		// Zero waits for any signal, as in RTX
+		if (signals ? (t->signals & signals) == signals : t->signals != 0) {
+			ev.status = osEventSignal;
+			ev.value.signals = t->signals;
+			t->signals &= signals ? ~signals : 0;
+			break;
+		}
+		if (!millisec || (pts ? pthread_cond_timedwait(&t->cond, &t->lock, pts) : pthread_cond_wait(&t->cond, &t->lock)) == ETIMEDOUT) {
+			ev.status = millisec ? osEventTimeout : osOK;
+			ev.value.signals = 0;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&t->lock);
+	return ev;
+}
+
+osMutexId osMutexCreate(const osMutexDef_t *mutex_def) {
+	pthread_mutexattr_t attr;
+	osMutexId m;
+
+	(void)mutex_def;
+	if (!(m = malloc(sizeof(*m))))
+		return 0;
+
+	// RTX mutexes can be taken again by the owner
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&m->mutex, &attr);
+	pthread_mutexattr_destroy(&attr);
+	return m;
+}
+
+osStatus osMutexWait(osMutexId mutex_id, uint32_t millisec) {
+	struct timespec ts;
+
+	if (!mutex_id)
+		return osErrorParameter;
+	if (millisec == osWaitForever)
+		return pthread_mutex_lock(&mutex_id->mutex) ? osErrorOS : osOK;
+	if (!millisec)
+		return pthread_mutex_trylock(&mutex_id->mutex) ? osErrorResource : osOK;
+	return pthread_mutex_timedlock(&mutex_id->mutex, deadline(&ts, millisec)) ? osErrorTimeoutResource : osOK;
+}
+
+osStatus osMutexRelease(osMutexId mutex_id) {
+	if (!mutex_id)
+		return osErrorParameter;
+	return pthread_mutex_unlock(&mutex_id->mutex) ? osErrorResource : osOK;
+}
+
+osStatus osMutexDelete(osMutexId mutex_id) {
+	if (!mutex_id)
+		return osErrorParameter;
+	pthread_mutex_destroy(&mutex_id->mutex);
+	free(mutex_id);
+	return osOK;
+}
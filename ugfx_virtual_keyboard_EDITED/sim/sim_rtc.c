@@ -0,0 +1,93 @@
+/*
+ * Host simulator RTC.
+ *
+ * The RTC is the host clock plus an offset. Setting the date moves the offset, so the
+ * time set from GPS keeps running. SIM_RTC gives the unix time at start up, zero starts
+ * at 2000-01-01 like a board with a flat backup battery. SIM_LSE_MS is how long such a cold
+ * start waits for the 32 kHz oscillator in TM_RTC_Init().
+ */
+
+#include "tm_stm32_rtc.h"
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+static int64_t offset;
+static int started;
+
+// The RTC runs from power up, it may be read before TM_RTC_Init()
+static void rtcStart(void) {
+	const char *s;
+
+	if (started)
+		return;
+	started = 1;
+	if ((s = getenv("SIM_RTC"))) {
+		offset = strtoll(s, 0, 0) - (int64_t)time(0);
+		if (offset < 946684800 - (int64_t)time(0))
+			offset = 946684800 - (int64_t)time(0);
+	}
+}
+
+uint32_t TM_RTC_Init(TM_RTC_ClockSource_t source) {
+	const char *s;
+
+	(void)source;
+	rtcStart();
+	if (getenv("SIM_RTC") && (s = getenv("SIM_LSE_MS")))
+		usleep((useconds_t)strtoul(s, 0, 0) * 1000);
+
+	// Without SIM_RTC the host time is used, as a backed up RTC would be running
+	return getenv("SIM_RTC") ? 0 : 1;
+}
+
+uint32_t TM_RTC_GetUnixTimeStamp(TM_RTC_t* data) {
+	struct tm t = {0};
+
+	t.tm_year = data->Year + 100;
+	t.tm_mon = data->Month - 1;
+	t.tm_mday = data->Day;
+	t.tm_hour = data->Hours;
+	t.tm_min = data->Minutes;
+	t.tm_sec = data->Seconds;
+	return (uint32_t)timegm(&t);
+}
+
+TM_RTC_Result_t TM_RTC_GetDateTimeFromUnix(TM_RTC_t* data, uint32_t unix) {
+	time_t now = unix;
+	struct tm t;
+
+	gmtime_r(&now, &t);
+	data->Year = t.tm_year - 100;
+	data->Month = t.tm_mon + 1;
+	data->Day = t.tm_mday;
+	data->WeekDay = t.tm_wday ? t.tm_wday : 7;
+	data->Hours = t.tm_hour;
+	data->Minutes = t.tm_min;
+	data->Seconds = t.tm_sec;
+	data->Unix = unix;
+	return TM_RTC_Result_Ok;
+}
+
+TM_RTC_Result_t TM_RTC_GetDateTime(TM_RTC_t* data, TM_RTC_Format_t format) {
+	struct timespec ts;
+
+	if (format != TM_RTC_Format_BIN)
+		return TM_RTC_Result_Error;
+	rtcStart();
+	clock_gettime(CLOCK_REALTIME, &ts);
+	TM_RTC_GetDateTimeFromUnix(data, (uint32_t)(ts.tv_sec + offset));
+
+	// The subsecond register counts down from the synchronous prescaler
+	data->Subseconds = RTC_SYNC_PREDIV - (uint32_t)(ts.tv_nsec / 1000) * (RTC_SYNC_PREDIV + 1) / 1000000;
+	return TM_RTC_Result_Ok;
+}
+
+TM_RTC_Result_t TM_RTC_SetDateTime(TM_RTC_t* data, TM_RTC_Format_t format) {
+	if (format != TM_RTC_Format_BIN || data->Month < 1 || data->Month > 12 || data->Day < 1 || data->Day > 31
+			|| data->Hours > 23 || data->Minutes > 59 || data->Seconds > 59 || data->Year > 99)
+		return TM_RTC_Result_Error;
+	started = 1;
+	offset = (int64_t)TM_RTC_GetUnixTimeStamp(data) - (int64_t)time(0);
+	return TM_RTC_Result_Ok;
+}
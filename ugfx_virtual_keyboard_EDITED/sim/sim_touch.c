@@ -0,0 +1,139 @@
+/*
+ * Host simulator touch panel for headless runs.
+ *
+ * Replaces the FT6x06 driver with touches from the script named by SIM_TOUCH. Each line
+ * waits for a time in milliseconds since the last line and then touches or releases:
+ *
+ *	<ms> <x> <y>		touch down, or move while down
+ *	<ms> up				release
+ *	repeat				start the script again
+ *
+ * Blank lines and lines starting with # are skipped. A touch raises the INT line (PE5) so
+ * it goes through TM_EXTI_Handler() and the latency trace as it does on the board.
+ */
+
+#include "gfx.h"
+
+#if GFX_USE_GINPUT && GINPUT_NEED_MOUSE
+
+#define GMOUSE_DRIVER_VMT		GMOUSEVMT_SimTouch
+#include "../ugfx/src/ginput/ginput_driver_mouse.h"
+
+#include "tm_stm32_exti.h"
+#include "latency.h"
+#include "sim.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static GMouse *touchMouse;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static coord_t touchX, touchY;
+static uint16_t touchZ;
+
+// From the EXTI handler for the INT line
+void touchInterrupt(void) {
+	if (touchMouse)
+		_gmouseWakeupI(touchMouse);
+}
+
+static void touch(coord_t x, coord_t y, uint16_t z) {
+	pthread_mutex_lock(&lock);
+	if (z) {
+		touchX = x;
+		touchY = y;
+	}
+	touchZ = z;
+	pthread_mutex_unlock(&lock);
+	simInterrupt(GPIO_PIN_5);
+}
+
+static void *touchScript(void *arg) {
+	const char *name = arg;
+	char line[64];
+	unsigned ms;
+	int x, y;
+	FILE *f;
+
+	if (!(f = fopen(name, "r"))) {
+		fprintf(stderr, "sim: touch script %s can not be opened\n", name);
+		return 0;
+	}
+	while (fgets(line, sizeof(line), f)) {
+		if (line[0] == '#' || line[0] == '\n' || line[0] == '\r')
+			continue;
+		if (strncmp(line, "repeat", 6) == 0) {
+			rewind(f);
+			continue;
+		}
+		if (sscanf(line, "%u %d %d", &ms, &x, &y) == 3) {
+			usleep(ms * 1000);
+			touch(x, y, 1);
+		} else if (sscanf(line, "%u up", &ms) == 1 && strstr(line, "up")) {
+			usleep(ms * 1000);
+			touch(0, 0, 0);
+		} else
+			fprintf(stderr, "sim: touch script line skipped: %s", line);
+	}
+	fclose(f);
+	return 0;
+}
+
+static bool_t SimTouchInit(GMouse *m, unsigned driverinstance) {
+	pthread_t thread;
+	char *s;
+
+	(void)driverinstance;
+	touchMouse = m;
+	EXTI->IMR |= GPIO_PIN_5;
+	if ((s = getenv("SIM_TOUCH")) && !pthread_create(&thread, 0, touchScript, s))
+		pthread_detach(thread);
+	return TRUE;
+}
+
+static bool_t SimTouchRead(GMouse *m, GMouseReading *pdr) {
+	(void)m;
+
+	latencyMark(LATENCY_READ);
+	pthread_mutex_lock(&lock);
+	pdr->x = touchX;
+	pdr->y = touchY;
+	pdr->z = touchZ;
+	pthread_mutex_unlock(&lock);
+	pdr->buttons = 0;
+	return TRUE;
+}
+
+const GMouseVMT const GMOUSE_DRIVER_VMT[1] = {{
+	{
+		GDRIVER_TYPE_TOUCH,
+		GMOUSE_VFLG_TOUCH | GMOUSE_VFLG_NOPOLL,
+		sizeof(GMouse),
+		_gmouseInitDriver,
+		_gmousePostInitDriver,
+		_gmouseDeInitDriver
+	},
+	1,				// z_max
+	0,				// z_min
+	1,				// z_touchon
+	0,				// z_touchoff
+	{				// pen_jitter
+		0,				// calibrate
+		0,				// click
+		0				// move
+	},
+	{				// finger_jitter
+		0,				// calibrate
+		0,				// click
+		0				// move
+	},
+	SimTouchInit,	// init
+	0,				// deinit
+	SimTouchRead,	// get
+	0,				// calsave
+	0				// calload
+}};
+
+#endif /* GFX_USE_GINPUT && GINPUT_NEED_MOUSE */
@@ -0,0 +1,15 @@
+/*
+ * Host simulator LCD header.
+ *
+ * The display is a uGFX driver on the host, the BSP LCD functions are not used.
+ */
+
+#ifndef _SIM_STM32469I_DISCOVERY_LCD_H
+#define _SIM_STM32469I_DISCOVERY_LCD_H
+
+#include "stm32469i_discovery_sdram.h"
+
+#define LCD_OK							((uint8_t)0x00)
+#define LCD_ERROR						((uint8_t)0x01)
+
+#endif /* _SIM_STM32469I_DISCOVERY_LCD_H */
@@ -0,0 +1,16 @@
+/*
+ * Host simulator SD card header.
+ *
+ * The SD card is a host directory through the native GFILE file system, diskio.c is
+ * compiled out and only needs this header to be found.
+ */
+
+#ifndef _SIM_STM32469I_DISCOVERY_SD_H
+#define _SIM_STM32469I_DISCOVERY_SD_H
+
+#include "stm32f4xx_hal.h"
+
+#define MSD_OK							((uint8_t)0x00)
+#define MSD_ERROR						((uint8_t)0x01)
+
+#endif /* _SIM_STM32469I_DISCOVERY_SD_H */
@@ -0,0 +1,29 @@
+/*
+ * Host simulator SDRAM header.
+ *
+ * The application keeps its buffers at fixed SDRAM addresses, BSP_SDRAM_Init() maps host
+ * memory at the same address so they are used unchanged.
+ */
+
+#ifndef _SIM_STM32469I_DISCOVERY_SDRAM_H
+#define _SIM_STM32469I_DISCOVERY_SDRAM_H
+
+#include "stm32f4xx_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SDRAM_OK						((uint8_t)0x00)
+#define SDRAM_ERROR						((uint8_t)0x01)
+
+#define SDRAM_DEVICE_ADDR				((uint32_t)0xC0000000)
+#define SDRAM_DEVICE_SIZE				((uint32_t)0x800000)
+
+uint8_t BSP_SDRAM_Init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SIM_STM32469I_DISCOVERY_SDRAM_H */
@@ -0,0 +1,205 @@
+/*
+ * Host simulator device header.
+ *
+ * Stands in for the CMSIS device header. Peripherals are plain structures in host memory
+ * so the register macros in the TM libraries still compile, the simulated devices are
+ * behind the library functions in sim_hal.c, sim_nrf.c and sim_gps.c.
+ */
+
+#ifndef _SIM_STM32F4XX_H
+#define _SIM_STM32F4XX_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// gcc predefines unix in GNU mode, the RTC library uses it as a parameter name
+#undef unix
+
+#define STM32F469xx
+#define __IO							volatile
+#define __I								volatile const
+#define __O								volatile
+#define __INLINE						inline
+#define __STATIC_INLINE					static inline
+#define __weak							__attribute__((weak))
+#define __packed						__attribute__((packed))
+#define __ALIGN_BEGIN
+#define __ALIGN_END						__attribute__((aligned(4)))
+
+#define __disable_irq()
+#define __enable_irq()
+#define __DSB()
+#define __ISB()
+#define __DMB()
+#define __NOP()
+
+typedef enum { RESET = 0, SET = !RESET } FlagStatus, ITStatus;
+typedef enum { DISABLE = 0, ENABLE = !DISABLE } FunctionalState;
+typedef enum { ERROR = 0, SUCCESS = !ERROR } ErrorStatus;
+
+extern uint32_t SystemCoreClock;
+
+typedef struct {
+	__IO uint32_t MODER;
+	__IO uint32_t OTYPER;
+	__IO uint32_t OSPEEDR;
+	__IO uint32_t PUPDR;
+	__IO uint32_t IDR;
+	__IO uint32_t ODR;
+	__IO uint32_t BSRR;
+	__IO uint32_t LCKR;
+	__IO uint32_t AFR[2];
+} GPIO_TypeDef;
+
+typedef struct {
+	__IO uint32_t CR1;
+	__IO uint32_t CR2;
+	__IO uint32_t SR;
+	__IO uint32_t DR;
+	__IO uint32_t CRCPR;
+	__IO uint32_t RXCRCR;
+	__IO uint32_t TXCRCR;
+	__IO uint32_t I2SCFGR;
+	__IO uint32_t I2SPR;
+} SPI_TypeDef;
+
+typedef struct {
+	__IO uint32_t SR;
+	__IO uint32_t DR;
+	__IO uint32_t BRR;
+	__IO uint32_t CR1;
+	__IO uint32_t CR2;
+	__IO uint32_t CR3;
+	__IO uint32_t GTPR;
+} USART_TypeDef;
+
+typedef struct {
+	__IO uint32_t CR1;
+	__IO uint32_t CR2;
+	__IO uint32_t OAR1;
+	__IO uint32_t OAR2;
+	__IO uint32_t DR;
+	__IO uint32_t SR1;
+	__IO uint32_t SR2;
+	__IO uint32_t CCR;
+	__IO uint32_t TRISE;
+	__IO uint32_t FLTR;
+} I2C_TypeDef;
+
+typedef struct {
+	__IO uint32_t IMR;
+	__IO uint32_t EMR;
+	__IO uint32_t RTSR;
+	__IO uint32_t FTSR;
+	__IO uint32_t SWIER;
+	__IO uint32_t PR;
+} EXTI_TypeDef;
+
+typedef struct {
+	__IO uint32_t CR;
+	__IO uint32_t NDTR;
+	__IO uint32_t PAR;
+	__IO uint32_t M0AR;
+	__IO uint32_t M1AR;
+	__IO uint32_t FCR;
+} DMA_Stream_TypeDef;
+
+typedef struct {
+	__IO uint32_t CTRL;
+	__IO uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+	__IO uint32_t DHCSR;
+	__IO uint32_t DCRSR;
+	__IO uint32_t DCRDR;
+	__IO uint32_t DEMCR;
+} CoreDebug_Type;
+
+// DMA stream interrupts of the USART receive streams
+typedef enum {
+	DMA1_Stream0_IRQn				= 11,
+	DMA1_Stream1_IRQn				= 12,
+	DMA1_Stream2_IRQn				= 13,
+	DMA1_Stream3_IRQn				= 14,
+	DMA1_Stream5_IRQn				= 16,
+	DMA1_Stream6_IRQn				= 17,
+	DMA2_Stream1_IRQn				= 57,
+	DMA2_Stream2_IRQn				= 58
+} IRQn_Type;
+
+// The peripherals, see sim_hal.c, simDMA is only used by sim/bench/usart_dma.c
+extern GPIO_TypeDef simGPIO[11];
+extern SPI_TypeDef simSPI[6];
+extern USART_TypeDef simUSART[8];
+extern DMA_Stream_TypeDef simDMA[16];
+extern I2C_TypeDef simI2C[3];
+extern EXTI_TypeDef simEXTI;
+extern CoreDebug_Type simCoreDebug;
+DWT_Type *simDWT(void);
+
+#define GPIOA							(&simGPIO[0])
+#define GPIOB							(&simGPIO[1])
+#define GPIOC							(&simGPIO[2])
+#define GPIOD							(&simGPIO[3])
+#define GPIOE							(&simGPIO[4])
+#define GPIOF							(&simGPIO[5])
+#define GPIOG							(&simGPIO[6])
+#define GPIOH							(&simGPIO[7])
+#define GPIOI							(&simGPIO[8])
+#define GPIOJ							(&simGPIO[9])
+#define GPIOK							(&simGPIO[10])
+#define SPI1							(&simSPI[0])
+#define SPI2							(&simSPI[1])
+#define SPI3							(&simSPI[2])
+#define SPI4							(&simSPI[3])
+#define SPI5							(&simSPI[4])
+#define SPI6							(&simSPI[5])
+#define USART1							(&simUSART[0])
+#define USART2							(&simUSART[1])
+#define USART3							(&simUSART[2])
+#define UART4							(&simUSART[3])
+#define UART5							(&simUSART[4])
+#define USART6							(&simUSART[5])
+#define UART7							(&simUSART[6])
+#define UART8							(&simUSART[7])
+#define DMA1_Stream0					(&simDMA[0])
+#define DMA1_Stream1					(&simDMA[1])
+#define DMA1_Stream2					(&simDMA[2])
+#define DMA1_Stream3					(&simDMA[3])
+#define DMA1_Stream5					(&simDMA[5])
+#define DMA1_Stream6					(&simDMA[6])
+#define DMA2_Stream0					(&simDMA[8])
+#define DMA2_Stream1					(&simDMA[9])
+#define DMA2_Stream2					(&simDMA[10])
+#define I2C1							(&simI2C[0])
+#define I2C2							(&simI2C[1])
+#define I2C3							(&simI2C[2])
+#define EXTI							(&simEXTI)
+#define CoreDebug						(&simCoreDebug)
+
+// Reading the cycle counter brings it up to the host clock at SystemCoreClock
+#define DWT								(simDWT())
+
+#define SPI_CR1_SPE						0x0040
+#define SPI_SR_RXNE						0x0001
+#define SPI_SR_TXE						0x0002
+#define SPI_SR_BSY						0x0080
+#define USART_CR1_IDLEIE				0x0010
+#define USART_CR1_RXNEIE				0x0020
+#define USART_CR1_UE					0x2000
+#define USART_CR3_DMAR					0x0040
+#define USART_SR_RXNE					0x0020
+#define USART_SR_TC						0x0040
+#define USART_SR_TXE					0x0080
+#define DWT_CTRL_CYCCNTENA_Msk			0x00000001
+#define CoreDebug_DEMCR_TRCENA_Msk		0x01000000
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SIM_STM32F4XX_H */
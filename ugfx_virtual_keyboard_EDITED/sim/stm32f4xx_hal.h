@@ -0,0 +1,260 @@
+/*
+ * Host simulator HAL header.
+ *
+ * The types, constants and functions of the STM32Cube HAL that the application and the
+ * TM library headers use. Clock and power configuration is accepted and ignored,
+ * the tick and the delays run on the host clock.
+ */
+
+#ifndef _SIM_STM32F4XX_HAL_H
+#define _SIM_STM32F4XX_HAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "stm32f4xx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+	HAL_OK			= 0x00,
+	HAL_ERROR		= 0x01,
+	HAL_BUSY		= 0x02,
+	HAL_TIMEOUT		= 0x03
+} HAL_StatusTypeDef;
+
+#define HAL_MAX_DELAY					0xFFFFFFFFU
+
+/* RCC and power */
+typedef struct {
+	uint32_t PLLState;
+	uint32_t PLLSource;
+	uint32_t PLLM;
+	uint32_t PLLN;
+	uint32_t PLLP;
+	uint32_t PLLQ;
+	uint32_t PLLR;
+} RCC_PLLInitTypeDef;
+
+typedef struct {
+	uint32_t OscillatorType;
+	uint32_t HSEState;
+	uint32_t LSEState;
+	uint32_t HSIState;
+	uint32_t HSICalibrationValue;
+	uint32_t LSIState;
+	RCC_PLLInitTypeDef PLL;
+} RCC_OscInitTypeDef;
+
+typedef struct {
+	uint32_t ClockType;
+	uint32_t SYSCLKSource;
+	uint32_t AHBCLKDivider;
+	uint32_t APB1CLKDivider;
+	uint32_t APB2CLKDivider;
+} RCC_ClkInitTypeDef;
+
+typedef struct {
+	uint32_t PLLSAIN;
+	uint32_t PLLSAIP;
+	uint32_t PLLSAIQ;
+	uint32_t PLLSAIR;
+} RCC_PLLSAIInitTypeDef;
+
+typedef struct {
+	uint32_t PLLI2SN;
+	uint32_t PLLI2SR;
+	uint32_t PLLI2SQ;
+} RCC_PLLI2SInitTypeDef;
+
+typedef struct {
+	uint32_t PeriphClockSelection;
+	RCC_PLLI2SInitTypeDef PLLI2S;
+	RCC_PLLSAIInitTypeDef PLLSAI;
+	uint32_t PLLI2SDivQ;
+	uint32_t PLLSAIDivQ;
+	uint32_t PLLSAIDivR;
+	uint32_t RTCClockSelection;
+	uint8_t TIMPresSelection;
+	uint32_t Clk48ClockSelection;
+	uint32_t SdioClockSelection;
+} RCC_PeriphCLKInitTypeDef;
+
+#define RCC_OSCILLATORTYPE_NONE			0x00000000U
+#define RCC_OSCILLATORTYPE_HSE			0x00000001U
+#define RCC_OSCILLATORTYPE_HSI			0x00000002U
+#define RCC_OSCILLATORTYPE_LSE			0x00000004U
+#define RCC_OSCILLATORTYPE_LSI			0x00000008U
+#define RCC_HSE_OFF						0x00000000U
+#define RCC_HSE_ON						0x00010000U
+#define RCC_PLL_NONE					0x00000000U
+#define RCC_PLL_OFF						0x00000001U
+#define RCC_PLL_ON						0x00000002U
+#define RCC_PLLSOURCE_HSI				0x00000000U
+#define RCC_PLLSOURCE_HSE				0x00400000U
+#define RCC_PLLP_DIV2					0x00000002U
+#define RCC_PLLP_DIV4					0x00000004U
+#define RCC_PLLP_DIV6					0x00000006U
+#define RCC_PLLP_DIV8					0x00000008U
+#define RCC_CLOCKTYPE_SYSCLK			0x00000001U
+#define RCC_CLOCKTYPE_HCLK				0x00000002U
+#define RCC_CLOCKTYPE_PCLK1				0x00000004U
+#define RCC_CLOCKTYPE_PCLK2				0x00000008U
+#define RCC_SYSCLKSOURCE_HSI			0x00000000U
+#define RCC_SYSCLKSOURCE_HSE			0x00000001U
+#define RCC_SYSCLKSOURCE_PLLCLK			0x00000002U
+#define RCC_SYSCLK_DIV1					0x00000000U
+#define RCC_SYSCLK_DIV2					0x00000080U
+#define RCC_HCLK_DIV1					0x00000000U
+#define RCC_HCLK_DIV2					0x00001000U
+#define RCC_HCLK_DIV4					0x00001400U
+#define RCC_HCLK_DIV8					0x00001800U
+#define RCC_PERIPHCLK_LTDC				0x00000008U
+#define RCC_PLLSAIDIVR_2				0x00000000U
+#define RCC_PLLSAIDIVR_4				0x00010000U
+#define RCC_PLLSAIDIVR_8				0x00020000U
+#define RCC_PLLSAIDIVR_16				0x00030000U
+#define FLASH_LATENCY_5					0x00000005U
+#define PWR_REGULATOR_VOLTAGE_SCALE1	0x0000C000U
+
+#define __HAL_RCC_PWR_CLK_ENABLE()
+#define __HAL_PWR_VOLTAGESCALING_CONFIG(__REGULATOR__)	((void)(__REGULATOR__))
+#define __HAL_RCC_GPIOA_CLK_ENABLE()
+#define __HAL_RCC_GPIOB_CLK_ENABLE()
+#define __HAL_RCC_GPIOC_CLK_ENABLE()
+#define __HAL_RCC_GPIOD_CLK_ENABLE()
+#define __HAL_RCC_GPIOH_CLK_ENABLE()
+
+/* GPIO */
+#define GPIO_MODE_INPUT					0x00000000U
+#define GPIO_MODE_OUTPUT_PP				0x00000001U
+#define GPIO_MODE_OUTPUT_OD				0x00000011U
+#define GPIO_MODE_AF_PP					0x00000002U
+#define GPIO_MODE_AF_OD					0x00000012U
+#define GPIO_MODE_ANALOG				0x00000003U
+#define GPIO_NOPULL						0x00000000U
+#define GPIO_PULLUP						0x00000001U
+#define GPIO_PULLDOWN					0x00000002U
+#define GPIO_SPEED_LOW					0x00000000U
+#define GPIO_SPEED_MEDIUM				0x00000001U
+#define GPIO_SPEED_FAST					0x00000002U
+#define GPIO_SPEED_HIGH					0x00000003U
+#define GPIO_SPEED_FREQ_LOW				GPIO_SPEED_LOW
+#define GPIO_SPEED_FREQ_MEDIUM			GPIO_SPEED_MEDIUM
+#define GPIO_SPEED_FREQ_HIGH			GPIO_SPEED_FAST
+#define GPIO_SPEED_FREQ_VERY_HIGH		GPIO_SPEED_HIGH
+
+/* SPI */
+#define SPI_MODE_SLAVE					0x00000000U
+#define SPI_MODE_MASTER					0x00000104U
+#define SPI_DATASIZE_8BIT				0x00000000U
+#define SPI_DATASIZE_16BIT				0x00000800U
+#define SPI_FIRSTBIT_MSB				0x00000000U
+#define SPI_FIRSTBIT_LSB				0x00000080U
+#define SPI_BAUDRATEPRESCALER_2			0x00000000U
+#define SPI_BAUDRATEPRESCALER_4			0x00000008U
+#define SPI_BAUDRATEPRESCALER_8			0x00000010U
+#define SPI_BAUDRATEPRESCALER_16		0x00000018U
+#define SPI_BAUDRATEPRESCALER_32		0x00000020U
+#define SPI_BAUDRATEPRESCALER_64		0x00000028U
+#define SPI_BAUDRATEPRESCALER_128		0x00000030U
+#define SPI_BAUDRATEPRESCALER_256		0x00000038U
+#define SPI_FLAG_RXNE					SPI_SR_RXNE
+#define SPI_FLAG_TXE					SPI_SR_TXE
+#define SPI_FLAG_BSY					SPI_SR_BSY
+
+/* UART */
+#define UART_WORDLENGTH_8B				0x00000000U
+#define UART_WORDLENGTH_9B				0x00001000U
+#define UART_STOPBITS_1					0x00000000U
+#define UART_STOPBITS_2					0x00002000U
+#define UART_PARITY_NONE				0x00000000U
+#define UART_PARITY_EVEN				0x00000400U
+#define UART_PARITY_ODD					0x00000600U
+#define UART_MODE_RX					0x00000004U
+#define UART_MODE_TX					0x00000008U
+#define UART_MODE_TX_RX					0x0000000CU
+#define UART_HWCONTROL_NONE				0x00000000U
+#define UART_HWCONTROL_RTS				0x00000100U
+#define UART_HWCONTROL_CTS				0x00000200U
+#define UART_HWCONTROL_RTS_CTS			0x00000300U
+#define USART_FLAG_RXNE					USART_SR_RXNE
+#define USART_FLAG_TC					USART_SR_TC
+#define USART_FLAG_TXE					USART_SR_TXE
+
+/* DMA, the functions are only provided by sim/bench/usart_dma.c */
+typedef struct {
+	uint32_t Channel;
+	uint32_t Direction;
+	uint32_t PeriphInc;
+	uint32_t MemInc;
+	uint32_t PeriphDataAlignment;
+	uint32_t MemDataAlignment;
+	uint32_t Mode;
+	uint32_t Priority;
+	uint32_t FIFOMode;
+	uint32_t MemBurst;
+	uint32_t PeriphBurst;
+} DMA_InitTypeDef;
+
+typedef struct {
+	DMA_Stream_TypeDef *Instance;
+	DMA_InitTypeDef Init;
+	uint32_t State;
+} DMA_HandleTypeDef;
+
+#define DMA_CHANNEL_4					0x08000000U
+#define DMA_CHANNEL_5					0x0A000000U
+#define DMA_PERIPH_TO_MEMORY			0x00000000U
+#define DMA_PINC_DISABLE				0x00000000U
+#define DMA_MINC_ENABLE					0x00000400U
+#define DMA_PDATAALIGN_BYTE				0x00000000U
+#define DMA_MDATAALIGN_BYTE				0x00000000U
+#define DMA_CIRCULAR					0x00000100U
+#define DMA_PRIORITY_MEDIUM				0x00010000U
+#define DMA_FIFOMODE_DISABLE			0x00000000U
+#define DMA_MBURST_SINGLE				0x00000000U
+#define DMA_PBURST_SINGLE				0x00000000U
+#define DMA_IT_TC						0x00000010U
+#define DMA_IT_HT						0x00000008U
+
+// Transfer flags are not kept, the stream interrupt handlers only clear them
+#define __HAL_RCC_DMA1_CLK_ENABLE()
+#define __HAL_RCC_DMA2_CLK_ENABLE()
+#define __HAL_DMA_GET_COUNTER(__HANDLE__)				((__HANDLE__)->Instance->NDTR)
+#define __HAL_DMA_ENABLE_IT(__HANDLE__, __INTERRUPT__)	((__HANDLE__)->Instance->CR |= (__INTERRUPT__))
+#define __HAL_DMA_GET_HT_FLAG_INDEX(__HANDLE__)		0x00000010U
+#define __HAL_DMA_GET_TC_FLAG_INDEX(__HANDLE__)		0x00000020U
+#define __HAL_DMA_GET_TE_FLAG_INDEX(__HANDLE__)		0x00000008U
+#define __HAL_DMA_GET_FE_FLAG_INDEX(__HANDLE__)		0x00000001U
+#define __HAL_DMA_GET_DME_FLAG_INDEX(__HANDLE__)		0x00000004U
+#define __HAL_DMA_GET_FLAG(__HANDLE__, __FLAG__)		((void)(__HANDLE__), (__FLAG__) & 0)
+#define __HAL_DMA_CLEAR_FLAG(__HANDLE__, __FLAG__)		((void)(__HANDLE__), (void)(__FLAG__))
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma);
+HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef *hdma);
+HAL_StatusTypeDef HAL_DMA_Start(DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t DstAddress, uint32_t DataLength);
+HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef *hdma);
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn);
+void HAL_NVIC_ClearPendingIRQ(IRQn_Type IRQn);
+
+/* Core */
+HAL_StatusTypeDef HAL_Init(void);
+void HAL_IncTick(void);
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t Delay);
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct);
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef *RCC_ClkInitStruct, uint32_t FLatency);
+uint32_t HAL_RCC_GetHCLKFreq(void);
+void HAL_RCCEx_GetPeriphCLKConfig(RCC_PeriphCLKInitTypeDef *PeriphClkInit);
+HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef *PeriphClkInit);
+HAL_StatusTypeDef HAL_PWREx_EnableOverDrive(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SIM_STM32F4XX_HAL_H */
@@ -0,0 +1,1047 @@
+/*
+ * Vector map tile converter.
+ *
+ * Reads an OpenStreetMap XML extract and writes the tiles of vmap.h for data zooms 12, 14 and
+ * 16 to <dir>/Vector/<zoom>/<x>/<y>.vmt, the layout the firmware expects on the SD card:
+ *
+ *	vmt_convert <map.osm> <dir>
+ *
+ * Ways are classed by their tags with the table below, closed ways of an area class become
+ * areas and the rest lines. Relations are not read, so multipolygons are left out. For each
+ * data zoom the ways are simplified to half a pixel of that zoom with the same world positions
+ * projection.c gives on the board, then clipped to every tile they touch with the margin of
+ * vmap.h. Areas are triangulated and the triangles merged into convex pieces. Features smaller
+ * than two pixels get a higher min zoom or are left out, and when a tile does not fit into
+ * VMAP_TILE_BYTES the least important classes are left out of that tile.
+ *
+ * Build from the project directory:
+ *
+ *	gcc -std=gnu99 -O2 -Wno-duplicate-decl-specifier -Isim/headless -Isim -I. -Iugfx \
+ *		-Iugfx/drivers/gdisp/framebuffer -o vmt_convert sim/tools/vmt_convert.c projection.c -lm
+ *
+ * sim/bench/vmap_roundtrip.c builds it with VMT_CONVERT_NO_MAIN and calls vmtConvert().
+ */
+
+#include "vmt_convert.h"
+#include "vmap.h"
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define VMT_DATA_ZOOMS			3				// 12, 14 and 16
+#define VMT_MARGIN				(VMAP_EXTENT / 8)
+#define VMT_PIXEL				(VMAP_EXTENT / 256)	// Tile units per pixel at the data zoom
+#define VMT_TOLERANCE			(VMT_PIXEL / 2.0)
+#define VMT_MIN_PIXELS			2
+#define VMT_ESCAPE				-128
+#define VMT_HEADER_BYTES		12
+#define VMT_FEATURE_BYTES		6
+#define VMT_ATTR_SIZE			64
+
+typedef struct {
+	int64_t		id;
+	proj_world_t	w;
+} vmtNode;
+
+typedef struct {
+	uint8_t		cls;
+	uint8_t		zoom;				// First display zoom of the class
+	uint8_t		area;
+	uint32_t	first;				// Points of the way
+	uint32_t	count;
+	uint32_t	zfirst;				// Points simplified for the data zoom being converted
+	uint32_t	zcount;
+	proj_world_t	min, max;
+} vmtWay;
+
+typedef struct {
+	double		x, y;
+} vmtPoint;
+
+typedef struct {
+	int32_t		x, y;
+} vmtXY;
+
+typedef struct {
+	uint8_t		cls;
+	uint8_t		minZoom;
+	uint8_t		area;
+	uint8_t		dropped;
+	uint32_t	seq;				// Keeps the order of the ways within a class
+	uint32_t	first;
+	uint32_t	count;
+} vmtFeature;
+
+typedef struct {
+	const char *	key;
+	const char *	value;
+	uint8_t			cls;
+	uint8_t			area;
+	uint8_t			zoom;		// First display zoom with a width in the styles of vmap.c
+} vmtTag;
+
+typedef struct {
+	uint32_t	tiles;
+	uint32_t	features;
+	uint32_t	bytes;
+	uint32_t	largest;
+	uint32_t	dropped;			// Features left out of tiles that were too large
+	uint32_t	failed;				// Areas that could not be triangulated to the end
+} vmtStats;
+
+// A way gets the class of its first row that matches one of its tags
+static const vmtTag tags[] = {
+	{"highway",		"motorway",			VMAP_CLASS_MOTORWAY,	0, 12},
+	{"highway",		"motorway_link",	VMAP_CLASS_MOTORWAY,	0, 12},
+	{"highway",		"trunk",			VMAP_CLASS_PRIMARY,		0, 12},
+	{"highway",		"trunk_link",		VMAP_CLASS_PRIMARY,		0, 12},
+	{"highway",		"primary",			VMAP_CLASS_PRIMARY,		0, 12},
+	{"highway",		"primary_link",		VMAP_CLASS_PRIMARY,		0, 12},
+	{"highway",		"secondary",		VMAP_CLASS_SECONDARY,	0, 12},
+	{"highway",		"secondary_link",	VMAP_CLASS_SECONDARY,	0, 12},
+	{"highway",		"tertiary",			VMAP_CLASS_SECONDARY,	0, 12},
+	{"highway",		"tertiary_link",	VMAP_CLASS_SECONDARY,	0, 12},
+	{"highway",		"cycleway",			VMAP_CLASS_CYCLEWAY,	0, 13},
+	{"highway",		"residential",		VMAP_CLASS_MINOR,		0, 13},
+	{"highway",		"unclassified",		VMAP_CLASS_MINOR,		0, 13},
+	{"highway",		"living_street",	VMAP_CLASS_MINOR,		0, 13},
+	{"highway",		"service",			VMAP_CLASS_MINOR,		0, 15},
+	{"highway",		"path",				VMAP_CLASS_PATH,		0, 15},
+	{"highway",		"footway",			VMAP_CLASS_PATH,		0, 15},
+	{"highway",		"bridleway",		VMAP_CLASS_PATH,		0, 15},
+	{"highway",		"track",			VMAP_CLASS_PATH,		0, 15},
+	{"highway",		"pedestrian",		VMAP_CLASS_PATH,		0, 15},
+	{"highway",		"steps",			VMAP_CLASS_PATH,		0, 16},
+	{"waterway",	"river",			VMAP_CLASS_RIVER,		0, 12},
+	{"waterway",	"canal",			VMAP_CLASS_RIVER,		0, 12},
+	{"waterway",	"stream",			VMAP_CLASS_RIVER,		0, 14},
+	{"natural",		"water",			VMAP_CLASS_WATER,		1, 12},
+	{"waterway",	"riverbank",		VMAP_CLASS_WATER,		1, 12},
+	{"landuse",		"reservoir",		VMAP_CLASS_WATER,		1, 12},
+	{"landuse",		"basin",			VMAP_CLASS_WATER,		1, 12},
+	{"leisure",		"park",				VMAP_CLASS_PARK,		1, 12},
+	{"leisure",		"golf_course",		VMAP_CLASS_PARK,		1, 12},
+	{"landuse",		"grass",			VMAP_CLASS_PARK,		1, 12},
+	{"landuse",		"recreation_ground",	VMAP_CLASS_PARK,	1, 12},
+	{"landuse",		"forest",			VMAP_CLASS_FOREST,		1, 12},
+	{"natural",		"wood",				VMAP_CLASS_FOREST,		1, 12},
+	{"landuse",		"residential",		VMAP_CLASS_RESIDENTIAL,	1, 14},
+	{"landuse",		"industrial",		VMAP_CLASS_INDUSTRIAL,	1, 14},
+	{"landuse",		"commercial",		VMAP_CLASS_INDUSTRIAL,	1, 14},
+	{"landuse",		"retail",			VMAP_CLASS_INDUSTRIAL,	1, 14}
+};
+
+// Areas are drawn in this order, so water lies over parks and parks over built up land
+static const uint8_t areaRank[VMAP_CLASSES] = {
+	[VMAP_CLASS_RESIDENTIAL] = 0,
+	[VMAP_CLASS_INDUSTRIAL] = 1,
+	[VMAP_CLASS_FOREST] = 2,
+	[VMAP_CLASS_PARK] = 3,
+	[VMAP_CLASS_WATER] = 4
+};
+
+// Classes left out of a tile that is too large, least important first
+static const uint8_t dropOrder[] = {
+	VMAP_CLASS_PATH, VMAP_CLASS_RESIDENTIAL, VMAP_CLASS_INDUSTRIAL, VMAP_CLASS_MINOR, VMAP_CLASS_FOREST,
+	VMAP_CLASS_PARK, VMAP_CLASS_CYCLEWAY, VMAP_CLASS_RIVER, VMAP_CLASS_WATER, VMAP_CLASS_SECONDARY,
+	VMAP_CLASS_PRIMARY, VMAP_CLASS_MOTORWAY
+};
+
+static vmtNode *nodes;
+static uint32_t nodeCount, nodeSize;
+static int nodesSorted = 1;
+static proj_world_t *points, *zpoints;
+static uint32_t pointCount, pointSize, zpointCount, zpointSize;
+static vmtWay *ways;
+static uint32_t wayCount, waySize;
+static int64_t *refs;
+static uint32_t refCount, refSize;
+
+// Tile being built
+static vmtFeature *features;
+static uint32_t featureCount, featureSize;
+static vmtXY *pool;
+static uint32_t poolCount, poolSize;
+static uint8_t tileData[VMAP_TILE_BYTES];
+
+// Scratch for one way in tile units
+static vmtPoint *work, *work2;
+static uint32_t workSize, work2Size;
+static vmtXY *ring;
+static uint32_t ringSize;
+
+static void *vmtGrow(void *p, uint32_t *size, uint32_t need, size_t item) {
+	uint32_t n = *size ? *size : 1024;
+
+	if (need <= *size)
+		return p;
+	while (n < need)
+		n *= 2;
+	p = realloc(p, n * item);
+	if (!p) {
+		fprintf(stderr, "Out of memory\n");
+		exit(2);
+	}
+	*size = n;
+	return p;
+}
+
+// Value of attribute name within the XML element at p
+static int vmtAttr(const char *p, const char *name, char *out, size_t size) {
+	const char *end = strchr(p, '>');
+	size_t len = strlen(name), i;
+	char quote;
+
+	if (!end)
+		return 0;
+	for (p = strchr(p, ' '); p && p < end; p = strchr(p + 1, ' ')) {
+		if (strncmp(p + 1, name, len) || p[len + 1] != '=')
+			continue;
+		quote = p[len + 2];
+		if (quote != '"' && quote != '\'')
+			return 0;
+		p += len + 3;
+		for (i = 0; i + 1 < size && p < end && *p != quote; i++)
+			out[i] = *p++;
+		out[i] = 0;
+		return 1;
+	}
+	return 0;
+}
+
+static int32_t vmtDegrees(const char *s) {
+	return (int32_t)lround(strtod(s, 0) * 1e7);
+}
+
+static int vmtNodeCompare(const void *a, const void *b) {
+	int64_t x = ((const vmtNode *)a)->id, y = ((const vmtNode *)b)->id;
+
+	return x < y ? -1 : x > y;
+}
+
+static const vmtNode *vmtFindNode(int64_t id) {
+	uint32_t lo = 0, hi = nodeCount, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (nodes[mid].id < id)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo < nodeCount && nodes[lo].id == id ? &nodes[lo] : 0;
+}
+
+static void vmtAddWay(int best) {
+	const vmtTag *t = &tags[best];
+	const vmtNode *n;
+	vmtWay *w;
+	uint32_t i, count = refCount;
+
+	// Areas must be closed, their last point is not kept
+	if (t->area) {
+		if (count < 4 || refs[0] != refs[count - 1])
+			return;
+		count--;
+	}
+	if (!nodesSorted) {
+		qsort(nodes, nodeCount, sizeof(vmtNode), vmtNodeCompare);
+		nodesSorted = 1;
+	}
+
+	ways = vmtGrow(ways, &waySize, wayCount + 1, sizeof(vmtWay));
+	points = vmtGrow(points, &pointSize, pointCount + count, sizeof(proj_world_t));
+	w = &ways[wayCount];
+	w->cls = t->cls;
+	w->zoom = t->zoom;
+	w->area = t->area;
+	w->first = pointCount;
+	w->count = 0;
+	// Nodes outside an extract are missing, the way goes on from the next one it has
+	for (i = 0; i < count; i++) {
+		if (!(n = vmtFindNode(refs[i])))
+			continue;
+		points[pointCount + w->count++] = n->w;
+	}
+	if (w->count < (w->area ? 3u : 2u))
+		return;
+	w->min = w->max = points[w->first];
+	for (i = 1; i < w->count; i++) {
+		const proj_world_t *p = &points[w->first + i];
+
+		if (p->x < w->min.x)
+			w->min.x = p->x;
+		if (p->x > w->max.x)
+			w->max.x = p->x;
+		if (p->y < w->min.y)
+			w->min.y = p->y;
+		if (p->y > w->max.y)
+			w->max.y = p->y;
+	}
+	pointCount += w->count;
+	wayCount++;
+}
+
+static int vmtRead(const char *path) {
+	char attr[VMT_ATTR_SIZE], key[VMT_ATTR_SIZE], *buf, *p;
+	proj_world_t w;
+	FILE *f;
+	long size;
+	int inWay = 0, best = -1, i;
+
+	if (!(f = fopen(path, "rb"))) {
+		fprintf(stderr, "%s: %s\n", path, strerror(errno));
+		return 1;
+	}
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	if (size < 0 || !(buf = malloc(size + 1)) || fread(buf, 1, size, f) != (size_t)size) {
+		fprintf(stderr, "%s: can not be read\n", path);
+		fclose(f);
+		return 1;
+	}
+	fclose(f);
+	buf[size] = 0;
+
+	for (p = buf; (p = strchr(p, '<')); p++) {
+		if (!strncmp(p, "<node ", 6)) {
+			nodes = vmtGrow(nodes, &nodeSize, nodeCount + 1, sizeof(vmtNode));
+			if (!vmtAttr(p, "id", attr, sizeof(attr)))
+				continue;
+			nodes[nodeCount].id = strtoll(attr, 0, 10);
+			if (!vmtAttr(p, "lat", attr, sizeof(attr)))
+				continue;
+			i = vmtDegrees(attr);
+			if (!vmtAttr(p, "lon", attr, sizeof(attr)))
+				continue;
+			projToWorld(i, vmtDegrees(attr), &w);
+			nodes[nodeCount].w = w;
+			if (nodeCount && nodes[nodeCount].id < nodes[nodeCount - 1].id)
+				nodesSorted = 0;
+			nodeCount++;
+		} else if (!strncmp(p, "<way ", 5)) {
+			// A way without nodes closes itself
+			inWay = strchr(p, '>') && strchr(p, '>')[-1] != '/';
+			refCount = 0;
+			best = -1;
+		} else if (inWay && !strncmp(p, "<nd ", 4)) {
+			if (vmtAttr(p, "ref", attr, sizeof(attr))) {
+				refs = vmtGrow(refs, &refSize, refCount + 1, sizeof(int64_t));
+				refs[refCount++] = strtoll(attr, 0, 10);
+			}
+		} else if (inWay && !strncmp(p, "<tag ", 5)) {
+			if (!vmtAttr(p, "k", key, sizeof(key)) || !vmtAttr(p, "v", attr, sizeof(attr)))
+				continue;
+			for (i = 0; i < (int)(sizeof(tags) / sizeof(tags[0])); i++) {
+				if ((best < 0 || i < best) && !strcmp(tags[i].key, key) && !strcmp(tags[i].value, attr))
+					best = i;
+			}
+		} else if (inWay && !strncmp(p, "</way>", 6)) {
+			if (best >= 0)
+				vmtAddWay(best);
+			inWay = 0;
+		}
+	}
+	free(buf);
+	return 0;
+}
+
+static double vmtSegmentDistance2(double px, double py, double ax, double ay, double bx, double by) {
+	double dx = bx - ax, dy = by - ay, len2 = dx * dx + dy * dy, t = 0;
+
+	if (len2 > 0) {
+		t = ((px - ax) * dx + (py - ay) * dy) / len2;
+		t = t < 0 ? 0 : t > 1 ? 1 : t;
+	}
+	dx = ax + t * dx - px;
+	dy = ay + t * dy - py;
+	return dx * dx + dy * dy;
+}
+
+// Douglas-Peucker over in[lo..hi], marks the points that stay
+static void vmtDouglasPeucker(const proj_world_t *in, uint32_t lo, uint32_t hi, double tol2, uint8_t *keep, uint32_t *stack) {
+	uint32_t top = 0, i, far;
+	double d, best;
+
+	keep[lo] = keep[hi] = 1;
+	stack[top++] = lo;
+	stack[top++] = hi;
+	while (top) {
+		hi = stack[--top];
+		lo = stack[--top];
+		best = tol2;
+		far = lo;
+		for (i = lo + 1; i < hi; i++) {
+			d = vmtSegmentDistance2(in[i].x, in[i].y, in[lo].x, in[lo].y, in[hi].x, in[hi].y);
+			if (d > best) {
+				best = d;
+				far = i;
+			}
+		}
+		if (far != lo) {
+			keep[far] = 1;
+			stack[top++] = lo;
+			stack[top++] = far;
+			stack[top++] = far;
+			stack[top++] = hi;
+		}
+	}
+}
+
+// Simplifies every way for one data zoom, tolerance is in world units
+static void vmtSimplify(double tol) {
+	proj_world_t *in = 0;
+	uint32_t inSize = 0, keepSize = 0, stackSize = 0, i, j, n, far;
+	uint32_t *stack = 0;
+	uint8_t *keep = 0;
+	double d, best;
+
+	zpointCount = 0;
+	for (i = 0; i < wayCount; i++) {
+		vmtWay *w = &ways[i];
+
+		// A ring is closed again and split at the point furthest from its start
+		n = w->count + w->area;
+		in = vmtGrow(in, &inSize, n, sizeof(proj_world_t));
+		keep = vmtGrow(keep, &keepSize, n, 1);
+		stack = vmtGrow(stack, &stackSize, 4 * n, sizeof(uint32_t));
+		memcpy(in, &points[w->first], w->count * sizeof(proj_world_t));
+		memset(keep, 0, n);
+		if (w->area) {
+			in[w->count] = in[0];
+			far = 0;
+			best = -1;
+			for (j = 1; j < w->count; j++) {
+				d = vmtSegmentDistance2(in[j].x, in[j].y, in[0].x, in[0].y, in[0].x, in[0].y);
+				if (d > best) {
+					best = d;
+					far = j;
+				}
+			}
+			vmtDouglasPeucker(in, 0, far, tol * tol, keep, stack);
+			vmtDouglasPeucker(in, far, n - 1, tol * tol, keep, stack);
+			n--;
+		} else {
+			vmtDouglasPeucker(in, 0, n - 1, tol * tol, keep, stack);
+		}
+
+		zpoints = vmtGrow(zpoints, &zpointSize, zpointCount + n, sizeof(proj_world_t));
+		w->zfirst = zpointCount;
+		for (j = 0; j < n; j++) {
+			if (keep[j])
+				zpoints[zpointCount++] = in[j];
+		}
+		w->zcount = zpointCount - w->zfirst;
+	}
+	free(in);
+	free(keep);
+	free(stack);
+}
+
+static void vmtAddFeature(const vmtXY *p, uint32_t n, const vmtWay *w, uint8_t minZoom) {
+	vmtFeature *f;
+
+	features = vmtGrow(features, &featureSize, featureCount + 1, sizeof(vmtFeature));
+	pool = vmtGrow(pool, &poolSize, poolCount + n, sizeof(vmtXY));
+	f = &features[featureCount];
+	f->cls = w->cls;
+	f->minZoom = minZoom;
+	f->area = w->area;
+	f->dropped = 0;
+	f->seq = featureCount++;
+	f->first = poolCount;
+	f->count = n;
+	memcpy(&pool[poolCount], p, n * sizeof(vmtXY));
+	poolCount += n;
+}
+
+// Rounds a clipped polyline to tile units and adds it, split where it has too many points
+static void vmtAddLine(const vmtPoint *in, uint32_t n, const vmtWay *w, uint8_t minZoom) {
+	uint32_t i, m = 0;
+
+	ring = vmtGrow(ring, &ringSize, n, sizeof(vmtXY));
+	for (i = 0; i < n; i++) {
+		ring[m].x = (int32_t)lround(in[i].x);
+		ring[m].y = (int32_t)lround(in[i].y);
+		if (!m || ring[m].x != ring[m - 1].x || ring[m].y != ring[m - 1].y)
+			m++;
+	}
+	if (m < 2)
+		return;
+	// Pieces share their end points so the line stays joined
+	for (i = 0; i + 1 < m; i += VMAP_MAX_POINTS - 1)
+		vmtAddFeature(&ring[i], m - i < VMAP_MAX_POINTS ? m - i : VMAP_MAX_POINTS, w, minZoom);
+}
+
+// Liang-Barsky clip of each segment, a polyline leaving the tile and coming back becomes two
+static void vmtClipLine(const vmtPoint *in, uint32_t n, double lo, double hi, const vmtWay *w, uint8_t minZoom) {
+	double t0, t1, dx, dy, p[4], q[4], r;
+	uint32_t i, k, m = 0;
+
+	work2 = vmtGrow(work2, &work2Size, n + 1, sizeof(vmtPoint));
+	for (i = 0; i + 1 < n; i++) {
+		dx = in[i + 1].x - in[i].x;
+		dy = in[i + 1].y - in[i].y;
+		p[0] = -dx; q[0] = in[i].x - lo;
+		p[1] = dx; q[1] = hi - in[i].x;
+		p[2] = -dy; q[2] = in[i].y - lo;
+		p[3] = dy; q[3] = hi - in[i].y;
+		t0 = 0;
+		t1 = 1;
+		for (k = 0; k < 4; k++) {
+			if (p[k] == 0) {
+				if (q[k] < 0)
+					t1 = -1;
+				continue;
+			}
+			r = q[k] / p[k];
+			if (p[k] < 0 && r > t0)
+				t0 = r;
+			else if (p[k] > 0 && r < t1)
+				t1 = r;
+		}
+		if (t0 > t1) {
+			if (m) {
+				vmtAddLine(work2, m, w, minZoom);
+				m = 0;
+			}
+			continue;
+		}
+		if (t0 > 0 && m) {
+			vmtAddLine(work2, m, w, minZoom);
+			m = 0;
+		}
+		if (!m) {
+			work2[m].x = in[i].x + t0 * dx;
+			work2[m++].y = in[i].y + t0 * dy;
+		}
+		work2[m].x = in[i].x + t1 * dx;
+		work2[m++].y = in[i].y + t1 * dy;
+		if (t1 < 1) {
+			vmtAddLine(work2, m, w, minZoom);
+			m = 0;
+		}
+	}
+	if (m)
+		vmtAddLine(work2, m, w, minZoom);
+}
+
+// Sutherland-Hodgman against one edge, axis 0 is x and 1 is y, below keeps values under limit
+static uint32_t vmtClipEdge(const vmtPoint *in, uint32_t n, vmtPoint **to, uint32_t *size, int axis, int below, double limit) {
+	uint32_t i, m = 0;
+	double a, b, t;
+	const vmtPoint *s, *e;
+	vmtPoint *out;
+
+	// Every point of the ring gives at most two
+	out = *to = vmtGrow(*to, size, 2 * n + 1, sizeof(vmtPoint));
+
+	for (i = 0; i < n; i++) {
+		s = &in[(i + n - 1) % n];
+		e = &in[i];
+		a = (axis ? s->y : s->x) - limit;
+		b = (axis ? e->y : e->x) - limit;
+		if (below) {
+			a = -a;
+			b = -b;
+		}
+		if (b >= 0) {
+			if (a < 0) {
+				t = a / (a - b);
+				out[m].x = s->x + t * (e->x - s->x);
+				out[m++].y = s->y + t * (e->y - s->y);
+			}
+			out[m++] = *e;
+		} else if (a >= 0) {
+			t = a / (a - b);
+			out[m].x = s->x + t * (e->x - s->x);
+			out[m++].y = s->y + t * (e->y - s->y);
+		}
+	}
+	return m;
+}
+
+static int64_t vmtCross(const vmtXY *a, const vmtXY *b, const vmtXY *c) {
+	return (int64_t)(b->x - a->x) * (c->y - b->y) - (int64_t)(b->y - a->y) * (c->x - b->x);
+}
+
+// Drops repeated and collinear points of a ring until none is left
+static uint32_t vmtCleanRing(vmtXY *p, uint32_t n) {
+	uint32_t i, m;
+	int changed = 1;
+
+	while (changed && n >= 3) {
+		changed = 0;
+		for (i = 0, m = 0; i < n; i++) {
+			if (m && p[i].x == p[m - 1].x && p[i].y == p[m - 1].y) {
+				changed = 1;
+				continue;
+			}
+			p[m++] = p[i];
+		}
+		while (m > 1 && p[m - 1].x == p[0].x && p[m - 1].y == p[0].y) {
+			m--;
+			changed = 1;
+		}
+		n = m;
+		for (i = 0, m = 0; i < n && n >= 3; i++) {
+			if (!vmtCross(&p[(i + n - 1) % n], &p[i], &p[(i + 1) % n])) {
+				changed = 1;
+				continue;
+			}
+			p[m++] = p[i];
+		}
+		if (n >= 3)
+			n = m;
+	}
+	return n;
+}
+
+typedef struct {
+	uint64_t	key;
+	int32_t		piece;
+} vmtEdge;
+
+static vmtEdge *edges;
+static uint32_t edgeMask;
+
+static int32_t *vmtEdgeSlot(uint32_t u, uint32_t v, int add) {
+	uint64_t key = ((uint64_t)u << 32 | v) + 1;
+	uint32_t i = (uint32_t)((key * 0x9E3779B97F4A7C15ull) >> 40) & edgeMask;
+
+	while (edges[i].key && edges[i].key != key)
+		i = (i + 1) & edgeMask;
+	if (!edges[i].key) {
+		if (!add)
+			return 0;
+		edges[i].key = key;
+		edges[i].piece = -1;
+	}
+	return &edges[i].piece;
+}
+
+static int32_t vmtEdgePiece(uint32_t u, uint32_t v) {
+	int32_t *s = vmtEdgeSlot(u, v, 0);
+
+	return s ? *s : -1;
+}
+
+typedef struct {
+	uint32_t *	v;
+	uint32_t	n;
+} vmtPiece;
+
+static void vmtSetEdges(const vmtPiece *pc, int32_t piece) {
+	uint32_t i;
+
+	for (i = 0; i < pc->n; i++)
+		*vmtEdgeSlot(pc->v[i], pc->v[(i + 1) % pc->n], 1) = piece;
+}
+
+static void vmtAddPiece(const vmtXY *p, const vmtPiece *pc, const vmtWay *w, uint8_t minZoom) {
+	vmtXY *out = malloc((pc->n + 1) * sizeof(vmtXY));
+	uint32_t i, m = 0, k;
+
+	for (i = 0; i < pc->n; i++)
+		out[i] = p[pc->v[i]];
+	m = vmtCleanRing(out, pc->n);
+	// A convex polygon split into fans from its first point stays convex
+	for (k = 1; k + 1 < m; k += VMAP_MAX_POINTS - 2) {
+		uint32_t n = m - k < VMAP_MAX_POINTS - 1 ? m - k : VMAP_MAX_POINTS - 1;
+
+		out[k - 1] = out[0];
+		vmtAddFeature(&out[k - 1], n + 1, w, minZoom);
+	}
+	free(out);
+}
+
+// Ear clipping, then triangles are merged across their diagonals while they stay convex
+static int vmtAddArea(const vmtXY *p, uint32_t n, const vmtWay *w, uint8_t minZoom) {
+	uint32_t *idx = malloc(n * sizeof(uint32_t)), *diag = malloc(2 * n * sizeof(uint32_t));
+	vmtPiece *pieces = malloc(n * sizeof(vmtPiece)), merged;
+	uint32_t m = n, i, j, k, a, b, c, pieceCount = 0, diagCount = 0, tried = 0, size;
+	int32_t pa, pb;
+	int ear, failed = 0;
+
+	for (size = 16; size < 8 * n; size *= 2)
+		;
+	edges = calloc(size, sizeof(vmtEdge));
+	edgeMask = size - 1;
+	for (i = 0; i < n; i++)
+		idx[i] = i;
+
+	for (i = 0; m > 3; ) {
+		a = idx[(i + m - 1) % m];
+		b = idx[i % m];
+		c = idx[(i + 1) % m];
+		ear = vmtCross(&p[a], &p[b], &p[c]) > 0;
+		for (j = 0; ear && j < m; j++) {
+			const vmtXY *q = &p[idx[j]];
+
+			if ((q->x == p[a].x && q->y == p[a].y) || (q->x == p[b].x && q->y == p[b].y) ||
+				(q->x == p[c].x && q->y == p[c].y))
+				continue;
+			if (vmtCross(&p[a], &p[b], q) >= 0 && vmtCross(&p[b], &p[c], q) >= 0 && vmtCross(&p[c], &p[a], q) >= 0)
+				ear = 0;
+		}
+		if (!ear) {
+			// Self touching rings can leave no ear, the rest of such a ring is left out. Only a rest
+			// that covers something counts as a failure, zero area bridges are left by clipping.
+			if (++tried > m) {
+				int64_t twice = 0;
+
+				for (j = 0; j < m; j++)
+					twice += (int64_t)p[idx[j]].x * p[idx[(j + 1) % m]].y - (int64_t)p[idx[(j + 1) % m]].x * p[idx[j]].y;
+				failed = twice != 0;
+				m = 0;
+				break;
+			}
+			i = (i + 1) % m;
+			continue;
+		}
+		tried = 0;
+		pieces[pieceCount].v = malloc(3 * sizeof(uint32_t));
+		pieces[pieceCount].v[0] = a;
+		pieces[pieceCount].v[1] = b;
+		pieces[pieceCount].v[2] = c;
+		pieces[pieceCount].n = 3;
+		vmtSetEdges(&pieces[pieceCount], pieceCount);
+		pieceCount++;
+		diag[diagCount++] = a;
+		diag[diagCount++] = c;
+		i %= m;
+		memmove(&idx[i], &idx[i + 1], (m - i - 1) * sizeof(uint32_t));
+		m--;
+		i = i ? i - 1 : m - 1;
+	}
+	if (!failed && m == 3 && vmtCross(&p[idx[0]], &p[idx[1]], &p[idx[2]]) > 0) {
+		pieces[pieceCount].v = malloc(3 * sizeof(uint32_t));
+		memcpy(pieces[pieceCount].v, idx, 3 * sizeof(uint32_t));
+		pieces[pieceCount].n = 3;
+		vmtSetEdges(&pieces[pieceCount], pieceCount);
+		pieceCount++;
+	}
+
+	// Hertel-Mehlhorn, a diagonal goes when both pieces form a convex one without it
+	for (k = 0; k < diagCount; k += 2) {
+		a = diag[k];
+		c = diag[k + 1];
+		pa = vmtEdgePiece(a, c);
+		pb = vmtEdgePiece(c, a);
+		if (pa < 0 || pb < 0 || pa == pb)
+			continue;
+		merged.v = malloc((pieces[pa].n + pieces[pb].n) * sizeof(uint32_t));
+		merged.n = 0;
+		for (i = 0; pieces[pa].v[i] != a || pieces[pa].v[(i + 1) % pieces[pa].n] != c; i++)
+			;
+		for (j = 0; j < pieces[pa].n; j++)
+			merged.v[merged.n++] = pieces[pa].v[(i + 1 + j) % pieces[pa].n];
+		for (i = 0; pieces[pb].v[i] != c || pieces[pb].v[(i + 1) % pieces[pb].n] != a; i++)
+			;
+		for (j = 2; j < pieces[pb].n; j++)
+			merged.v[merged.n++] = pieces[pb].v[(i + j) % pieces[pb].n];
+		for (j = 0; j < merged.n; j++) {
+			if (vmtCross(&p[merged.v[(j + merged.n - 1) % merged.n]], &p[merged.v[j]], &p[merged.v[(j + 1) % merged.n]]) < 0)
+				break;
+		}
+		if (j < merged.n) {
+			free(merged.v);
+			continue;
+		}
+		free(pieces[pa].v);
+		free(pieces[pb].v);
+		pieces[pa] = merged;
+		pieces[pb].v = 0;
+		pieces[pb].n = 0;
+		*vmtEdgeSlot(a, c, 1) = -1;
+		*vmtEdgeSlot(c, a, 1) = -1;
+		vmtSetEdges(&pieces[pa], pa);
+	}
+
+	for (k = 0; k < pieceCount; k++) {
+		if (pieces[k].n) {
+			vmtAddPiece(p, &pieces[k], w, minZoom);
+			free(pieces[k].v);
+		}
+	}
+	free(edges);
+	free(pieces);
+	free(diag);
+	free(idx);
+	return failed;
+}
+
+// First display zoom at which the way is at least VMT_MIN_PIXELS across, 0 when it never is
+static uint8_t vmtMinZoom(const vmtWay *w, uint8_t zoom, uint8_t unitShift) {
+	uint32_t size = w->max.x - w->min.x > w->max.y - w->min.y ? w->max.x - w->min.x : w->max.y - w->min.y;
+	uint8_t last = zoom == VMAP_MAX_DATA_ZOOM ? VMAP_MAX_ZOOM : zoom + 1, d;
+
+	size >>= unitShift;
+	for (d = w->zoom > zoom ? w->zoom : zoom; d <= last; d++) {
+		if (size >= (uint32_t)(VMT_MIN_PIXELS * VMT_PIXEL) >> (d - zoom))
+			return d;
+	}
+	return 0;
+}
+
+static int vmtFeatureCompare(const void *a, const void *b) {
+	const vmtFeature *x = a, *y = b;
+	int rx = x->area ? areaRank[x->cls] : VMAP_CLASSES + x->cls;
+	int ry = y->area ? areaRank[y->cls] : VMAP_CLASSES + y->cls;
+
+	if (rx != ry)
+		return rx - ry;
+	return x->seq < y->seq ? -1 : x->seq > y->seq;
+}
+
+static uint32_t vmtPointBytes(const vmtFeature *f) {
+	uint32_t i, bytes = 4;
+	int32_t dx, dy;
+
+	for (i = 1; i < f->count; i++) {
+		dx = pool[f->first + i].x - pool[f->first + i - 1].x;
+		dy = pool[f->first + i].y - pool[f->first + i - 1].y;
+		bytes += dx > VMT_ESCAPE && dx <= 127 && dy >= -128 && dy <= 127 ? 2 : 5;
+	}
+	return bytes;
+}
+
+static void vmtPut16(uint8_t *p, int32_t v) {
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+}
+
+static void vmtPut32(uint8_t *p, uint32_t v) {
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+	p[2] = (uint8_t)(v >> 16);
+	p[3] = (uint8_t)(v >> 24);
+}
+
+// Encodes the features that are not dropped, 0 when they do not fit
+static uint32_t vmtEncode(uint8_t zoom) {
+	uint8_t *p = tileData + VMT_HEADER_BYTES, *end = tileData + sizeof(tileData);
+	uint32_t i, j, bytes, areas = 0, lines = 0, lineOffset = 0;
+	int32_t dx, dy;
+
+	for (i = 0; i < featureCount; i++) {
+		const vmtFeature *f = &features[i];
+
+		if (f->dropped)
+			continue;
+		if (!f->area && !lineOffset)
+			lineOffset = (uint32_t)(p - tileData);
+		bytes = vmtPointBytes(f);
+		if (p + VMT_FEATURE_BYTES + bytes > end)
+			return 0;
+		p[0] = f->cls;
+		p[1] = f->minZoom;
+		vmtPut16(p + 2, f->count);
+		vmtPut16(p + 4, bytes);
+		p += VMT_FEATURE_BYTES;
+		vmtPut16(p, pool[f->first].x);
+		vmtPut16(p + 2, pool[f->first].y);
+		p += 4;
+		for (j = 1; j < f->count; j++) {
+			dx = pool[f->first + j].x - pool[f->first + j - 1].x;
+			dy = pool[f->first + j].y - pool[f->first + j - 1].y;
+			if (dx > VMT_ESCAPE && dx <= 127 && dy >= -128 && dy <= 127) {
+				*p++ = (uint8_t)dx;
+				*p++ = (uint8_t)dy;
+			} else {
+				*p++ = (uint8_t)VMT_ESCAPE;
+				vmtPut16(p, dx);
+				vmtPut16(p + 2, dy);
+				p += 4;
+			}
+		}
+		if (f->area)
+			areas++;
+		else
+			lines++;
+	}
+	if (!lineOffset)
+		lineOffset = (uint32_t)(p - tileData);
+
+	tileData[0] = 'V';
+	tileData[1] = 'M';
+	tileData[2] = VMAP_VERSION;
+	tileData[3] = zoom;
+	vmtPut16(tileData + 4, areas);
+	vmtPut16(tileData + 6, lines);
+	vmtPut32(tileData + 8, lineOffset);
+	return (uint32_t)(p - tileData);
+}
+
+static int vmtMakeDirs(char *path) {
+	char *s;
+
+	for (s = strchr(path + 1, '/'); s; s = strchr(s + 1, '/')) {
+		*s = 0;
+		if (mkdir(path, 0777) && errno != EEXIST) {
+			fprintf(stderr, "%s: %s\n", path, strerror(errno));
+			*s = '/';
+			return 1;
+		}
+		*s = '/';
+	}
+	return 0;
+}
+
+static int vmtWriteTile(const char *dir, uint8_t zoom, uint32_t x, uint32_t y, uint32_t size) {
+	char path[512];
+	FILE *f;
+
+	snprintf(path, sizeof(path), "%s/" VMAP_PATH, dir, zoom, x, y);
+	if (vmtMakeDirs(path))
+		return 1;
+	if (!(f = fopen(path, "wb")) || fwrite(tileData, 1, size, f) != size) {
+		fprintf(stderr, "%s: %s\n", path, strerror(errno));
+		if (f)
+			fclose(f);
+		return 1;
+	}
+	fclose(f);
+	return 0;
+}
+
+static int vmtConvertZoom(const char *dir, uint8_t zoom, vmtStats *st) {
+	uint8_t unitShift = 32 - zoom - VMAP_EXTENT_SHIFT, tileShift = 32 - zoom, minZoom;
+	int64_t margin = (int64_t)VMT_MARGIN << unitShift, tile = (int64_t)1 << tileShift, ox, oy;
+	int64_t minX = INT64_MAX, minY = INT64_MAX, maxX = INT64_MIN, maxY = INT64_MIN;
+	uint32_t i, j, n, size, tx, ty, tx0, tx1, ty0, ty1, last = (1u << zoom) - 1, d;
+	double scale = 1.0 / ((int64_t)1 << unitShift);
+
+	memset(st, 0, sizeof(*st));
+	if (!wayCount)
+		return 0;
+	vmtSimplify(VMT_TOLERANCE * ((int64_t)1 << unitShift));
+	for (i = 0; i < wayCount; i++) {
+		minX = ways[i].min.x < minX ? ways[i].min.x : minX;
+		minY = ways[i].min.y < minY ? ways[i].min.y : minY;
+		maxX = ways[i].max.x > maxX ? ways[i].max.x : maxX;
+		maxY = ways[i].max.y > maxY ? ways[i].max.y : maxY;
+	}
+	tx0 = minX - margin < 0 ? 0 : (uint32_t)((minX - margin) >> tileShift);
+	ty0 = minY - margin < 0 ? 0 : (uint32_t)((minY - margin) >> tileShift);
+	tx1 = (uint32_t)((maxX + margin) >> tileShift) > last ? last : (uint32_t)((maxX + margin) >> tileShift);
+	ty1 = (uint32_t)((maxY + margin) >> tileShift) > last ? last : (uint32_t)((maxY + margin) >> tileShift);
+
+	for (ty = ty0; ty <= ty1; ty++) {
+		for (tx = tx0; tx <= tx1; tx++) {
+			ox = (int64_t)tx << tileShift;
+			oy = (int64_t)ty << tileShift;
+			featureCount = 0;
+			poolCount = 0;
+			for (i = 0; i < wayCount; i++) {
+				const vmtWay *w = &ways[i];
+
+				if (w->max.x < ox - margin || w->min.x > ox + tile + margin || w->max.y < oy - margin ||
+					w->min.y > oy + tile + margin)
+					continue;
+				if (!(minZoom = vmtMinZoom(w, zoom, unitShift)))
+					continue;
+				n = w->zcount;
+				work = vmtGrow(work, &workSize, n, sizeof(vmtPoint));
+				for (j = 0; j < n; j++) {
+					work[j].x = ((int64_t)zpoints[w->zfirst + j].x - ox) * scale;
+					work[j].y = ((int64_t)zpoints[w->zfirst + j].y - oy) * scale;
+				}
+				if (!w->area) {
+					vmtClipLine(work, n, -VMT_MARGIN, VMAP_EXTENT + VMT_MARGIN, w, minZoom);
+					continue;
+				}
+
+				n = vmtClipEdge(work, n, &work2, &work2Size, 0, 0, -VMT_MARGIN);
+				n = vmtClipEdge(work2, n, &work, &workSize, 0, 1, VMAP_EXTENT + VMT_MARGIN);
+				n = vmtClipEdge(work, n, &work2, &work2Size, 1, 0, -VMT_MARGIN);
+				n = vmtClipEdge(work2, n, &work, &workSize, 1, 1, VMAP_EXTENT + VMT_MARGIN);
+				ring = vmtGrow(ring, &ringSize, n + 1, sizeof(vmtXY));
+				for (j = 0; j < n; j++) {
+					ring[j].x = (int32_t)lround(work[j].x);
+					ring[j].y = (int32_t)lround(work[j].y);
+				}
+				if ((n = vmtCleanRing(ring, n)) < 3)
+					continue;
+				// Positive area for counter clockwise with y up, so convex corners have positive cross
+				{
+					int64_t area = 0;
+					vmtXY t;
+
+					for (j = 0; j < n; j++)
+						area += (int64_t)ring[j].x * ring[(j + 1) % n].y - (int64_t)ring[(j + 1) % n].x * ring[j].y;
+					if (!area)
+						continue;
+					for (j = 0; area < 0 && j < n / 2; j++) {
+						t = ring[j];
+						ring[j] = ring[n - 1 - j];
+						ring[n - 1 - j] = t;
+					}
+				}
+				st->failed += vmtAddArea(ring, n, w, minZoom);
+			}
+			if (!featureCount)
+				continue;
+
+			qsort(features, featureCount, sizeof(vmtFeature), vmtFeatureCompare);
+			for (d = 0; !(size = vmtEncode(zoom)) && d < sizeof(dropOrder); d++) {
+				for (i = 0; i < featureCount; i++) {
+					if (features[i].cls == dropOrder[d] && !features[i].dropped) {
+						features[i].dropped = 1;
+						st->dropped++;
+					}
+				}
+			}
+			if (d) {
+				fprintf(stderr, "Tile %u/%u/%u too large, %u classes left out\n", zoom, tx, ty, d);
+			}
+			if (!size || size == VMT_HEADER_BYTES)
+				continue;
+			if (vmtWriteTile(dir, zoom, tx, ty, size))
+				return 1;
+			st->tiles++;
+			st->bytes += size;
+			st->largest = size > st->largest ? size : st->largest;
+			for (i = 0; i < featureCount; i++)
+				st->features += !features[i].dropped;
+		}
+	}
+	return 0;
+}
+
+int vmtConvert(const char *osm, const char *dir) {
+	vmtStats st;
+	uint8_t zoom;
+	uint32_t i;
+
+	projInit();
+	nodeCount = pointCount = wayCount = 0;
+	nodesSorted = 1;
+	if (vmtRead(osm))
+		return 1;
+	printf("%u nodes, %u ways with a class\n", (unsigned)nodeCount, (unsigned)wayCount);
+
+	for (i = 0; i < VMT_DATA_ZOOMS; i++) {
+		zoom = VMAP_MIN_ZOOM + 2 * i;
+		if (vmtConvertZoom(dir, zoom, &st))
+			return 1;
+		printf("Zoom %u: %u tiles, %u features, %u bytes, largest %u, %u features left out, %u areas not triangulated\n",
+			zoom, (unsigned)st.tiles, (unsigned)st.features, (unsigned)st.bytes, (unsigned)st.largest,
+			(unsigned)st.dropped, (unsigned)st.failed);
+	}
+	return 0;
+}
+
+#ifndef VMT_CONVERT_NO_MAIN
+int main(int argc, char **argv) {
+	if (argc != 3) {
+		fprintf(stderr, "Usage: %s <map.osm> <dir>\n", argv[0]);
+		return 2;
+	}
+	return vmtConvert(argv[1], argv[2]);
+}
+#endif
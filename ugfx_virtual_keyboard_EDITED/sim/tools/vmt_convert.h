@@ -0,0 +1,7 @@
+#ifndef _VMT_CONVERT_H_
+#define _VMT_CONVERT_H_
+
+// Converts an OpenStreetMap XML extract into vmap.h tiles under dir, returns 0 when done
+int vmtConvert(const char *osm, const char *dir);
+
+#endif /* _VMT_CONVERT_H_ */
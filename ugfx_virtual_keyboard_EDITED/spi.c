@@ -3,6 +3,8 @@
 #include "trace.h"
 #include "tm_stm32_delay.h"
 #include "msg.h"
+#include "fusion.h"
+#include <string.h>
 
 #include "tm_stm32_exti.h"
 
@@ -51,67 +53,60 @@ void sendResponseMSG(uint8_t msg_ID, uint8_t value);
 void sendGearSettingsMSG();
 void sendBluetoothScanMSG();
 
-osMessageQDef(spiQueue, 32, message_t);
-osMessageQId  spiQueue;
-
 void runSPI(){
 	nrfSetup();
 	uint8_t batt = 0;
 	uint8_t count = 0;
 	connectionStatus = true;
 	
-	spiQueue = osMessageCreate(osMessageQ(spiQueue), NULL);
-	
 	char temp[10];
-	message_t *messageReceived;
+	msg_t messageReceived;
 	while(1){
-		osEvent evt = osMessageGet(spiQueue, osWaitForever);
-		if (evt.status == osEventMessage) {
+		if(msgReceive(MSG_TO_SPI, &messageReceived, TIME_INFINITE)){
 			//nrfGetDeviceName();
-			messageReceived = (message_t*)evt.value.p;
-			if(messageReceived->msg_ID == GET_AVAILABILITY_MSG){
+			if(messageReceived.id == GET_AVAILABILITY_MSG){
 #ifdef DEBUG
 				TM_USART_Puts(USART3, "SPI:,GET_AVAILABILITY_MSG\n");
 #endif
 				TRACE("SPI:,GET_AVAILABILITY_MSG\n");
 				nrfGetAvailability();
-			}else if(messageReceived->msg_ID == GET_SPEED_MSG){
+			}else if(messageReceived.id == GET_SPEED_MSG){
 #ifdef DEBUG
 				TM_USART_Puts(USART3, "SPI:,GET_SPEED_MSG\n");
 #endif
 				TRACE("SPI:,GET_SPEED_MSG\n");
 				sendResponseMSG(GET_SPEED_MSG, getSpeed());
-			}else if(messageReceived->msg_ID == GET_CADENCE_MSG){
+			}else if(messageReceived.id == GET_CADENCE_MSG){
 #ifdef DEBUG
 				TM_USART_Puts(USART3, "SPI:,GET_CADENCE_MSG\n");
 #endif
 				TRACE("SPI:,GET_CADENCE_MSG\n");
 				sendResponseMSG(GET_CADENCE_MSG, getCadence());
-			}else if(messageReceived->msg_ID == GET_DISTANCE_MSG){
+			}else if(messageReceived.id == GET_DISTANCE_MSG){
 #ifdef DEBUG
 				TM_USART_Puts(USART3, "SPI:,GET_DISTANCE_MSG\n");
 #endif
 				TRACE("SPI:,GET_DISTANCE_MSG\n");
 				sendResponseMSG(GET_DISTANCE_MSG, getDistance());
-			}else if(messageReceived->msg_ID == GET_HEARTRATE_MSG){
+			}else if(messageReceived.id == GET_HEARTRATE_MSG){
 #ifdef DEBUG
 				TM_USART_Puts(USART3, "SPI:,GET_HEARTRATE_MSG\n");
 #endif
 				TRACE("SPI:,GET_HEARTRATE_MSG\n");
 				sendResponseMSG(GET_HEARTRATE_MSG, getHeartRate());
-			}else if(messageReceived->msg_ID == GET_CADENCE_SETPOINT_MSG){
+			}else if(messageReceived.id == GET_CADENCE_SETPOINT_MSG){
 #ifdef DEBUG
 				TM_USART_Puts(USART3, "SPI:,GET_CADENCE_SETPOINT_MSG\n");
 #endif
 				TRACE("SPI:,GET_CADENCE_SETPOINT_MSG\n");
 				sendResponseMSG(GET_CADENCE_SETPOINT_MSG, getCadenceSetPoint());
-			}else if(messageReceived->msg_ID == GET_BATTERY_MSG){
+			}else if(messageReceived.id == GET_BATTERY_MSG){
 #ifdef DEBUG
 				TM_USART_Puts(USART3, "SPI:,GET_BATTERY_MSG\n");
 #endif
 				TRACE("SPI:,GET_BATTERY_MSG\n");
 				sendResponseMSG(GET_BATTERY_MSG, getBattery());
-			}else if(messageReceived->msg_ID == GET_GEAR_COUNT_MSG){
+			}else if(messageReceived.id == GET_GEAR_COUNT_MSG){
 #ifdef DEBUG
 				TM_USART_Puts(USART3, "SPI:,GET_GEAR_COUNT_MSG\n");
 #endif
@@ -124,69 +119,71 @@ void runSPI(){
 				}
 				nrfGetGearSettings();
 				sendGearSettingsMSG();
-			}else if(messageReceived->msg_ID == SET_GEAR_COUNT_MSG){
+			}else if(messageReceived.id == SET_GEAR_COUNT_MSG){
 #ifdef DEBUG
 				TM_USART_Puts(USART3, "SPI:,SET_GEAR_COUNT_MSG\n");
 #endif
 				TRACE("SPI:,SET_GEAR_COUNT_MSG\n");
-				for(int count = 0; count <= messageReceived->frontGears[0]; count++){
-					spi_Data.gears.frontGears[count] = messageReceived->frontGears[count];
+				msg_gears_t *gears = (msg_gears_t *)messageReceived.payload;
+				for(int count = 0; count <= gears->frontGears[0]; count++){
+					spi_Data.gears.frontGears[count] = gears->frontGears[count];
 				}
-				for(int count = 0; count <= messageReceived->backGears[0]; count++){
-					spi_Data.gears.backGears[count] = messageReceived->backGears[count];
+				for(int count = 0; count <= gears->backGears[0]; count++){
+					spi_Data.gears.backGears[count] = gears->backGears[count];
 				}
 				nrfSetGearSettings();
-			}else if(messageReceived->msg_ID == NRF_SCAN_MSG){
+			}else if(messageReceived.id == NRF_SCAN_MSG){
 #ifdef DEBUG
 				TM_USART_Puts(USART3, "SPI:,NRF_SCAN_MSG\n");
 #endif
 				TRACE("SPI:,NRF_SCAN_MSG\n");
 				getBluetooth();
-			}else if(messageReceived->msg_ID == NRF_CONNECT_MSG){
+			}else if(messageReceived.id == NRF_CONNECT_MSG){
 #ifdef DEBUG
 				TM_USART_Puts(USART3, "SPI:,NRF_CONNECT_MSG\n");
 #endif
 				TRACE("SPI:,NRF_CONNECT_MSG\n");
-				nrfConnect(messageReceived->value);
-			}else if(messageReceived->msg_ID == NRF_FORGET_MSG){
+				nrfConnect(messageReceived.value);
+			}else if(messageReceived.id == NRF_FORGET_MSG){
 #ifdef DEBUG
 				TM_USART_Puts(USART3, "SPI:,NRF_FORGET_MSG\n");
 #endif
 				TRACE("SPI:,NRF_FORGET_MSG\n");
-				nrfForget(messageReceived->value);
+				nrfForget(messageReceived.value);
 			}
-			osPoolFree(mpool, messageReceived);
+			msgRelease(MSG_TO_SPI, &messageReceived);
 		}
 	}
 }
 
 void sendResponseMSG(uint8_t msg_ID, uint8_t value){
-	message_t *messageSent;
-	messageSent = (message_t*)osPoolAlloc(mpool);
-	messageSent->msg_ID = msg_ID;
-	messageSent->value = value;
-	osMessagePut(guiQueue, (uint32_t)messageSent, 0);
+	msgSend(MSG_TO_GUI, msg_ID, value);
 }
 
 void sendGearSettingsMSG(){
-	message_t *messageSent;
-	messageSent = (message_t*)osPoolAlloc(mpool);
-	messageSent->msg_ID = GET_GEAR_COUNT_MSG;
+	msg_gears_t *gears;
+	gears = (msg_gears_t *)msgAlloc(MSG_TO_GUI, GET_GEAR_COUNT_MSG);
+	if(gears == NULL){
+		return;
+	}
 	for(uint8_t count = 0; count <= spi_Data.gears.frontGears[0]; count++){
-		messageSent->frontGears[count] = spi_Data.gears.frontGears[count];
+		gears->frontGears[count] = spi_Data.gears.frontGears[count];
 	}
 	for(uint8_t count = 0; count <= spi_Data.gears.backGears[0]; count++){
-		messageSent->backGears[count] = spi_Data.gears.backGears[count];
+		gears->backGears[count] = spi_Data.gears.backGears[count];
 	}
-	osMessagePut(guiQueue, (uint32_t)messageSent, 0);
+	msgSendPayload(MSG_TO_GUI, GET_GEAR_COUNT_MSG, gears);
 }
 
 void sendBluetoothScanMSG(){
-	message_t *messageSent;
-	messageSent = (message_t*)osPoolAlloc(mpool);
-	messageSent->msg_ID = NRF_SCAN_MSG;
-	messageSent->value = spi_Data.bluetooth.deviceCount;
-	osMessagePut(guiQueue, (uint32_t)messageSent, 0);
+	msg_devices_t *devices;
+	devices = (msg_devices_t *)msgAlloc(MSG_TO_GUI, NRF_SCAN_MSG);
+	if(devices == NULL){
+		return;
+	}
+	devices->count = spi_Data.bluetooth.deviceCount;
+	memcpy(devices->mac, spi_Data.bluetooth.mac, sizeof(devices->mac));
+	msgSendPayload(MSG_TO_GUI, NRF_SCAN_MSG, devices);
 }
 
 void nrfSetup(){
@@ -330,6 +327,7 @@ bool nrfGetSpeed(){
 		return false;
 	}
 	spi_Data.speed.value = value;
+	fusionWheelSpeed((uint32_t)value * 1000000 / 3600);	// km/h to mm/s
 	getRTC(&RTCD_SPI, TM_RTC_Format_BIN);
 	spi_Data.speed.age = TM_RTC_GetUnixTimeStamp(&RTCD_SPI);
 	return true;
@@ -476,13 +474,13 @@ void nrfGetMacAddress(){
 	for(uint8_t count = 0; count < spi_Data.bluetooth.deviceCount; count++){
 		command[1] = count;
 		nrfSend(&command[0], 2);
-		nrfReceive(&devicesMAC[count][0], 6);
-		TRACE("SPI:,Device %d,MAC Address; %02X:%02X:%02X:%02X:%02X:%02X\n", count, devicesMAC[count][0], 
-																																		devicesMAC[count][1], 
-																																		devicesMAC[count][2], 
-																																		devicesMAC[count][3], 
-																																		devicesMAC[count][4], 
-																																		devicesMAC[count][5]);
+		nrfReceive(&spi_Data.bluetooth.mac[count][0], 6);
+		TRACE("SPI:,Device %d,MAC Address; %02X:%02X:%02X:%02X:%02X:%02X\n", count, spi_Data.bluetooth.mac[count][0], 
+																																		spi_Data.bluetooth.mac[count][1], 
+																																		spi_Data.bluetooth.mac[count][2], 
+																																		spi_Data.bluetooth.mac[count][3], 
+																																		spi_Data.bluetooth.mac[count][4], 
+																																		spi_Data.bluetooth.mac[count][5]);
 	}
 }
 
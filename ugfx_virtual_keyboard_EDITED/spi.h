@@ -4,6 +4,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "gui.h"
+#include "msg.h"
 
 #define DUMMY_VALUE			0xF0
 
@@ -77,6 +78,7 @@ struct SPI_data{
 	}gears;
 	struct Bluetooth{
 		uint8_t deviceCount;
+		uint8_t mac[MAXIMUM_BLUETOOTH][6];
 		uint32_t age;
 	}bluetooth;
 };
@@ -0,0 +1,537 @@
+#include "tiles.h"
+#include "sdram.h"
+#include "trace.h"
+#include "stm32fxxx_hal.h"
+#include <string.h>
+#include <math.h>
+
+#if GDISP_PIXELFORMAT != GDISP_PIXELFORMAT_RGB565
+	#error "Tile scaling expects RGB565 pixels"
+#endif
+
+#define TILES_SLOT_BYTES			GDISP_PIXMAP_MEMORY_SIZE(TILES_SIZE, TILES_SIZE)
+#define TILES_SLOTS						(SDRAM_TILES_SIZE / TILES_SLOT_BYTES)
+#define TILES_SHIFT						8
+#define TILES_VISIBLE					(TILES_ROTATE_GRID * TILES_ROTATE_GRID)
+#define TILES_MISSING_ENTRIES	32
+
+typedef enum {
+	TILE_EMPTY,
+	TILE_READY
+} tile_state_t;
+
+typedef struct {
+	uint32_t x;
+	uint32_t y;
+	uint8_t zoom;
+	uint8_t state;
+	uint32_t used;						// Draw in which tile was last used, for LRU
+	GDisplay *pixmap;					// Decoded tile in SDRAM, PNG is drawn straight into it
+	pixel_t *bits;
+} tile_slot_t;
+
+typedef struct {
+	uint32_t x;
+	uint32_t y;
+	uint8_t zoom;
+} tile_id_t;
+
+typedef struct {
+	uint32_t x;
+	uint32_t y;
+	coord_t sx;
+	coord_t sy;
+	int32_t distance;
+	tile_slot_t *slot;
+} tile_request_t;
+
+typedef struct {
+	const pixel_t *bits;			// Tile or parent covering this grid cell, NULL for background
+	uint8_t levels;						// Parent levels up, pixels of cell are this many times larger
+	uint16_t baseX;						// Corner of cell within parent tile
+	uint16_t baseY;
+} tile_cell_t;
+
+static tile_slot_t slots[TILES_SLOTS];
+static tile_id_t missing[TILES_MISSING_ENTRIES];
+static uint32_t missingNext;
+static uint32_t frame;
+
+static gdispImage tileImage;
+static char tilePath[40];
+static pixel_t scaleBuffer[TILES_SIZE << TILES_PARENT_LEVELS];
+static tile_cell_t grid[TILES_ROTATE_GRID][TILES_ROTATE_GRID];
+static uint32_t gridWidth;
+static uint32_t gridHeight;
+static tiles_stats_t stats;
+
+static uint32_t tilesCollect(tile_request_t *requests, uint8_t zoom, int32_t left, int32_t top, int32_t right, int32_t bottom, int32_t markerX, int32_t markerY, int32_t radius);
+static bool tilesFetch(tile_request_t *requests, uint32_t n, uint8_t zoom);
+static bool tilesDrawRotated(const proj_world_t *center, uint8_t zoom, int16_t rotation, coord_t centerX, coord_t centerY, coord_t x, coord_t y, coord_t cx, coord_t cy);
+static void tilesRotateRow(pixel_t *dst, coord_t count, fixed u, fixed v, fixed du, fixed dv);
+static tile_slot_t *tilesFind(uint8_t zoom, uint32_t x, uint32_t y);
+static tile_slot_t *tilesLoad(uint8_t zoom, uint32_t x, uint32_t y);
+static bool tilesIsMissing(uint8_t zoom, uint32_t x, uint32_t y);
+static void tilesFallback(uint8_t zoom, uint32_t x, uint32_t y, coord_t sx, coord_t sy);
+static void tilesUpscale(const tile_slot_t *slot, uint32_t levels, uint32_t ox, uint32_t oy, coord_t sx, coord_t sy);
+static void tilesDownscale(const tile_slot_t *slot, coord_t sx, coord_t sy);
+
+void tilesInit(){
+	uint32_t i;
+
+	for(i = 0; i < TILES_SLOTS; i++){
+		slots[i].pixmap = gdispPixmapCreateFrom(TILES_SIZE, TILES_SIZE, (void *)(SDRAM_TILES_ADDR + i * TILES_SLOT_BYTES));
+		slots[i].bits = gdispPixmapGetBits(slots[i].pixmap);
+		slots[i].state = TILE_EMPTY;
+	}
+	for(i = 0; i < TILES_MISSING_ENTRIES; i++){
+		missing[i].zoom = 0xFF;
+	}
+}
+
+bool tilesDraw(const proj_world_t *center, uint8_t zoom, int16_t rotation, coord_t centerX, coord_t centerY, coord_t x, coord_t y, coord_t cx, coord_t cy){
+	tile_request_t requests[TILES_VISIBLE];
+	coord_t clipX, clipY, clipCX, clipCY;
+	int32_t left, top;
+	uint32_t i, n, start = HAL_GetTick();
+	bool complete;
+
+	frame++;
+	stats.Draws++;
+	if(rotation != 0){
+		complete = tilesDrawRotated(center, zoom, rotation, centerX, centerY, x, y, cx, cy);
+		stats.LastDrawMS = HAL_GetTick() - start;
+		return complete;
+	}
+
+	// Global pixel position of map area corner at this zoom
+	left = (int32_t)(center->x >> PROJ_PIXEL_SHIFT(zoom)) - (centerX - x);
+	top = (int32_t)(center->y >> PROJ_PIXEL_SHIFT(zoom)) - (centerY - y);
+	n = tilesCollect(requests, zoom, left, top, left + cx, top + cy, left + centerX - x, top + centerY - y, 0);
+	complete = tilesFetch(requests, n, zoom);
+
+	// Clip set by the window manager is put back afterwards
+	gdispGetClip(&clipX, &clipY, &clipCX, &clipCY);
+	gdispSetClip(x, y, cx, cy);
+	for(i = 0; i < n; i++){
+		requests[i].sx = x + requests[i].x * TILES_SIZE - left;
+		requests[i].sy = y + requests[i].y * TILES_SIZE - top;
+		if(requests[i].slot != NULL){
+			gdispBlitAreaEx(requests[i].sx, requests[i].sy, TILES_SIZE, TILES_SIZE, 0, 0, TILES_SIZE, requests[i].slot->bits);
+		}else{
+			tilesFallback(zoom, requests[i].x, requests[i].y, requests[i].sx, requests[i].sy);
+		}
+	}
+	gdispSetClip(clipX, clipY, clipCX, clipCY);
+
+	stats.LastDrawMS = HAL_GetTick() - start;
+	return complete;
+}
+
+void tilesGetStats(tiles_stats_t *st){
+	*st = stats;
+}
+
+static uint32_t tilesCollect(tile_request_t *requests, uint8_t zoom, int32_t left, int32_t top, int32_t right, int32_t bottom, int32_t markerX, int32_t markerY, int32_t radius){
+	tile_request_t request;
+	int32_t tx, ty, dx, dy, last = (1 << zoom) - 1;
+	uint32_t j, n = 0;
+
+	// Tiles under area given in global pixels, sorted by distance of their centre from marker so nearest are loaded first
+	for(ty = top < 0 ? 0 : top >> TILES_SHIFT; ty <= (bottom - 1) >> TILES_SHIFT && ty <= last; ty++){
+		for(tx = left < 0 ? 0 : left >> TILES_SHIFT; tx <= (right - 1) >> TILES_SHIFT && tx <= last; tx++){
+			if(n == TILES_VISIBLE){
+				continue;
+			}
+			// Rotated view only needs tiles reaching into the circle through its furthest corner
+			if(radius > 0){
+				dx = markerX < tx * TILES_SIZE ? tx * TILES_SIZE - markerX : markerX - (tx + 1) * TILES_SIZE;
+				dy = markerY < ty * TILES_SIZE ? ty * TILES_SIZE - markerY : markerY - (ty + 1) * TILES_SIZE;
+				dx = dx < 0 ? 0 : dx;
+				dy = dy < 0 ? 0 : dy;
+				if(dx * dx + dy * dy > radius * radius){
+					continue;
+				}
+			}
+			request.x = tx;
+			request.y = ty;
+			dx = tx * TILES_SIZE + TILES_SIZE / 2 - markerX;
+			dy = ty * TILES_SIZE + TILES_SIZE / 2 - markerY;
+			request.distance = dx * dx + dy * dy;
+			request.slot = NULL;
+			for(j = n++; j > 0 && requests[j - 1].distance > request.distance; j--){
+				requests[j] = requests[j - 1];
+			}
+			requests[j] = request;
+		}
+	}
+	return n;
+}
+
+static bool tilesFetch(tile_request_t *requests, uint32_t n, uint8_t zoom){
+	uint32_t i, loads = 0;
+	bool complete = true;
+
+	// Cached tiles are marked used first so loads below cannot evict them
+	for(i = 0; i < n; i++){
+		requests[i].slot = tilesFind(zoom, requests[i].x, requests[i].y);
+		if(requests[i].slot != NULL){
+			stats.Hits++;
+		}
+	}
+	for(i = 0; i < n; i++){
+		if(requests[i].slot != NULL || tilesIsMissing(zoom, requests[i].x, requests[i].y)){
+			continue;
+		}
+		// Limited SD reads per draw, zooming or moving fast shows scaled tiles until next draws catch up
+		if(loads < TILES_LOADS_PER_DRAW){
+			requests[i].slot = tilesLoad(zoom, requests[i].x, requests[i].y);
+			loads++;
+		}else{
+			complete = false;
+		}
+	}
+#if GFILE_NEED_RAMFS
+	// Files of visible tiles stay in RAM tier while other files are read through it
+	gfileRamfsUnpinAll();
+	for(i = 0; i < n; i++){
+		formatString(tilePath, sizeof(tilePath), TILES_PATH, zoom, requests[i].x, requests[i].y);
+		gfileRamfsPin(tilePath);
+	}
+#endif
+	return complete;
+}
+
+static bool tilesDrawRotated(const proj_world_t *center, uint8_t zoom, int16_t rotation, coord_t centerX, coord_t centerY, coord_t x, coord_t y, coord_t cx, coord_t cy){
+	tile_request_t requests[TILES_VISIBLE];
+	tile_slot_t *parent;
+	tile_cell_t *cell;
+	fixed c = ffcos(rotation), s = ffsin(rotation), u, v, markerU, markerV;
+	int32_t markerX, markerY, left, right, top, bottom, gridX, gridY, ox, oy, radius;
+	uint32_t i, n, row, rows, levels;
+	bool complete;
+
+	// Screen offset from marker (ox, oy) samples map at marker + (c * ox - s * oy, s * ox + c * oy),
+	// so corners of map area give bounding box of the map pixels needed
+	markerX = (int32_t)(center->x >> PROJ_PIXEL_SHIFT(zoom));
+	markerY = (int32_t)(center->y >> PROJ_PIXEL_SHIFT(zoom));
+	left = top = INT32_MAX;
+	right = bottom = INT32_MIN;
+	radius = 0;
+	for(i = 0; i < 4; i++){
+		ox = (i & 1 ? x + cx : x) - centerX;
+		oy = (i & 2 ? y + cy : y) - centerY;
+		u = (c * ox - s * oy) >> 16;
+		v = (s * ox + c * oy) >> 16;
+		left = u < left ? u : left;
+		right = u > right ? u : right;
+		top = v < top ? v : top;
+		bottom = v > bottom ? v : bottom;
+		if(ox * ox + oy * oy > radius){
+			radius = ox * ox + oy * oy;
+		}
+	}
+	radius = (int32_t)sqrtf((float)radius) + 2;
+	left += markerX - 1;
+	right += markerX + 2;
+	top += markerY - 1;
+	bottom += markerY + 2;
+
+	n = tilesCollect(requests, zoom, left, top, right, bottom, markerX, markerY, radius);
+	complete = tilesFetch(requests, n, zoom);
+
+	// Grid of cells sampled by blitter, missing tiles come from a parent scaled up on the fly
+	gridX = left < 0 ? 0 : left >> TILES_SHIFT;
+	gridY = top < 0 ? 0 : top >> TILES_SHIFT;
+	gridWidth = TILES_ROTATE_GRID * TILES_SIZE;
+	gridHeight = TILES_ROTATE_GRID * TILES_SIZE;
+	memset(grid, 0, sizeof(grid));
+	for(i = 0; i < n; i++){
+		if(requests[i].x - gridX >= TILES_ROTATE_GRID || requests[i].y - gridY >= TILES_ROTATE_GRID){
+			continue;
+		}
+		cell = &grid[requests[i].y - gridY][requests[i].x - gridX];
+		if(requests[i].slot != NULL){
+			cell->bits = requests[i].slot->bits;
+			continue;
+		}
+		for(levels = 1; levels <= TILES_PARENT_LEVELS && levels <= zoom; levels++){
+			parent = tilesFind(zoom - levels, requests[i].x >> levels, requests[i].y >> levels);
+			if(parent != NULL){
+				cell->bits = parent->bits;
+				cell->levels = levels;
+				cell->baseX = (requests[i].x & ((1 << levels) - 1)) * (TILES_SIZE >> levels);
+				cell->baseY = (requests[i].y & ((1 << levels) - 1)) * (TILES_SIZE >> levels);
+				stats.ParentFallbacks++;
+				break;
+			}
+		}
+		if(cell->bits == NULL){
+			stats.Holes++;
+		}
+	}
+
+	// Marker in grid pixels, 16.16 fixed point so sub pixel movement is kept
+	markerU = (fixed)((((int64_t)center->x << 16) >> PROJ_PIXEL_SHIFT(zoom)) - ((int64_t)gridX << (TILES_SHIFT + 16)));
+	markerV = (fixed)((((int64_t)center->y << 16) >> PROJ_PIXEL_SHIFT(zoom)) - ((int64_t)gridY << (TILES_SHIFT + 16)));
+#if TILES_ROTATE_BILINEAR
+	// Bilinear weights are measured from pixel centres
+	markerU -= FIXED0_5;
+	markerV -= FIXED0_5;
+#endif
+
+	// Scanlines are rendered into scale buffer and blitted several rows at a time
+	rows = (sizeof(scaleBuffer) / sizeof(pixel_t)) / cx;
+	for(row = 0; row < (uint32_t)cy; row += rows){
+		if(rows > (uint32_t)cy - row){
+			rows = cy - row;
+		}
+		for(i = 0; i < rows; i++){
+			ox = x - centerX;
+			oy = y + row + i - centerY;
+			u = markerU + c * ox - s * oy;
+			v = markerV + s * ox + c * oy;
+			tilesRotateRow(scaleBuffer + i * cx, cx, u, v, c, s);
+		}
+		gdispBlitAreaEx(x, y + row, cx, rows, 0, 0, cx, scaleBuffer);
+	}
+	stats.RotatedDraws++;
+	return complete;
+}
+
+#if TILES_ROTATE_BILINEAR
+static pixel_t tilesSample(int32_t pu, int32_t pv){
+	const tile_cell_t *cell;
+
+	if((uint32_t)pu >= gridWidth || (uint32_t)pv >= gridHeight){
+		return TILES_BACKGROUND;
+	}
+	cell = &grid[pv >> TILES_SHIFT][pu >> TILES_SHIFT];
+	if(cell->bits == NULL){
+		return TILES_BACKGROUND;
+	}
+	return cell->bits[(cell->baseY + ((pv & (TILES_SIZE - 1)) >> cell->levels)) * TILES_SIZE +
+		cell->baseX + ((pu & (TILES_SIZE - 1)) >> cell->levels)];
+}
+
+// RGB565 spread to 0x07E0F81F so red, green and blue are weighted by up to 32 in one multiply
+static uint32_t tilesSpread(uint32_t p){
+	return (p | (p << 16)) & 0x07E0F81F;
+}
+
+static void tilesRotateRow(pixel_t *dst, coord_t count, fixed u, fixed v, fixed du, fixed dv){
+	const tile_cell_t *cell;
+	const pixel_t *p;
+	uint32_t a, b, c, d, fu, fv, top, bottom;
+	int32_t pu, pv;
+
+	while(count--){
+		pu = u >> 16;
+		pv = v >> 16;
+		fu = (u >> 11) & 31;
+		fv = (v >> 11) & 31;
+		u += du;
+		v += dv;
+
+		// Whole 2x2 block inside one cached tile is read directly, tile edges go through grid lookup
+		cell = ((uint32_t)pu < gridWidth && (uint32_t)pv < gridHeight) ? &grid[pv >> TILES_SHIFT][pu >> TILES_SHIFT] : NULL;
+		if(cell != NULL && cell->bits != NULL && cell->levels == 0 &&
+			(pu & (TILES_SIZE - 1)) != TILES_SIZE - 1 && (pv & (TILES_SIZE - 1)) != TILES_SIZE - 1){
+			p = cell->bits + (pv & (TILES_SIZE - 1)) * TILES_SIZE + (pu & (TILES_SIZE - 1));
+			a = p[0];
+			b = p[1];
+			c = p[TILES_SIZE];
+			d = p[TILES_SIZE + 1];
+		}else{
+			a = tilesSample(pu, pv);
+			b = tilesSample(pu + 1, pv);
+			c = tilesSample(pu, pv + 1);
+			d = tilesSample(pu + 1, pv + 1);
+		}
+
+		// 0x02008010 is half of 32 in each colour so the shifts round instead of darkening the map
+		top = ((tilesSpread(a) * (32 - fu) + tilesSpread(b) * fu + 0x02008010) >> 5) & 0x07E0F81F;
+		bottom = ((tilesSpread(c) * (32 - fu) + tilesSpread(d) * fu + 0x02008010) >> 5) & 0x07E0F81F;
+		top = ((top * (32 - fv) + bottom * fv + 0x02008010) >> 5) & 0x07E0F81F;
+		*dst++ = (pixel_t)((top & 0xF81F) | ((top >> 16) & 0x07E0));
+	}
+}
+#else
+static void tilesRotateRow(pixel_t *dst, coord_t count, fixed u, fixed v, fixed du, fixed dv){
+	const tile_cell_t *cell;
+	int32_t pu, pv;
+
+	// Nearest neighbour, source position steps by (du, dv) per destination pixel
+	while(count--){
+		pu = u >> 16;
+		pv = v >> 16;
+		u += du;
+		v += dv;
+		if((uint32_t)pu >= gridWidth || (uint32_t)pv >= gridHeight){
+			*dst++ = TILES_BACKGROUND;
+			continue;
+		}
+		cell = &grid[pv >> TILES_SHIFT][pu >> TILES_SHIFT];
+		if(cell->bits == NULL){
+			*dst++ = TILES_BACKGROUND;
+			continue;
+		}
+		*dst++ = cell->bits[(cell->baseY + ((pv & (TILES_SIZE - 1)) >> cell->levels)) * TILES_SIZE +
+			cell->baseX + ((pu & (TILES_SIZE - 1)) >> cell->levels)];
+	}
+}
+#endif
+
+static tile_slot_t *tilesFind(uint8_t zoom, uint32_t x, uint32_t y){
+	uint32_t i;
+
+	for(i = 0; i < TILES_SLOTS; i++){
+		if(slots[i].state == TILE_READY && slots[i].zoom == zoom && slots[i].x == x && slots[i].y == y){
+			slots[i].used = frame;
+			return &slots[i];
+		}
+	}
+	return NULL;
+}
+
+static tile_slot_t *tilesLoad(uint8_t zoom, uint32_t x, uint32_t y){
+	tile_slot_t *slot = NULL;
+	uint32_t i;
+
+	// Empty slot or least recently used one not needed by this draw
+	for(i = 0; i < TILES_SLOTS; i++){
+		if(slots[i].pixmap == NULL){
+			continue;
+		}
+		if(slots[i].state == TILE_EMPTY){
+			slot = &slots[i];
+			break;
+		}
+		if(slots[i].used != frame && (slot == NULL || frame - slots[i].used > frame - slot->used)){
+			slot = &slots[i];
+		}
+	}
+	if(slot == NULL){
+		return NULL;
+	}
+
+	formatString(tilePath, sizeof(tilePath), TILES_PATH, zoom, x, y);
+	if(gdispImageOpenFile(&tileImage, tilePath) != GDISP_IMAGE_ERR_OK){
+		missing[missingNext].zoom = zoom;
+		missing[missingNext].x = x;
+		missing[missingNext].y = y;
+		missingNext = (missingNext + 1) % TILES_MISSING_ENTRIES;
+		stats.Missing++;
+		return NULL;
+	}
+
+	if(slot->state == TILE_READY){
+		stats.Evictions++;
+	}
+	gdispGFillArea(slot->pixmap, 0, 0, TILES_SIZE, TILES_SIZE, TILES_BACKGROUND);
+	gdispGImageDraw(slot->pixmap, &tileImage, 0, 0, TILES_SIZE, TILES_SIZE, 0, 0);
+	gdispImageClose(&tileImage);
+
+	slot->zoom = zoom;
+	slot->x = x;
+	slot->y = y;
+	slot->state = TILE_READY;
+	slot->used = frame;
+	stats.Loads++;
+	return slot;
+}
+
+static bool tilesIsMissing(uint8_t zoom, uint32_t x, uint32_t y){
+	uint32_t i;
+
+	for(i = 0; i < TILES_MISSING_ENTRIES; i++){
+		if(missing[i].zoom == zoom && missing[i].x == x && missing[i].y == y){
+			return true;
+		}
+	}
+	return false;
+}
+
+static void tilesFallback(uint8_t zoom, uint32_t x, uint32_t y, coord_t sx, coord_t sy){
+	tile_slot_t *children[4], *parent;
+	uint32_t i, levels, found = 0;
+
+	// All four children give sharpest picture, usual case right after zooming out
+	if(zoom < TILES_MAX_ZOOM){
+		for(i = 0; i < 4; i++){
+			children[i] = tilesFind(zoom + 1, 2 * x + (i & 1), 2 * y + (i >> 1));
+			if(children[i] != NULL){
+				found++;
+			}
+		}
+		if(found == 4){
+			for(i = 0; i < 4; i++){
+				tilesDownscale(children[i], sx + (i & 1) * TILES_SIZE / 2, sy + (i >> 1) * TILES_SIZE / 2);
+			}
+			stats.ChildFallbacks++;
+			return;
+		}
+	}
+
+	// Parent or grandparent, usual case right after zooming in
+	for(levels = 1; levels <= TILES_PARENT_LEVELS && levels <= zoom; levels++){
+		parent = tilesFind(zoom - levels, x >> levels, y >> levels);
+		if(parent != NULL){
+			tilesUpscale(parent, levels, (x & ((1 << levels) - 1)) * (TILES_SIZE >> levels),
+				(y & ((1 << levels) - 1)) * (TILES_SIZE >> levels), sx, sy);
+			stats.ParentFallbacks++;
+			return;
+		}
+	}
+
+	// Nothing covers whole tile, use whatever children there are
+	gdispFillArea(sx, sy, TILES_SIZE, TILES_SIZE, TILES_BACKGROUND);
+	for(i = 0; i < 4 && found; i++){
+		if(children[i] != NULL){
+			tilesDownscale(children[i], sx + (i & 1) * TILES_SIZE / 2, sy + (i >> 1) * TILES_SIZE / 2);
+		}
+	}
+	stats.Holes++;
+}
+
+static void tilesUpscale(const tile_slot_t *slot, uint32_t levels, uint32_t ox, uint32_t oy, coord_t sx, coord_t sy){
+	uint32_t factor = 1 << levels, size = (uint32_t)TILES_SIZE >> levels;
+	uint32_t row, col, r;
+	const pixel_t *src;
+	pixel_t *dst;
+
+	// Integer factor nearest neighbour, each source row is widened once and blitted as factor rows
+	for(row = 0; row < size; row++){
+		src = slot->bits + (oy + row) * TILES_SIZE + ox;
+		dst = scaleBuffer;
+		for(col = 0; col < size; col++){
+			for(r = 0; r < factor; r++){
+				*dst++ = src[col];
+			}
+		}
+		for(r = 1; r < factor; r++){
+			memcpy(scaleBuffer + r * TILES_SIZE, scaleBuffer, TILES_SIZE * sizeof(pixel_t));
+		}
+		gdispBlitAreaEx(sx, sy + row * factor, TILES_SIZE, factor, 0, 0, TILES_SIZE, scaleBuffer);
+	}
+}
+
+static void tilesDownscale(const tile_slot_t *slot, coord_t sx, coord_t sy){
+	const pixel_t *a, *b;
+	uint32_t row, col, p0, p1, p2, p3;
+
+	// 2x2 box filter, red and blue are summed together since green sits between them as guard bits
+	for(row = 0; row < TILES_SIZE / 2; row++){
+		a = slot->bits + 2 * row * TILES_SIZE;
+		b = a + TILES_SIZE;
+		for(col = 0; col < TILES_SIZE / 2; col++){
+			p0 = a[2 * col];
+			p1 = a[2 * col + 1];
+			p2 = b[2 * col];
+			p3 = b[2 * col + 1];
+			scaleBuffer[col] = (pixel_t)(((((p0 & 0xF81F) + (p1 & 0xF81F) + (p2 & 0xF81F) + (p3 & 0xF81F)) >> 2) & 0xF81F) |
+				((((p0 & 0x07E0) + (p1 & 0x07E0) + (p2 & 0x07E0) + (p3 & 0x07E0)) >> 2) & 0x07E0));
+		}
+		gdispBlitAreaEx(sx, sy + row, TILES_SIZE / 2, 1, 0, 0, TILES_SIZE / 2, scaleBuffer);
+	}
+}
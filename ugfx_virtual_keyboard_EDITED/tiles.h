@@ -0,0 +1,39 @@
+#ifndef _TILES_H_
+#define _TILES_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "gfx.h"
+#include "projection.h"
+
+#define TILES_MIN_ZOOM					12
+#define TILES_MAX_ZOOM					18
+#define TILES_SIZE							256
+#define TILES_DIR								"Tiles"
+#define TILES_PATH							TILES_DIR "/%d/%d/%d.png"
+#define TILES_LOADS_PER_DRAW		2				// SD reads allowed per draw, rest are filled from other zoom levels
+#define TILES_PARENT_LEVELS			3				// Parent tiles up to this many levels up are scaled up
+#define TILES_BACKGROUND				HTML2COLOR(0xEAE6DC)
+#define TILES_ROTATE_GRID				5				// Tiles across area sampled by rotated map, 5 covers 900 px diagonal
+#ifndef TILES_ROTATE_BILINEAR
+#define TILES_ROTATE_BILINEAR		FALSE		// Smoother rotated map, sim/bench/tiles_rotate.c measures both
+#endif
+
+typedef struct {
+	uint32_t Draws;
+	uint32_t Hits;							// Tiles drawn straight from cache
+	uint32_t Loads;							// Tiles decoded from SD
+	uint32_t Missing;						// Tiles not on SD, remembered so they are not opened again
+	uint32_t Evictions;
+	uint32_t ParentFallbacks;		// Tiles drawn from scaled up parent
+	uint32_t ChildFallbacks;		// Tiles drawn from scaled down children
+	uint32_t Holes;							// Tiles filled with background
+	uint32_t RotatedDraws;			// Draws through affine blitter
+	uint32_t LastDrawMS;
+} tiles_stats_t;
+
+void tilesInit(void);
+bool tilesDraw(const proj_world_t *center, uint8_t zoom, int16_t rotation, coord_t centerX, coord_t centerY, coord_t x, coord_t y, coord_t cx, coord_t cy);
+void tilesGetStats(tiles_stats_t *stats);
+
+#endif /* _TILES_H_ */
@@ -32,8 +32,10 @@
 
 /* Char 2 digit conversions */
 #define GPS_C2N(a)				(((a) - 48))
-#define GPS_C2NM(a, x)			(C2N(a) * (x))
-#define GPS_CONCAT(x, y)		((x) << 5 | (y))
+
+/* Sentence talker and type packed to integer for switch statement */
+#define GPS_TALKER(a, b)		((uint16_t)(a) << 8 | (uint16_t)(b))
+#define GPS_TYPE(a, b, c)		((uint32_t)(a) << 16 | (uint32_t)(b) << 8 | (uint32_t)(c))
 
 /* NMEA statements */
 #define GPS_GPGGA				0
@@ -65,44 +67,52 @@
 /* GPGSV Flags */
 #define GPS_FLAG_SATSINVIEW		0x00010000	//GPGSV
 #define GPS_FLAG_SATSDESC       0x00040000  //GPGSV
+/* UBX Flags */
+#define GPS_FLAG_NAVPVT			0x00080000	//NAV-PVT, completes data set on its own
 
 /* GPGGA Positions */
-#define GPS_POS_LATITUDE		GPS_CONCAT(GPS_GPGGA, 2)	//
-#define GPS_POS_LONGITUDE		GPS_CONCAT(GPS_GPGGA, 4)	//
-#define GPS_POS_SATS			GPS_CONCAT(GPS_GPGGA, 7)	//
-#define GPS_POS_FIX				GPS_CONCAT(GPS_GPGGA, 6)	//
-#define GPS_POS_ALTITUDE		GPS_CONCAT(GPS_GPGGA, 9)	//
-#define GPS_POS_TIME			GPS_CONCAT(GPS_GPGGA, 1)	//
-#define GPS_POS_EW				GPS_CONCAT(GPS_GPGGA, 5)	//
-#define GPS_POS_NS				GPS_CONCAT(GPS_GPGGA, 3)	//
+#define GPS_POS_GGA_TIME		1
+#define GPS_POS_GGA_LATITUDE	2
+#define GPS_POS_GGA_NS			3
+#define GPS_POS_GGA_LONGITUDE	4
+#define GPS_POS_GGA_EW			5
+#define GPS_POS_GGA_FIX			6
+#define GPS_POS_GGA_SATS		7
+#define GPS_POS_GGA_ALTITUDE	9
 
 /* GPRMC Positions */
-#define GPS_POS_SPEED			GPS_CONCAT(GPS_GPRMC, 7)	//
-#define GPS_POS_DATE			GPS_CONCAT(GPS_GPRMC, 9)	//
-#define GPS_POS_VALIDITY		GPS_CONCAT(GPS_GPRMC, 2)	//
-#define GPS_POS_DIRECTION		GPS_CONCAT(GPS_GPRMC, 8)	//
+#define GPS_POS_RMC_VALIDITY	2
+#define GPS_POS_RMC_SPEED		7
+#define GPS_POS_RMC_DIRECTION	8
+#define GPS_POS_RMC_DATE		9
 
 /* GPGSA Positions */
-#define GPS_POS_PDOP			GPS_CONCAT(GPS_GPGSA, 15)	//
-#define GPS_POS_HDOP			GPS_CONCAT(GPS_GPGSA, 16)	//
-#define GPS_POS_VDOP			GPS_CONCAT(GPS_GPGSA, 17)	//
-#define GPS_POS_FIXMODE			GPS_CONCAT(GPS_GPGSA, 2)	//
-
-#define GPS_POS_SAT1			GPS_CONCAT(GPS_GPGSA, 3)	//
-#define GPS_POS_SAT2			GPS_CONCAT(GPS_GPGSA, 4)	//
-#define GPS_POS_SAT3			GPS_CONCAT(GPS_GPGSA, 5)	//
-#define GPS_POS_SAT4			GPS_CONCAT(GPS_GPGSA, 6)	//
-#define GPS_POS_SAT5			GPS_CONCAT(GPS_GPGSA, 7)	//
-#define GPS_POS_SAT6			GPS_CONCAT(GPS_GPGSA, 8)	//
-#define GPS_POS_SAT7			GPS_CONCAT(GPS_GPGSA, 9)	//
-#define GPS_POS_SAT8			GPS_CONCAT(GPS_GPGSA, 10)	//
-#define GPS_POS_SAT9			GPS_CONCAT(GPS_GPGSA, 11)	//
-#define GPS_POS_SAT10			GPS_CONCAT(GPS_GPGSA, 12)	//
-#define GPS_POS_SAT11			GPS_CONCAT(GPS_GPGSA, 13)	//
-#define GPS_POS_SAT12			GPS_CONCAT(GPS_GPGSA, 14)	//
+#define GPS_POS_GSA_FIXMODE		2
+#define GPS_POS_GSA_SAT1		3
+#define GPS_POS_GSA_PDOP		15
+#define GPS_POS_GSA_HDOP		16
+#define GPS_POS_GSA_VDOP		17
 
 /* GPGSV Positions */
-#define GPS_POS_SATSINVIEW		GPS_CONCAT(GPS_GPGSV, 3)	//
+#define GPS_POS_GSV_COUNT		1
+#define GPS_POS_GSV_NUMBER		2
+#define GPS_POS_GSV_SATSINVIEW	3
+#define GPS_POS_GSV_SAT1		4
+
+/* UBX protocol */
+#define GPS_UBX_SYNC1			0xB5
+#define GPS_UBX_SYNC2			0x62
+#define GPS_UBX_CLASS_NAV		0x01
+#define GPS_UBX_ID_NAV_PVT		0x07
+#define GPS_UBX_NAV_PVT_LENGTH	92
+#define GPS_UBX_OVERHEAD		8		/* Sync, class, id, length and checksum */
+#define GPS_UBX_MAX_LENGTH		1024	/* Longer frames are treated as garbage */
+
+#if GPS_USART_USE_DMA && GPS_SENTENCE_MAX_LENGTH < GPS_UBX_NAV_PVT_LENGTH + GPS_UBX_OVERHEAD
+#error "GPS: GPS_SENTENCE_MAX_LENGTH must hold UBX NAV-PVT frame"
+#endif
+#define GPS_UBX_LE16(p)			((uint16_t)(p)[0] | (uint16_t)(p)[1] << 8)
+#define GPS_UBX_LE32(p)			((uint32_t)(p)[0] | (uint32_t)(p)[1] << 8 | (uint32_t)(p)[2] << 16 | (uint32_t)(p)[3] << 24)
 
 /* Earth radius */
 #define GPS_EARTH_RADIUS		6371
@@ -115,50 +125,75 @@
 /* Maximal number of satellites in view */
 #define GPS_MAX_SATS_IN_VIEW    24
 
+/* Terms of one NMEA sentence, term 0 is sentence name without "$" */
+typedef struct {
+	const char* Term[GPS_MAX_TERMS];
+	uint8_t Length[GPS_MAX_TERMS];
+	uint8_t Count;
+} TM_GPS_INT_Terms_t;
+
 /* Internal variables */
-static char GPS_Term[15];
-static uint8_t GPS_Term_Number;
-static uint8_t GPS_Term_Pos;
-static uint8_t TM_GPS_CRC, TM_GPS_CRC_Received;
-static uint8_t TM_GPS_Star;
 static uint8_t TM_GPS_Statement = GPS_ERR;
 static uint32_t GPS_Flags = 0, GPS_Flags_OK;
 static TM_GPS_Data_t TM_GPS_INT_Data;
 static uint8_t TM_GPS_FirstTime;
-static char GPS_Statement_Name[7];
+static uint8_t GPS_UBX_Frame[GPS_UBX_NAV_PVT_LENGTH + GPS_UBX_OVERHEAD];
+static uint16_t GPS_UBX_Pos, GPS_UBX_Length;
+#if GPS_USART_USE_DMA
+static uint8_t GPS_DMA_Buffer[GPS_USART_DMA_BUFFER_SIZE];
+static uint8_t GPS_Sentence_Buffer[GPS_SENTENCE_MAX_LENGTH];
+#else
+static char GPS_Sentence_Buffer[GPS_SENTENCE_MAX_LENGTH];
+static uint16_t GPS_Sentence_Pos;
+#endif
 
+#ifndef GPS_DISABLE_GPGSA
+uint8_t GPGSA_IDs_Count = 0;
+#endif
 #ifndef GPS_DISABLE_GPGSV
-uint8_t GPGSV_StatementsCount = 0;
-uint8_t GPSGV_StatementNumber = 0;
-uint8_t GPGSV_Term_Number = 0;
-uint8_t GPGSV_Term_Mod = 0;
+uint8_t GPGSV_Base = 0;
+uint8_t GPGSV_InView = 0;
 #endif
 
 /* Private */
-TM_GPS_Result_t TM_GPS_INT_Do(TM_GPS_t* GPS_Data, char c);
-void TM_GPS_INT_CheckTerm(TM_GPS_t* GPS_Data);
+uint16_t TM_GPS_INT_Parse(TM_GPS_t* GPS_Data, const char* Sentence, uint16_t Length);
+const char* TM_GPS_INT_Sentence(TM_GPS_t* GPS_Data, const char* str, const char* end);
+void TM_GPS_INT_CheckTerms(TM_GPS_t* GPS_Data, const TM_GPS_INT_Terms_t* t);
+void TM_GPS_INT_GGA(const TM_GPS_INT_Terms_t* t);
+void TM_GPS_INT_RMC(const TM_GPS_INT_Terms_t* t);
+void TM_GPS_INT_GSA(const TM_GPS_INT_Terms_t* t);
+void TM_GPS_INT_GSV(const TM_GPS_INT_Terms_t* t);
+uint16_t TM_GPS_INT_UBX(TM_GPS_t* GPS_Data, const uint8_t* data, uint16_t len);
+void TM_GPS_INT_UBXFrame(TM_GPS_t* GPS_Data);
+void TM_GPS_INT_NavPvt(const uint8_t* p);
 TM_GPS_Result_t TM_GPS_INT_Return(TM_GPS_t* GPS_Data);
-uint8_t TM_GPS_INT_StringStartsWith(char* string, const char* str);
-uint8_t TM_GPS_INT_Atoi(char* str, uint32_t* val);
+TM_GPS_Result_t TM_GPS_INT_Status(TM_GPS_t* GPS_Data);
+uint32_t TM_GPS_INT_ParseUint(const char* str, uint8_t len);
+int32_t TM_GPS_INT_ParseFixed(const char* str, uint8_t len, uint8_t decimals);
+int32_t TM_GPS_INT_ParseCoordinate(const char* str, uint8_t len);
 uint32_t TM_GPS_INT_Pow(uint8_t x, uint8_t y);
 uint8_t TM_GPS_INT_Hex2Dec(char c);
 uint8_t TM_GPS_INT_FlagsOk(TM_GPS_t* GPS_Data);
 void TM_GPS_INT_ClearFlags(TM_GPS_t* GPS_Data);
-void TM_GPS_INT_CheckEmpty(TM_GPS_t* GPS_Data);
 
-#define TM_GPS_INT_Add2CRC(c)                            (TM_GPS_CRC ^= c)
 #define TM_GPS_INT_ReturnWithStatus(GPS_Data, status)    (GPS_Data)->Status = status; return status;
 #define TM_GPS_INT_SetFlag(flag)                         (GPS_Flags |= (flag))
 
 /* Public */
 void TM_GPS_Init(TM_GPS_t* GPS_Data, uint32_t baudrate) {
 	/* Initialize USART */
+#if GPS_USART_USE_DMA
+	TM_USART_DMA_Init(GPS_USART, GPS_USART_PINSPACK, baudrate, GPS_DMA_Buffer, GPS_USART_DMA_BUFFER_SIZE);
+#else
 	GPS_USART_INIT(baudrate);
+#endif
 	/* Set first-time variable */
 	TM_GPS_FirstTime = 1;
 	
 	/* Reset everything */
 	GPS_Data->CustomStatementsCount = 0;
+	memset(&GPS_Data->Stats, 0, sizeof(GPS_Data->Stats));
+	GPS_UBX_Pos = 0;
 	
 	/* Clear all flags */
 	TM_GPS_INT_ClearFlags(GPS_Data);
@@ -194,24 +229,75 @@ void TM_GPS_Init(TM_GPS_t* GPS_Data, uint32_t baudrate) {
 }
 
 TM_GPS_Result_t TM_GPS_Update(TM_GPS_t* GPS_Data) {
-	/* Check for data in USART */
-	if (!GPS_USART_BUFFER_EMPTY) {
-		while (!GPS_USART_BUFFER_EMPTY) {
-			TM_GPS_INT_Do(GPS_Data, (char)GPS_USART_BUFFER_GET_CHAR);
-			if (GPS_Data->Status == TM_GPS_Result_NewData) {
+#if GPS_USART_USE_DMA
+	TM_USART_DMA_Sentence_t sentence;
+	const char* str;
+	uint16_t len, n;
+	uint8_t newData = 0;
+	
+	/* Parse complete sentences received with DMA */
+	while (!newData && TM_USART_DMA_GetSentence(GPS_USART, &sentence, GPS_Sentence_Buffer, sizeof(GPS_Sentence_Buffer))) {
+		str = (const char *)sentence.Data;
+		len = sentence.Length;
+		while (len) {
+			n = TM_GPS_INT_Parse(GPS_Data, str, len);
+			str += n;
+			len -= n;
+			
+			/* Sentence is parsed in DMA buffer, drop what was collected when DMA wrote over it meanwhile */
+			if (!TM_USART_DMA_SentenceValid(GPS_USART, &sentence)) {
+				GPS_Data->Stats.Overwritten++;
+				TM_GPS_INT_ClearFlags(GPS_Data);
+				GPS_UBX_Pos = 0;
+				break;
+			}
+			if (TM_GPS_INT_Return(GPS_Data) == TM_GPS_Result_NewData) {
+				newData = 1;
+			}
+		}
+	}
+	
+	if (newData) {
+		TM_GPS_INT_ReturnWithStatus(GPS_Data, TM_GPS_Result_NewData);
+	}
+	return TM_GPS_INT_Status(GPS_Data);
+#else
+	uint16_t len;
+	
+	/* Collect characters from USART to line and parse it when complete */
+	while (!GPS_USART_BUFFER_EMPTY) {
+		GPS_Sentence_Buffer[GPS_Sentence_Pos++] = (char)GPS_USART_BUFFER_GET_CHAR;
+		if (GPS_Sentence_Buffer[GPS_Sentence_Pos - 1] == '\n' || GPS_Sentence_Pos == sizeof(GPS_Sentence_Buffer)) {
+			len = GPS_Sentence_Pos;
+			GPS_Sentence_Pos = 0;
+			if (TM_GPS_UpdateSentence(GPS_Data, GPS_Sentence_Buffer, len) == TM_GPS_Result_NewData) {
 				return GPS_Data->Status;
 			}
 		}
 	}
 	
-	if (TM_GPS_FirstTime) {
-		/* No any valid data, return First Data Waiting */
-		/* Returning only after power up and calling when no all data is received */
-		TM_GPS_INT_ReturnWithStatus(GPS_Data, TM_GPS_Result_FirstDataWaiting);
+	return TM_GPS_INT_Status(GPS_Data);
+#endif
+}
+
+TM_GPS_Result_t TM_GPS_UpdateSentence(TM_GPS_t* GPS_Data, const char* Sentence, uint16_t Length) {
+	uint16_t n;
+	uint8_t newData = 0;
+	
+	while (Length) {
+		n = TM_GPS_INT_Parse(GPS_Data, Sentence, Length);
+		Sentence += n;
+		Length -= n;
+		
+		if (TM_GPS_INT_Return(GPS_Data) == TM_GPS_Result_NewData) {
+			newData = 1;
+		}
 	}
 	
-	/* We have old data */
-	TM_GPS_INT_ReturnWithStatus(GPS_Data, TM_GPS_Result_OldData);
+	if (newData) {
+		TM_GPS_INT_ReturnWithStatus(GPS_Data, TM_GPS_Result_NewData);
+	}
+	return TM_GPS_INT_Status(GPS_Data);
 }
 
 TM_GPS_Custom_t * TM_GPS_AddCustom(TM_GPS_t* GPS_Data, char* GPG_Statement, uint8_t TermNumber) {
@@ -309,308 +395,411 @@ void TM_GPS_DistanceBetween(TM_GPS_Distance_t* Distance_Data) {
 }
 
 /* Private */
-TM_GPS_Result_t TM_GPS_INT_Do(TM_GPS_t* GPS_Data, char c) {
-	if (TM_GPS_INT_FlagsOk(GPS_Data)) {
-		TM_GPS_INT_ClearFlags(GPS_Data);				/* Data were valid before, new data are coming, not new anymore */
-		GPS_Data->Status = TM_GPS_Result_OldData;		/* Data were "new" on last call, now are only "Old data", no NEW data */
-	}
-	if (c == '$') {										/* Start of string detected */
-		TM_GPS_Star = 0;								/* Star detection reset */
-		TM_GPS_CRC = 0;									/* Reset CRC */
-		GPS_Term_Number = 0;							/* First term in new statement */
-		GPS_Term_Pos = 0;								/* At position 0 of a first term */
-		GPS_Term[GPS_Term_Pos++] = c;					/* Add character to first term */
-	} else if (c == ',') {
-		TM_GPS_INT_Add2CRC(c);							/* Add to parity */
-		GPS_Term[GPS_Term_Pos++] = 0;					/* End of term */
-		TM_GPS_INT_CheckEmpty(GPS_Data);				/* Check if term is empty */
-		TM_GPS_INT_CheckTerm(GPS_Data);					/* Check term */
-		GPS_Term_Number++;								/* Increase term number */
-		GPS_Term_Pos = 0;								/* At position 0 of a first term */
-	} else if (c == '\n') {
-		GPS_Term_Number = 0;							/* Reset term number */
-#ifndef GPS_DISABLE_GPGSV
-		/* Check for GPGSV statement */
-		if (TM_GPS_Statement == GPS_GPGSV && GPGSV_StatementsCount == GPSGV_StatementNumber) {
-			TM_GPS_INT_SetFlag(GPS_FLAG_SATSDESC);		/* Set flag */
+TM_GPS_Result_t TM_GPS_INT_Status(TM_GPS_t* GPS_Data) {
+	if (TM_GPS_FirstTime) {
+		/* No any valid data, return First Data Waiting */
+		/* Returning only after power up and calling when no all data is received */
+		TM_GPS_INT_ReturnWithStatus(GPS_Data, TM_GPS_Result_FirstDataWaiting);
+	}
+	
+	/* We have old data */
+	TM_GPS_INT_ReturnWithStatus(GPS_Data, TM_GPS_Result_OldData);
+}
+
+uint16_t TM_GPS_INT_Parse(TM_GPS_t* GPS_Data, const char* Sentence, uint16_t Length) {
+	const char* str = Sentence;
+	const char* end = Sentence + Length;
+	
+	while (str < end) {
+		if (TM_GPS_INT_FlagsOk(GPS_Data)) {
+			TM_GPS_INT_ClearFlags(GPS_Data);			/* Data were reported before, start collecting new set */
 		}
-#endif
-	} else if (c == '\r') {
-		GPS_Term[GPS_Term_Pos++] = 0;					/* End of character string */
-		TM_GPS_CRC_Received = TM_GPS_INT_Hex2Dec(GPS_Term[0]) * 16 + TM_GPS_INT_Hex2Dec(GPS_Term[1]);	/* Between * and \r are 2 characters of Checksum */
-		if (TM_GPS_CRC_Received != TM_GPS_CRC) {		/* CRC is not OK, data failed somewhere */			
-			TM_GPS_INT_ClearFlags(GPS_Data);			/* Clear all flags */
+		
+		if (GPS_UBX_Pos || (uint8_t)*str == GPS_UBX_SYNC1) {
+			/* UBX frame, can continue in next call */
+			str += TM_GPS_INT_UBX(GPS_Data, (const uint8_t *)str, end - str);
+		} else if (*str == '$') {
+			/* NMEA sentence */
+			str = TM_GPS_INT_Sentence(GPS_Data, str, end);
+		} else {
+			str++;										/* Line end or garbage */
+			continue;
 		}
-		GPS_Term_Number = 0;							/* Reset term number */
-	} else if (c == '*') {
-		TM_GPS_Star = 1;								/* Star detected */
-		GPS_Term[GPS_Term_Pos++] = 0;					/* Add 0 at the end */
-		TM_GPS_INT_CheckEmpty(GPS_Data);				/* Check empty */
-		TM_GPS_INT_CheckTerm(GPS_Data);					/* Check term */		
-		GPS_Term_Number++;								/* Increase term number */
-		GPS_Term_Pos = 0;								/* At position 0 of a first term */
-	} else {
-		/* Other characters detected */
-		if (!TM_GPS_Star) {								/* If star is not detected yet */
-			TM_GPS_INT_Add2CRC(c);						/* Add to parity */
+		
+		if (TM_GPS_INT_FlagsOk(GPS_Data)) {
+			break;										/* Data set is complete, report it before rest is parsed */
 		}
-		GPS_Term[GPS_Term_Pos++] = c;					/* Add to term */
 	}
-	return TM_GPS_INT_Return(GPS_Data);					/* Return current GPS status */
+	return str - Sentence;
 }
 
-void TM_GPS_INT_CheckTerm(TM_GPS_t* GPS_Data) {
-	uint32_t temp;
-#ifndef GPS_DISABLE_GPGSA
-	static uint8_t ids_count = 0;
-#endif
-	uint8_t count, i;
-	if (GPS_Term_Number == 0) {
-		/* Statement indicator */
-		if (TM_GPS_INT_StringStartsWith(GPS_Term, "$GPGGA")) {
-			TM_GPS_Statement = GPS_GPGGA;
-		} else if (TM_GPS_INT_StringStartsWith(GPS_Term, "$GPRMC")) {
-			TM_GPS_Statement = GPS_GPRMC;
-		} else if (TM_GPS_INT_StringStartsWith(GPS_Term, "$GPGSA")) {
-			TM_GPS_Statement = GPS_GPGSA;
-		} else if (TM_GPS_INT_StringStartsWith(GPS_Term, "$GPGSV")) {
-			TM_GPS_Statement = GPS_GPGSV;
+const char* TM_GPS_INT_Sentence(TM_GPS_t* GPS_Data, const char* str, const char* end) {
+	TM_GPS_INT_Terms_t t;
+	const char* star = NULL;
+	const char* p;
+	uint8_t crc = 0, len;
+	
+	/* Find star and calculate checksum before anything is parsed */
+	for (p = str + 1; p < end; p++) {
+		if (*p == '*') {
+			star = p;
+			break;
+		}
+		if (*p == '$' || *p == '\r' || *p == '\n') {	/* Sentence is broken */
+			break;
+		}
+		crc ^= *p;
+	}
+	if (star == NULL || (end - star) < 3 || (TM_GPS_INT_Hex2Dec(star[1]) * 16 + TM_GPS_INT_Hex2Dec(star[2])) != crc) {
+		GPS_Data->Stats.ChecksumErrors++;
+		return p;										/* Continue after broken part */
+	}
+	GPS_Data->Stats.Sentences++;
+	
+	/* Split sentence to terms, missing terms are empty */
+	memset(t.Length, 0, sizeof(t.Length));
+	t.Count = 1;
+	t.Term[0] = str + 1;
+	for (p = str + 1; p < star; p++) {
+		if (*p == ',') {
+			if (t.Count == GPS_MAX_TERMS) {
+				break;
+			}
+			t.Term[t.Count++] = p + 1;
 		} else {
-			TM_GPS_Statement = GPS_ERR;
+			t.Length[t.Count - 1]++;
 		}
-		
-		strcpy(GPS_Statement_Name, GPS_Term);			/* Copy term to variable */
-		return;											/* Do nothing */
 	}
 	
-	/* Check custom terms one by one */
+	for (p = star, len = t.Count; len < GPS_MAX_TERMS; len++) {
+		t.Term[len] = p;
+	}
+	
+	TM_GPS_INT_CheckTerms(GPS_Data, &t);
+	
+	return star + 3;									/* Continue after checksum */
+}
+
+void TM_GPS_INT_CheckTerms(TM_GPS_t* GPS_Data, const TM_GPS_INT_Terms_t* t) {
+	const char* name = t->Term[0];
+	TM_GPS_Custom_t* c;
+	uint8_t i, len;
+	
+	/* Check custom terms one by one, statement name must match including talker */
 	for (i = 0; i < GPS_Data->CustomStatementsCount; i++) {
-		/* Term is inside current statement */
-		if (TM_GPS_INT_StringStartsWith(GPS_Statement_Name, GPS_Data->CustomStatements[i]->Statement)) {
-			/* Term number is correct */
-			if (GPS_Term_Number == GPS_Data->CustomStatements[i]->TermNumber) {
-				/* Copy string value */
-				strcpy(GPS_Data->CustomStatements[i]->Value, GPS_Term);
-				
-				/* Set updated flag */
-				GPS_Data->CustomStatements[i]->Updated = 1;
+		c = GPS_Data->CustomStatements[i];
+		if (c->TermNumber < t->Count && strlen(c->Statement) == (size_t)t->Length[0] + 1 && strncmp(&c->Statement[1], name, t->Length[0]) == 0) {
+			/* Copy string value */
+			len = t->Length[c->TermNumber];
+			if (len >= sizeof(c->Value)) {
+				len = sizeof(c->Value) - 1;
 			}
+			memcpy(c->Value, t->Term[c->TermNumber], len);
+			c->Value[len] = 0;
+			
+			/* Set updated flag */
+			c->Updated = 1;
 		}
 	}
 	
-	switch (GPS_CONCAT(TM_GPS_Statement, GPS_Term_Number)) {
-#ifndef GPS_DISABLE_GPGGA
-		case GPS_POS_LATITUDE:	/* GPGGA */
-			/* Convert latitude */
-			count = TM_GPS_INT_Atoi(GPS_Term, &temp);
-			TM_GPS_INT_Data.Latitude = temp / 100;
-			TM_GPS_INT_Data.Latitude += (float)(temp % 100) / (float)60;
-		
-			count = TM_GPS_INT_Atoi(&GPS_Term[++count], &temp);
-			TM_GPS_INT_Data.Latitude += temp / (TM_GPS_INT_Pow(10, count) * 60.0);
-			TM_GPS_INT_SetFlag(GPS_FLAG_LATITUDE);
-			break;
-		case GPS_POS_NS: /* GPGGA */
-			if (GPS_Term[0] == 'S') {
-				TM_GPS_INT_Data.Latitude = -TM_GPS_INT_Data.Latitude;	/* South has negative coordinate */
-			}
-			TM_GPS_INT_SetFlag(GPS_FLAG_NS);
-			break;
-		case GPS_POS_LONGITUDE: /* GPGGA */
-			/* Convert longitude */
-			count = TM_GPS_INT_Atoi(GPS_Term, &temp);
-			TM_GPS_INT_Data.Longitude = temp / 100; /* Degrees */
-			TM_GPS_INT_Data.Longitude += (float)(temp % 100) / (float)60;
-		
-			count = TM_GPS_INT_Atoi(&GPS_Term[++count], &temp);
-			TM_GPS_INT_Data.Longitude += temp / (TM_GPS_INT_Pow(10, count) * 60.0);
-			TM_GPS_INT_SetFlag(GPS_FLAG_LONGITUDE);
-			break;
-		case GPS_POS_EW: /* GPGGA */
-			if (GPS_Term[0] == 'W') {
-				TM_GPS_INT_Data.Longitude = -TM_GPS_INT_Data.Longitude;	/* West has negative coordinate */
-			}
-			TM_GPS_INT_SetFlag(GPS_FLAG_EW);
-			break;
-		case GPS_POS_SATS: /* GPGGA */
-			/* Satellites in use */
-			TM_GPS_INT_Atoi(GPS_Term, &temp);
-			TM_GPS_INT_Data.Satellites = temp;
-			TM_GPS_INT_SetFlag(GPS_FLAG_SATS);
-			break;
-		case GPS_POS_FIX: /* GPGGA */
-			/* GPS Fix */
-			TM_GPS_INT_Atoi(GPS_Term, &temp);
-			TM_GPS_INT_Data.Fix = temp;
-			TM_GPS_INT_SetFlag(GPS_FLAG_FIX);
-			break;
-		case GPS_POS_ALTITUDE: /* GPGGA */
-			/* Convert altitude above sea */
-			if (GPS_Term[0] == '-') {
-				count = TM_GPS_INT_Atoi(&GPS_Term[1], &temp);
-				TM_GPS_INT_Data.Altitude = temp;
-				
-				count++;
-				count = TM_GPS_INT_Atoi(&GPS_Term[++count], &temp);
-				TM_GPS_INT_Data.Altitude += temp / (TM_GPS_INT_Pow(10, count) * 1.0);
-				
-				TM_GPS_INT_Data.Altitude = -TM_GPS_INT_Data.Altitude;
-			} else {
-				count = TM_GPS_INT_Atoi(GPS_Term, &temp);
-				TM_GPS_INT_Data.Altitude = temp;
-		
-				count = TM_GPS_INT_Atoi(&GPS_Term[++count], &temp);
-				TM_GPS_INT_Data.Altitude += temp / (TM_GPS_INT_Pow(10, count) * 1.0);
-			}
-			TM_GPS_INT_SetFlag(GPS_FLAG_ALTITUDE);
+	/* Statement name is talker and 3 characters of type */
+	if (t->Length[0] != 5) {
+		GPS_Data->Stats.Unknown++;
+		TM_GPS_Statement = GPS_ERR;
+		return;
+	}
+	switch (GPS_TALKER(name[0], name[1])) {
+		case GPS_TALKER('G', 'P'):						/* GPS */
+		case GPS_TALKER('G', 'N'):						/* Multi GNSS */
+		case GPS_TALKER('G', 'L'):						/* GLONASS */
+		case GPS_TALKER('G', 'A'):						/* Galileo */
+		case GPS_TALKER('B', 'D'):						/* BeiDou */
+		case GPS_TALKER('G', 'B'):						/* BeiDou, NMEA 4.10 */
 			break;
-		case GPS_POS_TIME: /* GPGGA */
-			/* Set time */
-			count = TM_GPS_INT_Atoi(GPS_Term, &temp);
-			TM_GPS_INT_Data.Time.Seconds = temp % 100;
-			TM_GPS_INT_Data.Time.Minutes = (int)(temp * (float) 0.01) % 100;
-			TM_GPS_INT_Data.Time.Hours = (int)(temp * (float)0.0001) % 100;
-			/* Hundredths */
-			TM_GPS_INT_Atoi(&GPS_Term[++count], &temp);
-			TM_GPS_INT_Data.Time.Hundredths = temp;
-			TM_GPS_INT_SetFlag(GPS_FLAG_TIME);
+		default:
+			GPS_Data->Stats.Unknown++;
+			TM_GPS_Statement = GPS_ERR;
+			return;
+	}
+	
+	switch (GPS_TYPE(name[2], name[3], name[4])) {
+#ifndef GPS_DISABLE_GPGGA
+		case GPS_TYPE('G', 'G', 'A'):
+			TM_GPS_INT_GGA(t);
+			TM_GPS_Statement = GPS_GPGGA;
 			break;
 #endif
 #ifndef GPS_DISABLE_GPRMC
-		case GPS_POS_SPEED:	/* GPRMC */	
-			/* Convert speed */
-			count = TM_GPS_INT_Atoi(GPS_Term, &temp);
-			TM_GPS_INT_Data.Speed = (float)temp;
-		
-			count = TM_GPS_INT_Atoi(&GPS_Term[++count], &temp);
-			TM_GPS_INT_Data.Speed += (float)((float)temp / (TM_GPS_INT_Pow(10, count) * 1.0));
-		
-			/* Set flag */
-			TM_GPS_INT_SetFlag(GPS_FLAG_SPEED);
-			break;
-		case GPS_POS_DATE: /* GPRMC */	
-			/* Set date */
-			TM_GPS_INT_Atoi(GPS_Term, &temp);
-			TM_GPS_INT_Data.Date.Year = temp % 100;
-			TM_GPS_INT_Data.Date.Month = (int)(temp * 0.01f) % 100;
-			TM_GPS_INT_Data.Date.Date = (int)(temp * 0.0001f) % 100;
-			TM_GPS_INT_SetFlag(GPS_FLAG_DATE);
-			break;
-		case GPS_POS_VALIDITY: /* GPRMC */	
-			/* GPS valid status */
-			TM_GPS_INT_Data.Validity = GPS_Term[0] == 'A';
-			TM_GPS_INT_SetFlag(GPS_FLAG_VALIDITY);
-			break;
-		case GPS_POS_DIRECTION: /* GPRMC */
-			count = TM_GPS_INT_Atoi(GPS_Term, &temp);
-			TM_GPS_INT_Data.Direction = (float)temp;
-		
-			count = TM_GPS_INT_Atoi(&GPS_Term[++count], &temp);
-			TM_GPS_INT_Data.Direction += (float)((float)temp / (TM_GPS_INT_Pow(10, count) * 1.0f));
-			TM_GPS_INT_SetFlag(GPS_FLAG_DIRECTION);
+		case GPS_TYPE('R', 'M', 'C'):
+			TM_GPS_INT_RMC(t);
+			TM_GPS_Statement = GPS_GPRMC;
 			break;
 #endif
 #ifndef GPS_DISABLE_GPGSA
-		case GPS_POS_HDOP: /* GPGSA */
-			count = TM_GPS_INT_Atoi(GPS_Term, &temp);
-			TM_GPS_INT_Data.HDOP = (float)temp;
-		
-			count = TM_GPS_INT_Atoi(&GPS_Term[++count], &temp);
-			TM_GPS_INT_Data.HDOP += (float)((float)temp / (TM_GPS_INT_Pow(10, count) * 1.0f));
-			TM_GPS_INT_SetFlag(GPS_FLAG_HDOP);
-			break;
-		case GPS_POS_PDOP: /* GPGSA */
-			count = TM_GPS_INT_Atoi(GPS_Term, &temp);
-			TM_GPS_INT_Data.PDOP = (float)temp;
-		
-			count = TM_GPS_INT_Atoi(&GPS_Term[++count], &temp);
-			TM_GPS_INT_Data.PDOP += (float)((float)temp / (TM_GPS_INT_Pow(10, count) * 1.0f));
-			TM_GPS_INT_SetFlag(GPS_FLAG_PDOP);
-			break;
-		case GPS_POS_VDOP: /* GPGSA */
-			count = TM_GPS_INT_Atoi(GPS_Term, &temp);
-			TM_GPS_INT_Data.VDOP = (float)temp;
-		
-			count = TM_GPS_INT_Atoi(&GPS_Term[++count], &temp);
-			TM_GPS_INT_Data.VDOP += (float)((float)temp / (TM_GPS_INT_Pow(10, count) * 1.0f));
-			TM_GPS_INT_SetFlag(GPS_FLAG_VDOP);
-			break;
-		case GPS_POS_FIXMODE: /* GPGSA */
-			/* Satellites in view */
-			TM_GPS_INT_Atoi(GPS_Term, &temp);
-			TM_GPS_INT_Data.FixMode = temp;
-			TM_GPS_INT_SetFlag(GPS_FLAG_FIXMODE);
-			break;
-		case GPS_POS_SAT1:
-		case GPS_POS_SAT2:
-		case GPS_POS_SAT3:
-		case GPS_POS_SAT4:
-		case GPS_POS_SAT5:
-		case GPS_POS_SAT6:
-		case GPS_POS_SAT7:
-		case GPS_POS_SAT8:
-		case GPS_POS_SAT9:
-		case GPS_POS_SAT10:
-		case GPS_POS_SAT11:
-		case GPS_POS_SAT12:
-			/* Satellite numbers */
-			TM_GPS_INT_Atoi(GPS_Term, &temp);
-			TM_GPS_INT_Data.SatelliteIDs[GPS_Term_Number - 3] = temp;
-			ids_count++;							/* Increase number of satellites found */
-		
-			if (ids_count == TM_GPS_INT_Data.Satellites) {
-				ids_count = 0;						/* Reset count, we have all statements */
-				TM_GPS_INT_SetFlag(GPS_FLAG_SATS1_12);
-			}
+		case GPS_TYPE('G', 'S', 'A'):
+			TM_GPS_INT_GSA(t);
+			TM_GPS_Statement = GPS_GPGSA;
 			break;
 #endif
 #ifndef GPS_DISABLE_GPGSV
-		case GPS_POS_SATSINVIEW: /* GPGSV */
-			/* Satellites in view */
-			TM_GPS_INT_Atoi(GPS_Term, &temp);
-			TM_GPS_INT_Data.SatellitesInView = temp;
-			TM_GPS_INT_SetFlag(GPS_FLAG_SATSINVIEW);
+		case GPS_TYPE('G', 'S', 'V'):
+			TM_GPS_INT_GSV(t);
+			TM_GPS_Statement = GPS_GPGSV;
 			break;
 #endif
-		default: 
+		default:
+			GPS_Data->Stats.Unknown++;
+			TM_GPS_Statement = GPS_ERR;
 			break;
 	}
+}
+
+/* Empty terms keep previous value, but flag is set anyway */
+#define GPS_TERM(i)				t->Term[(i)], t->Length[(i)]
+#define GPS_TERM_EMPTY(i)		(t->Length[(i)] == 0)
+
+void TM_GPS_INT_GGA(const TM_GPS_INT_Terms_t* t) {
+#ifndef GPS_DISABLE_GPGGA
+	int32_t temp;
+	
+	if (!GPS_TERM_EMPTY(GPS_POS_GGA_TIME)) {
+		/* hhmmss.ss */
+		temp = TM_GPS_INT_ParseFixed(GPS_TERM(GPS_POS_GGA_TIME), 2);
+		TM_GPS_INT_Data.Time.Hundredths = temp % 100;
+		temp /= 100;
+		TM_GPS_INT_Data.Time.Seconds = temp % 100;
+		TM_GPS_INT_Data.Time.Minutes = (temp / 100) % 100;
+		TM_GPS_INT_Data.Time.Hours = (temp / 10000) % 100;
+	}
+	if (!GPS_TERM_EMPTY(GPS_POS_GGA_LATITUDE)) {
+		temp = TM_GPS_INT_ParseCoordinate(GPS_TERM(GPS_POS_GGA_LATITUDE));
+		if (!GPS_TERM_EMPTY(GPS_POS_GGA_NS) && t->Term[GPS_POS_GGA_NS][0] == 'S') {
+			temp = -temp;								/* South has negative coordinate */
+		}
+		TM_GPS_INT_Data.LatitudeE7 = temp;
+	}
+	if (!GPS_TERM_EMPTY(GPS_POS_GGA_LONGITUDE)) {
+		temp = TM_GPS_INT_ParseCoordinate(GPS_TERM(GPS_POS_GGA_LONGITUDE));
+		if (!GPS_TERM_EMPTY(GPS_POS_GGA_EW) && t->Term[GPS_POS_GGA_EW][0] == 'W') {
+			temp = -temp;								/* West has negative coordinate */
+		}
+		TM_GPS_INT_Data.LongitudeE7 = temp;
+	}
+	if (!GPS_TERM_EMPTY(GPS_POS_GGA_FIX)) {
+		TM_GPS_INT_Data.Fix = TM_GPS_INT_ParseUint(GPS_TERM(GPS_POS_GGA_FIX));
+	}
+	if (!GPS_TERM_EMPTY(GPS_POS_GGA_SATS)) {
+		TM_GPS_INT_Data.Satellites = TM_GPS_INT_ParseUint(GPS_TERM(GPS_POS_GGA_SATS));
+	}
+	if (!GPS_TERM_EMPTY(GPS_POS_GGA_ALTITUDE)) {
+		TM_GPS_INT_Data.AltitudeMM = TM_GPS_INT_ParseFixed(GPS_TERM(GPS_POS_GGA_ALTITUDE), 3);
+	}
+	
+	TM_GPS_INT_SetFlag(GPS_FLAG_TIME | GPS_FLAG_LATITUDE | GPS_FLAG_NS | GPS_FLAG_LONGITUDE | GPS_FLAG_EW |
+	                   GPS_FLAG_FIX | GPS_FLAG_SATS | GPS_FLAG_ALTITUDE);
+#endif
+}
+
+void TM_GPS_INT_RMC(const TM_GPS_INT_Terms_t* t) {
+#ifndef GPS_DISABLE_GPRMC
+	uint32_t temp;
+	
+	if (!GPS_TERM_EMPTY(GPS_POS_RMC_VALIDITY)) {
+		TM_GPS_INT_Data.Validity = t->Term[GPS_POS_RMC_VALIDITY][0] == 'A';
+	}
+	if (!GPS_TERM_EMPTY(GPS_POS_RMC_SPEED)) {
+		/* Knots with 3 decimals to mm/s, 1 knot = 1852 m/h */
+		temp = TM_GPS_INT_ParseFixed(GPS_TERM(GPS_POS_RMC_SPEED), 3);
+		if (temp > 2000000) {
+			temp = 2000000;
+		}
+		TM_GPS_INT_Data.SpeedMMS = (temp * 1852 + 1800) / 3600;
+	}
+	if (!GPS_TERM_EMPTY(GPS_POS_RMC_DIRECTION)) {
+		TM_GPS_INT_Data.DirectionE2 = TM_GPS_INT_ParseFixed(GPS_TERM(GPS_POS_RMC_DIRECTION), 2);
+	}
+	if (!GPS_TERM_EMPTY(GPS_POS_RMC_DATE)) {
+		/* ddmmyy */
+		temp = TM_GPS_INT_ParseUint(GPS_TERM(GPS_POS_RMC_DATE));
+		TM_GPS_INT_Data.Date.Year = temp % 100;
+		TM_GPS_INT_Data.Date.Month = (temp / 100) % 100;
+		TM_GPS_INT_Data.Date.Date = (temp / 10000) % 100;
+	}
+	
+	TM_GPS_INT_SetFlag(GPS_FLAG_VALIDITY | GPS_FLAG_SPEED | GPS_FLAG_DIRECTION | GPS_FLAG_DATE);
+#endif
+}
+
+void TM_GPS_INT_GSA(const TM_GPS_INT_Terms_t* t) {
+#ifndef GPS_DISABLE_GPGSA
+	uint8_t i;
+	
+	/* Multi GNSS receivers send one GSA per system, collect IDs from all of them */
+	if (TM_GPS_Statement != GPS_GPGSA) {
+		GPGSA_IDs_Count = 0;
+		memset(TM_GPS_INT_Data.SatelliteIDs, 0, sizeof(TM_GPS_INT_Data.SatelliteIDs));
+	}
+	
+	if (!GPS_TERM_EMPTY(GPS_POS_GSA_FIXMODE)) {
+		TM_GPS_INT_Data.FixMode = TM_GPS_INT_ParseUint(GPS_TERM(GPS_POS_GSA_FIXMODE));
+	}
+	for (i = GPS_POS_GSA_SAT1; i < GPS_POS_GSA_SAT1 + 12 && GPGSA_IDs_Count < 12; i++) {
+		if (!GPS_TERM_EMPTY(i)) {
+			TM_GPS_INT_Data.SatelliteIDs[GPGSA_IDs_Count++] = TM_GPS_INT_ParseUint(GPS_TERM(i));
+		}
+	}
+	if (!GPS_TERM_EMPTY(GPS_POS_GSA_PDOP)) {
+		TM_GPS_INT_Data.PDOPE2 = TM_GPS_INT_ParseFixed(GPS_TERM(GPS_POS_GSA_PDOP), 2);
+	}
+	if (!GPS_TERM_EMPTY(GPS_POS_GSA_HDOP)) {
+		TM_GPS_INT_Data.HDOPE2 = TM_GPS_INT_ParseFixed(GPS_TERM(GPS_POS_GSA_HDOP), 2);
+	}
+	if (!GPS_TERM_EMPTY(GPS_POS_GSA_VDOP)) {
+		TM_GPS_INT_Data.VDOPE2 = TM_GPS_INT_ParseFixed(GPS_TERM(GPS_POS_GSA_VDOP), 2);
+	}
 	
+	TM_GPS_INT_SetFlag(GPS_FLAG_FIXMODE | GPS_FLAG_SATS1_12 | GPS_FLAG_PDOP | GPS_FLAG_HDOP | GPS_FLAG_VDOP);
+#endif
+}
+
+void TM_GPS_INT_GSV(const TM_GPS_INT_Terms_t* t) {
 #ifndef GPS_DISABLE_GPGSV
-	/* Check for GPGSV statement separatelly */
-	if (TM_GPS_Statement == GPS_GPGSV) {	
-		if (GPS_Term_Number == 1) {
-			TM_GPS_INT_Atoi(GPS_Term, &temp);			/* Save number of GPGSV statements */
-			GPGSV_StatementsCount = temp;
+	uint8_t count, number, i, term, index;
+	
+	/* Each talker sends own GSV group, satellites of all talkers are stored one after another */
+	if (TM_GPS_Statement != GPS_GPGSV) {
+		GPGSV_Base = 0;
+		GPGSV_InView = 0;
+	}
+	
+	count = TM_GPS_INT_ParseUint(GPS_TERM(GPS_POS_GSV_COUNT));
+	number = TM_GPS_INT_ParseUint(GPS_TERM(GPS_POS_GSV_NUMBER));
+	if (number == 0) {
+		return;
+	}
+	if (number == 1) {
+		/* First sentence of talker */
+		GPGSV_Base = GPGSV_InView;
+		GPGSV_InView += TM_GPS_INT_ParseUint(GPS_TERM(GPS_POS_GSV_SATSINVIEW));
+		TM_GPS_INT_Data.SatellitesInView = GPGSV_InView;
+	}
+	
+	/* Up to 4 satellites in each sentence */
+	for (i = 0; i < 4; i++) {
+		term = GPS_POS_GSV_SAT1 + i * 4;
+		index = GPGSV_Base + (number - 1) * 4 + i;
+		if (term + 3 >= t->Count || index >= GPS_MAX_SATS_IN_VIEW) {
+			break;
+		}
+		TM_GPS_INT_Data.SatDesc[index].ID = TM_GPS_INT_ParseUint(GPS_TERM(term));
+		TM_GPS_INT_Data.SatDesc[index].Elevation = TM_GPS_INT_ParseUint(GPS_TERM(term + 1));
+		TM_GPS_INT_Data.SatDesc[index].Azimuth = TM_GPS_INT_ParseUint(GPS_TERM(term + 2));
+		TM_GPS_INT_Data.SatDesc[index].SNR = TM_GPS_INT_ParseUint(GPS_TERM(term + 3));
+	}
+	
+	TM_GPS_INT_SetFlag(GPS_FLAG_SATSINVIEW);
+	if (number == count) {
+		TM_GPS_INT_SetFlag(GPS_FLAG_SATSDESC);		/* Last sentence of talker */
+	}
+#endif
+}
+
+uint16_t TM_GPS_INT_UBX(TM_GPS_t* GPS_Data, const uint8_t* data, uint16_t len) {
+	uint16_t i;
+	
+	for (i = 0; i < len; i++) {
+		if (GPS_UBX_Pos == 1 && data[i] != GPS_UBX_SYNC2) {
+			GPS_UBX_Pos = 0;							/* Sync character was part of something else */
+			return i;
 		}
-		if (GPS_Term_Number == 2) {
-			TM_GPS_INT_Atoi(GPS_Term, &temp);			/* Save current of GPGSV statement number */
-			GPSGV_StatementNumber = temp;
+		if (GPS_UBX_Pos < sizeof(GPS_UBX_Frame)) {
+			GPS_UBX_Frame[GPS_UBX_Pos] = data[i];		/* Only frames which fit are stored */
 		}
+		GPS_UBX_Pos++;
 		
-		/* Data */
-		if (GPS_Term_Number >= 4) {
-			TM_GPS_INT_Atoi(GPS_Term, &temp);			/* Convert to number */
-			
-			GPGSV_Term_Number = GPS_Term_Number - 4;	/* Get proper value */
-			GPGSV_Term_Mod = GPGSV_Term_Number % 4;
-			GPGSV_Term_Number = (GPSGV_StatementNumber - 1) * 4 + (GPGSV_Term_Number / 4);
-			
-			if (GPGSV_Term_Number < GPS_MAX_SATS_IN_VIEW) {	/* If still memory available */
-				/* Check offset from 4 */
-				if (GPGSV_Term_Mod == 0) {
-					TM_GPS_INT_Data.SatDesc[GPGSV_Term_Number].ID = temp;
-				} else if (GPGSV_Term_Mod == 1) {
-					TM_GPS_INT_Data.SatDesc[GPGSV_Term_Number].Elevation = temp;
-				} else if (GPGSV_Term_Mod == 2) {
-					TM_GPS_INT_Data.SatDesc[GPGSV_Term_Number].Azimuth = temp;
-				} else if (GPGSV_Term_Mod == 3) {
-					TM_GPS_INT_Data.SatDesc[GPGSV_Term_Number].SNR = temp;
-				}
+		if (GPS_UBX_Pos == 6) {
+			/* Header is complete, get frame length */
+			GPS_UBX_Length = GPS_UBX_LE16(&GPS_UBX_Frame[4]) + GPS_UBX_OVERHEAD;
+			if (GPS_UBX_Length > GPS_UBX_MAX_LENGTH) {
+				GPS_Data->Stats.UBXErrors++;
+				GPS_UBX_Pos = 0;
+				return i + 1;
 			}
+		} else if (GPS_UBX_Pos > 6 && GPS_UBX_Pos == GPS_UBX_Length) {
+			/* Frame is complete */
+			TM_GPS_INT_UBXFrame(GPS_Data);
+			GPS_UBX_Pos = 0;
+			return i + 1;
 		}
 	}
+	
+	/* Frame continues in next data */
+	return len;
+}
+
+void TM_GPS_INT_UBXFrame(TM_GPS_t* GPS_Data) {
+	uint8_t ck_a = 0, ck_b = 0;
+	uint16_t i;
+	
+	/* Frame was too long to be stored, so it is not NAV-PVT */
+	if (GPS_UBX_Length > sizeof(GPS_UBX_Frame)) {
+		return;
+	}
+	
+	/* 8-bit Fletcher checksum over class, id, length and payload */
+	for (i = 2; i < GPS_UBX_Length - 2; i++) {
+		ck_a += GPS_UBX_Frame[i];
+		ck_b += ck_a;
+	}
+	if (ck_a != GPS_UBX_Frame[GPS_UBX_Length - 2] || ck_b != GPS_UBX_Frame[GPS_UBX_Length - 1]) {
+		GPS_Data->Stats.UBXErrors++;
+		return;
+	}
+	GPS_Data->Stats.UBXFrames++;
+	
+	if (GPS_UBX_Frame[2] == GPS_UBX_CLASS_NAV && GPS_UBX_Frame[3] == GPS_UBX_ID_NAV_PVT && GPS_UBX_Length == GPS_UBX_NAV_PVT_LENGTH + GPS_UBX_OVERHEAD) {
+		TM_GPS_INT_NavPvt(&GPS_UBX_Frame[6]);
+	}
+}
+
+void TM_GPS_INT_NavPvt(const uint8_t* p) {
+	uint8_t fixOk = p[21] & 0x01;						/* gnssFixOK */
+#ifndef GPS_DISABLE_GPGGA
+	int32_t nano = (int32_t)GPS_UBX_LE32(&p[16]);
+	
+	TM_GPS_INT_Data.Time.Hours = p[8];
+	TM_GPS_INT_Data.Time.Minutes = p[9];
+	TM_GPS_INT_Data.Time.Seconds = p[10];
+	TM_GPS_INT_Data.Time.Hundredths = nano > 0 ? nano / 10000000 : 0;
+	TM_GPS_INT_Data.LongitudeE7 = (int32_t)GPS_UBX_LE32(&p[24]);
+	TM_GPS_INT_Data.LatitudeE7 = (int32_t)GPS_UBX_LE32(&p[28]);
+	TM_GPS_INT_Data.AltitudeMM = (int32_t)GPS_UBX_LE32(&p[36]);	/* Height above mean sea level */
+	TM_GPS_INT_Data.Satellites = p[23];
+	TM_GPS_INT_Data.Fix = fixOk ? ((p[21] & 0x02) ? 2 : 1) : 0;	/* DGPS when differential corrections applied */
+	TM_GPS_INT_SetFlag(GPS_FLAG_TIME | GPS_FLAG_LATITUDE | GPS_FLAG_NS | GPS_FLAG_LONGITUDE | GPS_FLAG_EW |
+	                   GPS_FLAG_FIX | GPS_FLAG_SATS | GPS_FLAG_ALTITUDE);
+#endif
+#ifndef GPS_DISABLE_GPRMC
+	int32_t speed = (int32_t)GPS_UBX_LE32(&p[60]);
+	int32_t heading = (int32_t)GPS_UBX_LE32(&p[64]);
+	
+	TM_GPS_INT_Data.Date.Year = GPS_UBX_LE16(&p[4]) % 100;
+	TM_GPS_INT_Data.Date.Month = p[6];
+	TM_GPS_INT_Data.Date.Date = p[7];
+	TM_GPS_INT_Data.Validity = fixOk;
+	TM_GPS_INT_Data.SpeedMMS = speed > 0 ? speed : 0;
+	TM_GPS_INT_Data.DirectionE2 = heading > 0 ? heading / 1000 : 0;	/* 1e-5 to 1e-2 degrees */
+	TM_GPS_INT_SetFlag(GPS_FLAG_VALIDITY | GPS_FLAG_SPEED | GPS_FLAG_DIRECTION | GPS_FLAG_DATE);
+#endif
+#ifndef GPS_DISABLE_GPGSA
+	TM_GPS_INT_Data.PDOPE2 = GPS_UBX_LE16(&p[76]);
+	TM_GPS_INT_Data.FixMode = p[20] == 2 ? 2 : (p[20] == 3 || p[20] == 4) ? 3 : 1;
+	TM_GPS_INT_SetFlag(GPS_FLAG_FIXMODE | GPS_FLAG_PDOP);
 #endif
+	
+	/* NAV-PVT is complete solution, report it without waiting for GSA and GSV */
+	/* HDOP, VDOP and satellites are not in it, their flags stay as they are */
+	TM_GPS_INT_SetFlag(GPS_FLAG_NAVPVT);
 }
 
 TM_GPS_Result_t TM_GPS_INT_Return(TM_GPS_t* GPS_Data) {
@@ -618,34 +807,46 @@ TM_GPS_Result_t TM_GPS_INT_Return(TM_GPS_t* GPS_Data) {
 	if (TM_GPS_INT_FlagsOk(GPS_Data)) {
 		TM_GPS_FirstTime = 0;							/* Clear first time */
 		
-		/* Set data */
+		/* Set data, float values are calculated from fixed point */
 #ifndef GPS_DISABLE_GPGGA
-		GPS_Data->Latitude = TM_GPS_INT_Data.Latitude;
-		GPS_Data->Longitude = TM_GPS_INT_Data.Longitude;
+		GPS_Data->LatitudeE7 = TM_GPS_INT_Data.LatitudeE7;
+		GPS_Data->LongitudeE7 = TM_GPS_INT_Data.LongitudeE7;
+		GPS_Data->AltitudeMM = TM_GPS_INT_Data.AltitudeMM;
+		GPS_Data->Latitude = (float)TM_GPS_INT_Data.LatitudeE7 * 0.0000001f;
+		GPS_Data->Longitude = (float)TM_GPS_INT_Data.LongitudeE7 * 0.0000001f;
+		GPS_Data->Altitude = (float)TM_GPS_INT_Data.AltitudeMM * 0.001f;
 		GPS_Data->Satellites = TM_GPS_INT_Data.Satellites;
 		GPS_Data->Fix = TM_GPS_INT_Data.Fix;
-		GPS_Data->Altitude = TM_GPS_INT_Data.Altitude;
 		GPS_Data->Time = TM_GPS_INT_Data.Time;
 #endif
 #ifndef GPS_DISABLE_GPRMC
-		GPS_Data->Speed = TM_GPS_INT_Data.Speed;
+		GPS_Data->SpeedMMS = TM_GPS_INT_Data.SpeedMMS;
+		GPS_Data->DirectionE2 = TM_GPS_INT_Data.DirectionE2;
+		GPS_Data->Speed = (float)TM_GPS_INT_Data.SpeedMMS * (3.6f / 1852.0f);	/* Knots */
+		GPS_Data->Direction = (float)TM_GPS_INT_Data.DirectionE2 * 0.01f;
 		GPS_Data->Date = TM_GPS_INT_Data.Date;
 		GPS_Data->Validity = TM_GPS_INT_Data.Validity;
-		GPS_Data->Direction = TM_GPS_INT_Data.Direction;
 #endif
 #ifndef GPS_DISABLE_GPGSA
-		GPS_Data->HDOP = TM_GPS_INT_Data.HDOP;
-		GPS_Data->VDOP = TM_GPS_INT_Data.VDOP;
-		GPS_Data->PDOP = TM_GPS_INT_Data.PDOP;
+		GPS_Data->PDOPE2 = TM_GPS_INT_Data.PDOPE2;
+		GPS_Data->PDOP = (float)TM_GPS_INT_Data.PDOPE2 * 0.01f;
 		GPS_Data->FixMode = TM_GPS_INT_Data.FixMode;
-		for (i = 0; i < 12; i++) {
-			GPS_Data->SatelliteIDs[i] = TM_GPS_INT_Data.SatelliteIDs[i];
+		if (GPS_Flags & GPS_FLAG_SATS1_12) {			/* Only from GPGSA, NAV-PVT alone keeps last values */
+			GPS_Data->HDOPE2 = TM_GPS_INT_Data.HDOPE2;
+			GPS_Data->VDOPE2 = TM_GPS_INT_Data.VDOPE2;
+			GPS_Data->HDOP = (float)TM_GPS_INT_Data.HDOPE2 * 0.01f;
+			GPS_Data->VDOP = (float)TM_GPS_INT_Data.VDOPE2 * 0.01f;
+			for (i = 0; i < 12; i++) {
+				GPS_Data->SatelliteIDs[i] = TM_GPS_INT_Data.SatelliteIDs[i];
+			}
 		}
 #endif
 #ifndef GPS_DISABLE_GPGSV
-		GPS_Data->SatellitesInView = TM_GPS_INT_Data.SatellitesInView;
-		for (i = 0; i < GPS_MAX_SATS_IN_VIEW; i++) {
-			GPS_Data->SatDesc[i] = TM_GPS_INT_Data.SatDesc[i];
+		if (GPS_Flags & GPS_FLAG_SATSDESC) {			/* Only from GPGSV */
+			GPS_Data->SatellitesInView = TM_GPS_INT_Data.SatellitesInView;
+			for (i = 0; i < GPS_MAX_SATS_IN_VIEW; i++) {
+				GPS_Data->SatDesc[i] = TM_GPS_INT_Data.SatDesc[i];
+			}
 		}
 #endif
 		TM_GPS_INT_ReturnWithStatus(GPS_Data, TM_GPS_Result_NewData);	/* Return new data */
@@ -657,23 +858,65 @@ TM_GPS_Result_t TM_GPS_INT_Return(TM_GPS_t* GPS_Data) {
 	TM_GPS_INT_ReturnWithStatus(GPS_Data, TM_GPS_Result_OldData);	/* Return old data */
 }
 
-uint8_t TM_GPS_INT_StringStartsWith(char* string, const char* str) {
-	while (*str) {
-		if (*str++ != *string++) {
-			return 0;
+uint32_t TM_GPS_INT_ParseUint(const char* str, uint8_t len) {
+	uint32_t val = 0;
+	while (len-- && GPS_IS_DIGIT(*str)) {
+		val = val * 10 + GPS_C2N(*str++);
+	}
+	return val;
+}
+
+int32_t TM_GPS_INT_ParseFixed(const char* str, uint8_t len, uint8_t decimals) {
+	const char* end = str + len;
+	int32_t val = 0;
+	uint8_t neg = 0;
+	
+	if (str < end && *str == '-') {
+		neg = 1;
+		str++;
+	}
+	/* Integer part */
+	while (str < end && GPS_IS_DIGIT(*str)) {
+		val = val * 10 + GPS_C2N(*str++);
+	}
+	/* Decimal part, cut or padded with zeros to selected number of decimals */
+	if (str < end && *str == '.') {
+		str++;
+	}
+	while (decimals--) {
+		val *= 10;
+		if (str < end && GPS_IS_DIGIT(*str)) {
+			val += GPS_C2N(*str++);
 		}
 	}
-	return 1;
+	return neg ? -val : val;
 }
 
-uint8_t TM_GPS_INT_Atoi(char* str, uint32_t* val) {
-	uint8_t count = 0;
-	*val = 0;
-	while (GPS_IS_DIGIT(*str)) {
-		*val = *val * 10 + GPS_C2N(*str++);
-		count++;
+int32_t TM_GPS_INT_ParseCoordinate(const char* str, uint8_t len) {
+	const char* end = str + len;
+	uint32_t deg = 0, min;
+	uint8_t i;
+	
+	/* (d)ddmm.mmmm format, degrees and minutes are together in integer part */
+	while (str < end && GPS_IS_DIGIT(*str)) {
+		deg = deg * 10 + GPS_C2N(*str++);
+	}
+	min = deg % 100;
+	deg /= 100;
+	
+	/* Minutes in units of 1e-7 */
+	if (str < end && *str == '.') {
+		str++;
 	}
-	return count;
+	for (i = 0; i < 7; i++) {
+		min *= 10;
+		if (str < end && GPS_IS_DIGIT(*str)) {
+			min += GPS_C2N(*str++);
+		}
+	}
+	
+	/* Degrees in units of 1e-7, rounded */
+	return (int32_t)(deg * 10000000 + (min + 30) / 60);
 }
 
 uint32_t TM_GPS_INT_Pow(uint8_t x, uint8_t y) {
@@ -696,7 +939,7 @@ uint8_t TM_GPS_INT_Hex2Dec(char c) {
 }
 
 uint8_t TM_GPS_INT_FlagsOk(TM_GPS_t* GPS_Data) {
-	if (GPS_Flags == GPS_Flags_OK) {					/* Check main flags */
+	if (GPS_Flags == GPS_Flags_OK || (GPS_Flags & GPS_FLAG_NAVPVT)) {	/* Check main flags, NAV-PVT is a set on its own */
 		uint8_t i;
 		for (i = 0; i < GPS_Data->CustomStatementsCount; i++) {	/* Check custom terms */
 			if (GPS_Data->CustomStatements[i]->Updated == 0) {	/* If not flag set */
@@ -716,52 +959,3 @@ void TM_GPS_INT_ClearFlags(TM_GPS_t* GPS_Data) {
 		GPS_Data->CustomStatements[i]->Updated = 0;		/* If not flag set */
 	}
 }
-
-void TM_GPS_INT_CheckEmpty(TM_GPS_t* GPS_Data) {
-	if (GPS_Term_Pos == 1) {
-		switch (GPS_CONCAT(TM_GPS_Statement, GPS_Term_Number)) {
-#ifndef GPS_DISABLE_GPGGA
-			case GPS_POS_LATITUDE: 	TM_GPS_INT_SetFlag(GPS_FLAG_LATITUDE); break;
-			case GPS_POS_NS: 		TM_GPS_INT_SetFlag(GPS_FLAG_NS); break;
-			case GPS_POS_LONGITUDE: TM_GPS_INT_SetFlag(GPS_FLAG_LONGITUDE); break;
-			case GPS_POS_EW: 		TM_GPS_INT_SetFlag(GPS_FLAG_EW); break;
-			case GPS_POS_SATS:		TM_GPS_INT_SetFlag(GPS_FLAG_SATS); break;
-			case GPS_POS_FIX: 		TM_GPS_INT_SetFlag(GPS_FLAG_FIX); break;
-			case GPS_POS_ALTITUDE: 	TM_GPS_INT_SetFlag(GPS_FLAG_ALTITUDE); break;
-			case GPS_POS_TIME: 		TM_GPS_INT_SetFlag(GPS_FLAG_TIME); break;
-#endif
-#ifndef GPS_DISABLE_GPRMC
-			case GPS_POS_SPEED: 	TM_GPS_INT_SetFlag(GPS_FLAG_SPEED); break;
-			case GPS_POS_DATE: 		TM_GPS_INT_SetFlag(GPS_FLAG_DATE); break;
-			case GPS_POS_VALIDITY: 	TM_GPS_INT_SetFlag(GPS_FLAG_VALIDITY); break;
-			case GPS_POS_DIRECTION: TM_GPS_INT_SetFlag(GPS_FLAG_DIRECTION); break;
-#endif
-#ifndef GPS_DISABLE_GPGSA
-			case GPS_POS_HDOP: 		TM_GPS_INT_SetFlag(GPS_FLAG_HDOP); break;
-			case GPS_POS_PDOP: 		TM_GPS_INT_SetFlag(GPS_FLAG_PDOP); break;
-			case GPS_POS_VDOP: 		TM_GPS_INT_SetFlag(GPS_FLAG_VDOP); break;
-			case GPS_POS_FIXMODE: 	TM_GPS_INT_SetFlag(GPS_FLAG_FIXMODE); break;
-
-			case GPS_POS_SAT1:
-			case GPS_POS_SAT2:
-			case GPS_POS_SAT3:
-			case GPS_POS_SAT4:
-			case GPS_POS_SAT5:
-			case GPS_POS_SAT6:
-			case GPS_POS_SAT7:
-			case GPS_POS_SAT8:
-			case GPS_POS_SAT9:
-			case GPS_POS_SAT10:
-			case GPS_POS_SAT11:
-			case GPS_POS_SAT12:
-				TM_GPS_INT_SetFlag(GPS_FLAG_SATS1_12);
-				break;
-#endif
-#ifndef GPS_DISABLE_GPGSV
-			case GPS_POS_SATSINVIEW: TM_GPS_INT_SetFlag(GPS_FLAG_SATSINVIEW); break;
-#endif
-			default: 
-				break;
-		}
-	}
-}
@@ -35,7 +35,7 @@
 \endverbatim
  */
 #ifndef TM_GPS_H
-#define TM_GPS_H 100
+#define TM_GPS_H 110
 
 /* C++ detection */
 #ifdef __cplusplus
@@ -62,6 +62,22 @@ extern C {
  * This library uses only 4. But some GPS don't returns all of this 4 sentences,
  * so I made a possibility to disable them.
  *
+ * Sentences are parsed whole at a time. Checksum is validated first and sentence is dropped when it fails,
+ * then sentence type is selected with one switch, independent of talker. Supported talkers are
+ * GP (GPS), GN (multi GNSS), GL (GLONASS), GA (Galileo) and BD/GB (BeiDou), so GGA statement below
+ * means any of $GPGGA, $GNGGA, $GLGGA, ...
+ *
+ * Numbers are converted in fixed point. Float members are still filled for compatibility,
+ * but fixed point members (for example LatitudeE7) have full receiver precision.
+ *
+ * \par UBX binary protocol
+ *
+ * u-blox receivers can output UBX NAV-PVT message (class 0x01, id 0x07), which carries position,
+ * velocity, time, fix and DOP in one 92 bytes long payload. When valid NAV-PVT frame is received,
+ * all GGA and RMC values (and PDOP) are updated at once and new data are reported, without waiting for GSA and GSV statements.
+ * HDOP, VDOP, satellite IDs and satellites in view are not in NAV-PVT, they keep values from last GSA and GSV.
+ * Other UBX frames are skipped. UBX and NMEA can be mixed on the same USART.
+ *
  * By default, these statements are in use and supported:
  *  - GPGGA: Global Positioning System Fix Data
  *     - Latitude
@@ -170,6 +186,13 @@ GPRMB_3_Pointer = TM_GPS_AddCustom(&GPS_Data, "$GPRMB", 3);
  * \par Changelog
  *
 \verbatim
+ Version 1.1
+  - Sentence at a time parser with checksum validation first
+  - Multi GNSS talkers (GP, GN, GL, GA, BD, GB)
+  - Fixed point values
+  - UBX NAV-PVT decoding
+  - Parser statistics
+  
  Version 1.0
   - First release
 \endverbatim
@@ -221,6 +244,30 @@ GPRMB_3_Pointer = TM_GPS_AddCustom(&GPS_Data, "$GPRMB", 3);
 #define GPS_USART_INIT(baudrate)    TM_USART_Init(GPS_USART, GPS_USART_PINSPACK, baudrate)
 #endif
 
+/* Receive GPS data with circular DMA instead of RXNE interrupt per character */
+#ifndef GPS_USART_USE_DMA
+#define GPS_USART_USE_DMA           1
+#endif
+
+/* DMA buffer size for GPS USART, must be power of 2 */
+#ifndef GPS_USART_DMA_BUFFER_SIZE
+#define GPS_USART_DMA_BUFFER_SIZE   1024
+#endif
+
+/* Maximal length of one received line, used when line wraps around DMA buffer end. Must hold UBX NAV-PVT frame (100 bytes) */
+#ifndef GPS_SENTENCE_MAX_LENGTH
+#define GPS_SENTENCE_MAX_LENGTH     128
+#endif
+
+#if GPS_USART_USE_DMA
+#include "tm_stm32_usart_dma.h"
+#endif
+
+/* Maximal number of terms in one NMEA sentence, GPGSV has 20 */
+#ifndef GPS_MAX_TERMS
+#define GPS_MAX_TERMS               24
+#endif
+
 /* Maximum number of custom GPGxx values */
 #ifndef GPS_CUSTOM_NUMBER
 #define GPS_CUSTOM_NUMBER       10
@@ -315,6 +362,18 @@ typedef struct {
 	uint8_t SNR;       /*!< SNR, 00-99 dB (0 when not tracking) */
 } TM_GPS_Satellite_t;
 
+/**
+ * @brief  Parser statistics
+ */
+typedef struct {
+	uint32_t Sentences;      /*!< Number of NMEA sentences with valid checksum */
+	uint32_t ChecksumErrors; /*!< Number of NMEA sentences dropped because of wrong or missing checksum */
+	uint32_t Unknown;        /*!< Number of valid NMEA sentences with unsupported talker or type */
+	uint32_t UBXFrames;      /*!< Number of UBX frames with valid checksum */
+	uint32_t UBXErrors;      /*!< Number of UBX frames dropped because of wrong checksum or length */
+	uint32_t Overwritten;    /*!< Number of lines dropped because DMA wrote over them while they were parsed */
+} TM_GPS_Stats_t;
+
 /**
  * @brief  Custom NMEA statement and term, selected by user 
  */
@@ -334,6 +393,9 @@ typedef struct {
 	float Latitude;                                       /*!< Latitude position from GPS, -90 to 90 degrees response. */
 	float Longitude;                                      /*!< Longitude position from GPS, -180 to 180 degrees response. */
 	float Altitude;                                       /*!< Altitude above the seain units of meters */
+	int32_t LatitudeE7;                                   /*!< Latitude in units of 1e-7 degrees */
+	int32_t LongitudeE7;                                  /*!< Longitude in units of 1e-7 degrees */
+	int32_t AltitudeMM;                                   /*!< Altitude above the sea in units of millimeters */
 	uint8_t Satellites;                                   /*!< Number of satellites in use for GPS position. */
 	uint8_t Fix;                                          /*!< GPS fix; 0: Invalid; 1: GPS Fix; 2: DGPS Fix. */
 	TM_GPS_Time_t Time;                                   /*!< Current time from GPS. @ref TM_GPS_Time_t. */
@@ -343,11 +405,16 @@ typedef struct {
 	float Speed;                                          /*!< Speed in knots from GPS. */
 	uint8_t Validity;                                     /*!< GPS validation; 1: valid; 0: invalid. */
 	float Direction;                                      /*!< Course on the ground in relation to North. */
+	uint32_t SpeedMMS;                                    /*!< Speed over ground in units of mm/s */
+	uint16_t DirectionE2;                                 /*!< Course on the ground in units of 0.01 degree */
 #endif
 #ifndef GPS_DISABLE_GPGSA
 	float HDOP;                                           /*!< Horizontal dilution of precision. */
 	float PDOP;                                           /*!< Position dilution od precision. */
 	float VDOP;                                           /*!< Vertical dilution of precision. */
+	uint16_t HDOPE2;                                      /*!< Horizontal dilution of precision multiplied by 100 */
+	uint16_t PDOPE2;                                      /*!< Position dilution of precision multiplied by 100 */
+	uint16_t VDOPE2;                                      /*!< Vertical dilution of precision multiplied by 100 */
 	uint8_t FixMode;                                      /*!< Current fix mode in use:; 1: Fix not available; 2: 2D; 3: 3D. */
 	uint8_t SatelliteIDs[12];                             /*!< Array with IDs of satellites in use. 
 	                                                           Only first data are valid, so if you have 5 satellites in use, only SatelliteIDs[4:0] are valid */
@@ -360,6 +427,7 @@ typedef struct {
 	TM_GPS_Custom_t* CustomStatements[GPS_CUSTOM_NUMBER]; /*!< Array of pointers for custom GPS NMEA statements, selected by user.
 	                                                              You can use @ref GPS_CUSTOM_NUMBER number of custom statements */
 	uint8_t CustomStatementsCount;                        /*!< Number of custom GPS statements selected by user */
+	TM_GPS_Stats_t Stats;                                 /*!< Parser statistics */
 } TM_GPS_t;
 
 /* Backward compatibility */
@@ -410,6 +478,18 @@ void TM_GPS_Init(TM_GPS_t* GPS_Data, uint32_t baudrate);
  */
 TM_GPS_Result_t TM_GPS_Update(TM_GPS_t* GPS_Data);
 
+/**
+ * @brief  Update GPS data from one complete sentence
+ * @note   Used by @ref TM_GPS_Update() in DMA mode, but can be used also when sentences are received other way.
+ * @note   Data may contain more NMEA sentences and parts of UBX frames. UBX frame can be split over more calls,
+ *         as long as data are passed in the order they were received.
+ * @param  *GPS_Data: Pointer to working @ref TM_GPS_t structure
+ * @param  *Sentence: Pointer to sentence characters, does not need to be null terminated
+ * @param  Length: Number of characters in sentence
+ * @retval Returns value of @ref TM_GPS_Result_t structure
+ */
+TM_GPS_Result_t TM_GPS_UpdateSentence(TM_GPS_t* GPS_Data, const char* Sentence, uint16_t Length);
+
 /**
  * @brief  Converts speed in knots (from GPS) to user selectable speed
  * @param  speedInKnots: float value from GPS module
@@ -446,7 +526,7 @@ void TM_GPS_DistanceBetween(TM_GPS_Distance_t* Distance_Data);
  * @note   Also note, that your GPS receiver HAVE TO send statement type you use in this function, or 
  *            @ref TM_GPS_Update() function will always return that there is not data available to read.
  * @param  *GPS_Data: Pointer to working @ref TM_GPS_t structure
- * @param  *GPG_Statement: String of NMEA starting line address, including "$" at beginning
+ * @param  *GPG_Statement: String of NMEA starting line address, including "$" at beginning and talker, for example "$GNRMB"
  * @param  TermNumber: Position in NMEA statement
  * @retval Success status:
  *            - NULL: Malloc() failed or you reached limit of user selectable custom statements:
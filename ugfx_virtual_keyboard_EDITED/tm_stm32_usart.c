@@ -449,6 +449,15 @@ __weak void TM_USART_InitCustomPinsCallback(USART_TypeDef* USARTx, uint16_t Alte
 	*/
 }
 
+/************************************/
+/*      USART IDLE LINE CALLBACK    */
+/************************************/
+__weak void TM_USART_IdleLineCallback(USART_TypeDef* USARTx) { 
+	/* NOTE: This function Should not be modified, when the callback is needed,
+           the TM_USART_IdleLineCallback could be implemented in the user file
+	*/
+}
+
 /* Private functions */
 static void TM_USART_INT_InsertToBuffer(TM_BUFFER_t* u, uint8_t c) {
 	TM_BUFFER_Write(u, &c, 1);
@@ -853,7 +862,7 @@ void TM_USART8_InitPins(TM_USART_PinsPack_t pinspack) {
 #ifdef USART1
 void USART1_IRQHandler(void) {
 	/* Check if interrupt was because data is received */
-	if (USART1->USART_STATUS_REG & USART_ISR_RXNE) {
+	if ((USART1->CR1 & USART_CR1_RXNEIE) && (USART1->USART_STATUS_REG & USART_ISR_RXNE)) {
 #ifdef TM_USART1_USE_CUSTOM_IRQ
 		/* Call user function */
 		TM_USART1_ReceiveHandler(USART_READ_DATA(USART1));
@@ -863,6 +872,11 @@ void USART1_IRQHandler(void) {
 #endif
 	}
 	
+	/* Check if interrupt was because of IDLE line in DMA receive mode */
+	if ((USART1->CR1 & USART_CR1_IDLEIE) && (USART1->USART_STATUS_REG & USART_FLAG_IDLE)) {
+		TM_USART_IdleLineCallback(USART1);
+	}
+	
 	/* Clear all USART flags */
 	TM_USART_INT_ClearAllFlags(USART1, IRQ_USART1);
 }
@@ -871,7 +885,7 @@ void USART1_IRQHandler(void) {
 #ifdef USART2
 void USART2_IRQHandler(void) {
 	/* Check if interrupt was because data is received */
-	if (USART2->USART_STATUS_REG & USART_ISR_RXNE) {
+	if ((USART2->CR1 & USART_CR1_RXNEIE) && (USART2->USART_STATUS_REG & USART_ISR_RXNE)) {
 #ifdef TM_USART2_USE_CUSTOM_IRQ
 		/* Call user function */
 		TM_USART2_ReceiveHandler(USART_READ_DATA(USART2));
@@ -881,6 +895,11 @@ void USART2_IRQHandler(void) {
 #endif
 	}
 	
+	/* Check if interrupt was because of IDLE line in DMA receive mode */
+	if ((USART2->CR1 & USART_CR1_IDLEIE) && (USART2->USART_STATUS_REG & USART_FLAG_IDLE)) {
+		TM_USART_IdleLineCallback(USART2);
+	}
+	
 	/* Clear all USART flags */
 	TM_USART_INT_ClearAllFlags(USART2, IRQ_USART2);
 }
@@ -889,7 +908,7 @@ void USART2_IRQHandler(void) {
 #ifdef USART3
 void USART3_IRQHandler(void) {
 	/* Check if interrupt was because data is received */
-	if (USART3->USART_STATUS_REG & USART_ISR_RXNE) {
+	if ((USART3->CR1 & USART_CR1_RXNEIE) && (USART3->USART_STATUS_REG & USART_ISR_RXNE)) {
 #ifdef TM_USART3_USE_CUSTOM_IRQ
 		/* Call user function */
 		TM_USART3_ReceiveHandler(USART_READ_DATA(USART3));
@@ -899,6 +918,11 @@ void USART3_IRQHandler(void) {
 #endif
 	}
 	
+	/* Check if interrupt was because of IDLE line in DMA receive mode */
+	if ((USART3->CR1 & USART_CR1_IDLEIE) && (USART3->USART_STATUS_REG & USART_FLAG_IDLE)) {
+		TM_USART_IdleLineCallback(USART3);
+	}
+	
 	/* Clear all USART flags */
 	TM_USART_INT_ClearAllFlags(USART3, IRQ_USART3);
 }
@@ -907,7 +931,7 @@ void USART3_IRQHandler(void) {
 #ifdef UART4
 void UART4_IRQHandler(void) {
 	/* Check if interrupt was because data is received */
-	if (UART4->USART_STATUS_REG & USART_ISR_RXNE) {
+	if ((UART4->CR1 & USART_CR1_RXNEIE) && (UART4->USART_STATUS_REG & USART_ISR_RXNE)) {
 #ifdef TM_UART4_USE_CUSTOM_IRQ
 		/* Call user function */
 		TM_UART4_ReceiveHandler(USART_READ_DATA(UART4));
@@ -917,6 +941,11 @@ void UART4_IRQHandler(void) {
 #endif
 	}
 	
+	/* Check if interrupt was because of IDLE line in DMA receive mode */
+	if ((UART4->CR1 & USART_CR1_IDLEIE) && (UART4->USART_STATUS_REG & USART_FLAG_IDLE)) {
+		TM_USART_IdleLineCallback(UART4);
+	}
+	
 	/* Clear all USART flags */
 	TM_USART_INT_ClearAllFlags(UART4, IRQ_UART4);
 }
@@ -925,7 +954,7 @@ void UART4_IRQHandler(void) {
 #ifdef UART5
 void UART5_IRQHandler(void) {
 	/* Check if interrupt was because data is received */
-	if (UART5->USART_STATUS_REG & USART_ISR_RXNE) {
+	if ((UART5->CR1 & USART_CR1_RXNEIE) && (UART5->USART_STATUS_REG & USART_ISR_RXNE)) {
 #ifdef TM_UART5_USE_CUSTOM_IRQ
 		/* Call user function */
 		TM_UART5_ReceiveHandler(USART_READ_DATA(UART5));
@@ -935,6 +964,11 @@ void UART5_IRQHandler(void) {
 #endif
 	}
 	
+	/* Check if interrupt was because of IDLE line in DMA receive mode */
+	if ((UART5->CR1 & USART_CR1_IDLEIE) && (UART5->USART_STATUS_REG & USART_FLAG_IDLE)) {
+		TM_USART_IdleLineCallback(UART5);
+	}
+	
 	/* Clear all USART flags */
 	TM_USART_INT_ClearAllFlags(UART5, IRQ_UART5);
 }
@@ -943,7 +977,7 @@ void UART5_IRQHandler(void) {
 #ifdef USART6
 void USART6_IRQHandler(void) {
 	/* Check if interrupt was because data is received */
-	if (USART6->USART_STATUS_REG & USART_ISR_RXNE) {
+	if ((USART6->CR1 & USART_CR1_RXNEIE) && (USART6->USART_STATUS_REG & USART_ISR_RXNE)) {
 #ifdef TM_USART6_USE_CUSTOM_IRQ
 		/* Call user function */
 		TM_USART6_ReceiveHandler(USART_READ_DATA(USART6));
@@ -953,6 +987,11 @@ void USART6_IRQHandler(void) {
 #endif
 	}
 	
+	/* Check if interrupt was because of IDLE line in DMA receive mode */
+	if ((USART6->CR1 & USART_CR1_IDLEIE) && (USART6->USART_STATUS_REG & USART_FLAG_IDLE)) {
+		TM_USART_IdleLineCallback(USART6);
+	}
+	
 	/* Clear all USART flags */
 	TM_USART_INT_ClearAllFlags(USART6, IRQ_USART6);
 }
@@ -961,7 +1000,7 @@ void USART6_IRQHandler(void) {
 #ifdef UART7
 void UART7_IRQHandler(void) {
 	/* Check if interrupt was because data is received */
-	if (UART7->USART_STATUS_REG & USART_ISR_RXNE) {
+	if ((UART7->CR1 & USART_CR1_RXNEIE) && (UART7->USART_STATUS_REG & USART_ISR_RXNE)) {
 #ifdef TM_UART7_USE_CUSTOM_IRQ
 		/* Call user function */
 		TM_UART7_ReceiveHandler(USART_READ_DATA(UART7));
@@ -971,6 +1010,11 @@ void UART7_IRQHandler(void) {
 #endif
 	}
 	
+	/* Check if interrupt was because of IDLE line in DMA receive mode */
+	if ((UART7->CR1 & USART_CR1_IDLEIE) && (UART7->USART_STATUS_REG & USART_FLAG_IDLE)) {
+		TM_USART_IdleLineCallback(UART7);
+	}
+	
 	/* Clear all USART flags */
 	TM_USART_INT_ClearAllFlags(UART7, IRQ_UART7);
 }
@@ -979,7 +1023,7 @@ void UART7_IRQHandler(void) {
 #ifdef UART8
 void UART8_IRQHandler(void) {
 	/* Check if interrupt was because data is received */
-	if (UART8->USART_STATUS_REG & USART_ISR_RXNE) {
+	if ((UART8->CR1 & USART_CR1_RXNEIE) && (UART8->USART_STATUS_REG & USART_ISR_RXNE)) {
 #ifdef TM_UART8_USE_CUSTOM_IRQ
 		/* Call user function */
 		TM_UART8_ReceiveHandler(USART_READ_DATA(UART8));
@@ -989,6 +1033,11 @@ void UART8_IRQHandler(void) {
 #endif
 	}
 	
+	/* Check if interrupt was because of IDLE line in DMA receive mode */
+	if ((UART8->CR1 & USART_CR1_IDLEIE) && (UART8->USART_STATUS_REG & USART_FLAG_IDLE)) {
+		TM_USART_IdleLineCallback(UART8);
+	}
+	
 	/* Clear all USART flags */
 	TM_USART_INT_ClearAllFlags(UART8, IRQ_UART8);
 }
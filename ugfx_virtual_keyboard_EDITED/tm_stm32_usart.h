@@ -696,6 +696,16 @@ int16_t TM_USART_FindString(USART_TypeDef* USARTx, char* str);
  */
 void TM_USART_InitCustomPinsCallback(USART_TypeDef* USARTx, uint16_t AlternateFunction);
 
+/**
+ * @brief  Callback called from USARTx interrupt when IDLE line is detected and IDLE interrupt is enabled.
+ *
+ *         IDLE interrupt is only enabled when USART works in DMA receive mode, look at TM_USART_DMA extension.
+ * @note   With __weak parameter to prevent link errors if not defined by user
+ * @param  *USARTx: Pointer to USARTx peripheral where IDLE line was detected
+ * @retval None
+ */
+void TM_USART_IdleLineCallback(USART_TypeDef* USARTx);
+
 /**
  * @brief  Callback function for receive interrupt on USART1 in case you have enabled custom USART handler mode 
  * @note   With __weak parameter to prevent link errors if not defined by user
@@ -0,0 +1,449 @@
+/**
+ * |----------------------------------------------------------------------
+ * | Permission is hereby granted, free of charge, to any person
+ * | obtaining a copy of this software and associated documentation
+ * | files (the "Software"), to deal in the Software without restriction,
+ * | including without limitation the rights to use, copy, modify, merge,
+ * | publish, distribute, sublicense, and/or sell copies of the Software,
+ * | and to permit persons to whom the Software is furnished to do so,
+ * | subject to the following conditions:
+ * |
+ * | The above copyright notice and this permission notice shall be
+ * | included in all copies or substantial portions of the Software.
+ * |
+ * | THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * | EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * | OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * | AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * | HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * | WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * | FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * | OTHER DEALINGS IN THE SOFTWARE.
+ * |----------------------------------------------------------------------
+ */
+#include "tm_stm32_usart_dma.h"
+#include "string.h"
+
+#if defined(STM32F4xx) || defined(STM32F7xx)
+
+/* DMA stream used for USART receive */
+typedef struct {
+	USART_TypeDef* USARTx;
+	DMA_Stream_TypeDef* Stream;
+	uint32_t Channel;
+	IRQn_Type IRQ;
+} TM_USART_DMA_INT_Stream_t;
+
+static const TM_USART_DMA_INT_Stream_t TM_USART_DMA_INT_Streams[] = {
+#ifdef USART1
+	{USART1, DMA2_Stream2, DMA_CHANNEL_4, DMA2_Stream2_IRQn},
+#endif
+#ifdef USART2
+	{USART2, DMA1_Stream5, DMA_CHANNEL_4, DMA1_Stream5_IRQn},
+#endif
+#ifdef USART3
+	{USART3, DMA1_Stream1, DMA_CHANNEL_4, DMA1_Stream1_IRQn},
+#endif
+#ifdef UART4
+	{UART4,  DMA1_Stream2, DMA_CHANNEL_4, DMA1_Stream2_IRQn},
+#endif
+#ifdef UART5
+	{UART5,  DMA1_Stream0, DMA_CHANNEL_4, DMA1_Stream0_IRQn},
+#endif
+#ifdef USART6
+	{USART6, DMA2_Stream1, DMA_CHANNEL_5, DMA2_Stream1_IRQn},
+#endif
+#ifdef UART7
+	{UART7,  DMA1_Stream3, DMA_CHANNEL_5, DMA1_Stream3_IRQn},
+#endif
+#ifdef UART8
+	{UART8,  DMA1_Stream6, DMA_CHANNEL_5, DMA1_Stream6_IRQn},
+#endif
+};
+
+#define TM_USART_DMA_INT_STREAMS_COUNT    (sizeof(TM_USART_DMA_INT_Streams) / sizeof(TM_USART_DMA_INT_Streams[0]))
+
+/* Working structures */
+static TM_USART_DMA_t TM_USART_DMA_Instances[TM_USART_DMA_MAX_INSTANCES];
+
+/* Private functions */
+static const TM_USART_DMA_INT_Stream_t* TM_USART_DMA_INT_GetStream(USART_TypeDef* USARTx);
+static void TM_USART_DMA_INT_Process(TM_USART_DMA_t* d, uint8_t Flush);
+static void TM_USART_DMA_INT_AddSpan(TM_USART_DMA_t* d, uint32_t End);
+static uint8_t TM_USART_DMA_INT_Overwritten(TM_USART_DMA_t* d, uint32_t Start);
+
+#define TM_USART_DMA_INT_SPAN_MASK        (TM_USART_DMA_SPAN_COUNT - 1)
+
+TM_USART_DMA_t* TM_USART_DMA_Init(USART_TypeDef* USARTx, TM_USART_PinsPack_t pinspack, uint32_t baudrate, uint8_t* Buffer, uint16_t Size) {
+	const TM_USART_DMA_INT_Stream_t* s;
+	TM_USART_DMA_t* d;
+	uint8_t i;
+
+	/* Check if USART has DMA stream and buffer size is power of 2 */
+	s = TM_USART_DMA_INT_GetStream(USARTx);
+	if (s == NULL || Size < 2 || (Size & (Size - 1))) {
+		return NULL;
+	}
+
+	/* Reuse structure when USART is reinitialized, or get free one */
+	d = TM_USART_DMA_Get(USARTx);
+	for (i = 0; d == NULL && i < TM_USART_DMA_MAX_INSTANCES; i++) {
+		if (TM_USART_DMA_Instances[i].USARTx == NULL) {
+			d = &TM_USART_DMA_Instances[i];
+		}
+	}
+	if (d == NULL) {
+		return NULL;
+	}
+
+	/* Stop previous DMA transfer if any */
+	if (d->USARTx != NULL) {
+		TM_USART_DMA_DeInit(USARTx);
+	}
+
+	/* Init USART the same way as in interrupt mode */
+	TM_USART_Init(USARTx, pinspack, baudrate);
+
+	/* Data will be taken by DMA, no RXNE interrupt anymore */
+	USARTx->CR1 &= ~USART_CR1_RXNEIE;
+
+	/* Fill working structure */
+	memset(d, 0, sizeof(TM_USART_DMA_t));
+	d->Buffer = Buffer;
+	d->Size = Size;
+	d->StringDelimiter = USART_STRING_DELIMITER;
+
+	/* Enable DMA clock */
+	if ((uint32_t)s->Stream >= (uint32_t)DMA2_Stream0) {
+		__HAL_RCC_DMA2_CLK_ENABLE();
+	} else {
+		__HAL_RCC_DMA1_CLK_ENABLE();
+	}
+
+	/* Init DMA stream in circular mode */
+	d->DMA_Handle.Instance = s->Stream;
+	d->DMA_Handle.Init.Channel = s->Channel;
+	d->DMA_Handle.Init.Direction = DMA_PERIPH_TO_MEMORY;
+	d->DMA_Handle.Init.PeriphInc = DMA_PINC_DISABLE;
+	d->DMA_Handle.Init.MemInc = DMA_MINC_ENABLE;
+	d->DMA_Handle.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+	d->DMA_Handle.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+	d->DMA_Handle.Init.Mode = DMA_CIRCULAR;
+	d->DMA_Handle.Init.Priority = DMA_PRIORITY_MEDIUM;
+	d->DMA_Handle.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+	d->DMA_Handle.Init.MemBurst = DMA_MBURST_SINGLE;
+	d->DMA_Handle.Init.PeriphBurst = DMA_PBURST_SINGLE;
+	if (HAL_DMA_Init(&d->DMA_Handle) != HAL_OK) {
+		USARTx->CR1 |= USART_CR1_RXNEIE;
+		return NULL;
+	}
+
+	/* Structure is valid for interrupts from now on */
+	d->USARTx = USARTx;
+
+	/* Set DMA stream NVIC */
+	HAL_NVIC_SetPriority(s->IRQ, USART_DMA_NVIC_PRIORITY, 0);
+	HAL_NVIC_ClearPendingIRQ(s->IRQ);
+	HAL_NVIC_EnableIRQ(s->IRQ);
+
+	/* Start DMA and enable half transfer and transfer complete interrupts */
+	HAL_DMA_Start(&d->DMA_Handle, (uint32_t)&USART_READ_DATA(USARTx), (uint32_t)Buffer, Size);
+	__HAL_DMA_ENABLE_IT(&d->DMA_Handle, DMA_IT_HT | DMA_IT_TC);
+
+	/* Enable DMA request and IDLE line interrupt on USART */
+	USARTx->CR3 |= USART_CR3_DMAR;
+	USARTx->CR1 |= USART_CR1_IDLEIE;
+
+	return d;
+}
+
+void TM_USART_DMA_DeInit(USART_TypeDef* USARTx) {
+	const TM_USART_DMA_INT_Stream_t* s;
+	TM_USART_DMA_t* d;
+
+	/* Get working structure */
+	d = TM_USART_DMA_Get(USARTx);
+	s = TM_USART_DMA_INT_GetStream(USARTx);
+	if (d == NULL || s == NULL) {
+		return;
+	}
+
+	/* Disable IDLE interrupt and DMA request */
+	USARTx->CR1 &= ~USART_CR1_IDLEIE;
+	USARTx->CR3 &= ~USART_CR3_DMAR;
+
+	/* Stop DMA */
+	HAL_NVIC_DisableIRQ(s->IRQ);
+	HAL_DMA_Abort(&d->DMA_Handle);
+	HAL_DMA_DeInit(&d->DMA_Handle);
+
+	/* Free structure */
+	d->USARTx = NULL;
+
+	/* Go back to RXNE interrupt mode */
+	USARTx->CR1 |= USART_CR1_RXNEIE;
+}
+
+TM_USART_DMA_t* TM_USART_DMA_Get(USART_TypeDef* USARTx) {
+	uint8_t i;
+
+	for (i = 0; i < TM_USART_DMA_MAX_INSTANCES; i++) {
+		if (TM_USART_DMA_Instances[i].USARTx == USARTx) {
+			return &TM_USART_DMA_Instances[i];
+		}
+	}
+	return NULL;
+}
+
+uint8_t TM_USART_DMA_GetSentence(USART_TypeDef* USARTx, TM_USART_DMA_Sentence_t* Sentence, uint8_t* Linear, uint16_t LinearSize) {
+	TM_USART_DMA_t* d;
+	TM_USART_DMA_Span_t span;
+	uint32_t offset, first;
+
+	/* Get working structure */
+	d = TM_USART_DMA_Get(USARTx);
+	if (d == NULL) {
+		return 0;
+	}
+
+	while (d->SpanOut != d->SpanIn) {
+		/* Look at span, it stays in queue until it is handed out whole */
+		span = d->Spans[d->SpanOut];
+
+		/* Check if DMA already wrote over this line */
+		if (TM_USART_DMA_INT_Overwritten(d, span.Start)) {
+			d->SpanOut = (d->SpanOut + 1) & TM_USART_DMA_INT_SPAN_MASK;
+			d->Overruns++;
+			continue;
+		}
+
+		offset = span.Start & (d->Size - 1);
+		first = d->Size - offset;
+		if (span.Length <= first) {
+			/* Line is contiguous, use data directly from DMA buffer */
+			d->SpanOut = (d->SpanOut + 1) & TM_USART_DMA_INT_SPAN_MASK;
+			Sentence->Data = &d->Buffer[offset];
+			Sentence->Length = span.Length;
+			Sentence->Copied = 0;
+			Sentence->Start = span.Start;
+			return 1;
+		}
+
+		/* Line wraps and does not fit linear buffer (binary data), hand out part up to buffer end, rest on next call */
+		if (Linear == NULL || span.Length > LinearSize) {
+			d->Spans[d->SpanOut].Start = span.Start + first;
+			d->Spans[d->SpanOut].Length = span.Length - first;
+			Sentence->Data = &d->Buffer[offset];
+			Sentence->Length = first;
+			Sentence->Copied = 0;
+			Sentence->Start = span.Start;
+			return 1;
+		}
+
+		/* Line wraps around buffer end, copy it to linear buffer */
+		d->SpanOut = (d->SpanOut + 1) & TM_USART_DMA_INT_SPAN_MASK;
+		memcpy(Linear, &d->Buffer[offset], first);
+		memcpy(&Linear[first], d->Buffer, span.Length - first);
+
+		/* DMA could write over line while it was copied */
+		if (TM_USART_DMA_INT_Overwritten(d, span.Start)) {
+			d->Overruns++;
+			continue;
+		}
+		Sentence->Data = Linear;
+		Sentence->Length = span.Length;
+		Sentence->Copied = 1;
+		Sentence->Start = span.Start;
+		return 1;
+	}
+
+	/* Nothing available */
+	return 0;
+}
+
+uint8_t TM_USART_DMA_SentenceValid(USART_TypeDef* USARTx, const TM_USART_DMA_Sentence_t* Sentence) {
+	TM_USART_DMA_t* d;
+
+	/* Copied line can not be overwritten */
+	if (Sentence->Copied) {
+		return 1;
+	}
+
+	d = TM_USART_DMA_Get(USARTx);
+	if (d == NULL || TM_USART_DMA_INT_Overwritten(d, Sentence->Start)) {
+		if (d != NULL) {
+			d->Overruns++;
+		}
+		return 0;
+	}
+	return 1;
+}
+
+uint16_t TM_USART_DMA_SentenceCount(USART_TypeDef* USARTx) {
+	TM_USART_DMA_t* d;
+
+	d = TM_USART_DMA_Get(USARTx);
+	if (d == NULL) {
+		return 0;
+	}
+	return (d->SpanIn - d->SpanOut) & TM_USART_DMA_INT_SPAN_MASK;
+}
+
+void TM_USART_DMA_SetCustomStringEndCharacter(USART_TypeDef* USARTx, uint8_t Character) {
+	TM_USART_DMA_t* d;
+
+	d = TM_USART_DMA_Get(USARTx);
+	if (d != NULL) {
+		d->StringDelimiter = Character;
+	}
+}
+
+void TM_USART_DMA_IRQHandler(USART_TypeDef* USARTx) {
+	TM_USART_DMA_t* d;
+	DMA_HandleTypeDef* h;
+
+	d = TM_USART_DMA_Get(USARTx);
+	if (d == NULL) {
+		return;
+	}
+	h = &d->DMA_Handle;
+
+	/* Clear half transfer and transfer complete flags */
+	if (__HAL_DMA_GET_FLAG(h, __HAL_DMA_GET_HT_FLAG_INDEX(h))) {
+		__HAL_DMA_CLEAR_FLAG(h, __HAL_DMA_GET_HT_FLAG_INDEX(h));
+	}
+	if (__HAL_DMA_GET_FLAG(h, __HAL_DMA_GET_TC_FLAG_INDEX(h))) {
+		__HAL_DMA_CLEAR_FLAG(h, __HAL_DMA_GET_TC_FLAG_INDEX(h));
+	}
+
+	/* Clear error flags, circular transfer continues */
+	__HAL_DMA_CLEAR_FLAG(h, __HAL_DMA_GET_TE_FLAG_INDEX(h) | __HAL_DMA_GET_FE_FLAG_INDEX(h) | __HAL_DMA_GET_DME_FLAG_INDEX(h));
+
+	/* Scan new data */
+	TM_USART_DMA_INT_Process(d, 0);
+}
+
+/************************************/
+/*    USART IDLE LINE CALLBACK      */
+/************************************/
+void TM_USART_IdleLineCallback(USART_TypeDef* USARTx) {
+	TM_USART_DMA_t* d;
+
+	/* Sender finished burst, scan data which did not reach half or end of buffer and hand out what is after last delimiter */
+	d = TM_USART_DMA_Get(USARTx);
+	if (d != NULL) {
+		TM_USART_DMA_INT_Process(d, 1);
+	}
+}
+
+/************************************/
+/*    USART DMA SENTENCE CALLBACK   */
+/************************************/
+__weak void TM_USART_DMA_SentenceCallback(USART_TypeDef* USARTx) {
+	/* NOTE: This function Should not be modified, when the callback is needed,
+           the TM_USART_DMA_SentenceCallback could be implemented in the user file
+	*/
+}
+
+/* DMA stream interrupt handlers, streams which are not shared with BSP */
+#ifdef USART1
+void DMA2_Stream2_IRQHandler(void) {
+	TM_USART_DMA_IRQHandler(USART1);
+}
+#endif
+#ifdef USART2
+void DMA1_Stream5_IRQHandler(void) {
+	TM_USART_DMA_IRQHandler(USART2);
+}
+#endif
+#ifdef USART3
+void DMA1_Stream1_IRQHandler(void) {
+	TM_USART_DMA_IRQHandler(USART3);
+}
+#endif
+#ifdef USART6
+void DMA2_Stream1_IRQHandler(void) {
+	TM_USART_DMA_IRQHandler(USART6);
+}
+#endif
+
+/* Private functions */
+static const TM_USART_DMA_INT_Stream_t* TM_USART_DMA_INT_GetStream(USART_TypeDef* USARTx) {
+	uint8_t i;
+
+	for (i = 0; i < TM_USART_DMA_INT_STREAMS_COUNT; i++) {
+		if (TM_USART_DMA_INT_Streams[i].USARTx == USARTx) {
+			return &TM_USART_DMA_INT_Streams[i];
+		}
+	}
+	return NULL;
+}
+
+static void TM_USART_DMA_INT_Process(TM_USART_DMA_t* d, uint8_t Flush) {
+	uint16_t pos, end;
+	uint8_t* found;
+	uint8_t added = d->SpanIn;
+
+	d->Interrupts++;
+
+	/* Current DMA write position */
+	pos = (d->Size - __HAL_DMA_GET_COUNTER(&d->DMA_Handle)) & (d->Size - 1);
+
+	/* Scan contiguous parts of new data for delimiter */
+	while (d->Position != pos) {
+		end = pos > d->Position ? pos : d->Size;
+		found = memchr(&d->Buffer[d->Position], d->StringDelimiter, end - d->Position);
+		if (found != NULL) {
+			end = (uint16_t)(found - d->Buffer) + 1;
+			d->Received += end - d->Position;
+			TM_USART_DMA_INT_AddSpan(d, d->Received);
+		} else {
+			d->Received += end - d->Position;
+		}
+		d->Position = end & (d->Size - 1);
+	}
+
+	/* Line is over when sender goes quiet, binary frames (UBX) have no delimiter to end them */
+	if (Flush && d->Received != d->LineStart) {
+		TM_USART_DMA_INT_AddSpan(d, d->Received);
+	}
+
+	/* Wake up user */
+	if (added != d->SpanIn) {
+		TM_USART_DMA_SentenceCallback(d->USARTx);
+	}
+}
+
+static void TM_USART_DMA_INT_AddSpan(TM_USART_DMA_t* d, uint32_t End) {
+	uint8_t next = (d->SpanIn + 1) & TM_USART_DMA_INT_SPAN_MASK;
+
+	/* Line is longer than buffer or thread is too slow */
+	if ((End - d->LineStart) > d->Size || next == d->SpanOut) {
+		d->Overruns++;
+	} else {
+		d->Spans[d->SpanIn].Start = d->LineStart;
+		d->Spans[d->SpanIn].Length = End - d->LineStart;
+		d->SpanIn = next;
+		d->Lines++;
+	}
+
+	/* Next line starts after delimiter */
+	d->LineStart = End;
+}
+
+static uint8_t TM_USART_DMA_INT_Overwritten(TM_USART_DMA_t* d, uint32_t Start) {
+	uint16_t position;
+	uint32_t written;
+
+	/* Position is read before Received, interrupt between them can only make count bigger */
+	position = *(volatile uint16_t *)&d->Position;
+	written = *(volatile uint32_t *)&d->Received;
+
+	/* Number of bytes DMA wrote until now, including bytes not scanned yet */
+	written += (d->Size - __HAL_DMA_GET_COUNTER(&d->DMA_Handle) - position) & (d->Size - 1);
+
+	/* First character is overwritten when DMA wrote whole buffer after it */
+	return (written - Start) > d->Size;
+}
+
+#endif /* STM32F4xx || STM32F7xx */
@@ -0,0 +1,290 @@
+/**
+ * @version v1.0
+ * @ide     Keil uVision
+ * @license MIT
+ * @brief   USART DMA receive extension for TM USART library
+ *
+\verbatim
+   ----------------------------------------------------------------------
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without restriction,
+    including without limitation the rights to use, copy, modify, merge,
+    publish, distribute, sublicense, and/or sell copies of the Software,
+    and to permit persons to whom the Software is furnished to do so,
+    subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+    AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+   ----------------------------------------------------------------------
+\endverbatim
+ */
+#ifndef TM_USART_DMA_H
+#define TM_USART_DMA_H 100
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @addtogroup TM_STM32Fxxx_HAL_Libraries
+ * @{
+ */
+
+/**
+ * @defgroup TM_USART_DMA
+ * @brief    USART receive with circular DMA and IDLE line detection
+ * @{
+ *
+ * Default @ref TM_USART library receives every byte in RXNE interrupt and stores it into cyclic buffer.
+ * For streaming peripherals (GPS receivers at 115200 bauds and 10Hz update rate) this means one interrupt per byte.
+ *
+ * This extension receives data into user supplied cyclic buffer with DMA in circular mode.
+ * CPU is only interrupted on:
+ *  - DMA half transfer: first half of buffer is full
+ *  - DMA transfer complete: second half of buffer is full, DMA wraps to start
+ *  - USART IDLE line: sender stopped sending, burst of data is finished
+ *
+ * On each of these events, new data are scanned for string delimiter (LF by default).
+ * On IDLE line, data after last delimiter are a line too, so binary frames without delimiter are not held back.
+ * Each detected line is stored as span (offset and length) inside DMA buffer into small span queue
+ * and @ref TM_USART_DMA_SentenceCallback() is called, so thread can be woken up.
+ *
+ * With @ref TM_USART_DMA_GetSentence() function, thread gets pointer directly to DMA buffer when line does not wrap around buffer end.
+ * Only lines which wrap around are copied into user linear buffer.
+ * Wrapping lines longer than linear buffer are returned in two parts, up to buffer end and rest.
+ *
+ * DMA keeps writing while thread parses a line in place. Call @ref TM_USART_DMA_SentenceValid() after the line
+ * is processed and discard the result when DMA has written over the line meanwhile.
+ *
+ * @note  Buffer must be big enough that DMA does not overwrite lines before thread processes them.
+ *        Number of overwritten lines is available in @ref TM_USART_DMA_t structure.
+ *
+ * \par DMA streams
+ *
+\verbatim
+U(S)ARTX     |DMA    STREAM  CHANNEL
+USART1       |DMA2   2       4
+USART2       |DMA1   5       4
+USART3       |DMA1   1       4
+UART4        |DMA1   2       4
+UART5        |DMA1   0       4
+USART6       |DMA2   1       5
+UART7        |DMA1   3       5
+UART8        |DMA1   6       5
+\endverbatim
+ *
+ * DMA stream interrupt handlers are implemented for USART1, USART2, USART3 and USART6.
+ * Other streams are shared with BSP drivers (audio), so you have to call @ref TM_USART_DMA_IRQHandler()
+ * from your own stream interrupt handler.
+ *
+ * @note  Only STM32F4xx and STM32F7xx are supported.
+ *
+ * \par Changelog
+ *
+\verbatim
+ Version 1.0
+  - First release
+\endverbatim
+ *
+ * \par Dependencies
+ *
+\verbatim
+ - STM32Fxxx HAL
+ - STM32Fxxx HAL DMA
+ - TM USART
+\endverbatim
+ */
+#include "stm32fxxx_hal.h"
+#include "tm_stm32_usart.h"
+
+/**
+ * @defgroup TM_USART_DMA_Macros
+ * @brief    Library defines
+ * @{
+ */
+
+/* Number of detected lines which can wait for thread, must be power of 2 */
+#ifndef TM_USART_DMA_SPAN_COUNT
+#define TM_USART_DMA_SPAN_COUNT             16
+#endif
+
+/* Maximal number of USARTs which can work in DMA mode at a time */
+#ifndef TM_USART_DMA_MAX_INSTANCES
+#define TM_USART_DMA_MAX_INSTANCES          2
+#endif
+
+/* NVIC priority for DMA stream interrupts */
+#ifndef USART_DMA_NVIC_PRIORITY
+#define USART_DMA_NVIC_PRIORITY             USART_NVIC_PRIORITY
+#endif
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup TM_USART_DMA_Typedefs
+ * @brief    Library Typedefs
+ * @{
+ */
+
+/**
+ * @brief  Detected line inside DMA buffer
+ */
+typedef struct {
+	uint32_t Start;  /*!< Absolute position of first character, counted from DMA start */
+	uint16_t Length; /*!< Number of characters, including delimiter */
+} TM_USART_DMA_Span_t;
+
+/**
+ * @brief  Line returned to user
+ */
+typedef struct {
+	const uint8_t* Data; /*!< Pointer to first character, points either to DMA buffer or to user linear buffer */
+	uint16_t Length;     /*!< Number of characters, including delimiter */
+	uint8_t Copied;      /*!< Set to 1 when line wrapped around end of DMA buffer and was copied to user buffer */
+	uint32_t Start;      /*!< Absolute position of first character, used by @ref TM_USART_DMA_SentenceValid() */
+} TM_USART_DMA_Sentence_t;
+
+/**
+ * @brief  USART DMA working structure
+ */
+typedef struct {
+	USART_TypeDef* USARTx;                              /*!< USART peripheral */
+	DMA_HandleTypeDef DMA_Handle;                       /*!< HAL DMA handle */
+	uint8_t* Buffer;                                    /*!< Pointer to DMA cyclic buffer */
+	uint16_t Size;                                      /*!< Size of DMA cyclic buffer in units of bytes */
+	uint16_t Position;                                  /*!< Position in buffer up to which data were already scanned */
+	uint32_t Received;                                  /*!< Total number of received bytes */
+	uint32_t LineStart;                                 /*!< Absolute position of current line start */
+	uint8_t StringDelimiter;                            /*!< Line delimiter character */
+	TM_USART_DMA_Span_t Spans[TM_USART_DMA_SPAN_COUNT]; /*!< Queue of detected lines */
+	volatile uint8_t SpanIn;                            /*!< Span queue input index, written in interrupt only */
+	volatile uint8_t SpanOut;                           /*!< Span queue output index, written in thread only */
+	uint32_t Interrupts;                                /*!< Number of DMA and IDLE interrupts */
+	uint32_t Lines;                                     /*!< Number of detected lines */
+	uint32_t Overruns;                                  /*!< Number of lines lost, because span queue was full or DMA overwrote them */
+} TM_USART_DMA_t;
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup TM_USART_DMA_Functions
+ * @brief    Library Functions
+ * @{
+ */
+
+/**
+ * @brief  Initializes USARTx and starts reception in circular DMA mode
+ * @note   RXNE interrupt is disabled and internal USART buffer is not used anymore for this USART
+ * @param  *USARTx: Pointer to USARTx peripheral you will use
+ * @param  pinspack: This parameter can be a value of @ref TM_USART_PinsPack_t enumeration
+ * @param  baudrate: Baudrate number for USART communication
+ * @param  *Buffer: Pointer to DMA buffer. It must stay valid all the time DMA is working
+ * @param  Size: Size of buffer in units of bytes. Must be power of 2
+ * @retval Pointer to @ref TM_USART_DMA_t structure or NULL if USART has no DMA stream or no instance is free
+ */
+TM_USART_DMA_t* TM_USART_DMA_Init(USART_TypeDef* USARTx, TM_USART_PinsPack_t pinspack, uint32_t baudrate, uint8_t* Buffer, uint16_t Size);
+
+/**
+ * @brief  Stops DMA reception and returns USART to RXNE interrupt mode
+ * @param  *USARTx: Pointer to USARTx peripheral you will use
+ * @retval None
+ */
+void TM_USART_DMA_DeInit(USART_TypeDef* USARTx);
+
+/**
+ * @brief  Gets working structure for USARTx
+ * @param  *USARTx: Pointer to USARTx peripheral
+ * @retval Pointer to @ref TM_USART_DMA_t structure or NULL if USARTx does not work in DMA mode
+ */
+TM_USART_DMA_t* TM_USART_DMA_Get(USART_TypeDef* USARTx);
+
+/**
+ * @brief  Gets next complete line received on USARTx
+ * @note   When line is contiguous in DMA buffer, pointer to DMA buffer is returned and nothing is copied.
+ *         DMA can write over them while they are processed, check them with @ref TM_USART_DMA_SentenceValid() afterwards.
+ * @param  *USARTx: Pointer to USARTx peripheral
+ * @param  *Sentence: Pointer to @ref TM_USART_DMA_Sentence_t structure to fill
+ * @param  *Linear: Pointer to buffer, used only when line wraps around end of DMA buffer
+ * @param  LinearSize: Size of linear buffer. Longer lines which wrap are returned in two parts
+ * @retval Line status:
+ *            - 0: No line available
+ *            - > 0: Line is available in Sentence structure
+ */
+uint8_t TM_USART_DMA_GetSentence(USART_TypeDef* USARTx, TM_USART_DMA_Sentence_t* Sentence, uint8_t* Linear, uint16_t LinearSize);
+
+/**
+ * @brief  Checks that line returned by @ref TM_USART_DMA_GetSentence() was not overwritten by DMA
+ * @note   Call it after line is processed. Copied lines are always valid.
+ *         Overwritten line is counted in Overruns member of @ref TM_USART_DMA_t structure
+ * @param  *USARTx: Pointer to USARTx peripheral
+ * @param  *Sentence: Pointer to @ref TM_USART_DMA_Sentence_t structure filled by @ref TM_USART_DMA_GetSentence()
+ * @retval Line status:
+ *            - 0: DMA wrote over line, data processed from it must be discarded
+ *            - > 0: Line is still intact
+ */
+uint8_t TM_USART_DMA_SentenceValid(USART_TypeDef* USARTx, const TM_USART_DMA_Sentence_t* Sentence);
+
+/**
+ * @brief  Gets number of lines waiting in span queue
+ * @param  *USARTx: Pointer to USARTx peripheral
+ * @retval Number of lines
+ */
+uint16_t TM_USART_DMA_SentenceCount(USART_TypeDef* USARTx);
+
+/**
+ * @brief  Sets custom character for line detection
+ * @param  *USARTx: Pointer to USARTx peripheral
+ * @param  Character: Character value to be used as line end
+ * @retval None
+ */
+void TM_USART_DMA_SetCustomStringEndCharacter(USART_TypeDef* USARTx, uint8_t Character);
+
+/**
+ * @brief  Processes DMA stream interrupt for USARTx
+ * @note   Call this from your DMA stream interrupt handler when handler is not implemented by library
+ * @param  *USARTx: Pointer to USARTx peripheral
+ * @retval None
+ */
+void TM_USART_DMA_IRQHandler(USART_TypeDef* USARTx);
+
+/**
+ * @brief  Callback called from interrupt when at least one new line is available
+ * @note   With __weak parameter to prevent link errors if not defined by user
+ * @param  *USARTx: Pointer to USARTx peripheral
+ * @retval None
+ */
+__weak void TM_USART_DMA_SentenceCallback(USART_TypeDef* USARTx);
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -14,6 +14,21 @@ char filename[24];
 TM_RTC_t fileTime;
 uint32_t fileSavedTime;
 
+// The boot thread starts the RTC while the GUI and the worker threads already run. A cold start
+// waits for the 32 kHz oscillator, until then the RTC is not touched and the last read time is used.
+static volatile bool rtcReady;
+static TM_RTC_t rtcLast;
+
+void setRTCReady(void)
+{
+	rtcReady = true;
+}
+
+bool isRTCReady(void)
+{
+	return rtcReady;
+}
+
 void deleteTraceFile(void)
 {
 	gfileDelete(filename);
@@ -53,6 +68,11 @@ void TRACE(const char *fmt, ...)
 {
 	TM_RTC_t rtcd;
 	osStatus status;
+	
+	// Nothing to write to until the boot thread has the RTC and SD card up
+	if(!rtcReady || myfile == NULL){
+		return;
+	}
 	status  = osMutexWait(traceMutex, 0);
 	if (status != osOK){
 		// handle failure code
@@ -95,36 +115,49 @@ int formatString(char *str, int sizeOfString, const char *format, ...)
 	return charcount;
 }
 
+// Not set while the RTC is starting, the caller gets an error and can try again later
 TM_RTC_Result_t updateRTC(TM_RTC_t* data, TM_RTC_Format_t format)
 {
 	osStatus status;
+	TM_RTC_Result_t result;
+	if(!rtcReady){
+		return TM_RTC_Result_Error;
+	}
 	status  = osMutexWait(traceMutex, 0);
 	if (status != osOK){
 		// handle failure code
 	}
 	
-	TM_RTC_SetDateTime(data, format);
+	result = TM_RTC_SetDateTime(data, format);
 	
 	status = osMutexRelease(traceMutex);
 	if (status != osOK)  {
 		// handle failure code
 	}	
+	return result;
 }
 
+// While the RTC is starting the last read time is given with an error, all callers read BIN
 TM_RTC_Result_t getRTC(TM_RTC_t* data, TM_RTC_Format_t format)
 {
 	osStatus status;
+	if(!rtcReady){
+		*data = rtcLast;
+		return TM_RTC_Result_Error;
+	}
 	status  = osMutexWait(traceMutex, 0);
 	if (status != osOK){
 		// handle failure code
 	}
 	
 	TM_RTC_GetDateTime(data, format);
+	rtcLast = *data;
 	
 	status = osMutexRelease(traceMutex);
 	if (status != osOK)  {
 		// handle failure code
 	}	
+	return TM_RTC_Result_Ok;
 }
 
 void saveGPS(TM_GPS_Data_t* gpsData){
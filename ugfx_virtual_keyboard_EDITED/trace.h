@@ -22,6 +22,8 @@ typedef struct {
 	uint8_t Validity;																			/*!< GPS validation; 1: valid; 0: invalid. */
 } my_GPS;
 
+void setRTCReady(void);
+bool isRTCReady(void);
 void deleteTraceFile(void);
 void closeTraceFile(void);
 void openTraceFile(void);
@@ -0,0 +1,450 @@
+#include "track.h"
+#include "sdram.h"
+#include "stm32fxxx_hal.h"
+#include <math.h>
+
+#define TRACK_CHUNKS					((TRACK_MAX_POINTS + TRACK_CHUNK_POINTS - 1) / TRACK_CHUNK_POINTS)
+
+// Cohen-Sutherland outcodes against view
+#define TRACK_CLIP_LEFT				0x01
+#define TRACK_CLIP_RIGHT			0x02
+#define TRACK_CLIP_TOP				0x04
+#define TRACK_CLIP_BOTTOM			0x08
+
+typedef struct {
+	proj_world_t min;
+	proj_world_t max;
+} track_box_t;
+
+// Store lives in SDRAM, box c bounds segments starting at points c*TRACK_CHUNK_POINTS up to first point of next chunk
+static proj_world_t * const points = (proj_world_t *)SDRAM_TRACK_ADDR;
+static track_box_t * const boxes = (track_box_t *)(SDRAM_TRACK_ADDR + TRACK_MAX_POINTS * sizeof(proj_world_t));
+static uint32_t count;
+static uint32_t tolerance = TRACK_TOLERANCE;
+
+// Raw fixes after last stored point, replaced by one segment while they stay within tolerance
+static proj_world_t window[TRACK_WINDOW];
+static uint32_t windowCount;
+static proj_world_t lastRaw;
+
+// View of last full draw and how much of track is already on screen
+static proj_world_t viewOrigin;
+static uint8_t viewZoom;
+static coord_t viewCenterX, viewCenterY, viewX, viewY, viewCX, viewCY;
+static int16_t viewRotation;
+static int32_t viewRadius;				// Furthest corner of rotated view from marker, pixels
+static MatrixFixed2D viewMatrix;		// Rotation about marker applied after projection
+static bool viewValid;
+static uint32_t drawnCount;
+static proj_world_t drawnTail;
+
+static track_stats_t stats;
+
+osMutexDef(trackMutex);
+static osMutexId trackMutexID;
+
+static bool trackDeviates(const proj_world_t *a, const proj_world_t *b, const proj_world_t *pts, uint32_t n, uint32_t tol);
+static uint32_t trackSimplify(uint32_t n, uint32_t tol);
+static void trackStore(const proj_world_t *p);
+static void trackBox(uint32_t i);
+static void trackCompact(void);
+static bool trackBoxVisible(const track_box_t *box);
+static uint8_t trackOutcode(const proj_screen_t *p);
+static bool trackClip(proj_screen_t *a, proj_screen_t *b);
+static void trackLine(const proj_screen_t *a, const proj_screen_t *b);
+static void trackProject(const proj_world_t *in, proj_screen_t *out, uint32_t n);
+
+void trackInit(){
+	trackMutexID = osMutexCreate(osMutex(trackMutex));
+	stats.Tolerance = tolerance;
+}
+
+void trackClear(){
+	osMutexWait(trackMutexID, osWaitForever);
+	count = 0;
+	windowCount = 0;
+	drawnCount = 0;
+	tolerance = TRACK_TOLERANCE;
+	stats.Points = 0;
+	stats.Tolerance = tolerance;
+	osMutexRelease(trackMutexID);
+}
+
+void trackAddPoint(int32_t latE7, int32_t lonE7){
+	proj_world_t p;
+	float dx, dy;
+
+	projToWorld(latE7, lonE7, &p);
+
+	osMutexWait(trackMutexID, osWaitForever);
+	stats.RawPoints++;
+	if(count == 0){
+		trackStore(&p);
+		lastRaw = p;
+		drawnTail = p;
+		windowCount = 0;
+		stats.Points = count;
+		osMutexRelease(trackMutexID);
+		return;
+	}
+
+	// Radial distance filter, standing still should not fill the store
+	dx = (float)(int32_t)(p.x - lastRaw.x);
+	dy = (float)(int32_t)(p.y - lastRaw.y);
+	if(dx * dx + dy * dy < (float)TRACK_MIN_DISTANCE * TRACK_MIN_DISTANCE){
+		stats.Dropped++;
+		osMutexRelease(trackMutexID);
+		return;
+	}
+
+	// Sliding window simplification, previous fix is stored once a straight segment
+	// from last stored point to this fix no longer covers the fixes in between
+	if(windowCount == TRACK_WINDOW || (windowCount && trackDeviates(&points[count - 1], &p, window, windowCount, tolerance))){
+		trackStore(&window[windowCount - 1]);
+		windowCount = 0;
+	}
+	window[windowCount++] = p;
+	lastRaw = p;
+
+	stats.Points = count;
+	stats.Tolerance = tolerance;
+	osMutexRelease(trackMutexID);
+}
+
+void trackSetView(const proj_world_t *origin, uint8_t zoom, int16_t rotation, coord_t centerX, coord_t centerY, coord_t x, coord_t y, coord_t cx, coord_t cy){
+	MatrixFixed2D rot;
+	int32_t dx, dy;
+
+	osMutexWait(trackMutexID, osWaitForever);
+	viewOrigin = *origin;
+	viewZoom = zoom;
+	viewRotation = rotation;
+	if(rotation != 0){
+		// Same turn as map about marker: R * p + (C - R * C)
+		gmiscMatrixFixed2DApplyRotation(&rot, NULL, rotation);
+		gmiscMatrixFixed2DApplyTranslation(&viewMatrix, &rot, FIXED(centerX) - rot.a00 * centerX - rot.a01 * centerY,
+			FIXED(centerY) - rot.a10 * centerX - rot.a11 * centerY);
+		dx = x + cx - centerX > centerX - x ? x + cx - centerX : centerX - x;
+		dy = y + cy - centerY > centerY - y ? y + cy - centerY : centerY - y;
+		viewRadius = (int32_t)sqrtf((float)(dx * dx + dy * dy)) + 1;
+	}
+	viewCenterX = centerX;
+	viewCenterY = centerY;
+	viewX = x;
+	viewY = y;
+	viewCX = cx;
+	viewCY = cy;
+	viewValid = true;
+	osMutexRelease(trackMutexID);
+}
+
+void trackClearView(){
+	osMutexWait(trackMutexID, osWaitForever);
+	viewValid = false;
+	osMutexRelease(trackMutexID);
+}
+
+void trackDraw(){
+	proj_screen_t buf[TRACK_CHUNK_POINTS + 1];
+	proj_screen_t last;
+	coord_t clipX, clipY, clipCX, clipCY;
+	uint32_t c, k, first, n, start;
+
+	osMutexWait(trackMutexID, osWaitForever);
+	if(!viewValid || count == 0){
+		osMutexRelease(trackMutexID);
+		return;
+	}
+
+	start = HAL_GetTick();
+	stats.ChunksDrawn = 0;
+	stats.ChunksCulled = 0;
+	stats.SegmentsDrawn = 0;
+	// Clip set by the window manager is put back afterwards
+	gdispGetClip(&clipX, &clipY, &clipCX, &clipCY);
+	gdispSetClip(viewX, viewY, viewCX, viewCY);
+
+	for(c = 0; c < TRACK_CHUNKS; c++){
+		first = c * TRACK_CHUNK_POINTS;
+		if(first + 1 >= count){
+			break;
+		}
+		if(!trackBoxVisible(&boxes[c])){
+			stats.ChunksCulled++;
+			continue;
+		}
+		stats.ChunksDrawn++;
+
+		n = count - first;
+		if(n > TRACK_CHUNK_POINTS + 1){
+			n = TRACK_CHUNK_POINTS + 1;
+		}
+		trackProject(&points[first], buf, n);
+
+		// Points closer than a pixel at this zoom are skipped, last point joins next chunk
+		last = buf[0];
+		for(k = 1; k < n; k++){
+			if(k != n - 1 && buf[k].x - last.x <= 1 && last.x - buf[k].x <= 1 && buf[k].y - last.y <= 1 && last.y - buf[k].y <= 1){
+				continue;
+			}
+			trackLine(&last, &buf[k]);
+			last = buf[k];
+			stats.SegmentsDrawn++;
+		}
+	}
+
+	// Segment from last stored point to current position
+	trackProject(&points[count - 1], &buf[0], 1);
+	trackProject(&lastRaw, &buf[1], 1);
+	trackLine(&buf[0], &buf[1]);
+
+	drawnCount = count;
+	drawnTail = lastRaw;
+	gdispSetClip(clipX, clipY, clipCX, clipCY);
+
+	stats.LastDrawMS = HAL_GetTick() - start;
+	if(stats.LastDrawMS > stats.MaxDrawMS){
+		stats.MaxDrawMS = stats.LastDrawMS;
+	}
+	osMutexRelease(trackMutexID);
+}
+
+bool trackDrawNew(){
+	proj_screen_t a, b;
+	coord_t clipX, clipY, clipCX, clipCY;
+	uint32_t i;
+
+	osMutexWait(trackMutexID, osWaitForever);
+	if(!viewValid || count == 0 || (drawnCount == count && drawnTail.x == lastRaw.x && drawnTail.y == lastRaw.y)){
+		osMutexRelease(trackMutexID);
+		return false;
+	}
+
+	// Only segments added since last draw, from where drawing stopped through new stored points to current position
+	// Clip set by the window manager is put back afterwards
+	gdispGetClip(&clipX, &clipY, &clipCX, &clipCY);
+	gdispSetClip(viewX, viewY, viewCX, viewCY);
+	trackProject(&drawnTail, &a, 1);
+	for(i = drawnCount; i < count; i++){
+		trackProject(&points[i], &b, 1);
+		trackLine(&a, &b);
+		a = b;
+	}
+	trackProject(&lastRaw, &b, 1);
+	trackLine(&a, &b);
+	gdispSetClip(clipX, clipY, clipCX, clipCY);
+
+	drawnCount = count;
+	drawnTail = lastRaw;
+	osMutexRelease(trackMutexID);
+	return true;
+}
+
+void trackGetStats(track_stats_t *st){
+	osMutexWait(trackMutexID, osWaitForever);
+	*st = stats;
+	osMutexRelease(trackMutexID);
+}
+
+static bool trackDeviates(const proj_world_t *a, const proj_world_t *b, const proj_world_t *pts, uint32_t n, uint32_t tol){
+	float dx = (float)(int32_t)(b->x - a->x);
+	float dy = (float)(int32_t)(b->y - a->y);
+	float len2 = dx * dx + dy * dy;
+	float tol2 = (float)tol * tol;
+	float px, py, cross;
+	uint32_t i;
+
+	// Distance from line is |cross| / length, compared squared to avoid division
+	for(i = 0; i < n; i++){
+		px = (float)(int32_t)(pts[i].x - a->x);
+		py = (float)(int32_t)(pts[i].y - a->y);
+		if(len2 == 0.0f){
+			if(px * px + py * py > tol2){
+				return true;
+			}
+			continue;
+		}
+		cross = dx * py - dy * px;
+		if(cross * cross > tol2 * len2){
+			return true;
+		}
+	}
+	return false;
+}
+
+static uint32_t trackSimplify(uint32_t n, uint32_t tol){
+	proj_world_t anchor;
+	uint32_t i, start, out;
+
+	if(n < 3){
+		return n;
+	}
+
+	// Same sliding window as live simplification, done in place since output never passes input
+	anchor = points[0];
+	out = 1;
+	start = 1;
+	for(i = 2; i < n; i++){
+		if(i - start >= TRACK_WINDOW || trackDeviates(&anchor, &points[i], &points[start], i - start, tol)){
+			anchor = points[i - 1];
+			points[out++] = anchor;
+			start = i;
+		}
+	}
+	points[out++] = points[n - 1];
+	return out;
+}
+
+static void trackStore(const proj_world_t *p){
+	if(count == TRACK_MAX_POINTS){
+		trackCompact();
+	}
+	points[count] = *p;
+	trackBox(count);
+	count++;
+}
+
+static void trackBox(uint32_t i){
+	track_box_t *box = &boxes[i / TRACK_CHUNK_POINTS];
+	const proj_world_t *p = &points[i];
+
+	if(i % TRACK_CHUNK_POINTS == 0){
+		box->min = *p;
+		box->max = *p;
+		if(i == 0){
+			return;
+		}
+		// First point of chunk also ends last segment of previous chunk
+		box--;
+	}
+	if(p->x < box->min.x){
+		box->min.x = p->x;
+	}
+	if(p->x > box->max.x){
+		box->max.x = p->x;
+	}
+	if(p->y < box->min.y){
+		box->min.y = p->y;
+	}
+	if(p->y > box->max.y){
+		box->max.y = p->y;
+	}
+}
+
+static void trackCompact(){
+	uint32_t i;
+
+	do{
+		tolerance *= 2;
+		count = trackSimplify(count, tolerance);
+		stats.Compactions++;
+	}while(count > TRACK_MAX_POINTS * TRACK_COMPACT_PERCENT / 100);
+
+	for(i = 0; i < count; i++){
+		trackBox(i);
+	}
+
+	// Simplified store is close enough to what is on screen, keep drawing from tail
+	drawnCount = count;
+}
+
+static bool trackBoxVisible(const track_box_t *box){
+	int64_t scale = (int64_t)1 << PROJ_PIXEL_SHIFT(viewZoom);
+	int64_t margin = TRACK_LINE_WIDTH * scale;
+	int64_t left = (viewX - viewCenterX) * scale - margin;
+	int64_t right = (viewX + viewCX - viewCenterX) * scale + margin;
+	int64_t top = (viewY - viewCenterY) * scale - margin;
+	int64_t bottom = (viewY + viewCY - viewCenterY) * scale + margin;
+
+	// Rotated view shows anything within its furthest corner
+	if(viewRotation != 0){
+		left = top = -viewRadius * scale - margin;
+		right = bottom = viewRadius * scale + margin;
+	}
+
+	// Relative to view origin, so comparison does not depend on where world wraps
+	return (int32_t)(box->max.x - viewOrigin.x) >= left && (int32_t)(box->min.x - viewOrigin.x) <= right &&
+		(int32_t)(box->max.y - viewOrigin.y) >= top && (int32_t)(box->min.y - viewOrigin.y) <= bottom;
+}
+
+static uint8_t trackOutcode(const proj_screen_t *p){
+	uint8_t code = 0;
+
+	// View grown by line width so that clipped ends and their round caps stay off screen
+	if(p->x < viewX - TRACK_LINE_WIDTH){
+		code |= TRACK_CLIP_LEFT;
+	}else if(p->x > viewX + viewCX + TRACK_LINE_WIDTH){
+		code |= TRACK_CLIP_RIGHT;
+	}
+	if(p->y < viewY - TRACK_LINE_WIDTH){
+		code |= TRACK_CLIP_TOP;
+	}else if(p->y > viewY + viewCY + TRACK_LINE_WIDTH){
+		code |= TRACK_CLIP_BOTTOM;
+	}
+	return code;
+}
+
+static bool trackClip(proj_screen_t *a, proj_screen_t *b){
+	uint8_t ca = trackOutcode(a), cb = trackOutcode(b), c;
+	proj_screen_t *p;
+	int64_t dx, dy;
+	int32_t x, y;
+
+	while(ca | cb){
+		if(ca & cb){
+			return false;
+		}
+		// Move an outside end onto the edge it is beyond, 64 bit products as ends can be far off
+		p = ca ? a : b;
+		c = ca ? ca : cb;
+		dx = (int64_t)b->x - a->x;
+		dy = (int64_t)b->y - a->y;
+		if(c & TRACK_CLIP_TOP){
+			y = viewY - TRACK_LINE_WIDTH;
+			x = (int32_t)(a->x + dx * (y - a->y) / dy);
+		}else if(c & TRACK_CLIP_BOTTOM){
+			y = viewY + viewCY + TRACK_LINE_WIDTH;
+			x = (int32_t)(a->x + dx * (y - a->y) / dy);
+		}else if(c & TRACK_CLIP_LEFT){
+			x = viewX - TRACK_LINE_WIDTH;
+			y = (int32_t)(a->y + dy * (x - a->x) / dx);
+		}else{
+			x = viewX + viewCX + TRACK_LINE_WIDTH;
+			y = (int32_t)(a->y + dy * (x - a->x) / dx);
+		}
+		p->x = x;
+		p->y = y;
+		if(p == a){
+			ca = trackOutcode(a);
+		}else{
+			cb = trackOutcode(b);
+		}
+	}
+	return true;
+}
+
+static void trackLine(const proj_screen_t *a, const proj_screen_t *b){
+	proj_screen_t ca = *a, cb = *b;
+
+	// Only narrowed to coord_t once clipped to view, far points would wrap around
+	if(!trackClip(&ca, &cb)){
+		return;
+	}
+	gdispDrawThickLine((coord_t)ca.x, (coord_t)ca.y, (coord_t)cb.x, (coord_t)cb.y, TRACK_LINE_COLOR, TRACK_LINE_WIDTH, TRUE);
+}
+
+static void trackProject(const proj_world_t *in, proj_screen_t *out, uint32_t n){
+	int32_t x;
+	uint32_t i;
+
+	projToScreenBatch(in, out, n, &viewOrigin, viewZoom, viewCenterX, viewCenterY);
+	if(viewRotation == 0){
+		return;
+	}
+	// 64 bit products as points far off screen overflow gmiscMatrixFixed2DApplyToPoints
+	for(i = 0; i < n; i++){
+		x = out[i].x;
+		out[i].x = (int32_t)(((int64_t)x * viewMatrix.a00 + (int64_t)out[i].y * viewMatrix.a01 + viewMatrix.a02 + FIXED0_5) >> 16);
+		out[i].y = (int32_t)(((int64_t)x * viewMatrix.a10 + (int64_t)out[i].y * viewMatrix.a11 + viewMatrix.a12 + FIXED0_5) >> 16);
+	}
+}
@@ -0,0 +1,42 @@
+#ifndef _TRACK_H_
+#define _TRACK_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "gfx.h"
+#include "projection.h"
+
+// Distances are in world units of projection.h, one unit is about 9 mm at the equator
+#define TRACK_MAX_POINTS				16384		// Simplified points kept in SDRAM
+#define TRACK_CHUNK_POINTS			32			// Segments per culling bounding box
+#define TRACK_WINDOW						64			// Raw points one simplified segment can replace
+#define TRACK_MIN_DISTANCE			256			// About 2 m, closer fixes are dropped
+#define TRACK_TOLERANCE					128			// About 1 m, initial simplification tolerance
+#define TRACK_COMPACT_PERCENT		75			// Store is simplified down to this when full
+
+#define TRACK_LINE_WIDTH				4
+#define TRACK_LINE_COLOR				HTML2COLOR(0xE0342B)
+
+typedef struct {
+	uint32_t RawPoints;				// Fixes passed to track
+	uint32_t Dropped;					// Fixes closer than minimum distance
+	uint32_t Points;					// Points in store
+	uint32_t Compactions;			// Number of times store was simplified again
+	uint32_t Tolerance;				// Current simplification tolerance, world units
+	uint32_t ChunksDrawn;			// Last full draw
+	uint32_t ChunksCulled;		// Last full draw
+	uint32_t SegmentsDrawn;		// Last full draw
+	uint32_t LastDrawMS;			// Duration of last full draw
+	uint32_t MaxDrawMS;				// Longest full draw
+} track_stats_t;
+
+void trackInit(void);
+void trackClear(void);
+void trackAddPoint(int32_t latE7, int32_t lonE7);
+void trackSetView(const proj_world_t *origin, uint8_t zoom, int16_t rotation, coord_t centerX, coord_t centerY, coord_t x, coord_t y, coord_t cx, coord_t cy);
+void trackClearView(void);
+void trackDraw(void);
+bool trackDrawNew(void);
+void trackGetStats(track_stats_t *stats);
+
+#endif /* _TRACK_H_ */
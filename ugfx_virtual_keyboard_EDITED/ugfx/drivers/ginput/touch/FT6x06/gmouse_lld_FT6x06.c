@@ -18,6 +18,16 @@
 // Hardware definitions
 #include "ft6x06.h"
 
+// The board wakes the mouse from the controller's interrupt line rather than it being polled
+#ifndef GMOUSE_FT6x06_INTERRUPT
+	#define GMOUSE_FT6x06_INTERRUPT		FALSE
+#endif
+#if GMOUSE_FT6x06_INTERRUPT
+	#define GMOUSE_FT6x06_FLG_NOPOLL	GMOUSE_VFLG_NOPOLL
+#else
+	#define GMOUSE_FT6x06_FLG_NOPOLL	0
+#endif
+
 static bool_t MouseInit(GMouse* m, unsigned driverinstance) {
 	if (!init_board(m, driverinstance))
 		return FALSE;
@@ -105,9 +115,9 @@ const GMouseVMT const GMOUSE_DRIVER_VMT[1] = {{
 	{
 		GDRIVER_TYPE_TOUCH,
 		#if GMOUSE_FT6x06_SELF_CALIBRATE
-			GMOUSE_VFLG_TOUCH | GMOUSE_VFLG_ONLY_DOWN | GMOUSE_VFLG_POORUPDOWN,
+			GMOUSE_VFLG_TOUCH | GMOUSE_VFLG_ONLY_DOWN | GMOUSE_VFLG_POORUPDOWN | GMOUSE_FT6x06_FLG_NOPOLL,
 		#else
-			GMOUSE_VFLG_TOUCH | GMOUSE_VFLG_ONLY_DOWN | GMOUSE_VFLG_POORUPDOWN | GMOUSE_VFLG_CALIBRATE | GMOUSE_VFLG_CAL_TEST,
+			GMOUSE_VFLG_TOUCH | GMOUSE_VFLG_ONLY_DOWN | GMOUSE_VFLG_POORUPDOWN | GMOUSE_VFLG_CALIBRATE | GMOUSE_VFLG_CAL_TEST | GMOUSE_FT6x06_FLG_NOPOLL,
 		#endif
 		sizeof(GMouse) + GMOUSE_FT6x06_BOARD_DATA_SIZE,
 		_gmouseInitDriver,
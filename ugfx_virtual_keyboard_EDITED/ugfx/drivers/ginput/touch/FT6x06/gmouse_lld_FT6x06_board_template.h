@@ -25,6 +25,10 @@
 //			It requires the active area of the touch panel to exactly match the display size.
 #define GMOUSE_FT6x06_SELF_CALIBRATE			FALSE
 
+// Set this to TRUE if the board calls _gmouseWakeupI(m) when the controller's INT line goes active.
+//	The mouse is then only read after an interrupt and while a touch is down.
+#define GMOUSE_FT6x06_INTERRUPT					FALSE
+
 static bool_t init_board(GMouse* m, unsigned driverinstance) {
 }
 
@@ -1267,6 +1267,22 @@ void gdispGBlitArea(GDisplay *g, coord_t x, coord_t y, coord_t cx, coord_t cy, c
 		#endif
 		MUTEX_EXIT(g);
 	}
+
+	void gdispGGetClip(GDisplay *g, coord_t *x, coord_t *y, coord_t *cx, coord_t *cy) {
+		MUTEX_ENTER(g);
+		#if GDISP_HARDWARE_CLIP != TRUE
+			*x = g->clipx0;
+			*y = g->clipy0;
+			*cx = g->clipx1 - g->clipx0;
+			*cy = g->clipy1 - g->clipy0;
+		#else
+			// Hardware clipping keeps no copy of the area
+			*x = *y = 0;
+			*cx = g->g.Width;
+			*cy = g->g.Height;
+		#endif
+		MUTEX_EXIT(g);
+	}
 #endif
 
 #if GDISP_NEED_CIRCLE
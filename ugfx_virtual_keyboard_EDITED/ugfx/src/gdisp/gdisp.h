@@ -540,6 +540,23 @@ void gdispGDrawBox(GDisplay *g, coord_t x, coord_t y, coord_t cx, coord_t cy, co
 	 */
 	void gdispGSetClip(GDisplay *g, coord_t x, coord_t y, coord_t cx, coord_t cy);
 	#define gdispSetClip(x,y,cx,cy)							gdispGSetClip(GDISP,x,y,cx,cy)
+
+	/**
+	 * @brief   Get the area drawing is currently clipped to.
+	 * @pre		GDISP_NEED_CLIP must be TRUE in your gfxconf.h
+	 *
+	 * @param[in] g 		The display to use
+	 * @param[out] x,y		The start position
+	 * @param[out] cx,cy	The size of the clip area
+	 *
+	 * @note	With clipping done by the hardware the full display is returned.
+	 * @note	Use it to put back a clip area set by someone else, e.g. the window manager
+	 * 			while a window is redrawn.
+	 *
+	 * @api
+	 */
+	void gdispGGetClip(GDisplay *g, coord_t *x, coord_t *y, coord_t *cx, coord_t *cy);
+	#define gdispGetClip(x,y,cx,cy)							gdispGGetClip(GDISP,x,y,cx,cy)
 #endif
 
 /* Circle Functions */
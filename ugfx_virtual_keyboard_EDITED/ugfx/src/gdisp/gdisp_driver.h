@@ -369,7 +369,7 @@ struct GDisplay {
 			coord_t		clipx1, clipy1;
 		} t;
 	#endif
-	#if GDISP_LINEBUF_SIZE != 0 && ((GDISP_NEED_SCROLL && !GDISP_HARDWARE_SCROLL) || (!GDISP_HARDWARE_STREAM_WRITE && GDISP_HARDWARE_BITFILLS))
+	#if GDISP_LINEBUF_SIZE != 0 && ((GDISP_NEED_SCROLL && GDISP_HARDWARE_SCROLL != TRUE) || (!GDISP_HARDWARE_STREAM_WRITE && GDISP_HARDWARE_BITFILLS))
 		// A pixel line buffer
 		color_t		linebuf[GDISP_LINEBUF_SIZE];
 	#endif
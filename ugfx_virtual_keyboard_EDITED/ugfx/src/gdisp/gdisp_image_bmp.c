@@ -18,6 +18,11 @@
  */
 #define BLIT_BUFFER_SIZE_BMP	32
 
+/**
+ * Uncompressed 16, 24 and 32 bit images in ROM or memory are drawn straight from their rows
+ */
+#define BMP_DIRECT		(GFILE_NEED_DIRECTPOINTER && (GDISP_NEED_IMAGE_BMP_16 || GDISP_NEED_IMAGE_BMP_24 || GDISP_NEED_IMAGE_BMP_32))
+
 typedef struct gdispImagePrivate_BMP {
 	uint8_t		bmpflags;
 		#define BMP_V2				0x01		// Version 2 (old) header format
@@ -49,6 +54,9 @@ typedef struct gdispImagePrivate_BMP {
 #endif
 	size_t		frame0pos;
 	pixel_t		*frame0cache;
+#if BMP_DIRECT
+	const uint8_t	*direct;				// The file bytes when the file is memory mapped
+#endif
 	pixel_t		buf[BLIT_BUFFER_SIZE_BMP];
 	} gdispImagePrivate_BMP;
 
@@ -74,6 +82,10 @@ gdispImageError gdispImageOpen_BMP(gdispImage *img) {
 	uint16_t	aword;
 	uint32_t	adword;
 	uint32_t	offsetColorTable;
+	#if BMP_DIRECT
+		size_t		stride;
+		long int	fsize;
+	#endif
 
 	/* Read the file identifier */
 	if (gfileRead(img->f, hdr, 2) != 2)
@@ -347,6 +359,17 @@ gdispImageError gdispImageOpen_BMP(gdispImage *img) {
 	}
 #endif
 
+#if BMP_DIRECT
+	// Only when every row is within the file, drawDirect() reads rows without checking
+	priv->direct = 0;
+	if (!(priv->bmpflags & (BMP_PALETTE|BMP_COMP_RLE)) && priv->bitsperpixel >= 16) {
+		stride = ((size_t)img->width * (priv->bitsperpixel / 8) + 3) & ~3;
+		fsize = gfileGetSize(img->f);
+		if (stride && fsize > 0 && (size_t)fsize >= priv->frame0pos && ((size_t)fsize - priv->frame0pos) / stride >= (size_t)img->height)
+			priv->direct = (const uint8_t *)gfileGetDirectPointer(img->f);
+	}
+#endif
+
 	img->type = GDISP_IMAGE_TYPE_BMP;
 	return GDISP_IMAGE_ERR_OK;
 
@@ -698,6 +721,73 @@ static coord_t getPixels(gdispImage *img, coord_t x) {
 	}
 }
 
+#if BMP_DIRECT
+	static color_t directColor(gdispImagePrivate_BMP *priv, const uint8_t *p) {
+		uint32_t	dw;
+		color_t		r, g, b;
+
+		if (priv->bitsperpixel == 24)
+			return RGB2COLOR(p[2], p[1], p[0]);
+		dw = priv->bitsperpixel == 16 ? gdispImageGetLE16(p, 0) : gdispImageGetLE32(p, 0);
+		if (priv->shiftred < 0)
+			r = (color_t)((dw & priv->maskred) << -priv->shiftred);
+		else
+			r = (color_t)((dw & priv->maskred) >> priv->shiftred);
+		if (priv->shiftgreen < 0)
+			g = (color_t)((dw & priv->maskgreen) << -priv->shiftgreen);
+		else
+			g = (color_t)((dw & priv->maskgreen) >> priv->shiftgreen);
+		if (priv->shiftblue < 0)
+			b = (color_t)((dw & priv->maskblue) << -priv->shiftblue);
+		else
+			b = (color_t)((dw & priv->maskblue) >> priv->shiftblue);
+		/* We don't support alpha yet */
+		return RGB2COLOR(r, g, b);
+	}
+
+	static void drawDirect(GDisplay *g, gdispImage *img, coord_t x, coord_t y, coord_t cx, coord_t cy, coord_t sx, coord_t sy) {
+		gdispImagePrivate_BMP *	priv;
+		const uint8_t *			row;
+		size_t					stride;
+		coord_t					my, mx, n, i;
+		unsigned				bytes;
+
+		// The open made sure all rows of this stride are within the file
+		priv = (gdispImagePrivate_BMP *)img->priv;
+		bytes = priv->bitsperpixel / 8;
+		stride = ((size_t)img->width * bytes + 3) & ~3;
+
+		#if GDISP_PIXELFORMAT == GDISP_PIXELFORMAT_RGB565 && GFX_CPU_ENDIAN == GFX_CPU_ENDIAN_LITTLE
+			// Rows already in display format are blitted as they are, top down ones all at once
+			if (priv->bitsperpixel == 16 && priv->maskred == 0xF800 && priv->maskgreen == 0x07E0 && priv->maskblue == 0x001F
+					&& !(((size_t)priv->direct + priv->frame0pos) & 1)) {
+				if (priv->bmpflags & BMP_TOP_TO_BOTTOM) {
+					gdispGBlitArea(g, x, y, cx, cy, sx, sy, stride/2, (const pixel_t *)(priv->direct + priv->frame0pos));
+					return;
+				}
+				for(my = sy; my < sy+cy; my++) {
+					row = priv->direct + priv->frame0pos + stride * (img->height-1-my);
+					gdispGBlitArea(g, x, y+my-sy, cx, 1, sx, 0, stride/2, (const pixel_t *)row);
+				}
+				return;
+			}
+		#endif
+
+		// Other formats are converted a buffer at a time, only the visible part of visible rows
+		for(my = sy; my < sy+cy; my++) {
+			row = priv->direct + priv->frame0pos + stride * ((priv->bmpflags & BMP_TOP_TO_BOTTOM) ? my : img->height-1-my);
+			for(mx = sx; mx < sx+cx; mx += n) {
+				n = sx+cx-mx;
+				if (n > BLIT_BUFFER_SIZE_BMP)
+					n = BLIT_BUFFER_SIZE_BMP;
+				for(i = 0; i < n; i++)
+					priv->buf[i] = directColor(priv, row + (mx+i) * bytes);
+				gdispGBlitArea(g, x+mx-sx, y+my-sy, n, 1, 0, 0, n, priv->buf);
+			}
+		}
+	}
+#endif
+
 gdispImageError gdispImageCache_BMP(gdispImage *img) {
 	gdispImagePrivate_BMP *	priv;
 	color_t *			pcs;
@@ -774,6 +864,14 @@ gdispImageError gdispGImageDraw_BMP(GDisplay *g, gdispImage *img, coord_t x, coo
 		return GDISP_IMAGE_ERR_OK;
 	}
 
+#if BMP_DIRECT
+	/* Draw from the file bytes in place - if they are memory mapped */
+	if (priv->direct) {
+		drawDirect(g, img, x, y, cx, cy, sx, sy);
+		return GDISP_IMAGE_ERR_OK;
+	}
+#endif
+
 	/* Start decoding from the beginning */
 	gfileSetPos(img->f, priv->frame0pos);
 #if GDISP_NEED_IMAGE_BMP_4_RLE || GDISP_NEED_IMAGE_BMP_8_RLE
@@ -78,6 +78,10 @@ typedef struct PNG_input {
 	uint8_t		*pbuf;							// The pointer to the next byte
 	uint32_t	chunklen;						// The number of bytes left in the current PNG chunk
 	uint32_t	chunknext;						// The file position of the next PNG chunk
+	#if GFILE_NEED_DIRECTPOINTER
+		const uint8_t	*direct;				// The file bytes when the file is memory mapped
+		uint32_t		directsize;				// and how many there are
+	#endif
 	uint8_t		buf[PNG_FILE_BUFFER_SIZE];		// Must be a minimum of 8 bytes to hold a chunk header
 	} PNG_input;
 
@@ -153,6 +157,10 @@ static void PNG_iInit(PNG_decode *d) {
 		d->i.chunklen = 0;
 		d->i.chunknext = 8;
 		d->i.f = d->img->f;
+		#if GFILE_NEED_DIRECTPOINTER
+			d->i.direct = (const uint8_t *)gfileGetDirectPointer(d->i.f);
+			d->i.directsize = d->i.direct ? (uint32_t)gfileGetSize(d->i.f) : 0;
+		#endif
 	}
 }
 
@@ -168,6 +176,32 @@ static bool_t PNG_iLoadData(PNG_decode *d) {
 	if (!d->i.f)
 		return FALSE;
 
+	#if GFILE_NEED_DIRECTPOINTER
+		// Memory mapped files hand out each whole IDAT chunk in place
+		if (d->i.direct) {
+			while(1) {
+				// The chunk header, its data and CRC must all be within the file
+				if (d->i.directsize < 12 || d->i.chunknext > d->i.directsize - 12)
+					return FALSE;
+				d->i.pbuf = (uint8_t *)d->i.direct + d->i.chunknext;
+				sz = gdispImageGetBE32(d->i.pbuf, 0);
+				if (sz > d->i.directsize - 12 - d->i.chunknext)
+					return FALSE;
+				d->i.chunknext += sz + 12;
+				switch (gdispImageGetBE32(d->i.pbuf, 4)) {
+				case 0x49444154:		// "IDAT" - Image Data
+					if (!sz)
+						break;
+					d->i.pbuf += 8;
+					d->i.buflen = sz;
+					return TRUE;
+				case 0x49454E44:		// "IEND"	- All done
+					return FALSE;
+				}
+			}
+		}
+	#endif
+
 	// Have we finished the current chunk?
 	if (!d->i.chunklen) {
 		while(1) {
@@ -42,6 +42,9 @@
 #include "gdisp_driver.h"
 #include "../gdriver/gdriver.h"
 
+// Pixmap memory was supplied by the application and is not freed on delete
+#define GDISP_FLG_PIXMAP_STATIC			(GDISP_FLG_DRIVER<<0)
+
 typedef struct pixmap {
 	#if GDISP_NEED_PIXMAP_IMAGE
 		uint8_t		imghdr[8];			// This field must come just before the data member.
@@ -86,6 +89,31 @@ GDisplay *gdispPixmapCreate(coord_t width, coord_t height) {
 	return g;
 }
 
+GDisplay *gdispPixmapCreateFrom(coord_t width, coord_t height, void *mem) {
+	GDisplay	*g;
+	pixmap		*p;
+
+	// The caller owns the memory, it must hold at least GDISP_PIXMAP_MEMORY_SIZE(width, height) bytes
+	p = (pixmap *)mem;
+	#if GDISP_NEED_PIXMAP_IMAGE
+		p->imghdr[0] = 'N';
+		p->imghdr[1] = 'I';
+		p->imghdr[2] = (uint8_t)(width >> 8);
+		p->imghdr[3] = (uint8_t)width;
+		p->imghdr[4] = (uint8_t)(height >> 8);
+		p->imghdr[5] = (uint8_t)height;
+		p->imghdr[6] = (uint8_t)(GDISP_PIXELFORMAT >> 8);
+		p->imghdr[7] = (uint8_t)(GDISP_PIXELFORMAT);
+	#endif
+	((coord_t *)p->pixels)[0] = width;
+	((coord_t *)p->pixels)[1] = height;
+
+	g = (GDisplay *)gdriverRegister(&GDISPVMT_pixmap->d, p);
+	if (g)
+		g->flags |= GDISP_FLG_PIXMAP_STATIC;
+	return g;
+}
+
 void gdispPixmapDelete(GDisplay *g) {
 	if (gvmt(g) != GDISPVMT_pixmap)
 		return;
@@ -130,7 +158,8 @@ LLDSPEC bool_t gdisp_lld_init(GDisplay *g) {
 }
 
 LLDSPEC	void gdisp_lld_deinit(GDisplay *g) {
-	gfxFree(g->priv);
+	if (!(g->flags & GDISP_FLG_PIXMAP_STATIC))
+		gfxFree(g->priv);
 }
 
 LLDSPEC void gdisp_lld_draw_pixel(GDisplay *g) {
@@ -43,6 +43,29 @@ extern "C" {
 	 */
 	GDisplay *gdispPixmapCreate(coord_t width, coord_t height);
 
+	/**
+	 * @brief	Number of bytes needed by @p gdispPixmapCreateFrom() for a pixmap of the given size
+	 */
+	#if GDISP_NEED_PIXMAP_IMAGE
+		#define GDISP_PIXMAP_MEMORY_SIZE(width, height)	(8 + (width) * (height) * sizeof(color_t))
+	#else
+		#define GDISP_PIXMAP_MEMORY_SIZE(width, height)	((width) * (height) * sizeof(color_t))
+	#endif
+
+	/**
+	 * @brief	Create an off-screen pixmap on memory supplied by the caller
+	 *
+	 * @param[in] width  	The width of the pixmap to be created
+	 * @param[in] height  	The height of the pixmap to be created
+	 * @param[in] mem		At least GDISP_PIXMAP_MEMORY_SIZE(width, height) bytes, aligned for color_t
+	 *
+	 * @return 	The created GDisplay representing the pixmap
+	 *
+	 * @note	Lets large pixmaps live in memory that is not part of the GFX heap, such as external SDRAM.
+	 * @note	The memory is not freed by @p gdispPixmapDelete() and must outlive the pixmap.
+	 */
+	GDisplay *gdispPixmapCreateFrom(coord_t width, coord_t height, void *mem);
+
 	/**
 	 * @brief	Destroy an off-screen pixmap
 	 *
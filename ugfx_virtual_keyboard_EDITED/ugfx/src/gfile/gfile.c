@@ -22,12 +22,12 @@
 #if GFILE_NEED_NATIVEFS
 	extern const GFILEVMT FsNativeVMT;
 #endif
-#if GFILE_NEED_FATFS
-	extern const GFILEVMT FsFatFSVMT;
-#endif
 #if GFILE_NEED_RAMFS
 	extern const GFILEVMT FsRAMVMT;
 #endif
+#if GFILE_NEED_FATFS
+	extern const GFILEVMT FsFatFSVMT;
+#endif
 
 
 /**
@@ -41,12 +41,12 @@ static const GFILEVMT const * FsArray[] = {
 	#if GFILE_NEED_NATIVEFS
 		&FsNativeVMT,
 	#endif
+	#if GFILE_NEED_RAMFS
+		&FsRAMVMT,				// Before FatFS so it can read through
+	#endif
 	#if GFILE_NEED_FATFS
 		&FsFatFSVMT,
 	#endif
-	#if GFILE_NEED_RAMFS
-		&FsRAMVMT,
-	#endif
 };
 
 /*
@@ -65,6 +65,9 @@ void _gfileInit(void) {
 		extern void _gfileNativeAssignStdio(void);
 		_gfileNativeAssignStdio();
 	#endif
+	#if GFILE_NEED_ROMFS
+		_gfileRomInit();
+	#endif
 }
 
 void _gfileDeinit(void)
@@ -152,6 +155,10 @@ bool_t gfileExists(const char *fname) {
 bool_t gfileDelete(const char *fname) {
 	const GFILEVMT **p;
 
+	#if GFILE_NEED_RAMFS
+		_gfileRamfsForget(fname);
+	#endif
+
 	#if GFILE_ALLOW_DEVICESPECIFIC
 		if (fname[0] && fname[1] == '|') {
 			for(p = FsArray; p < &FsArray[sizeof(FsArray)/sizeof(FsArray[0])]; p++) {
@@ -193,6 +200,11 @@ long int gfileGetFilesize(const char *fname) {
 bool_t gfileRename(const char *oldname, const char *newname) {
 	const GFILEVMT * const *p;
 
+	#if GFILE_NEED_RAMFS
+		_gfileRamfsForget(oldname);
+		_gfileRamfsForget(newname);
+	#endif
+
 	#if GFILE_ALLOW_DEVICESPECIFIC
 		if ((oldname[0] && oldname[1] == '|') || (newname[0] && newname[1] == '|')) {
 			char ch;
@@ -240,6 +252,9 @@ static bool_t testopen(const GFILEVMT *p, GFILE *f, const char *fname) {
 	f->flags |= GFILEFLG_OPEN;
 	if (p->flags & GFSFLG_SEEKABLE)
 		f->flags |= GFILEFLG_CANSEEK;
+	#if GFILE_NEED_CACHE
+		_gfileCacheOpen(f);
+	#endif
 	return TRUE;
 }
 
@@ -251,6 +266,12 @@ GFILE *gfileOpen(const char *fname, const char *mode) {
 	if (!(f = _gfileFindSlot(mode)))
 		return 0;
 
+	#if GFILE_NEED_RAMFS
+		// A copy in RAM would go stale once the file is written
+		if (f->flags & GFILEFLG_WRITE)
+			_gfileRamfsForget(fname);
+	#endif
+
 	#if GFILE_ALLOW_DEVICESPECIFIC
 		if (fname[0] && fname[1] == '|') {
 			for(p = FsArray; p < &FsArray[sizeof(FsArray)/sizeof(FsArray[0])]; p++) {
@@ -275,6 +296,10 @@ GFILE *gfileOpen(const char *fname, const char *mode) {
 void gfileClose(GFILE *f) {
 	if (!f || !(f->flags & GFILEFLG_OPEN))
 		return;
+	#if GFILE_NEED_CACHE
+		if (f->flags & GFILEFLG_CACHED)
+			_gfileCacheClose(f);
+	#endif
 	if (f->vmt->close)
 		f->vmt->close(f);
 	f->flags = 0;
@@ -287,6 +312,14 @@ size_t gfileRead(GFILE *f, void *buf, size_t len) {
 		return 0;
 	if (!f->vmt->read)
 		return 0;
+	#if GFILE_NEED_CACHE
+		if (f->flags & GFILEFLG_CACHED) {
+			if ((res = _gfileCacheRead(f, buf, len)) <= 0)
+				return 0;
+			f->pos += res;
+			return res;
+		}
+	#endif
 	if ((res = f->vmt->read(f, buf, len)) <= 0)
 		return 0;
 	f->pos += res;
@@ -315,6 +348,15 @@ long int gfileGetPos(GFILE *f) {
 bool_t gfileSetPos(GFILE *f, long int pos) {
 	if (!f || !(f->flags & GFILEFLG_OPEN))
 		return FALSE;
+	#if GFILE_NEED_CACHE
+		// The file system is only moved when the cache next has to read from it
+		if (f->flags & GFILEFLG_CACHED) {
+			if (pos < 0 || pos > f->cachesize)
+				return FALSE;
+			f->pos = pos;
+			return TRUE;
+		}
+	#endif
 	if (!f->vmt->setpos || !f->vmt->setpos(f, pos))
 		return FALSE;
 	f->pos = pos;
@@ -329,9 +371,32 @@ long int gfileGetSize(GFILE *f) {
 	return f->vmt->getsize(f);
 }
 
+#if GFILE_NEED_DIRECTPOINTER
+	const void *gfileGetDirectPointer(GFILE *f) {
+		const void *	p;
+
+		if (!f || !(f->flags & GFILEFLG_OPEN))
+			return 0;
+		#if GFILE_NEED_ROMFS
+			if ((p = _gfileRomDirect(f)))
+				return p;
+		#endif
+		#if GFILE_NEED_MEMFS
+			if ((p = _gfileMemDirect(f)))
+				return p;
+		#endif
+		(void)p;
+		return 0;
+	}
+#endif
+
 bool_t gfileEOF(GFILE *f) {
 	if (!f || !(f->flags & GFILEFLG_OPEN))
 		return TRUE;
+	#if GFILE_NEED_CACHE
+		if (f->flags & GFILEFLG_CACHED)
+			return f->pos >= f->cachesize;
+	#endif
 	if (!f->vmt->eof)
 		return FALSE;
 	return f->vmt->eof(f);
@@ -213,6 +213,23 @@ extern "C" {
 	 */
 	bool_t		gfileEOF(GFILE *f);
 
+	#if GFILE_NEED_DIRECTPOINTER || defined(__DOXYGEN__)
+		/**
+		 * @brief					Get the file contents in place
+		 * @details					Files of the ROM and memory file systems are already in the address space,
+		 * 							readers can use their bytes without copying them through @p gfileRead().
+		 *
+		 * @param[in] f				The file
+		 *
+		 * @return					Pointer to the first byte of the file, NULL if the file is not memory mapped
+		 *
+		 * @note					The pointer does not depend on the file position and stays valid until the file is closed.
+		 *
+		 * @api
+		 */
+		const void *gfileGetDirectPointer(GFILE *f);
+	#endif
+
 	/**
 	 * @brief					Mount a logical drive (aka partition)
 	 *
@@ -343,6 +360,99 @@ extern "C" {
 		GFILE *		gfileOpenMemory(void *memptr, const char *mode);
 	#endif
 
+	#if GFILE_NEED_CACHE || defined(__DOXYGEN__)
+		typedef struct gfileCacheStats {
+			uint32_t	Reads;			// gfileRead() calls
+			uint32_t	Hits;			// Blocks found in the cache
+			uint32_t	Misses;			// Blocks read into the cache on demand
+			uint32_t	ReadAheads;		// Blocks read into the cache ahead of a sequential reader
+			uint32_t	DirectReads;	// Whole block reads passed straight to the file system
+			uint32_t	FsReads;		// Reads issued to the file system
+			uint32_t	Bytes;			// Bytes returned to callers
+		} gfileCacheStats;
+
+		/**
+		 * @brief				Give the block cache its memory
+		 *
+		 * @param[in] memory	Memory for the cache blocks, external SDRAM is fine
+		 * @param[in] size		Size of the memory in bytes
+		 *
+		 * @return				TRUE if the cache is now active
+		 *
+		 * @note				Call once after gfxInit(). Files opened before this are not cached.
+		 *
+		 * @api
+		 */
+		bool_t gfileCacheInit(void *memory, size_t size);
+
+		/**
+		 * @brief				Get the cache statistics
+		 *
+		 * @param[in] f			An open file, or NULL for the totals of all files since start
+		 * @param[out] stats	The statistics
+		 *
+		 * @api
+		 */
+		void gfileCacheGetStats(GFILE *f, gfileCacheStats *stats);
+	#endif
+
+	#if GFILE_NEED_RAMFS || defined(__DOXYGEN__)
+		typedef struct gfileRamfsStats {
+			uint32_t	Opens;			// Opens tried on the RAM file system
+			uint32_t	Hits;			// Opens served by a file already in RAM
+			uint32_t	Copies;			// Files copied in from FatFS
+			uint32_t	Skipped;		// Files left on FatFS, too large or no room
+			uint32_t	Evictions;		// Files dropped to make room
+			uint32_t	BytesCopied;
+			uint32_t	Files;			// Files in RAM now
+			uint32_t	FreeBytes;
+		} gfileRamfsStats;
+
+		/**
+		 * @brief				Give the RAM file system its memory
+		 *
+		 * @param[in] memory	Memory for the file table and data, external SDRAM is fine
+		 * @param[in] size		Size of the memory in bytes
+		 *
+		 * @return				TRUE if the RAM file system is now active
+		 *
+		 * @note				Call once after gfxInit(), then mount path prefixes with
+		 * 						@p gfileMount('R', "Tiles/") to have them read through.
+		 * @note				Files are evicted least recently used first, open or pinned
+		 * 						files stay.
+		 *
+		 * @api
+		 */
+		bool_t gfileRamfsInit(void *memory, size_t size);
+
+		/**
+		 * @brief				Keep a file in RAM until @p gfileRamfsUnpinAll()
+		 *
+		 * @param[in] fname		The file name
+		 *
+		 * @return				TRUE if the file is in RAM
+		 *
+		 * @api
+		 */
+		bool_t gfileRamfsPin(const char *fname);
+
+		/**
+		 * @brief				Let all files in RAM be evicted again
+		 *
+		 * @api
+		 */
+		void gfileRamfsUnpinAll(void);
+
+		/**
+		 * @brief				Get the RAM file system statistics
+		 *
+		 * @param[out] stats	The statistics
+		 *
+		 * @api
+		 */
+		void gfileRamfsGetStats(gfileRamfsStats *stats);
+	#endif
+
 	#if GFILE_NEED_STRINGS || defined(__DOXYGEN__)
 		/**
 		 * @brief					Open file from a null terminated C string
@@ -4,6 +4,7 @@
 #              http://ugfx.org/license.html
 
 GFXSRC +=   $(GFXLIB)/src/gfile/gfile.c \
+            $(GFXLIB)/src/gfile/gfile_cache.c \
             $(GFXLIB)/src/gfile/gfile_fs_native.c \
             $(GFXLIB)/src/gfile/gfile_fs_ram.c \
             $(GFXLIB)/src/gfile/gfile_fs_rom.c \
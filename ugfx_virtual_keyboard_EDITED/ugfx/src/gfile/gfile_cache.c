@@ -0,0 +1,197 @@
+/*
+ * This file is subject to the terms of the GFX License. If a copy of
+ * the license was not distributed with this file, you can obtain one at:
+ *
+ *              http://ugfx.org/license.html
+ */
+
+/********************************************************
+ * The block cache between GFILE and slow file systems
+ ********************************************************/
+
+#include "../../gfx.h"
+
+#if GFX_USE_GFILE && GFILE_NEED_CACHE
+
+#include "gfile_fs.h"
+
+#include <string.h>
+
+typedef struct gfileCacheBlock {
+	GFILE *		f;				// Owner, 0 when free
+	long int	block;			// Block number within the file
+	int			len;			// Valid bytes, short at end of file
+	uint32_t	used;			// LRU stamp
+	uint8_t *	data;
+} gfileCacheBlock;
+
+static gfileCacheBlock	cacheBlocks[GFILE_CACHE_MAX_BLOCKS];
+static unsigned			cacheCount;
+static uint32_t			cacheStamp;
+static gfileCacheStats	cacheTotals;
+static gfxMutex			cacheMutex;
+
+static gfileCacheBlock *cacheFind(GFILE *f, long int block) {
+	gfileCacheBlock *	b;
+
+	for(b = cacheBlocks; b < &cacheBlocks[cacheCount]; b++) {
+		if (b->f == f && b->block == block) {
+			b->used = ++cacheStamp;
+			return b;
+		}
+	}
+	return 0;
+}
+
+static gfileCacheBlock *cacheVictim(void) {
+	gfileCacheBlock *	b;
+	gfileCacheBlock *	victim;
+
+	victim = cacheBlocks;
+	for(b = cacheBlocks; b < &cacheBlocks[cacheCount]; b++) {
+		if (!b->f)
+			return b;
+		if (cacheStamp - b->used > cacheStamp - victim->used)
+			victim = b;
+	}
+	return victim;
+}
+
+static int cacheFsRead(GFILE *f, long int pos, void *buf, int len) {
+	int		res;
+
+	// The file system position is only moved when the cache needs data from somewhere else
+	if (f->cachepos != pos) {
+		if (!f->vmt->setpos(f, pos))
+			return 0;
+		f->cachepos = pos;
+	}
+	if ((res = f->vmt->read(f, buf, len)) <= 0)
+		return 0;
+	f->cachepos += res;
+	f->cachestats.FsReads++;
+	cacheTotals.FsReads++;
+	return res;
+}
+
+static gfileCacheBlock *cacheFill(GFILE *f, long int block) {
+	gfileCacheBlock *	b;
+
+	b = cacheVictim();
+	b->f = 0;
+	if ((b->len = cacheFsRead(f, block * GFILE_CACHE_BLOCK_SIZE, b->data, GFILE_CACHE_BLOCK_SIZE)) <= 0)
+		return 0;
+	b->f = f;
+	b->block = block;
+	b->used = ++cacheStamp;
+	return b;
+}
+
+bool_t gfileCacheInit(void *memory, size_t size) {
+	unsigned	i;
+
+	if (cacheCount)
+		return FALSE;
+	cacheCount = size / GFILE_CACHE_BLOCK_SIZE;
+	if (cacheCount > GFILE_CACHE_MAX_BLOCKS)
+		cacheCount = GFILE_CACHE_MAX_BLOCKS;
+	for(i = 0; i < cacheCount; i++) {
+		cacheBlocks[i].f = 0;
+		cacheBlocks[i].data = (uint8_t *)memory + i * GFILE_CACHE_BLOCK_SIZE;
+	}
+	gfxMutexInit(&cacheMutex);
+	return cacheCount != 0;
+}
+
+void gfileCacheGetStats(GFILE *f, gfileCacheStats *stats) {
+	if (!cacheCount) {
+		memset(stats, 0, sizeof(*stats));
+		return;
+	}
+	gfxMutexEnter(&cacheMutex);
+	*stats = f ? f->cachestats : cacheTotals;
+	gfxMutexExit(&cacheMutex);
+}
+
+bool_t _gfileCacheOpen(GFILE *f) {
+	// Writable files and file systems that are already memory speed go straight through
+	if (!cacheCount || (f->flags & GFILEFLG_WRITE) || (f->vmt->flags & GFSFLG_FAST)
+			|| !(f->vmt->flags & GFSFLG_SEEKABLE) || !f->vmt->setpos || !f->vmt->getsize)
+		return FALSE;
+	f->flags |= GFILEFLG_CACHED;
+	f->cachepos = 0;
+	f->cachesize = f->vmt->getsize(f);
+	f->cachenext = -1;
+	memset(&f->cachestats, 0, sizeof(f->cachestats));
+	return TRUE;
+}
+
+void _gfileCacheClose(GFILE *f) {
+	gfileCacheBlock *	b;
+
+	gfxMutexEnter(&cacheMutex);
+	for(b = cacheBlocks; b < &cacheBlocks[cacheCount]; b++) {
+		if (b->f == f)
+			b->f = 0;
+	}
+	gfxMutexExit(&cacheMutex);
+}
+
+int _gfileCacheRead(GFILE *f, void *buf, int len) {
+	gfileCacheBlock *	b;
+	long int			pos, block;
+	int					off, n, done, ahead;
+
+	gfxMutexEnter(&cacheMutex);
+	f->cachestats.Reads++;
+	cacheTotals.Reads++;
+	for(done = 0, pos = f->pos; len > 0 && pos < f->cachesize; done += n, pos += n, len -= n) {
+		block = pos / GFILE_CACHE_BLOCK_SIZE;
+		off = pos % GFILE_CACHE_BLOCK_SIZE;
+
+		if ((b = cacheFind(f, block))) {
+			f->cachestats.Hits++;
+			cacheTotals.Hits++;
+		} else if (!off && len >= GFILE_CACHE_BLOCK_SIZE) {
+			// Whole blocks go straight to the caller, FatFS turns them into multi-sector disk reads.
+			// A read to the end of the file takes its short last block along instead of a second read.
+			if ((n = cacheFsRead(f, pos, (uint8_t *)buf + done, pos + len >= f->cachesize ? len : len - len % GFILE_CACHE_BLOCK_SIZE)) <= 0)
+				break;
+			f->cachestats.DirectReads++;
+			cacheTotals.DirectReads++;
+			f->cachenext = (pos + n) / GFILE_CACHE_BLOCK_SIZE;
+			continue;
+		} else {
+			if (!(b = cacheFill(f, block)))
+				break;
+			f->cachestats.Misses++;
+			cacheTotals.Misses++;
+
+			// A miss on the block after the last one read is sequential, following blocks are read while the file system is there
+			if (block == f->cachenext && cacheCount > GFILE_CACHE_READAHEAD) {
+				for(ahead = 1; ahead <= GFILE_CACHE_READAHEAD && (block + ahead) * GFILE_CACHE_BLOCK_SIZE < f->cachesize; ahead++) {
+					if (cacheFind(f, block + ahead))
+						continue;
+					if (!cacheFill(f, block + ahead))
+						break;
+					f->cachestats.ReadAheads++;
+					cacheTotals.ReadAheads++;
+				}
+			}
+		}
+
+		f->cachenext = block + 1;
+		n = b->len - off;
+		if (n <= 0)
+			break;
+		if (n > len)
+			n = len;
+		memcpy((uint8_t *)buf + done, b->data + off, n);
+	}
+	f->cachestats.Bytes += done;
+	cacheTotals.Bytes += done;
+	gfxMutexExit(&cacheMutex);
+	return done;
+}
+
+#endif //GFX_USE_GFILE && GFILE_NEED_CACHE
@@ -28,8 +28,15 @@ struct GFILE {
 		#define GFILEFLG_MUSTEXIST		0x0100		// On open file must exist
 		#define GFILEFLG_MUSTNOTEXIST	0x0200		// On open file must not exist
 		#define GFILEFLG_TRUNC			0x0400		// On open truncate the file
+		#define GFILEFLG_CACHED			0x0800		// Reads go through the block cache
 	void *					obj;
 	long int				pos;
+	#if GFILE_NEED_CACHE
+		long int			cachepos;		// Position of the file system, can differ from pos
+		long int			cachesize;
+		long int			cachenext;		// Block after the last one read, for read-ahead
+		gfileCacheStats		cachestats;
+	#endif
 };
 
 struct gfileList {
@@ -69,4 +76,24 @@ typedef struct GFILEVMT {
 
 GFILE *_gfileFindSlot(const char *mode);
 
+#if GFILE_NEED_CACHE
+	bool_t _gfileCacheOpen(GFILE *f);
+	void _gfileCacheClose(GFILE *f);
+	int _gfileCacheRead(GFILE *f, void *buf, int len);
+#endif
+
+#if GFILE_NEED_RAMFS
+	void _gfileRamfsForget(const char *fname);
+#endif
+
+#if GFILE_NEED_ROMFS
+	void _gfileRomInit(void);
+	#if GFILE_NEED_DIRECTPOINTER
+		const void *_gfileRomDirect(GFILE *f);
+	#endif
+#endif
+#if GFILE_NEED_MEMFS && GFILE_NEED_DIRECTPOINTER
+	const void *_gfileMemDirect(GFILE *f);
+#endif
+
 #endif //_GFILE_FS_H
@@ -47,6 +47,12 @@ static bool_t MEMSetpos(GFILE *f, long int pos) {
 	return TRUE;
 }
 
+#if GFILE_NEED_DIRECTPOINTER
+	const void *_gfileMemDirect(GFILE *f) {
+		return f->vmt == &FsMemVMT ? f->obj : 0;
+	}
+#endif
+
 GFILE *	gfileOpenMemory(void *memptr, const char *mode) {
 	GFILE	*f;
 
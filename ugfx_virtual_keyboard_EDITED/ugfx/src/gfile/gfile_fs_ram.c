@@ -7,6 +7,10 @@
 
 /********************************************************
  * The RAM file-system
+ *
+ * A read-through tier in front of FatFS. Files under a mounted
+ * path prefix are copied whole into RAM on their first open and
+ * served from there until evicted.
  ********************************************************/
 
 #include "../../gfx.h"
@@ -15,18 +19,470 @@
 
 #include "gfile_fs.h"
 
-#error "GFILE: RAMFS Not implemented yet"
+#include <string.h>
+
+#define RAMFS_NOCHUNK		0xFFFF
+
+typedef struct ramFile {
+	uint32_t	hash;			// Of the name, 0 when the entry is free
+	uint32_t	used;			// LRU stamp
+	long int	size;
+	uint16_t	first;			// First chunk of the data
+	uint8_t		opens;
+	uint8_t		pinned;
+	char		name[GFILE_RAMFS_MAX_NAME];
+} ramFile;
+
+static bool_t RAMExists(const char *fname);
+static long int RAMFilesize(const char *fname);
+static bool_t RAMOpen(GFILE *f, const char *fname);
+static void RAMClose(GFILE *f);
+static int RAMRead(GFILE *f, void *buf, int size);
+static bool_t RAMSetpos(GFILE *f, long int pos);
+static long int RAMGetsize(GFILE *f);
+static bool_t RAMEof(GFILE *f);
+static bool_t RAMMount(const char *drive);
+static bool_t RAMUnmount(const char *drive);
 
 const GFILEVMT FsRAMVMT = {
-	0,								// flags
-	'R',							// prefix
-	0, 0, 0, 0,
-	0, 0, 0, 0,
-	0, 0, 0,
-	0, 0, 0,
+	GFSFLG_SEEKABLE|GFSFLG_CASESENSITIVE|GFSFLG_FAST,	// flags
+	'R',												// prefix
+	0, RAMExists, RAMFilesize, 0,
+	RAMOpen, RAMClose, RAMRead, 0,
+	RAMSetpos, RAMGetsize, RAMEof,
+	RAMMount, RAMUnmount, 0,
 	#if GFILE_NEED_FILELISTS
 		0, 0, 0,
 	#endif
 };
 
+#if GFILE_NEED_FATFS
+	extern const GFILEVMT FsFatFSVMT;
+#endif
+
+static ramFile *		ramFiles;
+static uint16_t *		ramNext;		// Chunk chains, free chunks are chained from ramFreeList
+static uint8_t *		ramChunks;
+static unsigned			ramChunkCount;
+static unsigned			ramFreeCount;
+static uint16_t			ramFreeList;
+static uint32_t			ramStamp;
+static uint32_t			ramChanges;		// Forgets and unmounts, a copy made meanwhile may be stale
+static char				ramMounts[GFILE_RAMFS_MAX_MOUNTS][GFILE_RAMFS_MAX_NAME];
+static gfileRamfsStats	ramStats;
+static gfxMutex			ramMutex;
+
+static uint32_t ramHash(const char *fname) {
+	uint32_t	h;
+
+	// FNV-1a, never 0 so 0 can mark a free entry
+	for(h = 2166136261u; *fname; fname++)
+		h = (h ^ (uint8_t)*fname) * 16777619u;
+	return h ? h : 1;
+}
+
+static ramFile *ramFind(const char *fname) {
+	ramFile *	e;
+	uint32_t	h;
+
+	h = ramHash(fname);
+	for(e = ramFiles; e < &ramFiles[GFILE_RAMFS_MAX_FILES]; e++) {
+		if (e->hash == h && !strcmp(e->name, fname))
+			return e;
+	}
+	return 0;
+}
+
+static void ramRelease(ramFile *e) {
+	uint16_t	c;
+
+	// The chain goes back on the free list in one piece
+	if (e->first != RAMFS_NOCHUNK) {
+		for(c = e->first; ramNext[c] != RAMFS_NOCHUNK; c = ramNext[c])
+			ramFreeCount++;
+		ramFreeCount++;
+		ramNext[c] = ramFreeList;
+		ramFreeList = e->first;
+		e->first = RAMFS_NOCHUNK;
+	}
+	e->hash = 0;
+	e->name[0] = 0;
+	e->pinned = 0;
+}
+
+#if GFILE_NEED_FATFS
+	static ramFile *ramVictim(void) {
+		ramFile *	e;
+		ramFile *	victim;
+
+		victim = 0;
+		for(e = ramFiles; e < &ramFiles[GFILE_RAMFS_MAX_FILES]; e++) {
+			if (!e->hash || e->opens || e->pinned)
+				continue;
+			if (!victim || ramStamp - e->used > ramStamp - victim->used)
+				victim = e;
+		}
+		return victim;
+	}
+
+	static ramFile *ramSlot(void) {
+		ramFile *	e;
+
+		for(e = ramFiles; e < &ramFiles[GFILE_RAMFS_MAX_FILES]; e++) {
+			if (!e->hash && !e->opens)
+				return e;
+		}
+		if ((e = ramVictim())) {
+			ramRelease(e);
+			ramStats.Evictions++;
+		}
+		return e;
+	}
+
+	static uint16_t ramAlloc(unsigned count) {
+		ramFile *	e;
+		uint16_t	first, c;
+		unsigned	i;
+
+		while (ramFreeCount < count) {
+			if (!(e = ramVictim()))
+				return RAMFS_NOCHUNK;
+			ramRelease(e);
+			ramStats.Evictions++;
+		}
+		first = c = ramFreeList;
+		for(i = 1; i < count; i++)
+			c = ramNext[c];
+		ramFreeList = ramNext[c];
+		ramNext[c] = RAMFS_NOCHUNK;
+		ramFreeCount -= count;
+		return first;
+	}
+
+	static bool_t ramMounted(const char *fname) {
+		unsigned	i;
+
+		for(i = 0; i < GFILE_RAMFS_MAX_MOUNTS; i++) {
+			if (ramMounts[i][0] && !strncmp(fname, ramMounts[i], strlen(ramMounts[i])))
+				return TRUE;
+		}
+		return FALSE;
+	}
+
+	// Called without the lock, returns the copy opened once
+	static ramFile *ramCopy(const char *fname) {
+		GFILE		src;
+		ramFile *	e;
+		ramFile *	other;
+		long int	size, done;
+		unsigned	count;
+		uint32_t	changes;
+		uint16_t	c;
+		int			n;
+
+		if (strlen(fname) >= GFILE_RAMFS_MAX_NAME || (size = FsFatFSVMT.filesize(fname)) <= 0)
+			return 0;
+		count = (size + GFILE_RAMFS_CHUNK_SIZE - 1) / GFILE_RAMFS_CHUNK_SIZE;
+		if (size > GFILE_RAMFS_MAX_FILE || count > ramChunkCount) {
+			gfxMutexEnter(&ramMutex);
+			ramStats.Skipped++;
+			gfxMutexExit(&ramMutex);
+			return 0;
+		}
+
+		// Opened straight on FatFS so the block cache is not filled with a file that will live here
+		memset(&src, 0, sizeof(src));
+		src.flags = GFILEFLG_READ|GFILEFLG_MUSTEXIST|GFILEFLG_BINARY;
+		if (!FsFatFSVMT.open(&src, fname))
+			return 0;
+
+		// The slot and its chunks are reserved under the lock. Opened with no name it can not be
+		// found, reused or evicted while the data is read without the lock.
+		gfxMutexEnter(&ramMutex);
+		changes = ramChanges;
+		if ((e = ramSlot())) {
+			if ((e->first = ramAlloc(count)) == RAMFS_NOCHUNK)
+				e = 0;
+			else
+				e->opens = 1;
+		}
+		if (!e)
+			ramStats.Skipped++;
+		gfxMutexExit(&ramMutex);
+		if (!e)
+			goto done;
+
+		// Chunks are sector multiples in SDRAM, each one is a multi-sector read into place
+		for(done = 0, c = e->first; done < size; done += n, c = ramNext[c]) {
+			n = size - done > GFILE_RAMFS_CHUNK_SIZE ? GFILE_RAMFS_CHUNK_SIZE : (int)(size - done);
+			if (FsFatFSVMT.read(&src, ramChunks + (uint32_t)c * GFILE_RAMFS_CHUNK_SIZE, n) != n)
+				break;
+		}
+
+		// Published unless the read failed, the file was forgotten meanwhile or another open copied it first
+		gfxMutexEnter(&ramMutex);
+		other = ramFind(fname);
+		if (done < size || changes != ramChanges || other) {
+			e->opens = 0;
+			ramRelease(e);
+			if ((e = other)) {
+				e->opens++;
+				ramStats.Hits++;
+			}
+		} else {
+			strcpy(e->name, fname);
+			e->hash = ramHash(fname);
+			e->size = size;
+			e->pinned = 0;
+			ramStats.Copies++;
+			ramStats.BytesCopied += size;
+		}
+		if (e)
+			e->used = ++ramStamp;
+		gfxMutexExit(&ramMutex);
+
+	done:
+		FsFatFSVMT.close(&src);
+		return e;
+	}
+#endif
+
+bool_t gfileRamfsInit(void *memory, size_t size) {
+	unsigned	i;
+	size_t		table;
+
+	if (ramChunkCount)
+		return FALSE;
+
+	// File table first, then the chunk chains, then the chunks themselves aligned for DMA
+	table = (GFILE_RAMFS_MAX_FILES * sizeof(ramFile) + 31) & ~31;
+	if (size <= table)
+		return FALSE;
+	ramChunkCount = (size - table - 32) / (GFILE_RAMFS_CHUNK_SIZE + sizeof(uint16_t));
+	if (ramChunkCount >= RAMFS_NOCHUNK)
+		ramChunkCount = RAMFS_NOCHUNK - 1;
+	if (!ramChunkCount)
+		return FALSE;
+	ramFiles = (ramFile *)memory;
+	ramNext = (uint16_t *)((uint8_t *)memory + table);
+	ramChunks = (uint8_t *)ramNext + ((ramChunkCount * sizeof(uint16_t) + 31) & ~31);
+
+	for(i = 0; i < GFILE_RAMFS_MAX_FILES; i++) {
+		ramFiles[i].hash = 0;
+		ramFiles[i].name[0] = 0;
+		ramFiles[i].opens = 0;
+		ramFiles[i].pinned = 0;
+		ramFiles[i].first = RAMFS_NOCHUNK;
+	}
+	for(i = 0; i < ramChunkCount; i++)
+		ramNext[i] = i + 1 < ramChunkCount ? i + 1 : RAMFS_NOCHUNK;
+	ramFreeList = 0;
+	ramFreeCount = ramChunkCount;
+	gfxMutexInit(&ramMutex);
+	return TRUE;
+}
+
+bool_t gfileRamfsPin(const char *fname) {
+	ramFile *	e;
+
+	if (!ramChunkCount)
+		return FALSE;
+	gfxMutexEnter(&ramMutex);
+	if ((e = ramFind(fname)))
+		e->pinned = 1;
+	gfxMutexExit(&ramMutex);
+	return e != 0;
+}
+
+void gfileRamfsUnpinAll(void) {
+	ramFile *	e;
+
+	if (!ramChunkCount)
+		return;
+	gfxMutexEnter(&ramMutex);
+	for(e = ramFiles; e < &ramFiles[GFILE_RAMFS_MAX_FILES]; e++)
+		e->pinned = 0;
+	gfxMutexExit(&ramMutex);
+}
+
+void gfileRamfsGetStats(gfileRamfsStats *stats) {
+	ramFile *	e;
+
+	if (!ramChunkCount) {
+		memset(stats, 0, sizeof(*stats));
+		return;
+	}
+	gfxMutexEnter(&ramMutex);
+	*stats = ramStats;
+	stats->Files = 0;
+	for(e = ramFiles; e < &ramFiles[GFILE_RAMFS_MAX_FILES]; e++) {
+		if (e->hash)
+			stats->Files++;
+	}
+	stats->FreeBytes = ramFreeCount * GFILE_RAMFS_CHUNK_SIZE;
+	gfxMutexExit(&ramMutex);
+}
+
+void _gfileRamfsForget(const char *fname) {
+	ramFile *	e;
+
+	if (!ramChunkCount)
+		return;
+	if (fname[0] && fname[1] == '|')
+		fname += 2;
+	gfxMutexEnter(&ramMutex);
+	ramChanges++;
+	if ((e = ramFind(fname))) {
+		// An open copy keeps its data until closed but can no longer be found
+		if (e->opens) {
+			e->hash = 0;
+			e->name[0] = 0;
+		} else
+			ramRelease(e);
+	}
+	gfxMutexExit(&ramMutex);
+}
+
+static bool_t RAMExists(const char *fname) {
+	bool_t	res;
+
+	if (!ramChunkCount)
+		return FALSE;
+	gfxMutexEnter(&ramMutex);
+	res = ramFind(fname) != 0;
+	gfxMutexExit(&ramMutex);
+	return res;
+}
+
+static long int RAMFilesize(const char *fname) {
+	ramFile *	e;
+	long int	res;
+
+	if (!ramChunkCount)
+		return -1;
+	gfxMutexEnter(&ramMutex);
+	res = (e = ramFind(fname)) ? e->size : -1;
+	gfxMutexExit(&ramMutex);
+	return res;
+}
+
+static bool_t RAMOpen(GFILE *f, const char *fname) {
+	ramFile *	e;
+	#if GFILE_NEED_FATFS
+		bool_t	copy = FALSE;
+	#endif
+
+	if (!ramChunkCount)
+		return FALSE;
+	gfxMutexEnter(&ramMutex);
+	ramStats.Opens++;
+	if ((e = ramFind(fname))) {
+		ramStats.Hits++;
+		e->opens++;
+		e->used = ++ramStamp;
+	}
+	#if GFILE_NEED_FATFS
+		else
+			copy = ramMounted(fname);
+	#endif
+	gfxMutexExit(&ramMutex);
+
+	// The card is read without the lock so hits on other files are not held up by a copy
+	#if GFILE_NEED_FATFS
+		if (copy)
+			e = ramCopy(fname);
+	#endif
+	if (e)
+		f->obj = e;
+	return e != 0;
+}
+
+static void RAMClose(GFILE *f) {
+	ramFile *	e;
+
+	e = (ramFile *)f->obj;
+	gfxMutexEnter(&ramMutex);
+	if (!--e->opens && !e->hash)
+		ramRelease(e);
+	gfxMutexExit(&ramMutex);
+}
+
+static int RAMRead(GFILE *f, void *buf, int size) {
+	ramFile *	e;
+	uint16_t	c;
+	long int	i;
+	int			off, n, done;
+
+	// The chain of an open file does not change so no lock is needed
+	e = (ramFile *)f->obj;
+	if (size > e->size - f->pos)
+		size = e->size - f->pos;
+	if (size <= 0)
+		return 0;
+	for(c = e->first, i = f->pos / GFILE_RAMFS_CHUNK_SIZE; i; i--)
+		c = ramNext[c];
+	off = f->pos % GFILE_RAMFS_CHUNK_SIZE;
+	for(done = 0; done < size; done += n, off = 0, c = ramNext[c]) {
+		n = GFILE_RAMFS_CHUNK_SIZE - off;
+		if (n > size - done)
+			n = size - done;
+		memcpy((uint8_t *)buf + done, ramChunks + (uint32_t)c * GFILE_RAMFS_CHUNK_SIZE + off, n);
+	}
+	return size;
+}
+
+static bool_t RAMSetpos(GFILE *f, long int pos) {
+	return pos >= 0 && pos <= ((ramFile *)f->obj)->size;
+}
+
+static long int RAMGetsize(GFILE *f) {
+	return ((ramFile *)f->obj)->size;
+}
+
+static bool_t RAMEof(GFILE *f) {
+	return f->pos >= ((ramFile *)f->obj)->size;
+}
+
+static bool_t RAMMount(const char *drive) {
+	unsigned	i;
+
+	// The drive is a path prefix, files opened under it are read through into RAM
+	if (!ramChunkCount || strlen(drive) >= GFILE_RAMFS_MAX_NAME)
+		return FALSE;
+	gfxMutexEnter(&ramMutex);
+	for(i = 0; i < GFILE_RAMFS_MAX_MOUNTS; i++) {
+		if (!ramMounts[i][0] || !strcmp(ramMounts[i], drive))
+			break;
+	}
+	if (i < GFILE_RAMFS_MAX_MOUNTS)
+		strcpy(ramMounts[i], drive);
+	gfxMutexExit(&ramMutex);
+	return i < GFILE_RAMFS_MAX_MOUNTS;
+}
+
+static bool_t RAMUnmount(const char *drive) {
+	ramFile *	e;
+	unsigned	i;
+	size_t		len;
+
+	if (!ramChunkCount)
+		return FALSE;
+	gfxMutexEnter(&ramMutex);
+	for(i = 0; i < GFILE_RAMFS_MAX_MOUNTS; i++) {
+		if (!strcmp(ramMounts[i], drive))
+			break;
+	}
+	if (i < GFILE_RAMFS_MAX_MOUNTS) {
+		ramMounts[i][0] = 0;
+		ramChanges++;
+		len = strlen(drive);
+		for(e = ramFiles; e < &ramFiles[GFILE_RAMFS_MAX_FILES]; e++) {
+			if (e->hash && !e->opens && !strncmp(e->name, drive, len))
+				ramRelease(e);
+		}
+	}
+	gfxMutexExit(&ramMutex);
+	return i < GFILE_RAMFS_MAX_MOUNTS;
+}
+
 #endif //GFX_USE_GFILE && GFILE_NEED_RAMFS
@@ -30,12 +30,17 @@ typedef struct ROMFS_DIRENTRY {
 	const char *					name;			// The file name
 	long int						size;			// The file size
 	const char *					file;			// The file data
+	uint32_t						hash;			// FNV-1a of the name from file2c, 0 in older headers
 } ROMFS_DIRENTRY;
 
 #define ROMFS_DIRENTRY_HEAD		0
 #include "romfs_files.h"
 static const ROMFS_DIRENTRY const *FsROMHead = ROMFS_DIRENTRY_HEAD;
 
+// Open addressed index over the directory list, FALSE if the list did not fit
+static const ROMFS_DIRENTRY *	FsROMIndex[GFILE_ROMFS_INDEX_SIZE];
+static bool_t					FsROMIndexed;
+
 typedef struct ROMFileList {
 	gfileList				fl;
 	const ROMFS_DIRENTRY	*pdir;
@@ -68,9 +73,52 @@ const GFILEVMT FsROMVMT = {
 	#endif
 };
 
+static uint32_t ROMHash(const char *fname)
+{
+	uint32_t	h;
+
+	// Must match the hash file2c puts in the directory entry
+	for(h = 2166136261u; *fname; fname++)
+		h = (h ^ (uint8_t)*fname) * 16777619u;
+	return h;
+}
+
+static uint32_t ROMEntryHash(const ROMFS_DIRENTRY *p)
+{
+	return p->hash ? p->hash : ROMHash(p->name);
+}
+
+void _gfileRomInit(void)
+{
+	const ROMFS_DIRENTRY *p;
+	unsigned i, n;
+
+	// Only entries we can read go in the index, 3/4 full at most to keep probes short
+	for(n = 0, p = FsROMHead; p; p = p->next) {
+		if (p->ver > ROMFS_DIR_VER_MAX || p->cmp != ROMFS_CMP_UNCOMPRESSED)
+			continue;
+		if (++n > GFILE_ROMFS_INDEX_SIZE * 3 / 4)
+			return;
+		for(i = ROMEntryHash(p) & (GFILE_ROMFS_INDEX_SIZE-1); FsROMIndex[i]; i = (i+1) & (GFILE_ROMFS_INDEX_SIZE-1));
+		FsROMIndex[i] = p;
+	}
+	FsROMIndexed = TRUE;
+}
+
 static const ROMFS_DIRENTRY *ROMFindFile(const char *fname)
 {
 	const ROMFS_DIRENTRY *p;
+	uint32_t h;
+	unsigned i;
+
+	if (FsROMIndexed) {
+		h = ROMHash(fname);
+		for(i = h & (GFILE_ROMFS_INDEX_SIZE-1); (p = FsROMIndex[i]); i = (i+1) & (GFILE_ROMFS_INDEX_SIZE-1)) {
+			if (ROMEntryHash(p) == h && !strcmp(p->name, fname))
+				return p;
+		}
+		return 0;
+	}
 
 	for(p = FsROMHead; p; p = p->next) {
 		if (p->ver <= ROMFS_DIR_VER_MAX && p->cmp == ROMFS_CMP_UNCOMPRESSED && !strcmp(p->name, fname))
@@ -133,6 +181,13 @@ static bool_t ROMEof(GFILE *f)
 	return f->pos >= ((const ROMFS_DIRENTRY *)f->obj)->size;
 }
 
+#if GFILE_NEED_DIRECTPOINTER
+	const void *_gfileRomDirect(GFILE *f)
+	{
+		return f->vmt == &FsROMVMT ? ((const ROMFS_DIRENTRY *)f->obj)->file : 0;
+	}
+#endif
+
 #if GFILE_NEED_FILELISTS
 	static gfileList *ROMFlOpen(const char *path, bool_t dirs) {
 		ROMFileList *	p;
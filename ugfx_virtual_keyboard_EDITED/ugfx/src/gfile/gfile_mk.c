@@ -6,6 +6,7 @@
  */
 
 #include "gfile.c"
+#include "gfile_cache.c"
 #include "gfile_fs_native.c"
 #include "gfile_fs_ram.c"
 #include "gfile_fs_rom.c"
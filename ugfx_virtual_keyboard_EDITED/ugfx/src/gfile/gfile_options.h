@@ -94,8 +94,9 @@
 	 * @note	If GFILE_ALLOW_DEVICESPECIFIC is on then you can ensure that you are
 	 * 			opening a file on the RAM file system by prefixing
 	 * 			its name with "R|" (the letter 'R', followed by a vertical bar).
-	 * @note	You must also define GFILE_RAMFS_SIZE with the size of the file system
-	 * 			to be allocated in RAM.
+	 * @note	Memory for the file system is given to @p gfileRamfsInit(). Each
+	 * 			@p gfileMount('R', prefix) makes files under that path prefix
+	 * 			read through: their first open copies them whole from FatFS.
 	 */
 	#ifndef GFILE_NEED_RAMFS
 		#define GFILE_NEED_RAMFS		FALSE
@@ -172,6 +173,23 @@
 	#ifndef GFILE_NEED_FILELISTS
 		#define GFILE_NEED_FILELISTS	FALSE
 	#endif
+	/**
+	 * @brief   Include a block cache between GFILE and slow file systems
+	 * @details	Defaults to FALSE
+	 * @note	Memory for the cache is given to @p gfileCacheInit(). Files opened before that are not cached.
+	 * @note	Only files opened read-only on seekable file systems without GFSFLG_FAST are cached.
+	 */
+	#ifndef GFILE_NEED_CACHE
+		#define GFILE_NEED_CACHE		FALSE
+	#endif
+	/**
+	 * @brief   Include @p gfileGetDirectPointer() for files already in memory
+	 * @details	Defaults to FALSE
+	 * @note	ROMFS and MEMFS files return a pointer to their bytes, other file systems return NULL.
+	 */
+	#ifndef GFILE_NEED_DIRECTPOINTER
+		#define GFILE_NEED_DIRECTPOINTER	FALSE
+	#endif
 /**
  * @}
  *
@@ -225,6 +243,63 @@
 	#ifndef GFILE_PETITFS_EXTERNAL_LIB
 		#define GFILE_PETITFS_EXTERNAL_LIB	FALSE
 	#endif
+	/**
+	 * @brief   Size of a cache block in bytes
+	 * @note	Keep this a multiple of the sector size so whole blocks are read as whole sectors.
+	 */
+	#ifndef GFILE_CACHE_BLOCK_SIZE
+		#define GFILE_CACHE_BLOCK_SIZE		4096
+	#endif
+	/**
+	 * @brief   The most cache blocks, memory given to @p gfileCacheInit() beyond this is not used
+	 */
+	#ifndef GFILE_CACHE_MAX_BLOCKS
+		#define GFILE_CACHE_MAX_BLOCKS		64
+	#endif
+	/**
+	 * @brief   Blocks read ahead when a file is read sequentially
+	 */
+	#ifndef GFILE_CACHE_READAHEAD
+		#define GFILE_CACHE_READAHEAD		2
+	#endif
+	/**
+	 * @brief   Slots in the ROM file system name index, a power of 2
+	 * @note	Directories with more than 3/4 of this many files are searched in a list instead.
+	 */
+	#ifndef GFILE_ROMFS_INDEX_SIZE
+		#define GFILE_ROMFS_INDEX_SIZE		32
+	#endif
+	/**
+	 * @brief   Allocation unit of the RAM file system in bytes
+	 * @note	Keep this a multiple of the sector size so files are copied in as whole sectors.
+	 */
+	#ifndef GFILE_RAMFS_CHUNK_SIZE
+		#define GFILE_RAMFS_CHUNK_SIZE		2048
+	#endif
+	/**
+	 * @brief   The most files held by the RAM file system
+	 */
+	#ifndef GFILE_RAMFS_MAX_FILES
+		#define GFILE_RAMFS_MAX_FILES		128
+	#endif
+	/**
+	 * @brief   Longest file name plus one, longer names are not copied into RAM
+	 */
+	#ifndef GFILE_RAMFS_MAX_NAME
+		#define GFILE_RAMFS_MAX_NAME		32
+	#endif
+	/**
+	 * @brief   Largest file copied into RAM, bigger files are read from FatFS
+	 */
+	#ifndef GFILE_RAMFS_MAX_FILE
+		#define GFILE_RAMFS_MAX_FILE		65536
+	#endif
+	/**
+	 * @brief   The most path prefixes mounted on the RAM file system at once
+	 */
+	#ifndef GFILE_RAMFS_MAX_MOUNTS
+		#define GFILE_RAMFS_MAX_MOUNTS		4
+	#endif
 	
 /** @} */
 
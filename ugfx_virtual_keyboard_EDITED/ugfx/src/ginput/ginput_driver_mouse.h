@@ -52,6 +52,7 @@ typedef struct GMouse {
 			#define GMOUSE_FLG_DRIVER_FIRST		0x0100				// The first flag available for the driver
 	point								clickpos;			// The position of the last click event
 	systemticks_t						clicktime;			// The time of the last click event
+	systemticks_t						readtime;			// The time of the last reading
 	GDisplay *							display;			// The display the mouse is associated with
 	#if !GINPUT_TOUCH_NOCALIBRATE
 		GMouseCalibration				caldata;			// The calibration data
@@ -68,7 +69,7 @@ typedef struct GMouseJitter {
 typedef struct GMouseVMT {
 	GDriverVMT	d;											// Device flags are part of the general vmt
 		#define GMOUSE_VFLG_TOUCH			0x0001			// This is a touch device (rather than a mouse). Button 1 is calculated from z value.
-		#define GMOUSE_VFLG_NOPOLL			0x0002			// Do not poll this device - it is purely interrupt driven
+		#define GMOUSE_VFLG_NOPOLL			0x0002			// Do not poll this device - it is interrupt driven (it is still polled while a button is down)
 		#define GMOUSE_VFLG_SELFROTATION	0x0004			// This device returns readings that are aligned with the display orientation
 		#define GMOUSE_VFLG_DEFAULTFINGER	0x0008			// Default to finger mode
 		#define GMOUSE_VFLG_CALIBRATE		0x0010			// This device requires calibration
@@ -50,6 +50,7 @@
 
 // The mouse poll timer
 static GTIMER_DECL(MouseTimer);
+static bool_t		MousePolling;			// The timer is running periodically rather than waiting for a wakeup
 
 // Calibration application
 #if !GINPUT_TOUCH_NOCALIBRATE
@@ -107,6 +108,7 @@ static void GetMouseReading(GMouse *m) {
 	// Step 1 - Get the Raw Reading
 	{
 		m->flags &= ~GMOUSE_FLG_NEEDREAD;
+		m->readtime = gfxSystemTicks();
 		if (!gmvmt(m)->get(m, &r))
 			return;
 	}
@@ -321,11 +323,43 @@ static void GetMouseReading(GMouse *m) {
 
 static void MousePoll(void *param) {
 	GMouse *	m;
+	bool_t		polling;
 	(void) 		param;
 
+	polling = FALSE;
 	for(m = (GMouse *)gdriverGetNext(GDRIVER_TYPE_MOUSE, 0); m; m = (GMouse *)gdriverGetNext(GDRIVER_TYPE_MOUSE, (GDriver *)m)) {
-		if (!(gmvmt(m)->d.flags & GMOUSE_VFLG_NOPOLL) || (m->flags & GMOUSE_FLG_NEEDREAD))
+		if (!(gmvmt(m)->d.flags & GMOUSE_VFLG_NOPOLL)) {
 			GetMouseReading(m);
+			polling = TRUE;
+			continue;
+		}
+
+		// An interrupt driven mouse is read when it interrupts. While it is down it is read each poll period instead,
+		//	so the release is seen even if it doesn't interrupt and a stream of drag interrupts becomes one reading a period.
+		if ((m->r.buttons & GINPUT_MOUSE_BTN_MASK) || (m->flags & GMOUSE_FLG_INDELTA)) {
+			if (gfxSystemTicks() - m->readtime >= gfxMillisecondsToTicks(GINPUT_MOUSE_POLL_PERIOD/2))
+				GetMouseReading(m);
+		} else if ((m->flags & GMOUSE_FLG_NEEDREAD))
+			GetMouseReading(m);
+
+		if ((m->r.buttons & GINPUT_MOUSE_BTN_MASK) || (m->flags & (GMOUSE_FLG_INDELTA|GMOUSE_FLG_NEEDREAD)))
+			polling = TRUE;
+	}
+
+	// Only run the timer when something needs polling. A wakeup jabs it otherwise.
+	if (polling != MousePolling) {
+		MousePolling = polling;
+		gtimerStart(&MouseTimer, MousePoll, 0, TRUE, polling ? GINPUT_MOUSE_POLL_PERIOD : TIME_INFINITE);
+
+		// Restarting the timer forgets a jab that came in meanwhile
+		if (!polling) {
+			for(m = (GMouse *)gdriverGetNext(GDRIVER_TYPE_MOUSE, 0); m; m = (GMouse *)gdriverGetNext(GDRIVER_TYPE_MOUSE, (GDriver *)m)) {
+				if ((m->flags & GMOUSE_FLG_NEEDREAD)) {
+					gtimerJab(&MouseTimer);
+					break;
+				}
+			}
+		}
 	}
 }
 
@@ -678,8 +712,11 @@ bool_t _gmouseInitDriver(GDriver *g, void *display, unsigned driverinstance, uns
         return FALSE;
 
 	// Ensure the Poll timer is started
-	if (!gtimerIsActive(&MouseTimer))
+	if (!gtimerIsActive(&MouseTimer)) {
+		MousePolling = TRUE;
 		gtimerStart(&MouseTimer, MousePoll, 0, TRUE, GINPUT_MOUSE_POLL_PERIOD);
+	} else if (!MousePolling)
+		gtimerJab(&MouseTimer);			// Let the poll decide if this mouse needs the timer running
 
     return TRUE;
 
@@ -34,79 +34,262 @@
 
 	// Slot structure - user memory follows
 	typedef struct memslot {
-		struct memslot *next;		// The next memslot
-		size_t			sz;			// Includes the size of this memslot.
+		size_t			prevsz;		// Size of the slot before this one, 0 for the first slot of a heap block. Offset from its run for small slots.
+		size_t			sz;			// Includes the size of this memslot. The low bits are SLOT_xxx flags.
 		} memslot;
 
 	// Free Slot - immediately follows the memslot structure
 	typedef struct freeslot {
 		memslot *nextfree;			// The next free slot
+		memslot *prevfree;			// The previous free slot
 	} freeslot;
 
-	#define GetSlotSize(sz)		((((sz) + (sizeof(freeslot) - 1)) & ~(sizeof(freeslot) - 1)) + sizeof(memslot))
+	// Size class run - immediately follows the memslot structure of the run, small slots follow
+	typedef struct runinfo {
+		size_t			cls;		// The size class
+		size_t			used;		// Slots allocated from this run
+	} runinfo;
+
+	#define SLOT_USED			1
+	#define SLOT_SMALL			2			// Slot is carved out of a size class run
+	#define SLOT_FLAGS			(SLOT_USED|SLOT_SMALL)
+
+	#define HEAP_ALIGN			sizeof(memslot)
+	#define HEAP_CLASSES		10			// Number of small size classes
+	#define HEAP_SMALL_MAX		(32*HEAP_ALIGN)	// Largest size class, bigger requests go to the best fit heap
+	#define HEAP_RUN_SIZE		512			// Bytes taken from the best fit heap when a size class runs dry
+	#define HEAP_RUN_MIN		4			// Minimum slots in a run
+
+	#define GetSlotSize(sz)		((((sz) + (HEAP_ALIGN - 1)) & ~(HEAP_ALIGN - 1)) + sizeof(memslot))
+	#define MinSlotSize			GetSlotSize(sizeof(freeslot))
+	#define SlotSize(pslot)		((pslot)->sz & ~(size_t)SLOT_FLAGS)
+	#define NextSlot(pslot)		((memslot *)((char *)(pslot) + SlotSize(pslot)))
+	#define PrevSlot(pslot)		((memslot *)((char *)(pslot) - (pslot)->prevsz))
 	#define NextFree(pslot)		((freeslot *)Slot2Ptr(pslot))->nextfree
+	#define PrevFree(pslot)		((freeslot *)Slot2Ptr(pslot))->prevfree
 	#define Ptr2Slot(p)			((memslot *)(p) - 1)
 	#define Slot2Ptr(pslot)		((pslot)+1)
-
-	static memslot *			firstSlot;
-	static memslot *			lastSlot;
+	#define SlotRun(pslot)		((memslot *)((char *)(pslot) - (pslot)->prevsz))
+	#define RunInfo(prun)		((runinfo *)Slot2Ptr(prun))
+
+	// Size classes in units of HEAP_ALIGN
+	static const uint8_t		classUnits[HEAP_CLASSES] = { 1, 2, 3, 4, 6, 8, 12, 16, 24, 32 };
+	static uint8_t				classOf[HEAP_SMALL_MAX/HEAP_ALIGN+1];
+	static memslot *			smallSlots[HEAP_CLASSES];
+	static memslot *			emptyRuns[HEAP_CLASSES];	// One fully free run is kept per class so a single slot does not thrash
 	static memslot *			freeSlots;
-	static char					heap[GFX_OS_HEAP_SIZE];
+	static memslot *			heapEnd;
+	static gfxMutex				heapMutex;
+	static gfxHeapStats			stats;
+	static size_t				heap[(GFX_OS_HEAP_SIZE + sizeof(size_t) - 1) / sizeof(size_t)];
+
+	static void listInsert(memslot **list, memslot *p) {
+		NextFree(p) = *list;
+		PrevFree(p) = 0;
+		if (*list)
+			PrevFree(*list) = p;
+		*list = p;
+	}
 
-	void _gosHeapInit(void) {
-		lastSlot = 0;
-		gfxAddHeapBlock(heap, GFX_OS_HEAP_SIZE);
+	static void listRemove(memslot **list, memslot *p) {
+		if (PrevFree(p))
+			NextFree(PrevFree(p)) = NextFree(p);
+		else
+			*list = NextFree(p);
+		if (NextFree(p))
+			PrevFree(NextFree(p)) = PrevFree(p);
 	}
 
-	void gfxAddHeapBlock(void *ptr, size_t sz) {
-		if (sz < sizeof(memslot)+sizeof(freeslot))
+	// Put a slot on the free list, merging it with free neighbours
+	static void slotRelease(memslot *p) {
+		memslot *n;
+
+		p->sz &= ~(size_t)SLOT_FLAGS;
+		n = NextSlot(p);
+		if (!(n->sz & SLOT_USED)) {
+			listRemove(&freeSlots, n);
+			p->sz += n->sz;
+		}
+		if (p->prevsz) {
+			n = PrevSlot(p);
+			if (!(n->sz & SLOT_USED)) {
+				listRemove(&freeSlots, n);
+				n->sz += p->sz;
+				p = n;
+			}
+		}
+		NextSlot(p)->prevsz = p->sz;
+		listInsert(&freeSlots, p);
+	}
+
+	// Give back the end of a used slot beyond sz
+	static void slotTrim(memslot *p, size_t sz) {
+		memslot *new;
+
+		if (SlotSize(p) < sz + MinSlotSize)
 			return;
+		new = (memslot *)((char *)p + sz);
+		new->prevsz = sz;
+		new->sz = SlotSize(p) - sz;
+		p->sz = sz | (p->sz & SLOT_FLAGS);
+		stats.Used -= new->sz;
+		slotRelease(new);
+	}
 
-		if (lastSlot)
-			lastSlot->next = (memslot *)ptr;
-		else
-			firstSlot = lastSlot = freeSlots = (memslot *)ptr;
+	static void heapGrew(void) {
+		if (stats.Used > stats.HighWater)
+			stats.HighWater = stats.Used;
+	}
+
+	// Give a fully free size class run back to the best fit heap
+	static void runRelease(memslot *run) {
+		memslot *p, *end;
+		size_t	 sz;
+
+		sz = classUnits[RunInfo(run)->cls] * HEAP_ALIGN + sizeof(memslot);
+		end = NextSlot(run);
+		for (p = (memslot *)(RunInfo(run) + 1); (char *)p + sz <= (char *)end; p = (memslot *)((char *)p + sz))
+			listRemove(&smallSlots[RunInfo(run)->cls], p);
+		stats.Used -= SlotSize(run);
+		stats.RunReleases++;
+		slotRelease(run);
+	}
+
+	static bool_t runReclaim(void) {
+		unsigned c;
+		bool_t	 any;
 
-		lastSlot->next = 0;
-		lastSlot->sz = sz;
-		NextFree(lastSlot) = 0;
+		for (any = FALSE, c = 0; c < HEAP_CLASSES; c++) {
+			if (emptyRuns[c]) {
+				runRelease(emptyRuns[c]);
+				emptyRuns[c] = 0;
+				any = TRUE;
+			}
+		}
+		return any;
+	}
+
+	// Best fit from the free list
+	static memslot *slotAlloc(size_t sz) {
+		memslot *p, *best;
+
+	retry:
+		for (best = 0, p = freeSlots; p != 0; p = NextFree(p)) {
+			if (p->sz < sz || (best && p->sz >= best->sz))
+				continue;
+			best = p;
+			if (p->sz == sz)
+				break;
+		}
+		if (!best) {
+			// Kept empty runs are the last reserve
+			if (runReclaim())
+				goto retry;
+			return 0;
+		}
+		listRemove(&freeSlots, best);
+		best->sz |= SLOT_USED;
+		stats.Used += best->sz & ~(size_t)SLOT_FLAGS;
+		slotTrim(best, sz);
+		heapGrew();
+		return best;
+	}
+
+	// Fill an empty size class with a run of slots taken from the best fit heap
+	static memslot *smallRun(unsigned c) {
+		memslot *run, *p;
+		size_t	 sz;
+		unsigned n;
+
+		sz = classUnits[c] * HEAP_ALIGN + sizeof(memslot);
+		n = HEAP_RUN_SIZE / sz;
+		if (n < HEAP_RUN_MIN)
+			n = HEAP_RUN_MIN;
+		if (!(run = slotAlloc(GetSlotSize(sizeof(runinfo) + n * sz))))
+			return 0;
+		stats.SmallRuns++;
+		RunInfo(run)->cls = c;
+		RunInfo(run)->used = 0;
+		for (p = (memslot *)(RunInfo(run) + 1); n; n--, p = (memslot *)((char *)p + sz)) {
+			p->prevsz = (char *)p - (char *)run;
+			p->sz = sz | SLOT_SMALL;
+			listInsert(&smallSlots[c], p);
+		}
+		return smallSlots[c];
+	}
+
+	void _gosHeapInit(void) {
+		unsigned	c, u;
+
+		for (c = 0, u = 0; u <= HEAP_SMALL_MAX/HEAP_ALIGN; u++) {
+			if (u > classUnits[c])
+				c++;
+			classOf[u] = c;
+		}
+		gfxMutexInit(&heapMutex);
+		gfxAddHeapBlock(heap, sizeof(heap));
+	}
+
+	void gfxAddHeapBlock(void *ptr, size_t sz) {
+		memslot *p;
+
+		p = (memslot *)(((size_t)ptr + (HEAP_ALIGN - 1)) & ~(HEAP_ALIGN - 1));
+		if (sz < (size_t)((char *)p - (char *)ptr) + MinSlotSize + sizeof(memslot))
+			return;
+		sz = (sz - ((char *)p - (char *)ptr)) & ~(HEAP_ALIGN - 1);
+
+		gfxMutexEnter(&heapMutex);
+		stats.Size += sz;
+
+		// A block that starts where the last one ended takes over its end marker
+		if (heapEnd && p == heapEnd + 1) {
+			p = heapEnd;
+			sz += sizeof(memslot);
+		} else
+			p->prevsz = 0;
+
+		// Every heap block ends with a used marker so merging never runs off the end
+		p->sz = (sz - sizeof(memslot)) | SLOT_USED;
+		heapEnd = NextSlot(p);
+		heapEnd->prevsz = SlotSize(p);
+		heapEnd->sz = SLOT_USED;
+		slotRelease(p);
+		gfxMutexExit(&heapMutex);
 	}
 
 	void *gfxAlloc(size_t sz) {
-		register memslot *prev, *p, *new;
+		memslot *p;
+		unsigned c;
 
 		if (!sz) return 0;
-		sz = GetSlotSize(sz);
-		for (prev = 0, p = freeSlots; p != 0; prev = p, p = NextFree(p)) {
-			// Loop till we have a block big enough
-			if (p->sz < sz)
-				continue;
-			// Can we save some memory by splitting this block?
-			if (p->sz >= sz + sizeof(memslot)+sizeof(freeslot)) {
-				new = (memslot *)((char *)p + sz);
-				new->next = p->next;
-				p->next = new;
-				new->sz = p->sz - sz;
-				p->sz = sz;
-				if (lastSlot == p)
-					lastSlot = new;
-				NextFree(new) = NextFree(p);
-				NextFree(p) = new;
+		gfxMutexEnter(&heapMutex);
+		stats.Allocs++;
+
+		// Small requests pop a slot off their size class list
+		if (sz <= HEAP_SMALL_MAX) {
+			c = classOf[(sz + (HEAP_ALIGN - 1)) / HEAP_ALIGN];
+			if ((p = smallSlots[c]) || (p = smallRun(c))) {
+				listRemove(&smallSlots[c], p);
+				p->sz |= SLOT_USED;
+				if (!RunInfo(SlotRun(p))->used++ && emptyRuns[c] == SlotRun(p))
+					emptyRuns[c] = 0;
+				stats.SmallAllocs++;
+				gfxMutexExit(&heapMutex);
+				return Slot2Ptr(p);
 			}
-			// Remove it from the free list
-			if (prev)
-				NextFree(prev) = NextFree(p);
-			else
-				freeSlots = NextFree(p);
-			// Return the result found
-			return Slot2Ptr(p);
 		}
-		// No slots large enough
-		return 0;
+
+		if (!(p = slotAlloc(GetSlotSize(sz)))) {
+			stats.Failures++;
+			stats.LastFailSize = sz;
+		}
+		gfxMutexExit(&heapMutex);
+		return p ? Slot2Ptr(p) : 0;
 	}
 
 	void *gfxRealloc(void *ptr, size_t oldsz, size_t sz) {
-		register memslot *prev, *p, *new;
+		register memslot *p, *n;
+		void *new;
 		(void) oldsz;
 
 		if (!ptr)
@@ -117,79 +300,87 @@
 		}
 
 		p = Ptr2Slot(ptr);
-		sz = GetSlotSize(sz);
-
-		// If the next slot is free (and contiguous) merge it into this one
-		if ((char *)p + p->sz == (char *)p->next) {
-			for (prev = 0, new = freeSlots; new != 0; prev = new, new = NextFree(new)) {
-				if (new == p->next) {
-					p->next = new->next;
-					p->sz += new->sz;
-					if (prev)
-						NextFree(prev) = NextFree(new);
-					else
-						freeSlots = NextFree(new);
-					if (lastSlot == new)
-						lastSlot = p;
-					break;
-				}
+		if (p->sz & SLOT_SMALL) {
+			if (GetSlotSize(sz) <= SlotSize(p))
+				return ptr;
+		} else {
+			gfxMutexEnter(&heapMutex);
+			sz = GetSlotSize(sz);
+
+			// If the next slot is free and big enough grow into it
+			n = NextSlot(p);
+			if (sz > SlotSize(p) && !(n->sz & SLOT_USED) && SlotSize(p) + n->sz >= sz) {
+				listRemove(&freeSlots, n);
+				p->sz += n->sz;
+				NextSlot(p)->prevsz = SlotSize(p);
+				stats.Used += n->sz;
+				heapGrew();
 			}
-		}
 
-		// If this block is large enough we are nearly done
-		if (sz < p->sz) {
-			// Can we save some memory by splitting this block?
-			if (p->sz >= sz + sizeof(memslot)+sizeof(freeslot)) {
-				new = (memslot *)((char *)p + sz);
-				new->next = p->next;
-				p->next = new;
-				new->sz = p->sz - sz;
-				p->sz = sz;
-				if (lastSlot == p)
-					lastSlot = new;
-				NextFree(new) = freeSlots;
-				freeSlots = new;
+			// If this block is large enough we are done
+			if (sz <= SlotSize(p)) {
+				slotTrim(p, sz);
+				gfxMutexExit(&heapMutex);
+				return ptr;
 			}
-			return Slot2Ptr(p);
+			gfxMutexExit(&heapMutex);
+			sz -= sizeof(memslot);
 		}
 
 		// We need to do this the hard way
 		new = gfxAlloc(sz);
-		if (new)
+		if (!new)
 			return 0;
-		memcpy(new, ptr, p->sz - sizeof(memslot));
+		memcpy(new, ptr, SlotSize(p) - sizeof(memslot) < sz ? SlotSize(p) - sizeof(memslot) : sz);
 		gfxFree(ptr);
 		return new;
 	}
 
 	void gfxFree(void *ptr) {
-		register memslot *prev, *p, *new;
+		register memslot *p, *run;
+		unsigned c;
 
 		if (!ptr)
 			return;
 
 		p = Ptr2Slot(ptr);
-
-		// If the next slot is free (and contiguous) merge it into this one
-		if ((char *)p + p->sz == (char *)p->next) {
-			for (prev = 0, new = freeSlots; new != 0; prev = new, new = NextFree(new)) {
-				if (new == p->next) {
-					p->next = new->next;
-					p->sz += new->sz;
-					if (prev)
-						NextFree(prev) = NextFree(new);
-					else
-						freeSlots = NextFree(new);
-					if (lastSlot == new)
-						lastSlot = p;
-					break;
-				}
+		gfxMutexEnter(&heapMutex);
+		stats.Frees++;
+		if (p->sz & SLOT_SMALL) {
+			// Small slots go back on their size class list, a run that empties goes back to the heap
+			p->sz &= ~(size_t)SLOT_USED;
+			run = SlotRun(p);
+			c = RunInfo(run)->cls;
+			listInsert(&smallSlots[c], p);
+			if (!--RunInfo(run)->used) {
+				if (emptyRuns[c])
+					runRelease(run);
+				else
+					emptyRuns[c] = run;
 			}
+		} else {
+			stats.Used -= SlotSize(p);
+			slotRelease(p);
 		}
+		gfxMutexExit(&heapMutex);
+	}
+
+	void gfxHeapGetStats(gfxHeapStats *pstats) {
+		memslot *p;
 
-		// Add it into the free chain
-		NextFree(p) = freeSlots;
-		freeSlots = p;
+		gfxMutexEnter(&heapMutex);
+		*pstats = stats;
+		for (p = freeSlots; p != 0; p = NextFree(p)) {
+			pstats->Free += p->sz;
+			pstats->FreeBlocks++;
+			if (p->sz > pstats->LargestFree)
+				pstats->LargestFree = p->sz;
+		}
+		gfxMutexExit(&heapMutex);
+		if (pstats->LargestFree)
+			pstats->LargestFree -= sizeof(memslot);
+		if (pstats->Free)
+			pstats->Fragmentation = 100 - (unsigned)((pstats->LargestFree + sizeof(memslot)) * 100 / pstats->Free);
 	}
 #endif
 
@@ -14,6 +14,30 @@
 /* Type definitions                                                          */
 /*===========================================================================*/
 
+#if GFX_OS_HEAP_SIZE != 0 || defined(__DOXYGEN__)
+	/**
+	 * @brief	Heap usage counters
+	 * @note	Small requests are served from size class runs. A run counts as used
+	 * 			as a whole while it is on the heap.
+	 */
+	typedef struct gfxHeapStats {
+		size_t		Size;				/**< Bytes given to the heap */
+		size_t		Used;				/**< Bytes taken from the best fit heap including headers and size class runs */
+		size_t		HighWater;			/**< The largest value of Used so far */
+		size_t		Free;				/**< Bytes on the best fit free list */
+		size_t		LargestFree;		/**< The largest allocation that will currently succeed */
+		unsigned	FreeBlocks;			/**< Number of separate free blocks */
+		unsigned	Fragmentation;		/**< Percentage of Free that is not in the largest free block */
+		uint32_t	Allocs;
+		uint32_t	Frees;
+		uint32_t	SmallAllocs;		/**< Allocations served from a size class */
+		uint32_t	SmallRuns;			/**< Size class runs taken from the best fit heap */
+		uint32_t	RunReleases;		/**< Size class runs given back when all their slots were freed */
+		uint32_t	Failures;			/**< Allocations that returned NULL */
+		size_t		LastFailSize;		/**< Size of the last failed allocation */
+	} gfxHeapStats;
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -30,6 +54,13 @@ extern "C" {
 		 * 			internal ugfx heap allocator rather than its own allocator.
 		 */
 		void gfxAddHeapBlock(void *ptr, size_t sz);
+
+		/**
+		 * @brief	Get the heap usage counters
+		 * @pre		GFX_OS_HEAP_SIZE != 0 and an operating system that uses the
+		 * 			internal ugfx heap allocator rather than its own allocator.
+		 */
+		void gfxHeapGetStats(gfxHeapStats *pstats);
 	#endif
 
 	void *gfxAlloc(size_t sz);
@@ -429,6 +429,180 @@ void _gqueueDeinit(void)
 	}
 #endif
 
+#if GQUEUE_NEED_RING
+	/*
+	 * Ring queues only need a compare and swap. On Cortex-M it comes from LDREX/STREX,
+	 * an interrupt between the two makes the store fail and it is tried again.
+	 */
+	#if defined(__CC_ARM)
+		static bool_t ringCAS(volatile uint32_t *p, uint32_t old, uint32_t new) {
+			do {
+				if (__ldrex(p) != old) {
+					__clrex();
+					return FALSE;
+				}
+			} while(__strex(new, p));
+			__dmb(0xF);
+			return TRUE;
+		}
+		#define ringBarrier()			__dmb(0xF)
+	#elif defined(__GNUC__)
+		#define ringCAS(p, old, new)	__sync_bool_compare_and_swap((p), (old), (new))
+		#define ringBarrier()			__sync_synchronize()
+	#else
+		#error "GQUEUE: Ring queues need a compare and swap for this compiler"
+	#endif
+
+	static void ringAdd(volatile uint32_t *p, uint32_t n) {
+		uint32_t	v;
+
+		do {
+			v = *p;
+		} while(!ringCAS(p, v, v+n));
+	}
+
+	static void ringMax(volatile uint32_t *p, uint32_t n) {
+		uint32_t	v;
+
+		while((v = *p) < n && !ringCAS(p, v, n));
+	}
+
+	#define RING_FULL		0
+	#define RING_QUEUED		1
+	#define RING_WAKE		2			// Queued and the getter needs a signal
+
+	static int ringPut(gfxQueueRing *pqueue, void * const *items, unsigned n) {
+		gfxQueueRingSlot	*ps;
+		uint32_t			pos, depth;
+		unsigned			i;
+
+		// Claim n slots. The getter frees slots in order so if the last one is free they all are.
+		do {
+			pos = pqueue->head;
+			if (n > pqueue->mask+1 || pqueue->slots[(pos+n-1) & pqueue->mask].seq != pos+n-1) {
+				ringAdd(&pqueue->full, n);
+				return RING_FULL;
+			}
+			if (!pqueue->multi) {
+				pqueue->head = pos+n;
+				break;
+			}
+		} while(!ringCAS(&pqueue->head, pos, pos+n));
+
+		// Fill them and hand each over
+		for(i = 0; i < n; i++) {
+			ps = &pqueue->slots[(pos+i) & pqueue->mask];
+			ps->item = items[i];
+			ringBarrier();
+			ps->seq = pos+i+1;
+		}
+		ringAdd(&pqueue->puts, n);
+		depth = pos+n-pqueue->tail;				// The getter may already be past them
+		if ((int32_t)depth > 0)
+			ringMax(&pqueue->highwater, depth);
+
+		// Only wake the getter if it has gone to sleep
+		ringBarrier();
+		if (!pqueue->waiting)
+			return RING_QUEUED;
+		pqueue->waiting = FALSE;
+		return RING_WAKE;
+	}
+
+	static unsigned ringTake(gfxQueueRing *pqueue, void **items, unsigned max) {
+		gfxQueueRingSlot	*ps;
+		uint32_t			pos;
+		unsigned			n;
+
+		for(pos = pqueue->tail, n = 0; n < max; n++, pos++) {
+			ps = &pqueue->slots[pos & pqueue->mask];
+			if (ps->seq != pos+1)
+				break;
+			ringBarrier();
+			items[n] = ps->item;
+			pqueue->tail = pos+1;
+			ringBarrier();
+			ps->seq = pos+pqueue->mask+1;
+		}
+		pqueue->gets += n;
+		return n;
+	}
+
+	void gfxQueueRingInit(gfxQueueRing *pqueue, gfxQueueRingSlot *slots, unsigned size, bool_t multi) {
+		unsigned	i;
+
+		for(i = 0; i < size; i++)
+			slots[i].seq = i;
+		pqueue->slots = slots;
+		pqueue->mask = size-1;
+		pqueue->multi = multi;
+		pqueue->waiting = FALSE;
+		pqueue->head = pqueue->tail = 0;
+		pqueue->puts = pqueue->full = pqueue->highwater = 0;
+		pqueue->gets = pqueue->waits = 0;
+		gfxSemInit(&pqueue->sem, 0, 1);
+	}
+
+	void gfxQueueRingDeinit(gfxQueueRing *pqueue) {
+		gfxSemDestroy(&pqueue->sem);
+	}
+
+	bool_t gfxQueueRingPut(gfxQueueRing *pqueue, void * const *items, unsigned n) {
+		switch(n ? ringPut(pqueue, items, n) : RING_QUEUED) {
+		case RING_FULL:
+			return FALSE;
+		case RING_WAKE:
+			gfxSemSignal(&pqueue->sem);
+			break;
+		}
+		return TRUE;
+	}
+
+	bool_t gfxQueueRingPutI(gfxQueueRing *pqueue, void * const *items, unsigned n) {
+		switch(n ? ringPut(pqueue, items, n) : RING_QUEUED) {
+		case RING_FULL:
+			return FALSE;
+		case RING_WAKE:
+			gfxSemSignalI(&pqueue->sem);
+			break;
+		}
+		return TRUE;
+	}
+
+	unsigned gfxQueueRingGet(gfxQueueRing *pqueue, void **items, unsigned max, delaytime_t ms) {
+		unsigned	n;
+
+		while(!(n = ringTake(pqueue, items, max)) && ms != TIME_IMMEDIATE) {
+			// Sleep only when empty. Check again after saying so in case a put just missed it.
+			pqueue->waiting = TRUE;
+			ringBarrier();
+			if ((n = ringTake(pqueue, items, max))) {
+				pqueue->waiting = FALSE;
+				break;
+			}
+			pqueue->waits++;
+			if (!gfxSemWait(&pqueue->sem, ms)) {
+				pqueue->waiting = FALSE;
+				return ringTake(pqueue, items, max);
+			}
+		}
+		return n;
+	}
+
+	unsigned gfxQueueRingGetI(gfxQueueRing *pqueue, void **items, unsigned max) {
+		return ringTake(pqueue, items, max);
+	}
+
+	void gfxQueueRingGetStats(gfxQueueRing *pqueue, gfxQueueRingStats *stats) {
+		stats->Puts = pqueue->puts;
+		stats->Gets = pqueue->gets;
+		stats->Full = pqueue->full;
+		stats->Waits = pqueue->waits;
+		stats->Depth = pqueue->head - pqueue->tail;
+		stats->HighWater = pqueue->highwater;
+	}
+#endif
+
 #if GQUEUE_NEED_BUFFERS
 	bool_t gfxBufferAlloc(unsigned num, size_t size) {
 		GDataBuffer *pd;
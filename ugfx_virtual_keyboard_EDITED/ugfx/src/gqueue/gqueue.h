@@ -81,6 +81,49 @@ typedef struct GDataBuffer {
 	size_t				len;		// @< The length of the data in the buffer area (in bytes)
 } GDataBuffer;
 
+#if GQUEUE_NEED_RING || defined(__DOXYGEN__)
+	/**
+	 * @brief	A ring queue slot
+	 * @note	The application provides an array of these, a power of two in length.
+	 */
+	typedef struct gfxQueueRingSlot {
+		volatile uint32_t	seq;		// @< Which lap of the ring the slot is free or filled for
+		void *				item;
+	} gfxQueueRingSlot;
+
+	/**
+	 * @brief	A lock free ring queue of pointers
+	 * @details	Any number of threads and interrupt routines can put (if created with multi TRUE),
+	 * 			a single thread gets. Only the getter ever waits and only when the queue is empty.
+	 */
+	typedef struct gfxQueueRing {
+		gfxQueueRingSlot *	slots;
+		uint32_t			mask;
+		bool_t				multi;		// @< More than one producer
+		volatile bool_t		waiting;	// @< The getter is asleep on the semaphore
+		volatile uint32_t	head;		// @< Next slot to be claimed by a producer
+		volatile uint32_t	tail;		// @< Next slot to be read
+		volatile uint32_t	puts;
+		volatile uint32_t	full;
+		volatile uint32_t	highwater;
+		uint32_t			gets;
+		uint32_t			waits;
+		gfxSem				sem;
+	} gfxQueueRing;
+
+	/**
+	 * @brief	Ring queue counters
+	 */
+	typedef struct gfxQueueRingStats {
+		uint32_t	Puts;			// @< Items put
+		uint32_t	Gets;			// @< Items got
+		uint32_t	Full;			// @< Items refused because the queue was full
+		uint32_t	Waits;			// @< Times the getter slept on an empty queue
+		uint32_t	Depth;			// @< Items in the queue now
+		uint32_t	HighWater;		// @< Most items ever in the queue
+	} gfxQueueRingStats;
+#endif
+
 /*===========================================================================*/
 /* Function declarations.                                                    */
 /*===========================================================================*/
@@ -403,6 +446,39 @@ void gfxBufferReleaseI(GDataBuffer *pd);
 /** @} */
 
 
+#if GQUEUE_NEED_RING || defined(__DOXYGEN__)
+	/**
+	 * @name	Ring queue functions
+	 * @brief	Lock free queues of pointers that are safe to put to from interrupt routines
+	 *
+	 * @param[in]	pqueue	A pointer to the queue
+	 * @param[in]	slots	The slot array. Its size must be a power of two.
+	 * @param[in]	size	The number of slots
+	 * @param[in]	multi	TRUE if more than one thread or interrupt routine puts to the queue
+	 * @param[in]	items	The items to put or where to put the items got
+	 * @param[in]	n		The number of items to put
+	 * @param[in]	max		The maximum number of items to get
+	 * @param[in]	ms		The maximum time to wait for an item if the queue is empty
+	 *
+	 * @note	A Put() queues all the items in order or, if there is not room for all of them, none of them.
+	 * 			It returns FALSE when the queue is full. Nothing ever blocks a putter.
+	 * @note	Get() returns the number of items got, 0 on timeout. Only one thread may get.
+	 * @note	The routines ending in "I" are interrupt/system/iclass level routines.
+	 *
+	 * @api
+	 * @{
+	 */
+	void gfxQueueRingInit(gfxQueueRing *pqueue, gfxQueueRingSlot *slots, unsigned size, bool_t multi);
+	void gfxQueueRingDeinit(gfxQueueRing *pqueue);
+	bool_t gfxQueueRingPut(gfxQueueRing *pqueue, void * const *items, unsigned n);
+	bool_t gfxQueueRingPutI(gfxQueueRing *pqueue, void * const *items, unsigned n);
+	unsigned gfxQueueRingGet(gfxQueueRing *pqueue, void **items, unsigned max, delaytime_t ms);
+	unsigned gfxQueueRingGetI(gfxQueueRing *pqueue, void **items, unsigned max);
+	void gfxQueueRingGetStats(gfxQueueRing *pqueue, gfxQueueRingStats *stats);
+	#define gfxQueueRingIsEmpty(pqueue)		((pqueue)->head == (pqueue)->tail)
+	/** @} */
+#endif
+
 #ifdef __cplusplus
 }
 #endif
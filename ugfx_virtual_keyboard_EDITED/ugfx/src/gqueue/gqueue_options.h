@@ -47,6 +47,14 @@
 	#ifndef GQUEUE_NEED_BUFFERS
 		#define GQUEUE_NEED_BUFFERS		FALSE
 	#endif
+	/**
+	 * @brief	Enable lock free Ring Queues
+	 * @details	Defaults to FALSE
+	 * @note	Needs an atomic compare and swap, provided for Keil ARMCC and GCC.
+	 */
+	#ifndef GQUEUE_NEED_RING
+		#define GQUEUE_NEED_RING		FALSE
+	#endif
 /**
  * @}
  *
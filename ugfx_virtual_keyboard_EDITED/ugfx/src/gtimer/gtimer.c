@@ -7,20 +7,40 @@
 
 #include "../../gfx.h"
 
+#include <string.h>
+
 #if GFX_USE_GTIMER || defined(__DOXYGEN__)
 
 #define GTIMER_FLG_PERIODIC		0x0001
 #define GTIMER_FLG_INFINITE		0x0002
 #define GTIMER_FLG_JABBED		0x0004
 #define GTIMER_FLG_SCHEDULED	0x0008
+#define GTIMER_FLG_TIMED		0x0010		// The last callback was on time rather than jabbed
 
-/* Don't rework this macro to use a ternary operator - the gcc compiler stuffs it up */
-#define TimeIsWithin(x, start, end)	((end >= start && x >= start && x <= end) || (end < start && (x >= start || x <= end)))
+/*
+ * Timers live on a hierarchical timing wheel counting milliseconds. Level 0 has a slot per millisecond,
+ * each higher level has a slot per turn of the level below. When a level turns over the next slot of the
+ * level above is cascaded down. Starting and stopping a timer is O(1), expiry is amortised O(1).
+ */
+#define WHEEL_BITS		6
+#define WHEEL_SIZE		(1<<WHEEL_BITS)
+#define WHEEL_MASK		(WHEEL_SIZE-1)
+#define WHEEL_LEVELS	4
+#define WHEEL_MAX		((1UL<<(WHEEL_BITS*WHEEL_LEVELS))-1)	// Furthest ahead a timer is placed, further timers are placed again on cascade
+#define WHEEL_MAXSLEEP	5000									// The system ticks must be read more often than they wrap
+#define WHEEL_DUE		(WHEEL_LEVELS*WHEEL_SIZE)				// Slot for timers that are already due
 
 /* This mutex protects access to our tables */
 static gfxMutex			mutex;
 static gfxThreadHandle	hThread = 0;
-static GTimer			*pTimerHead = 0;
+static GTimer			*wheel[WHEEL_DUE+1];
+static unsigned			wheelCount;						// Timers on the wheel
+static uint32_t			wheelNow;						// The next millisecond to be processed
+static GTimer			*pInfinite = 0;					// Timers that only run when jabbed
+static volatile bool_t	jabPending;
+static uint32_t			clockMs;
+static systemticks_t	clockLast;
+static systemticks_t	clockPart;						// Ticks not yet making up a millisecond
 static gfxSem			waitsem;
 static systemticks_t	ticks2ms;
 static DECLARE_THREAD_STACK(waTimerThread, GTIMER_THREAD_WORKAREA_SIZE);
@@ -29,84 +49,250 @@ static DECLARE_THREAD_STACK(waTimerThread, GTIMER_THREAD_WORKAREA_SIZE);
 /* Driver local functions.                                                   */
 /*===========================================================================*/
 
-static DECLARE_THREAD_FUNCTION(GTimerThreadHandler, arg) {
-	GTimer			*pt;
+// The millisecond clock. The system ticks can be much finer than a millisecond and wrap quickly.
+static uint32_t clockNow(void) {
 	systemticks_t	tm;
-	systemticks_t	nxtTimeout;
-	systemticks_t	lastTime;
+
+	tm = gfxSystemTicks();
+	clockPart += tm - clockLast;
+	clockLast = tm;
+	clockMs += clockPart / ticks2ms;
+	clockPart %= ticks2ms;
+	return clockMs;
+}
+
+static void listAdd(GTimer **phead, GTimer *pt) {
+	// Just pop it on the end of the queue
+	if (*phead) {
+		pt->next = *phead;
+		pt->prev = (*phead)->prev;
+		pt->prev->next = pt;
+		pt->next->prev = pt;
+	} else
+		pt->next = pt->prev = *phead = pt;
+}
+
+static void listRemove(GTimer **phead, GTimer *pt) {
+	if (pt->next == pt)
+		*phead = 0;
+	else {
+		pt->next->prev = pt->prev;
+		pt->prev->next = pt->next;
+		if (*phead == pt)
+			*phead = pt->next;
+	}
+}
+
+static void wheelAdd(GTimer *pt) {
+	uint32_t	e, d;
+	unsigned	level;
+
+	if (pt->flags & GTIMER_FLG_INFINITE) {
+		listAdd(&pInfinite, pt);
+		return;
+	}
+
+	e = pt->when;
+	d = e - wheelNow;
+	if ((int32_t)d < 0)
+		pt->slot = WHEEL_DUE;
+	else {
+		if (d > WHEEL_MAX) {
+			e = wheelNow + WHEEL_MAX;
+			d = WHEEL_MAX;
+		}
+		for(level = 0; d >> (WHEEL_BITS*(level+1)); level++);
+		pt->slot = level*WHEEL_SIZE + ((e >> (WHEEL_BITS*level)) & WHEEL_MASK);
+	}
+	listAdd(&wheel[pt->slot], pt);
+	wheelCount++;
+}
+
+static void wheelRemove(GTimer *pt) {
+	if (pt->flags & GTIMER_FLG_INFINITE) {
+		listRemove(&pInfinite, pt);
+		return;
+	}
+	listRemove(&wheel[pt->slot], pt);
+	wheelCount--;
+}
+
+// Move the timers in the current slot of a level down the wheel
+static unsigned wheelCascade(unsigned level) {
+	GTimer		*pt, *list;
+	unsigned	idx;
+
+	idx = (wheelNow >> (WHEEL_BITS*level)) & WHEEL_MASK;
+	list = wheel[level*WHEEL_SIZE+idx];
+	if (list) {
+		wheel[level*WHEEL_SIZE+idx] = 0;
+		list->prev->next = 0;
+		while(list) {
+			pt = list;
+			list = list->next;
+			wheelCount--;
+			wheelAdd(pt);
+		}
+	}
+	return idx;
+}
+
+// Turn the wheel up to now and take off the first timer that is due
+static GTimer *wheelExpired(uint32_t now) {
+	GTimer		*pt;
+	unsigned	level;
+
+	if ((pt = wheel[WHEEL_DUE])) {
+		wheelRemove(pt);
+		return pt;
+	}
+
+	// An empty wheel can jump straight to now
+	if (!wheelCount) {
+		wheelNow = now + 1;
+		return 0;
+	}
+	while((int32_t)(now - wheelNow) >= 0) {
+		if ((pt = wheel[wheelNow & WHEEL_MASK])) {
+			wheelRemove(pt);
+			return pt;
+		}
+		if (!(++wheelNow & WHEEL_MASK)) {
+			for(level = 1; level < WHEEL_LEVELS && !wheelCascade(level); level++);
+		}
+	}
+	return 0;
+}
+
+// The time until the next timer is due or level 0 needs to be refilled
+static delaytime_t wheelTimeout(uint32_t now) {
+	uint32_t	t;
+
+	if (!wheelCount)
+		return WHEEL_MAXSLEEP;
+	if (wheel[WHEEL_DUE])
+		return TIME_IMMEDIATE;
+	for(t = wheelNow; !wheel[t & WHEEL_MASK]; )
+		if (!(++t & WHEEL_MASK))
+			break;
+	if ((int32_t)(t - now) <= 0)
+		return TIME_IMMEDIATE;
+	return t - now < WHEEL_MAXSLEEP ? t - now : WHEEL_MAXSLEEP;
+}
+
+static GTimer *findJabbed(void) {
+	GTimer		*pt;
+	unsigned	i;
+
+	if ((pt = pInfinite)) {
+		do {
+			if (pt->flags & GTIMER_FLG_JABBED)
+				return pt;
+			pt = pt->next;
+		} while(pt != pInfinite);
+	}
+	for(i = 0; i <= WHEEL_DUE; i++) {
+		if ((pt = wheel[i])) {
+			do {
+				if (pt->flags & GTIMER_FLG_JABBED)
+					return pt;
+				pt = pt->next;
+			} while(pt != wheel[i]);
+		}
+	}
+	return 0;
+}
+
+// Run a timer that has been taken off the wheel. Called with the mutex held, returns with it held.
+static void fireTimer(GTimer *pt, uint32_t now) {
 	GTimerFunction	fn;
 	void			*param;
+	uint32_t		missed;
+
+	missed = 0;
+	#if GTIMER_NEED_STATS
+		pt->stats.Fires++;
+		if (!(pt->flags & GTIMER_FLG_JABBED)) {
+			uint32_t	late;
+
+			late = (now - pt->when) * 1000 + clockPart * 1000 / ticks2ms;
+			if ((pt->flags & GTIMER_FLG_TIMED) && now - pt->when < pt->period) {
+				if (late > pt->stats.LastLateUS && late - pt->stats.LastLateUS > pt->stats.MaxJitterUS)
+					pt->stats.MaxJitterUS = late - pt->stats.LastLateUS;
+				else if (late < pt->stats.LastLateUS && pt->stats.LastLateUS - late > pt->stats.MaxJitterUS)
+					pt->stats.MaxJitterUS = pt->stats.LastLateUS - late;
+			}
+			pt->stats.LastLateUS = late;
+			if (late > pt->stats.MaxLateUS)
+				pt->stats.MaxLateUS = late;
+			pt->flags |= GTIMER_FLG_TIMED;
+		} else
+			pt->flags &= ~GTIMER_FLG_TIMED;
+	#endif
+
+	// Is this timer periodic?
+	if ((pt->flags & GTIMER_FLG_PERIODIC) && pt->period != TIME_IMMEDIATE) {
+		// Yes - Update ready for the next period
+		if (!(pt->flags & GTIMER_FLG_INFINITE)) {
+			// We may have skipped a period. Stepping from when it was due rather than from now stops drift.
+			missed = (now + pt->period - pt->when) / pt->period;
+			pt->when += missed * pt->period;
+			if (missed)
+				missed--;
+		}
+
+		// We are definitely no longer jabbed
+		pt->flags &= ~GTIMER_FLG_JABBED;
+		wheelAdd(pt);
+	} else {
+		pt->flags = 0;
+	}
+	#if GTIMER_NEED_STATS
+		pt->stats.Missed += missed;
+	#else
+		(void) missed;
+	#endif
+
+	// Call the callback function
+	fn = pt->fn;
+	param = pt->param;
+	gfxMutexExit(&mutex);
+	fn(param);
+
+	// We no longer hold the mutex, the callback function may have taken a while
+	gfxMutexEnter(&mutex);
+}
+
+static DECLARE_THREAD_FUNCTION(GTimerThreadHandler, arg) {
+	GTimer			*pt;
+	uint32_t		now;
+	delaytime_t		nxtTimeout;
 	(void)			arg;
 
-	nxtTimeout = TIME_INFINITE;
-	lastTime = 0;
+	nxtTimeout = WHEEL_MAXSLEEP;
 	while(1) {
 		/* Wait for work to do. */
 		gfxYield();					// Give someone else a go no matter how busy we are
 		gfxSemWait(&waitsem, nxtTimeout);
-		
-	restartTimerChecks:
-	
-		// Our reference time
-		tm = gfxSystemTicks();
-		nxtTimeout = TIME_INFINITE;
-		
+
 		/* We need to obtain the mutex */
 		gfxMutexEnter(&mutex);
 
-		if (pTimerHead) {
-			pt = pTimerHead;
-			do {
-				// Do we have something to do for this timer?
-				if ((pt->flags & GTIMER_FLG_JABBED) || (!(pt->flags & GTIMER_FLG_INFINITE) && TimeIsWithin(pt->when, lastTime, tm))) {
-				
-					// Is this timer periodic?
-					if ((pt->flags & GTIMER_FLG_PERIODIC) && pt->period != TIME_IMMEDIATE) {
-						// Yes - Update ready for the next period
-						if (!(pt->flags & GTIMER_FLG_INFINITE)) {
-							// We may have skipped a period.
-							// We use this complicated formulae rather than a loop
-							//	because the gcc compiler stuffs up the loop so that it
-							//	either loops forever or doesn't get executed at all.
-							pt->when += ((tm + pt->period - pt->when) / pt->period) * pt->period;
-						}
-
-						// We are definitely no longer jabbed
-						pt->flags &= ~GTIMER_FLG_JABBED;
-						
-					} else {
-						// No - get us off the timers list
-						if (pt->next == pt)
-							pTimerHead = 0;
-						else {
-							pt->next->prev = pt->prev;
-							pt->prev->next = pt->next;
-							if (pTimerHead == pt)
-								pTimerHead = pt->next;
-						}
-						pt->flags = 0;
-					}
-					
-					// Call the callback function
-					fn = pt->fn;
-					param = pt->param;
-					gfxMutexExit(&mutex);
-					fn(param);
-					
-					// We no longer hold the mutex, the callback function may have taken a while
-					// and our list may have been altered so start again!
-					goto restartTimerChecks;
-				}
-				
-				// Find when we next need to wake up
-				if (!(pt->flags & GTIMER_FLG_INFINITE) && pt->when - tm < nxtTimeout)
-					nxtTimeout = (pt->when - tm)/ticks2ms;
-				pt = pt->next;
-			} while(pt != pTimerHead);
+		// Jabbed timers first. The list may be altered by each callback so look again each time.
+		if (jabPending) {
+			jabPending = FALSE;
+			while((pt = findJabbed())) {
+				wheelRemove(pt);
+				fireTimer(pt, clockNow());
+			}
 		}
 
+		// Everything that is due
+		while((pt = wheelExpired(now = clockNow())))
+			fireTimer(pt, now);
+
 		// Ready for the next loop
-		lastTime = tm;
+		nxtTimeout = wheelTimeout(now);
 		gfxMutexExit(&mutex);
 	}
 	THREAD_RETURN(0);
@@ -117,6 +303,7 @@ void _gtimerInit(void)
 	gfxSemInit(&waitsem, 0, 1);
 	gfxMutexInit(&mutex);
 	ticks2ms = gfxMillisecondsToTicks(1);
+	clockLast = gfxSystemTicks();
 }
 
 void _gtimerDeinit(void)
@@ -148,14 +335,7 @@ void gtimerStart(GTimer *pt, GTimerFunction fn, void *param, bool_t periodic, de
 	// Is this already scheduled?
 	if (pt->flags & GTIMER_FLG_SCHEDULED) {
 		// Cancel it!
-		if (pt->next == pt)
-			pTimerHead = 0;
-		else {
-			pt->next->prev = pt->prev;
-			pt->prev->next = pt->next;
-			if (pTimerHead == pt)
-				pTimerHead = pt->next;
-		}
+		wheelRemove(pt);
 	}
 	
 	// Set up the timer structure
@@ -168,18 +348,13 @@ void gtimerStart(GTimer *pt, GTimerFunction fn, void *param, bool_t periodic, de
 		pt->flags |= GTIMER_FLG_INFINITE;
 		pt->period = TIME_INFINITE;
 	} else {
-		pt->period = gfxMillisecondsToTicks(millisec);
-		pt->when = gfxSystemTicks() + pt->period;
+		pt->period = millisec;
+		pt->when = clockNow() + pt->period;
 	}
-
-	// Just pop it on the end of the queue
-	if (pTimerHead) {
-		pt->next = pTimerHead;
-		pt->prev = pTimerHead->prev;
-		pt->prev->next = pt;
-		pt->next->prev = pt;
-	} else
-		pt->next = pt->prev = pTimerHead = pt;
+	#if GTIMER_NEED_STATS
+		memset(&pt->stats, 0, sizeof(pt->stats));
+	#endif
+	wheelAdd(pt);
 
 	// Bump the thread
 	if (!(pt->flags & GTIMER_FLG_INFINITE))
@@ -191,14 +366,7 @@ void gtimerStop(GTimer *pt) {
 	gfxMutexEnter(&mutex);
 	if (pt->flags & GTIMER_FLG_SCHEDULED) {
 		// Cancel it!
-		if (pt->next == pt)
-			pTimerHead = 0;
-		else {
-			pt->next->prev = pt->prev;
-			pt->prev->next = pt->next;
-			if (pTimerHead == pt)
-				pTimerHead = pt->next;
-		}
+		wheelRemove(pt);
 		// Make sure we know the structure is dead!
 		pt->flags = 0;
 	}
@@ -214,6 +382,7 @@ void gtimerJab(GTimer *pt) {
 	
 	// Jab it!
 	pt->flags |= GTIMER_FLG_JABBED;
+	jabPending = TRUE;
 
 	// Bump the thread
 	gfxSemSignal(&waitsem);
@@ -223,9 +392,18 @@ void gtimerJab(GTimer *pt) {
 void gtimerJabI(GTimer *pt) {
 	// Jab it!
 	pt->flags |= GTIMER_FLG_JABBED;
+	jabPending = TRUE;
 
 	// Bump the thread
 	gfxSemSignalI(&waitsem);
 }
 
+#if GTIMER_NEED_STATS
+	void gtimerGetStats(GTimer *pt, GTimerStats *stats) {
+		gfxMutexEnter(&mutex);
+		*stats = pt->stats;
+		gfxMutexExit(&mutex);
+	}
+#endif
+
 #endif /* GFX_USE_GTIMER */
@@ -37,8 +37,25 @@
 /* Type definitions                                                          */
 /*===========================================================================*/
 
-/* Data part of a static GTimer initialiser */
-#define _GTIMER_DATA() {0,0,0,0,0,0,0}
+#if GTIMER_NEED_STATS || defined(__DOXYGEN__)
+	/**
+	 * @brief	Timing of a timer's callbacks since it was started
+	 * @note	Lateness is measured from when the callback was due, jabbed callbacks are only counted in Fires.
+	 */
+	typedef struct GTimerStats {
+		uint32_t			Fires;			/**< Callbacks made */
+		uint32_t			Missed;			/**< Periods skipped because a callback was too late */
+		uint32_t			LastLateUS;		/**< How late the last callback was in microseconds */
+		uint32_t			MaxLateUS;
+		uint32_t			MaxJitterUS;	/**< Largest change in lateness between consecutive periods */
+	} GTimerStats;
+
+	/* Data part of a static GTimer initialiser */
+	#define _GTIMER_DATA() {0,0,0,0,0,0,0,0,{0,0,0,0,0}}
+#else
+	/* Data part of a static GTimer initialiser */
+	#define _GTIMER_DATA() {0,0,0,0,0,0,0,0}
+#endif
 
 /* Static GTimer initialiser */
 #define GTIMER_DECL(name) GTimer name = _GTIMER_DATA()
@@ -57,6 +74,10 @@ typedef struct GTimer_t {
 	uint16_t			flags;
 	struct GTimer_t		*next;
 	struct GTimer_t		*prev;
+	uint16_t			slot;
+	#if GTIMER_NEED_STATS
+		GTimerStats		stats;
+	#endif
 } GTimer;
 
 /*===========================================================================*/
@@ -169,6 +190,17 @@ void gtimerJab(GTimer *pt);
  */
 void gtimerJabI(GTimer *pt);
 
+#if GTIMER_NEED_STATS || defined(__DOXYGEN__)
+	/**
+	 * @brief   			Get the timing of a timer's callbacks
+	 * @param[in] pt		Pointer to a GTimer structure
+	 * @param[out] stats	The statistics, reset each time the timer is started
+	 * @pre					GTIMER_NEED_STATS must be TRUE
+	 * @api
+	 */
+	void gtimerGetStats(GTimer *pt, GTimerStats *stats);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -20,6 +20,13 @@
  * @name    GTIMER Functionality to be included
  * @{
  */
+	/**
+	 * @brief	Keep callback count, lateness and jitter for each timer
+	 * @details	Defaults to FALSE
+	 */
+	#ifndef GTIMER_NEED_STATS
+		#define GTIMER_NEED_STATS				FALSE
+	#endif
 /**
  * @}
  *
@@ -491,6 +491,34 @@ extern "C" {
 		 */
 		void gwinRedrawDisplay(GDisplay *g, bool_t preserve);
 
+		/**
+		 * @brief	Redraw statistics of the window manager
+		 * @note	A frame is one pass of the window manager over the damaged screen area.
+		 * 			Each pixel is painted only by the top-most window covering it so
+		 * 			PaintedPixels above DamagedPixels shows repainting of the same pixel.
+		 */
+		typedef struct GWindowDamageStats {
+			uint32_t	Frames;					/**< Frames painted */
+			uint32_t	DamagedPixels;			/**< Damaged area of the last frame */
+			uint32_t	PaintedPixels;			/**< Pixels painted in the last frame */
+			uint32_t	TotalDamaged;			/**< Damaged area of all frames */
+			uint32_t	TotalPainted;			/**< Pixels painted in all frames */
+			uint32_t	WindowsPainted;			/**< Windows that painted part of the damage */
+			uint32_t	WindowsCulled;			/**< Windows in the damaged area but covered by the windows above */
+			uint32_t	WindowsSkipped;			/**< Visible windows outside the damaged area */
+			uint32_t	Overflows;				/**< Times the damage was merged into its bounding box */
+			uint32_t	ScrolledPixels;			/**< Pixels moved on the display instead of being redrawn */
+		} GWindowDamageStats;
+
+		/**
+		 * @brief	Get the window manager redraw statistics
+		 *
+		 * @param[out] pstats		The statistics
+		 *
+		 * @api
+		 */
+		void gwinGetDamageStats(GWindowDamageStats *pstats);
+
 		/**
 		 * @brief	Minimize, Maximize or Restore a window
 		 * @pre		GWIN_NEED_WINDOWMANAGER must be TRUE
@@ -1054,6 +1082,9 @@ extern "C" {
 	#if GWIN_NEED_GRAPH || defined(__DOXYGEN__)
 		#include "gwin_graph.h"
 	#endif
+	#if GWIN_NEED_CHART || defined(__DOXYGEN__)
+		#include "gwin_chart.h"
+	#endif
 	#if GWIN_NEED_IMAGE || defined(__DOXYGEN__)
 		#include "gwin_image.h"
 	#endif
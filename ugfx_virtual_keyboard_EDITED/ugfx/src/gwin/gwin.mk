@@ -8,6 +8,7 @@ GFXSRC +=   $(GFXLIB)/src/gwin/gwin.c \
 			$(GFXLIB)/src/gwin/gwin_wm.c \
 			$(GFXLIB)/src/gwin/gwin_console.c \
 			$(GFXLIB)/src/gwin/gwin_graph.c \
+			$(GFXLIB)/src/gwin/gwin_chart.c \
 			$(GFXLIB)/src/gwin/gwin_button.c \
 			$(GFXLIB)/src/gwin/gwin_slider.c \
 			$(GFXLIB)/src/gwin/gwin_checkbox.c \
@@ -0,0 +1,375 @@
+/*
+ * This file is subject to the terms of the GFX License. If a copy of
+ * the license was not distributed with this file, you can obtain one at:
+ *
+ *              http://ugfx.org/license.html
+ */
+
+/**
+ * @file    src/gwin/gwin_chart.c
+ * @brief   GWIN sub-system streaming chart code
+ */
+
+#include "../../gfx.h"
+
+#if GFX_USE_GWIN && GWIN_NEED_CHART
+
+#include "gwin_class.h"
+
+#include <string.h>
+
+#define GCHART_FLG_ALLOCPLOT				(GWIN_FIRST_CONTROL_FLAG<<0)
+#define GCHART_LABEL						"-000"			// The widest label the margin leaves room for
+
+#define gc2obj		((GChartObject *)gh)
+
+static void ChartDestroy(GHandle gh);
+static void ChartRedraw(GHandle gh);
+
+static const gwinVMT chartVMT = {
+		"Chart",				// The classname
+		sizeof(GChartObject),	// The object size
+		ChartDestroy,			// The destroy routine
+		ChartRedraw,			// The redraw routine
+		0,						// The after-clear routine
+};
+
+// The plot row of a value. Row 0 is the top of the plot.
+static coord_t ChartRow(GChartObject *gc, int32_t v) {
+	if (v <= gc->ymin)
+		return gc->ph-1;
+	if (v >= gc->ymax)
+		return 0;
+	return gc->ph - 1 - (coord_t)(((v - gc->ymin) * (gc->ph - 1)) / ((int32_t)gc->ymax - gc->ymin));
+}
+
+// Paint one column of the background layer with the horizontal grid lines on it.
+//	It is copied into every new column rather than worked out again.
+static void ChartBackground(GChartObject *gc) {
+	coord_t		y;
+	int32_t		v;
+
+	for(y = 0; y < gc->ph; y++)
+		gc->background[y] = gc->g.bgcolor;
+	if (gc->ygrid > 0) {
+		for(v = (int32_t)gc->ymin + gc->ygrid; v <= gc->ymax; v += gc->ygrid)
+			gc->background[ChartRow(gc, v)] = gc->gridcolor;
+	}
+}
+
+// Draw a column into the plot. Column i is i columns older than the newest one.
+static void ChartDrawColumn(GChartObject *gc, coord_t x, unsigned i) {
+	GChartSeries *	ps;
+	pixel_t *		p;
+	coord_t			y, y1;
+	unsigned		head, ring, c, pc, s;
+	int16_t			lo, hi;
+
+	// The background, or a vertical grid line which moves with the samples
+	p = gc->plot + x;
+	if (i < gc->ccount && gc->xgrid && !((gc->colno - i) % gc->xgrid)) {
+		for(y = 0; y < gc->ph; y++, p += gc->pw)
+			*p = gc->gridcolor;
+	} else {
+		for(y = 0; y < gc->ph; y++, p += gc->pw)
+			*p = gc->background[y];
+	}
+	if (i >= gc->ccount)
+		return;
+
+	// The column rings hold one column more than the plot width
+	head = gc->chead;
+	ring = (unsigned)gc->pw + 1;
+	c = head >= i ? head - i : head + ring - i;
+	pc = c ? c - 1 : ring - 1;
+	for(s = 0, ps = gc->series; s < gc->nseries; s++, ps++) {
+		lo = ps->colmin[c];
+		hi = ps->colmax[c];
+		if (lo == GWIN_CHART_NODATA)
+			continue;
+
+		// Reach the previous column so that the trace is continuous. The rings keep one column
+		//	more than the plot shows so the oldest column drawn still has one.
+		if (i+1 < gc->ccount && ps->colmin[pc] != GWIN_CHART_NODATA) {
+			if (ps->colmax[pc] < lo)
+				lo = ps->colmax[pc];
+			if (ps->colmin[pc] > hi)
+				hi = ps->colmin[pc];
+		}
+
+		y1 = ChartRow(gc, lo);
+		for(y = ChartRow(gc, hi), p = gc->plot + y * gc->pw + x; y <= y1; y++, p += gc->pw)
+			*p = ps->color;
+	}
+}
+
+// Draw the whole plot from the columns
+static void ChartRenderPlot(GChartObject *gc) {
+	coord_t		x;
+
+	ChartBackground(gc);
+	for(x = 0; x < gc->pw; x++)
+		ChartDrawColumn(gc, x, gc->pw - 1 - x);
+}
+
+// Move the plot left by one pixel and draw the new column
+static void ChartScrollPlot(GChartObject *gc) {
+	pixel_t *	p;
+	coord_t		y;
+
+	for(y = 0, p = gc->plot; y < gc->ph; y++, p += gc->pw)
+		memmove(p, p+1, (gc->pw - 1) * sizeof(pixel_t));
+	ChartDrawColumn(gc, gc->pw - 1, 0);
+}
+
+static void ChartResetColumns(GChartObject *gc) {
+	gc->chead = gc->pw;
+	gc->ccount = 0;
+	gc->colno = 0;
+}
+
+// Add sample number t of each series to the columns. Returns TRUE if it started a new column.
+//	Columns start on whole multiples of the samples per column so the same history always gives the same plot.
+static bool_t ChartAddColumnSamples(GChartObject *gc, const int16_t *values, uint32_t t) {
+	GChartSeries *	ps;
+	unsigned		s;
+	bool_t			newcol;
+
+	newcol = FALSE;
+	if (!gc->ccount || !(t % gc->percolumn)) {
+		gc->chead = gc->chead >= gc->pw ? 0 : gc->chead + 1;
+		if (gc->ccount <= gc->pw)
+			gc->ccount++;
+		gc->colno = t / gc->percolumn;
+		for(s = 0, ps = gc->series; s < gc->nseries; s++, ps++)
+			ps->colmin[gc->chead] = ps->colmax[gc->chead] = GWIN_CHART_NODATA;
+		newcol = TRUE;
+	}
+
+	for(s = 0, ps = gc->series; s < gc->nseries; s++, ps++) {
+		if (values[s] == GWIN_CHART_NODATA)
+			continue;
+		if (ps->colmin[gc->chead] == GWIN_CHART_NODATA || values[s] < ps->colmin[gc->chead])
+			ps->colmin[gc->chead] = values[s];
+		if (ps->colmax[gc->chead] == GWIN_CHART_NODATA || values[s] > ps->colmax[gc->chead])
+			ps->colmax[gc->chead] = values[s];
+	}
+	return newcol;
+}
+
+// Work the columns out again from the history
+static void ChartRebuildColumns(GChartObject *gc) {
+	int16_t		values[GWIN_CHART_MAX_SERIES];
+	unsigned	n, pos, s;
+	uint32_t	t;
+
+	ChartResetColumns(gc);
+
+	if (!gc->total)
+		return;
+
+	// Start from the first sample of the oldest column the rings keep, if the history reaches back that far
+	t = (gc->total - 1) / gc->percolumn;
+	t = t > (uint32_t)gc->pw ? (t - gc->pw) * gc->percolumn : 0;
+	n = gc->total - t;
+	if (n > gc->scount) {
+		n = gc->scount;
+		t = gc->total - n;
+	}
+	pos = gc->shead >= n ? gc->shead - n : gc->shead + gc->capacity - n;
+	for(; t != gc->total; t++) {
+		for(s = 0; s < gc->nseries; s++)
+			values[s] = gc->series[s].samples[pos];
+		ChartAddColumnSamples(gc, values, t);
+		if (++pos >= gc->capacity)
+			pos = 0;
+	}
+}
+
+// Label a value against the plot row it is on
+static void ChartLabel(GChartObject *gc, int32_t v) {
+	char		buf[8];
+	char *		p;
+	uint32_t	u;
+	coord_t		fh;
+
+	p = buf + sizeof(buf);
+	*--p = 0;
+	u = v < 0 ? -v : v;
+	do {
+		*--p = '0' + u % 10;
+		u /= 10;
+	} while(u && p > buf+1);
+	if (v < 0)
+		*--p = '-';
+
+	fh = gdispGetFontMetric(gc->g.font, fontHeight);
+	gdispGDrawStringBox(gc->g.display, gc->g.x, gc->g.y + gc->py + ChartRow(gc, v) - fh/2, gc->px - 3, fh, p, gc->g.font, gc->g.color, justifyRight);
+}
+
+static void ChartDestroy(GHandle gh) {
+	unsigned	s;
+
+	for(s = 0; s < gc2obj->nseries; s++)
+		gfxFree(gc2obj->series[s].samples);
+	gc2obj->nseries = 0;
+	if ((gh->flags & GCHART_FLG_ALLOCPLOT))
+		gfxFree(gc2obj->plot);
+	gc2obj->plot = 0;
+}
+
+static void ChartRedraw(GHandle gh) {
+	coord_t		y;
+	int32_t		v;
+
+	if (!gc2obj->plot) {
+		gdispGFillArea(gh->display, gh->x, gh->y, gh->width, gh->height, gh->bgcolor);
+		return;
+	}
+
+	// The plot is redrawn from the columns. It is not kept up to date while the chart is hidden.
+	ChartRenderPlot(gc2obj);
+
+	// The label margin and the strips above and below the plot
+	gdispGFillArea(gh->display, gh->x, gh->y, gc2obj->px, gh->height, gh->bgcolor);
+	gdispGFillArea(gh->display, gh->x+gc2obj->px, gh->y, gc2obj->pw, gc2obj->py, gh->bgcolor);
+	y = gc2obj->py + gc2obj->ph;
+	gdispGFillArea(gh->display, gh->x+gc2obj->px, gh->y+y, gc2obj->pw, gh->height - y, gh->bgcolor);
+
+	// The axes
+	gdispGDrawLine(gh->display, gh->x+gc2obj->px-1, gh->y+gc2obj->py, gh->x+gc2obj->px-1, gh->y+y, gh->color);
+	gdispGDrawLine(gh->display, gh->x+gc2obj->px, gh->y+y, gh->x+gc2obj->px+gc2obj->pw-1, gh->y+y, gh->color);
+
+	// Label the bottom, each horizontal grid line and the top
+	if (gh->font) {
+		for(v = gc2obj->ymin; v < gc2obj->ymax; v += gc2obj->ygrid > 0 ? gc2obj->ygrid : gc2obj->ymax - gc2obj->ymin)
+			ChartLabel(gc2obj, v);
+		ChartLabel(gc2obj, gc2obj->ymax);
+	}
+
+	gdispGBlitArea(gh->display, gh->x+gc2obj->px, gh->y+gc2obj->py, gc2obj->pw, gc2obj->ph, 0, 0, gc2obj->pw, gc2obj->plot);
+}
+
+GHandle gwinGChartCreate(GDisplay *g, GChartObject *gc, const GWindowInit *pInit, unsigned history, void *plotmem) {
+	coord_t		fh;
+
+	if (!(gc = (GChartObject *)_gwindowCreate(g, &gc->g, pInit, &chartVMT, 0)))
+		return 0;
+
+	// Leave room for the labels on the left and for half a label above and below the plot
+	gc->px = 1;
+	fh = 0;
+	if (gc->g.font) {
+		gc->px += gdispGetStringWidth(GCHART_LABEL, gc->g.font) + 3;
+		fh = (gdispGetFontMetric(gc->g.font, fontHeight) + 1) / 2;
+	}
+	gc->py = fh;
+	gc->pw = gc->g.width - gc->px;
+	gc->ph = gc->g.height - 2 * fh - 1;
+	gc->plot = 0;
+	if (gc->pw > 1 && gc->ph > 1) {
+		if (plotmem)
+			gc->plot = (pixel_t *)plotmem;
+		else if ((gc->plot = gfxAlloc((gc->pw + 1) * gc->ph * sizeof(pixel_t))))
+			gc->g.flags |= GCHART_FLG_ALLOCPLOT;
+	}
+	gc->background = gc->plot ? gc->plot + gc->pw * gc->ph : 0;
+
+	gc->ymin = 0;
+	gc->ymax = 100;
+	gc->ygrid = 0;
+	gc->xgrid = 0;
+	gc->gridcolor = GRAY;
+	gc->capacity = history;
+	gc->shead = gc->scount = 0;
+	gc->total = 0;
+	gc->percolumn = 1;
+	gc->nseries = 0;
+	ChartResetColumns(gc);
+
+	gwinSetVisible((GHandle)gc, pInit->show);
+	_gwinFlushRedraws(REDRAW_WAIT);
+	return (GHandle)gc;
+}
+
+int gwinChartAddSeries(GHandle gh, color_t color) {
+	GChartSeries *	ps;
+
+	if (gh->vmt != &chartVMT || !gc2obj->plot || gc2obj->nseries >= GWIN_CHART_MAX_SERIES || gc2obj->ccount)
+		return -1;
+
+	// The history ring and the two column rings in one block
+	ps = &gc2obj->series[gc2obj->nseries];
+	if (!(ps->samples = gfxAlloc((gc2obj->capacity + 2 * (gc2obj->pw + 1)) * sizeof(int16_t))))
+		return -1;
+	ps->colmin = ps->samples + gc2obj->capacity;
+	ps->colmax = ps->colmin + gc2obj->pw + 1;
+	ps->color = color;
+	return gc2obj->nseries++;
+}
+
+void gwinChartSetRange(GHandle gh, int16_t ymin, int16_t ymax, int16_t ygrid) {
+	if (gh->vmt != &chartVMT || ymax <= ymin)
+		return;
+
+	gc2obj->ymin = ymin;
+	gc2obj->ymax = ymax;
+	gc2obj->ygrid = ygrid;
+	_gwinUpdate(gh);
+}
+
+void gwinChartSetSpan(GHandle gh, unsigned percolumn, unsigned xgrid) {
+	if (gh->vmt != &chartVMT || !percolumn)
+		return;
+
+	gc2obj->percolumn = percolumn;
+	gc2obj->xgrid = xgrid;
+	if (gc2obj->plot)
+		ChartRebuildColumns(gc2obj);
+	_gwinUpdate(gh);
+}
+
+void gwinChartSetGridColor(GHandle gh, color_t color) {
+	if (gh->vmt != &chartVMT)
+		return;
+
+	gc2obj->gridcolor = color;
+	_gwinUpdate(gh);
+}
+
+void gwinChartAddSamples(GHandle gh, const int16_t *values) {
+	unsigned	s;
+	bool_t		newcol;
+
+	if (gh->vmt != &chartVMT || !gc2obj->plot || !gc2obj->nseries)
+		return;
+
+	// Keep the history for when the columns need working out again
+	if (gc2obj->capacity) {
+		for(s = 0; s < gc2obj->nseries; s++)
+			gc2obj->series[s].samples[gc2obj->shead] = values[s];
+		if (++gc2obj->shead >= gc2obj->capacity)
+			gc2obj->shead = 0;
+		if (gc2obj->scount < gc2obj->capacity)
+			gc2obj->scount++;
+	}
+
+	newcol = ChartAddColumnSamples(gc2obj, values, gc2obj->total++);
+
+	// A hidden chart draws its plot from the columns when it is shown
+	if (!_gwinDrawStart(gh))
+		return;
+	if (newcol) {
+		ChartScrollPlot(gc2obj);
+		gdispGBlitArea(gh->display, gh->x+gc2obj->px, gh->y+gc2obj->py, gc2obj->pw, gc2obj->ph, 0, 0, gc2obj->pw, gc2obj->plot);
+	} else {
+		// Only the newest column has changed
+		ChartDrawColumn(gc2obj, gc2obj->pw - 1, 0);
+		gdispGBlitArea(gh->display, gh->x+gc2obj->px+gc2obj->pw-1, gh->y+gc2obj->py, 1, gc2obj->ph, gc2obj->pw-1, 0, gc2obj->pw, gc2obj->plot);
+	}
+	_gwinDrawEnd(gh);
+}
+
+#undef gc2obj
+
+#endif /* GFX_USE_GWIN && GWIN_NEED_CHART */
@@ -0,0 +1,175 @@
+/*
+ * This file is subject to the terms of the GFX License. If a copy of
+ * the license was not distributed with this file, you can obtain one at:
+ *
+ *              http://ugfx.org/license.html
+ */
+
+/**
+ * @file	src/gwin/gwin_chart.h
+ * @brief	GWIN CHART module header file
+ *
+ * @defgroup Chart Chart
+ * @ingroup Windows
+ *
+ * @brief	Streaming chart window. Used to display the recent history of live values.
+ *
+ * @details	A chart keeps a history of samples for each of its series and plots them against time.
+ *			New samples enter at the right hand side and older ones move left.
+ *			Each pixel column shows the minimum and maximum of the samples that fall into it so
+ *			the cost of drawing depends on the width of the chart and not on the length of the history.
+ *			The plot is kept in an off-screen buffer. A new column moves the buffer left by one
+ *			pixel and only the new column is drawn.
+ *
+ * @pre		GFX_USE_GWIN must be set to TRUE in your gfxconf.h
+ * @pre		GWIN_NEED_CHART must be set to TRUE in your gfxconf.h
+ *
+ * @{
+ */
+
+#ifndef _GWIN_CHART_H
+#define _GWIN_CHART_H
+
+/* This file is included within "src/gwin/gwin.h" */
+
+/**
+ * @brief	A sample value that marks a gap in a series
+ */
+#define GWIN_CHART_NODATA		((int16_t)0x8000)
+
+/**
+ * @brief	The number of bytes of plot memory a chart of the given window size may need
+ */
+#define GWIN_CHART_MEMORY_SIZE(width, height)	((width) * (height) * sizeof(pixel_t))
+
+// One series of samples
+typedef struct GChartSeries {
+	color_t				color;
+	int16_t *			samples;			// The history ring. It is shared in position by all the series.
+	int16_t *			colmin;				// The minimum per pixel column. A ring of one entry per column and one more.
+	int16_t *			colmax;				// The maximum per pixel column
+	} GChartSeries;
+
+// A chart window
+typedef struct GChartObject {
+	GWindowObject		g;
+	pixel_t *			plot;				// The off-screen plot, followed by the background column
+	pixel_t *			background;			// The plot background and horizontal grid for one column
+	coord_t				px, py;				// Position of the plot within the window
+	coord_t				pw, ph;				// Size of the plot
+	int16_t				ymin, ymax;			// The value range shown
+	int16_t				ygrid;				// The value spacing of the horizontal grid lines
+	uint16_t			xgrid;				// The column spacing of the vertical grid lines
+	color_t				gridcolor;
+	uint16_t			capacity;			// The length of the history
+	uint16_t			shead;				// Where the next sample goes in the history
+	uint16_t			scount;				// The number of samples in the history
+	uint16_t			percolumn;			// The number of samples in a pixel column
+	uint16_t			chead;				// The newest column in the column rings
+	uint16_t			ccount;				// The number of columns with data
+	uint32_t			colno;				// The number of the newest column since the chart started
+	uint32_t			total;				// The number of samples since the chart started
+	uint8_t				nseries;
+	GChartSeries		series[GWIN_CHART_MAX_SERIES];
+	} GChartObject;
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Create a chart window.
+ * @return  NULL if there is no resultant drawing area, otherwise a window handle.
+ *
+ * @param[in] g			The GDisplay to display this window on
+ * @param[in] gc		The GChartObject structure to initialise. If this is NULL the structure is dynamically allocated.
+ * @param[in] pInit		The initialization parameters to use
+ * @param[in] history	The number of samples of each series to keep
+ * @param[in] plotmem	At least GWIN_CHART_MEMORY_SIZE(width, height) bytes for the plot.
+ * 						If this is NULL the plot memory is dynamically allocated.
+ *
+ * @note				The drawing color is used for the axes and their labels. The background color fills the plot.
+ * @note				The font gets set to the current default font. It labels the horizontal grid lines and its
+ * 						size sets the room left for the labels. Set the default font before creating the chart.
+ * @note				The history is only needed to redraw the chart when @p gwinChartSetSpan() changes the number of
+ * 						samples per column. The plot itself draws from the decimated columns.
+ *
+ * @api
+ */
+GHandle gwinGChartCreate(GDisplay *g, GChartObject *gc, const GWindowInit *pInit, unsigned history, void *plotmem);
+#define gwinChartCreate(gc, pInit, history, plotmem)	gwinGChartCreate(GDISP, gc, pInit, history, plotmem)
+
+/**
+ * @brief   Add a series to the chart.
+ * @return	The index of the series or -1 if it could not be added.
+ *
+ * @param[in] gh		The window handle (must be a chart window)
+ * @param[in] color		The color to draw the series in
+ *
+ * @note				Series must be added before the first sample.
+ *
+ * @api
+ */
+int gwinChartAddSeries(GHandle gh, color_t color);
+
+/**
+ * @brief   Set the value range and the horizontal grid lines.
+ *
+ * @param[in] gh		The window handle (must be a chart window)
+ * @param[in] ymin, ymax	The values at the bottom and top of the plot
+ * @param[in] ygrid		The value spacing of horizontal grid lines from ymin. Zero for none.
+ *
+ * @note				The chart is redrawn.
+ *
+ * @api
+ */
+void gwinChartSetRange(GHandle gh, int16_t ymin, int16_t ymax, int16_t ygrid);
+
+/**
+ * @brief   Set how much time the plot spans.
+ *
+ * @param[in] gh			The window handle (must be a chart window)
+ * @param[in] percolumn		The number of samples shown in each pixel column
+ * @param[in] xgrid			The column spacing of vertical grid lines. Zero for none.
+ *
+ * @note				The columns are worked out again from the history and the chart is redrawn.
+ *
+ * @api
+ */
+void gwinChartSetSpan(GHandle gh, unsigned percolumn, unsigned xgrid);
+
+/**
+ * @brief   Set the color of the grid lines.
+ *
+ * @param[in] gh		The window handle (must be a chart window)
+ * @param[in] color		The grid color
+ *
+ * @note				The chart is redrawn.
+ *
+ * @api
+ */
+void gwinChartSetGridColor(GHandle gh, color_t color);
+
+/**
+ * @brief   Add one sample to every series.
+ *
+ * @param[in] gh		The window handle (must be a chart window)
+ * @param[in] values	One value per series in the order they were added. @p GWIN_CHART_NODATA leaves a gap.
+ *
+ * @note				Only the newest column is drawn. When a column fills the plot moves left by one pixel.
+ * @note				A hidden chart keeps its history and columns and draws them when it is next shown.
+ *
+ * @api
+ */
+void gwinChartAddSamples(GHandle gh, const int16_t *values);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* _GWIN_CHART_H */
+/** @} */
@@ -156,7 +156,7 @@ typedef struct gwinVMT {
 		void (*DeInit)		(void);									/**< The window manager has just been removed as the current window manager */
 		bool_t (*Add)		(GHandle gh, const GWindowInit *pInit);	/**< A window has been added */
 		void (*Delete)		(GHandle gh);							/**< A window has been deleted */
-		void (*Redraw)		(GHandle gh);							/**< A window needs to be redraw (or undrawn) */
+		void (*Redraw)		(GHandle gh);							/**< Paint a visible window inside the current clip */
 		void (*Size)		(GHandle gh, coord_t w, coord_t h);		/**< A window wants to be resized */
 		void (*Move)		(GHandle gh, coord_t x, coord_t y);		/**< A window wants to be moved */
 		void (*Raise)		(GHandle gh);							/**< A window wants to be on top */
@@ -204,6 +204,38 @@ GHandle _gwindowCreate(GDisplay *g, GWindowObject *pgw, const GWindowInit *pInit
  */
 void _gwinUpdate(GHandle gh);
 
+/**
+ * @brief	Redraw part of a window after a status change.
+ *
+ * @param[in]	gh		The window to redraw
+ * @param[in]	x,y		The top left corner of the area (screen relative)
+ * @param[in]	cx,cy	The size of the area
+ *
+ * @note	Only the area is repainted. The window's redraw routine is called
+ * 			with the clip set to it.
+ * @note	This must not be called while holding the drawing lock.
+ *
+ * @notapi
+ */
+void _gwinUpdateArea(GHandle gh, coord_t x, coord_t y, coord_t cx, coord_t cy);
+
+/**
+ * @brief	Scroll part of a window vertically after a status change.
+ *
+ * @param[in]	gh		The window to scroll
+ * @param[in]	x,y		The top left corner of the area (screen relative)
+ * @param[in]	cx,cy	The size of the area
+ * @param[in]	lines	The number of lines to move the contents up (negative to move it down)
+ *
+ * @note	The pixels already on the display are moved and only the lines uncovered are repainted.
+ * 			If that can't be done safely (no GDISP_NEED_SCROLL, another window over the area or
+ * 			redrawing still to be done) the whole area is repainted instead.
+ * @note	This must not be called while holding the drawing lock.
+ *
+ * @notapi
+ */
+void _gwinScrollArea(GHandle gh, coord_t x, coord_t y, coord_t cx, coord_t cy, int lines);
+
 /**
  * @brief	How to flush the redraws
  * @notes	REDRAW_WAIT			- Wait for a drawing session to be available
@@ -246,6 +278,22 @@ bool_t _gwinDrawStart(GHandle gh);
  */
 void _gwinDrawEnd(GHandle gh);
 
+#if GDISP_NEED_CLIP || defined(__DOXYGEN__)
+	/**
+	 * @brief	Restrict drawing to part of a window
+	 *
+	 * @param[in]	gh		The window
+	 * @param[in]	x,y		The top left corner of the area
+	 * @param[in]	cx,cy	The size of the area
+	 *
+	 * @note	Use this rather than gdispGSetClip() inside a redraw. The window manager
+	 * 			may be repainting just part of the window and this keeps the clip inside it.
+	 *
+	 * @notapi
+	 */
+	void _gwinSetClip(GHandle gh, coord_t x, coord_t y, coord_t cx, coord_t cy);
+#endif
+
 /**
  * @brief	Destroy a window.
  *
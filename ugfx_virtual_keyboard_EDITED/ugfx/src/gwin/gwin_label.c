@@ -16,6 +16,8 @@
 
 #include "gwin_class.h"
 
+#include <string.h>
+
 // macros to assist in data type conversions
 #define gh2obj					((GLabelObject *)gh)
 #define gw2obj					((GLabelObject *)gw)
@@ -99,6 +101,12 @@ GHandle gwinGLabelCreate(GDisplay *g, GLabelObject *widget, GWidgetInit *pInit)
 		widget->attr = 0;
 	#endif
 
+	#if GWIN_LABEL_NUMBER
+		widget->number[0] = 0;
+		widget->cellfont = 0;
+		widget->cellwidth = 0;
+	#endif
+
 	widget->w.g.flags |= flags;	
 	gwinSetVisible(&widget->w.g, pInit->g.show);
 
@@ -129,6 +137,141 @@ void gwinLabelSetBorder(GHandle gh, bool_t border) {
 	}
 #endif // GWIN_LABEL_ATTRIBUTE
 
+#if GWIN_LABEL_NUMBER
+	// A label is showing a number while its text is its own number buffer
+	#define isnumber(pgw)		((pgw)->text == ((GLabelObject *)(pgw))->number)
+
+	// The widest digit (or sign) sets the width of every character cell
+	static coord_t getcellwidth(GWidgetObject *gw) {
+		const char	*p;
+		coord_t		w;
+
+		if (gw2obj->cellfont != gw->g.font) {
+			gw2obj->cellfont = gw->g.font;
+			gw2obj->cellwidth = 0;
+			for (p = "-0123456789"; *p; p++) {
+				if ((w = gdispGetCharWidth(*p, gw->g.font)) > gw2obj->cellwidth)
+					gw2obj->cellwidth = w;
+			}
+		}
+		return gw2obj->cellwidth;
+	}
+
+	// Where the first of len cells starts in a label w pixels wide
+	static coord_t getcellorigin(GWidgetObject *gw, justify_t justify, unsigned len, coord_t w) {
+		switch(justify) {
+		case justifyCenter:
+			return gw->g.x + (w - (coord_t)len * gw2obj->cellwidth) / 2;
+		case justifyRight:
+			return gw->g.x + w - (coord_t)len * gw2obj->cellwidth;
+		default:
+			return gw->g.x;
+		}
+	}
+
+	static void gwinLabelDrawNumber(GWidgetObject *gw, justify_t justify, coord_t w, coord_t h, color_t c) {
+		const char	*p;
+		char		s[2];
+		coord_t		x, cw;
+
+		cw = gw2obj->cellwidth;
+		x = getcellorigin(gw, justify, strlen(gw->text), w);
+
+		// Draw each character centered in its cell. Anything outside the clip is skipped quickly.
+		if (x > gw->g.x)
+			gdispGFillArea(gw->g.display, gw->g.x, gw->g.y, x - gw->g.x, h, gw->pstyle->background);
+		s[1] = 0;
+		for (p = gw->text; *p; p++, x += cw) {
+			s[0] = *p;
+			gdispGFillStringBox(gw->g.display, x, gw->g.y, cw, h, s, gw->g.font, c, gw->pstyle->background, justifyCenter);
+		}
+		if (x < gw->g.x + w)
+			gdispGFillArea(gw->g.display, x, gw->g.y, gw->g.x + w - x, h, gw->pstyle->background);
+	}
+
+	void gwinLabelSetNumber(GHandle gh, int32_t value) {
+		char		buf[sizeof(gh2obj->number)];
+		char		*p;
+		const char	*old;
+		uint32_t	u;
+		unsigned	len, oldlen, n, i, first, last;
+		char		nc, oc;
+		justify_t	justify;
+		bool_t		partial;
+		coord_t		x;
+
+		// is it a valid handle?
+		if (gh->vmt != (gwinVMT *)&labelVMT)
+			return;
+
+		// Format from the right
+		p = buf + sizeof(buf) - 1;
+		*p = 0;
+		u = value < 0 ? -(uint32_t)value : (uint32_t)value;
+		do {
+			*--p = '0' + u % 10;
+			u /= 10;
+		} while (u);
+		if (value < 0)
+			*--p = '-';
+		len = buf + sizeof(buf) - 1 - p;
+
+		old = gh2obj->w.text;
+		if (isnumber(&gh2obj->w) && !strcmp(old, p))
+			return;
+
+		// Only the changed cells need redrawing if the old text was laid out in cells of the same size
+		// and the remaining cells stay where they were. We can't tell for a custom draw routine.
+		oldlen = strlen(old);
+		partial = isnumber(&gh2obj->w) && gh2obj->cellfont == gh->font && !(gh->flags & (GLABEL_FLG_WAUTO|GLABEL_FLG_HAUTO));
+		justify = justifyLeft;
+		if (gh2obj->w.fnDraw == gwinLabelDrawJustifiedRight)
+			justify = justifyRight;
+		else if (gh2obj->w.fnDraw == gwinLabelDrawJustifiedCenter) {
+			justify = justifyCenter;
+			if (len != oldlen)
+				partial = FALSE;
+		} else if (gh2obj->w.fnDraw != gwinLabelDrawJustifiedLeft)
+			partial = FALSE;
+
+		// Find the first and last cells that differ, lined up on the justified edge
+		n = len > oldlen ? len : oldlen;
+		first = n;
+		last = 0;
+		if (partial) {
+			for (i = 0; i < n; i++) {
+				if (justify == justifyRight) {
+					nc = i >= n - len ? p[i - (n - len)] : 0;
+					oc = i >= n - oldlen ? old[i - (n - oldlen)] : 0;
+				} else {
+					nc = i < len ? p[i] : 0;
+					oc = i < oldlen ? old[i] : 0;
+				}
+				if (nc != oc) {
+					if (first == n)
+						first = i;
+					last = i;
+				}
+			}
+		}
+
+		// Take the new text
+		if ((gh->flags & GWIN_FLG_ALLOCTXT)) {
+			gh->flags &= ~GWIN_FLG_ALLOCTXT;
+			gfxFree((void *)gh2obj->w.text);
+		}
+		memcpy(gh2obj->number, p, len+1);
+		gh2obj->w.text = gh2obj->number;
+
+		if (!partial) {
+			_gwinUpdate(gh);
+			return;
+		}
+		x = getcellorigin(&gh2obj->w, justify, n, gh->width);
+		_gwinUpdateArea(gh, x + (coord_t)first * gh2obj->cellwidth, gh->y, (coord_t)(last - first + 1) * gh2obj->cellwidth, gh->height);
+	}
+#endif // GWIN_LABEL_NUMBER
+
 static void gwinLabelDraw(GWidgetObject *gw, justify_t justify) {
 	coord_t				w, h;
 	color_t				c;
@@ -137,6 +280,11 @@ static void gwinLabelDraw(GWidgetObject *gw, justify_t justify) {
 	if (gw->g.vmt != (gwinVMT *)&labelVMT)
 		return;
 
+	#if GWIN_LABEL_NUMBER
+		if (isnumber(gw))
+			w = (gw->g.flags & GLABEL_FLG_WAUTO) ? (coord_t)strlen(gw->text) * getcellwidth(gw) + 2 : gw->g.width;
+		else
+	#endif
 	w = (gw->g.flags & GLABEL_FLG_WAUTO) ? getwidth(gw->text, gw->g.font, gdispGGetWidth(gw->g.display) - gw->g.x) : gw->g.width;
 	h = (gw->g.flags & GLABEL_FLG_HAUTO) ? getheight(gw->text, gw->g.font, gdispGGetWidth(gw->g.display) - gw->g.x) : gw->g.height;
 	c = (gw->g.flags & GWIN_FLG_SYSENABLED) ? gw->pstyle->enabled.text : gw->pstyle->disabled.text;
@@ -155,6 +303,12 @@ static void gwinLabelDraw(GWidgetObject *gw, justify_t justify) {
 		h = gw->g.height;
 	}
 
+	#if GWIN_LABEL_NUMBER
+		if (isnumber(gw)) {
+			getcellwidth(gw);
+			gwinLabelDrawNumber(gw, justify, w, h, c);
+		} else
+	#endif
 	#if GWIN_LABEL_ATTRIBUTE
 		if (gw2obj->attr) {
 			gdispGFillStringBox(gw->g.display, gw->g.x, gw->g.y, gw2obj->tab, h, gw2obj->attr, gw->g.font, c, gw->pstyle->background, justify);
@@ -188,6 +342,7 @@ void gwinLabelDrawJustifiedCenter(GWidgetObject *gw, void *param) {
 	gwinLabelDraw(gw, justifyCenter);
 }
 
+#undef isnumber
 #undef gh2obj
 #undef gw2obj
 #endif // GFX_USE_GWIN && GFX_NEED_LABEL
@@ -51,6 +51,12 @@ typedef struct GLabelObject {
 		coord_t         tab;
 		const char*		attr;
 	#endif
+
+	#if GWIN_LABEL_NUMBER
+		char			number[12];			// The text while showing a number: a sign, up to 10 digits and the nul
+		font_t			cellfont;			// The font the cell width was measured for
+		coord_t			cellwidth;			// The widest digit in that font
+	#endif
 } GLabelObject;
 
 #ifdef __cplusplus
@@ -109,6 +115,26 @@ void gwinLabelSetBorder(GHandle gh, bool_t border);
 	void gwinLabelSetAttribute(GHandle gh, coord_t tab, const char* attr);
 #endif
 
+#if GWIN_LABEL_NUMBER || defined(__DOXYGEN__)
+	/**
+	 * @brief				Show an integer in a label
+	 * @details				The number is formatted into the label itself without using printf.
+	 *
+	 * @note				From then on the label draws each character of its text in a cell
+	 *						as wide as the widest digit. Only the cells that differ from the
+	 *						previous value are repainted if the number of characters is the same
+	 *						(or the label is left or right justified).
+	 * @note				Nothing is redrawn if the value has not changed.
+	 * @note				This must not be called from inside a custom draw routine.
+	 *
+	 * @param[in] gh		The widget handle (must be a label handle)
+	 * @param[in] value		The number to show
+	 *
+	 * @api
+	 */
+	void gwinLabelSetNumber(GHandle gh, int32_t value);
+#endif
+
 /**
  * @defgroup Renderings_Label Renderings
  *
@@ -31,6 +31,37 @@
 #define qix2li		((ListItem *)qix)
 #define ple			((GEventGWinList *)pe)
 
+#if GWIN_LIST_VIRTUAL
+	// A virtual list has no items of its own
+	#define isvirtual(pgw)		(((GListObject *)(pgw))->fnItem != 0)
+	#define SELBYTES(cnt)		(((cnt)+7)/8)
+
+	static bool_t VirtualIsSelected(GListObject *gl, int item) {
+		return (gl->selected && (gl->selected[item>>3] & (1<<(item&7)))) ? TRUE : FALSE;
+	}
+
+	static void VirtualSelect(GListObject *gl, int item, bool_t doSelect) {
+		if (!gl->selected)
+			return;
+		if (doSelect)
+			gl->selected[item>>3] |= 1<<(item&7);
+		else
+			gl->selected[item>>3] &=~ (1<<(item&7));
+	}
+
+	static int VirtualGetSelected(GListObject *gl) {
+		int		i;
+
+		if (gl->selected) {
+			for(i = 0; i < gl->cnt; i++) {
+				if (VirtualIsSelected(gl, i))
+					return i;
+			}
+		}
+		return -1;
+	}
+#endif
+
 static void sendListEvent(GWidgetObject *gw, int item) {
 	GSourceListener*	psl;
 	GEvent*				pe;
@@ -53,6 +84,29 @@ static void sendListEvent(GWidgetObject *gw, int item) {
 	}
 }
 
+// The list has scrolled from oldtop. The rows still in view are moved on the display and only the new ones are drawn.
+static void ListScrolled(GWidgetObject *gw, int oldtop) {
+	coord_t		iheight, iwidth;
+
+	if (gw2obj->top == oldtop || !(gw->g.flags & GLIST_FLG_ENABLERENDER))
+		return;
+
+	// The item area as gwinListDefaultDraw() lays it out
+	iheight = gdispGetFontMetric(gw->g.font, fontHeight) + LST_VERT_PAD;
+	if (gw->g.flags & GLIST_FLG_SCROLLSMOOTH)
+		iwidth = gw->g.width - 2 - 4;
+	else if ((gw2obj->cnt > (gw->g.height-2) / iheight) || (gw->g.flags & GLIST_FLG_SCROLLALWAYS))
+		iwidth = gw->g.width - (LST_SCROLLWIDTH+3);
+	else
+		iwidth = gw->g.width - 2;
+
+	_gwinScrollArea(&gw->g, gw->g.x+1, gw->g.y+1, iwidth, gw->g.height-2, gw2obj->top - oldtop);
+
+	// The smooth scroll bar moves with the list
+	if (gw->g.flags & GLIST_FLG_SCROLLSMOOTH)
+		_gwinUpdateArea(&gw->g, gw->g.x+1+iwidth, gw->g.y+1, gw->g.width-2-iwidth, gw->g.height-2);
+}
+
 #if GINPUT_NEED_MOUSE
     static void ListMouseSelect(GWidgetObject* gw, coord_t x, coord_t y) {
         const gfxQueueASyncItem*    qi;
@@ -68,6 +122,18 @@ static void sendListEvent(GWidgetObject *gw, int item) {
         if (item < 0 || item >= gw2obj->cnt)
             return;
 
+        #if GWIN_LIST_VIRTUAL
+            if (isvirtual(gw)) {
+                if ((gw->g.flags & GLIST_FLG_MULTISELECT))
+                    VirtualSelect(gw2obj, item, !VirtualIsSelected(gw2obj, item));
+                else {
+                    if (gw2obj->selected)
+                        memset(gw2obj->selected, 0, SELBYTES(gw2obj->cnt));
+                    VirtualSelect(gw2obj, item, TRUE);
+                }
+            }
+        #endif
+
         for(qi = gfxQueueASyncPeek(&gw2obj->list_head), i = 0; qi; qi = gfxQueueASyncNext(qi), i++) {
             if ((gw->g.flags & GLIST_FLG_MULTISELECT)) {
                 if (item == i) {
@@ -90,6 +156,7 @@ static void sendListEvent(GWidgetObject *gw, int item) {
 	// a mouse down has occurred over the list area
 	static void ListMouseDown(GWidgetObject* gw, coord_t x, coord_t y) {
 		coord_t		iheight, pgsz;
+		int			oldtop;
 
 		// Save our mouse start position
         gw2obj->start_mouse_x = x;
@@ -106,19 +173,18 @@ static void sendListEvent(GWidgetObject *gw, int item) {
 
 		// Handle click over the scroll bar
 		if (x >= gw->g.width-(LST_SCROLLWIDTH+2) && (gw2obj->cnt > pgsz/iheight || (gw->g.flags & GLIST_FLG_SCROLLALWAYS))) {
+			oldtop = gw2obj->top;
 			if (y < 2*LST_ARROW_SZ) {
 				if (gw2obj->top > 0) {
 					gw2obj->top -= iheight;
 					if (gw2obj->top < 0)
 					    gw2obj->top = 0;
-					_gwinUpdate(&gw->g);
 				}
 			} else if (y >= gw->g.height - 2*LST_ARROW_SZ) {
 				if (gw2obj->top < gw2obj->cnt * iheight - pgsz) {
 				    gw2obj->top += iheight;
 				    if (gw2obj->top > gw2obj->cnt * iheight - pgsz)
 				        gw2obj->top = gw2obj->cnt * iheight - pgsz;
-				    _gwinUpdate(&gw->g);
 				}
 			} else if (y < gw->g.height/2) {
 				if (gw2obj->top > 0) {
@@ -126,7 +192,6 @@ static void sendListEvent(GWidgetObject *gw, int item) {
 						gw2obj->top -= pgsz;
 					else
 						gw2obj->top = 0;
-					_gwinUpdate(&gw->g);
 				}
 			} else {
 				if (gw2obj->top < gw2obj->cnt * iheight - pgsz) {
@@ -134,9 +199,9 @@ static void sendListEvent(GWidgetObject *gw, int item) {
 						gw2obj->top += pgsz;
 					else
 						gw2obj->top = gw2obj->cnt * iheight - pgsz;
-					_gwinUpdate(&gw->g);
 				}
 			}
+			ListScrolled(gw, oldtop);
 			return;
 		}
 
@@ -171,8 +236,7 @@ static void sendListEvent(GWidgetObject *gw, int item) {
             if (gw2obj->top < 0)
                 gw2obj->top = 0;
             gw2obj->last_mouse_y = y;
-            if (oldtop != gw2obj->top)
-            	_gwinUpdate(&gw->g);
+            ListScrolled(gw, oldtop);
         }
 	}
 #endif
@@ -187,6 +251,34 @@ static void sendListEvent(GWidgetObject *gw, int item) {
 		coord_t		iheight;
 		iheight = gdispGetFontMetric(gw->g.font, fontHeight) + LST_VERT_PAD;
 
+		#if GWIN_LIST_VIRTUAL
+			if (isvirtual(gw)) {
+				if ((i = VirtualGetSelected(gw2obj)) < 0)
+					return;
+				if (role == 0 && i+1 < gw2obj->cnt) {
+					VirtualSelect(gw2obj, i, FALSE);
+					VirtualSelect(gw2obj, i+1, TRUE);
+
+					//if we need to scroll down
+					if (((i+2)*iheight - gw2obj->top) > gw->g.height)
+						gw2obj->top += iheight;
+				} else if (role == 1 && i > 0) {
+					VirtualSelect(gw2obj, i, FALSE);
+					VirtualSelect(gw2obj, i-1, TRUE);
+
+					//if we need to scroll up
+					if (((i-1)*iheight) < gw2obj->top) {
+						gw2obj->top -= iheight;
+						if (gw2obj->top < 0)
+							gw2obj->top = 0;
+					}
+				} else
+					return;
+				_gwinUpdate(&gw->g);
+				return;
+			}
+		#endif
+
 		switch (role) {
 			// select down
 			case 0:
@@ -253,6 +345,10 @@ static void ListDestroy(GHandle gh) {
 
 	while((qi = gfxQueueASyncGet(&gh2obj->list_head)))
 		gfxFree((void *)qi);
+	#if GWIN_LIST_VIRTUAL
+		if (gh2obj->selected)
+			gfxFree(gh2obj->selected);
+	#endif
 
 	_gwidgetDestroy(gh);
 }
@@ -305,6 +401,11 @@ GHandle gwinGListCreate(GDisplay *g, GListObject* gobj, GWidgetInit* pInit, bool
 	gfxQueueASyncInit(&gobj->list_head);
 	gobj->cnt = 0;
 	gobj->top = 0;
+	#if GWIN_LIST_VIRTUAL
+		gobj->fnItem = 0;
+		gobj->itemParam = 0;
+		gobj->selected = 0;
+	#endif
 	if (multiselect)
 		gobj->w.g.flags |= GLIST_FLG_MULTISELECT;
 	gobj->w.g.flags |= GLIST_FLG_SCROLLALWAYS;
@@ -355,6 +456,12 @@ int gwinListAddItem(GHandle gh, const char* item_name, bool_t useAlloc) {
 	if (gh->vmt != (gwinVMT *)&listVMT)
 		return -1;
 
+	#if GWIN_LIST_VIRTUAL
+		// The application holds the items of a virtual list
+		if (isvirtual(gh))
+			return -1;
+	#endif
+
 	if (useAlloc) {
 		size_t len = strlen(item_name)+1;
 		if (!(newItem = gfxAlloc(sizeof(ListItem) + len)))
@@ -403,6 +510,11 @@ const char* gwinListItemGetText(GHandle gh, int item) {
 	if (item < 0 || item >= gh2obj->cnt)
 		return 0;
 
+	#if GWIN_LIST_VIRTUAL
+		if (isvirtual(gh))
+			return gh2obj->fnItem(gh, item, gh2obj->itemParam);
+	#endif
+
 	for(qi = gfxQueueASyncPeek(&gh2obj->list_head), i = 0; qi; qi = gfxQueueASyncNext(qi), i++) {
 		if (i == item)
 			return qi2li->text;
@@ -422,6 +534,18 @@ int gwinListFindText(GHandle gh, const char* text) {
 	if (!text)
 		return -1;
 
+	#if GWIN_LIST_VIRTUAL
+		if (isvirtual(gh)) {
+			const char	*p;
+
+			for(i = 0; i < gh2obj->cnt; i++) {
+				if ((p = gh2obj->fnItem(gh, i, gh2obj->itemParam)) && strcmp(p, text) == 0)
+					return i;
+			}
+			return -1;
+		}
+	#endif
+
 	for(qi = gfxQueueASyncPeek(&gh2obj->list_head), i = 0; qi; qi = gfxQueueASyncNext(qi), i++) {
 		if (strcmp(((ListItem *)qi)->text, text) == 0)
 			return i;	
@@ -442,6 +566,11 @@ int gwinListGetSelected(GHandle gh) {
 	if ((gh->flags & GLIST_FLG_MULTISELECT))
 		return -1;
 
+	#if GWIN_LIST_VIRTUAL
+		if (isvirtual(gh))
+			return VirtualGetSelected(gh2obj);
+	#endif
+
 	for(qi = gfxQueueASyncPeek(&gh2obj->list_head), i = 0; qi; qi = gfxQueueASyncNext(qi), i++) {
 		if (qi2li->flags & GLIST_FLG_SELECTED)
 			return i;
@@ -479,6 +608,12 @@ void gwinListDeleteAll(GHandle gh) {
 
 	while((qi = gfxQueueASyncGet(&gh2obj->list_head)))
 		gfxFree(qi);
+	#if GWIN_LIST_VIRTUAL
+		if (gh2obj->selected) {
+			gfxFree(gh2obj->selected);
+			gh2obj->selected = 0;
+		}
+	#endif
 
 	gh->flags &= ~GLIST_FLG_HASIMAGES;
 	gh2obj->cnt = 0;
@@ -542,6 +677,11 @@ bool_t gwinListItemIsSelected(GHandle gh, int item) {
 	if (item < 0 || item > (gh2obj->cnt) - 1)
 		return FALSE;
 
+	#if GWIN_LIST_VIRTUAL
+		if (isvirtual(gh))
+			return VirtualIsSelected(gh2obj, item);
+	#endif
+
 	for(qi = gfxQueueASyncPeek(&gh2obj->list_head), i = 0; qi; qi = gfxQueueASyncNext(qi), i++) {
 		if (i == item)
 			return (qi2li->flags &  GLIST_FLG_SELECTED) ? TRUE : FALSE;
@@ -581,6 +721,16 @@ void gwinListSetSelected(GHandle gh, int item, bool_t doSelect) {
 	if (item < 0 || item >= gh2obj->cnt)
 		return;
 
+	#if GWIN_LIST_VIRTUAL
+		if (isvirtual(gh)) {
+			if (doSelect && !(gh->flags & GLIST_FLG_MULTISELECT) && gh2obj->selected)
+				memset(gh2obj->selected, 0, SELBYTES(gh2obj->cnt));
+			VirtualSelect(gh2obj, item, doSelect);
+			_gwinUpdate(gh);
+			return;
+		}
+	#endif
+
 	// If not a multiselect mode - clear previous selected item
 	if (doSelect && !(gh->flags & GLIST_FLG_MULTISELECT)) {
 		for(qi = gfxQueueASyncPeek(&gh2obj->list_head); qi; qi = gfxQueueASyncNext(qi)) {
@@ -606,6 +756,7 @@ void gwinListSetSelected(GHandle gh, int item, bool_t doSelect) {
 
 void gwinListViewItem(GHandle gh, int item) {
 	coord_t iheight;
+	int		oldtop;
 
 	// is it a valid handle?
 	if (gh->vmt != (gwinVMT *)&listVMT)
@@ -617,6 +768,7 @@ void gwinListViewItem(GHandle gh, int item) {
 
 	// Work out a possible new top for the list
 	iheight = gdispGetFontMetric(gh->font, fontHeight) + LST_VERT_PAD;
+	oldtop = gh2obj->top;
 	gh2obj->top = iheight * item;
 
 	// Adjust the list
@@ -625,9 +777,98 @@ void gwinListViewItem(GHandle gh, int item) {
 	if (gh2obj->top < 0)
 		gh2obj->top = 0;
 
-	_gwinUpdate(gh);
+	ListScrolled((GWidgetObject *)gh, oldtop);
+}
+
+void gwinListItemUpdate(GHandle gh, int item) {
+	coord_t		iheight, y;
+
+	// is it a valid handle?
+	if (gh->vmt != (gwinVMT *)&listVMT)
+		return;
+
+	// watch out for an invalid item
+	if (item < 0 || item >= gh2obj->cnt)
+		return;
+
+	// Only an item in view needs drawing
+	iheight = gdispGetFontMetric(gh->font, fontHeight) + LST_VERT_PAD;
+	y = 1 + item * iheight - gh2obj->top;
+	if (y + iheight <= 1 || y >= gh->height-1)
+		return;
+	_gwinUpdateArea(gh, gh->x+1, gh->y+y, gh->width-2, iheight);
 }
 
+#if GWIN_LIST_VIRTUAL
+	void gwinListSetVirtual(GHandle gh, GListItemFunction fn, void *param, int count) {
+		gfxQueueASyncItem*	qi;
+
+		// is it a valid handle?
+		if (gh->vmt != (gwinVMT *)&listVMT)
+			return;
+
+		// Start again with no items and nothing selected
+		while((qi = gfxQueueASyncGet(&gh2obj->list_head)))
+			gfxFree(qi);
+		if (gh2obj->selected) {
+			gfxFree(gh2obj->selected);
+			gh2obj->selected = 0;
+		}
+		gh->flags &= ~GLIST_FLG_HASIMAGES;
+		gh2obj->fnItem = fn;
+		gh2obj->itemParam = param;
+		gh2obj->cnt = 0;
+		gh2obj->top = 0;
+
+		if (fn && count > 0) {
+			gh2obj->cnt = count;
+			if ((gh2obj->selected = gfxAlloc(SELBYTES(count))))
+				memset(gh2obj->selected, 0, SELBYTES(count));
+
+			// select the first item as adding it would have
+			if (!(gh->flags & GLIST_FLG_MULTISELECT))
+				VirtualSelect(gh2obj, 0, TRUE);
+		}
+		_gwinUpdate(gh);
+	}
+
+	void gwinListSetCount(GHandle gh, int count) {
+		uint8_t		*sel;
+		coord_t		iheight;
+		int			i, maxtop;
+
+		// is it a valid handle?
+		if (gh->vmt != (gwinVMT *)&listVMT || !isvirtual(gh))
+			return;
+
+		if (count < 0)
+			count = 0;
+
+		// Keep the selection of the items that remain
+		if (SELBYTES(count) != SELBYTES(gh2obj->cnt) || !gh2obj->selected) {
+			if ((sel = count ? gfxAlloc(SELBYTES(count)) : 0)) {
+				memset(sel, 0, SELBYTES(count));
+				if (gh2obj->selected)
+					memcpy(sel, gh2obj->selected, SELBYTES(count) < SELBYTES(gh2obj->cnt) ? SELBYTES(count) : SELBYTES(gh2obj->cnt));
+			}
+			if (gh2obj->selected)
+				gfxFree(gh2obj->selected);
+			gh2obj->selected = sel;
+		}
+		for(i = count; i < gh2obj->cnt && i < SELBYTES(count)*8; i++)
+			VirtualSelect(gh2obj, i, FALSE);
+		gh2obj->cnt = count;
+
+		// Keep the view inside the list
+		iheight = gdispGetFontMetric(gh->font, fontHeight) + LST_VERT_PAD;
+		maxtop = count * iheight - (gh->height-2);
+		if (gh2obj->top > maxtop)
+			gh2obj->top = maxtop > 0 ? maxtop : 0;
+
+		_gwinUpdate(gh);
+	}
+#endif
+
 #if GWIN_NEED_LIST_IMAGES
 	void gwinListItemSetImage(GHandle gh, int item, gdispImage *pimg) {
 		const gfxQueueASyncItem	*	qi;
@@ -722,10 +963,24 @@ void gwinListDefaultDraw(GWidgetObject* gw, void* param) {
 
 	// Set the clipping region so we do not override the frame.
 	#if GDISP_NEED_CLIP
-		gdispGSetClip(gw->g.display, gw->g.x+1, gw->g.y+1, gw->g.width-2, gw->g.height-2);
+		_gwinSetClip(&gw->g, gw->g.x+1, gw->g.y+1, gw->g.width-2, gw->g.height-2);
 	#endif
 
 	// Draw until we run out of room or items
+	#if GWIN_LIST_VIRTUAL
+		if (isvirtual(gw)) {
+			const char	*text;
+
+			// Only the items in view are asked for
+			for (i = gw2obj->top / iheight, y = 1-(gw2obj->top%iheight); y < gw->g.height-2 && i < gw2obj->cnt; i++, y += iheight) {
+				if (!(text = gw2obj->fnItem(&gw->g, i, gw2obj->itemParam)))
+					text = "";
+				fill = VirtualIsSelected(gw2obj, i) ? ps->fill : gw->pstyle->background;
+				gdispGFillArea(gw->g.display, gw->g.x+1, gw->g.y+y, iwidth, iheight, fill);
+				gdispGFillStringBox(gw->g.display, gw->g.x+x+LST_HORIZ_PAD, gw->g.y+y, iwidth-LST_HORIZ_PAD, iheight, text, gw->g.font, ps->text, fill, justifyLeft);
+			}
+		} else
+	#endif
 	for (y = 1-(gw2obj->top%iheight); y < gw->g.height-2 && qi; qi = gfxQueueASyncNext(qi), y += iheight) {
 		fill = (qi2li->flags & GLIST_FLG_SELECTED) ? ps->fill : gw->pstyle->background;
 		gdispGFillArea(gw->g.display, gw->g.x+1, gw->g.y+y, iwidth, iheight, fill);
@@ -758,4 +1013,6 @@ void gwinListDefaultDraw(GWidgetObject* gw, void* param) {
 #undef qi2li
 #undef qix2li
 #undef ple
+#undef isvirtual
+#undef SELBYTES
 #endif // GFX_USE_GWIN && GWIN_NEED_LIST
@@ -47,6 +47,17 @@ typedef struct GEventGWinList {
 	int				item;		// The item that has been selected (or unselected in a multi-select listbox)
 } GEventGWinList;
 
+/**
+ * @brief	A function that supplies the text of an item of a virtual list
+ *
+ * @param[in] gh		The list
+ * @param[in] item		The item ID
+ * @param[in] param		The parameter passed to @p gwinListSetVirtual()
+ *
+ * @return	The text of the item. It only needs to stay valid until the next call.
+ */
+typedef const char * (*GListItemFunction)(GHandle gh, int item, void *param);
+
 // A list window
 typedef struct GListObject {
 	GWidgetObject	w;
@@ -64,6 +75,11 @@ typedef struct GListObject {
 	int				cnt;		// Number of items currently in the list (quicker than counting each time)
 	int				top;		// Viewing offset in pixels from the top of the list
 	gfxQueueASync	list_head;	// The list of items
+	#if GWIN_LIST_VIRTUAL
+		GListItemFunction	fnItem;		// Supplies the items of a virtual list (0 for a normal list)
+		void *				itemParam;	// The parameter for fnItem
+		uint8_t *			selected;	// One bit for each item of a virtual list
+	#endif
 } GListObject;
 
 /**
@@ -202,6 +218,18 @@ const char* gwinListItemGetText(GHandle gh, int item);
  */
 int gwinListFindText(GHandle gh, const char* text);
 
+/**
+ * @brief				Redraw an item after its contents have changed
+ *
+ * @details				Only the row of the item is redrawn and only if it is in view.
+ *
+ * @param[in] gh		The widget handle (must be a list handle)
+ * @param[in] item		The item ID
+ *
+ * @api
+ */
+void gwinListItemUpdate(GHandle gh, int item);
+
 /**
  * @brief				Set the custom parameter of an item with a given ID
  *
@@ -326,6 +354,45 @@ void gwinListSetSelected(GHandle gh, int item, bool_t doSelect);
  */
 void gwinListViewItem(GHandle gh, int item);
 
+#if GWIN_LIST_VIRTUAL || defined(__DOXYGEN__)
+	/**
+	 * @brief				Have the application supply the items of the list
+	 *
+	 * @pre					GWIN_LIST_VIRTUAL must be set to true in your gfxconf.h
+	 *
+	 * @param[in] gh		The widget handle (must be a list handle)
+	 * @param[in] fn		The function that supplies the item text or NULL to go back to a normal list
+	 * @param[in] param		A parameter passed to the function
+	 * @param[in] count		The number of items
+	 *
+	 * @note				Any items already in the list are deleted, the selection is cleared and the
+	 * 						list is scrolled to the top. As with @p gwinListAddItem() the first item of a
+	 * 						single-select list is selected.
+	 * @note				A virtual list stores only its item count and one selection bit per item. The
+	 * 						function is called for each row being drawn so a list of hundreds of items
+	 * 						costs no more to draw than a short one.
+	 * @note				@p gwinListAddItem(), @p gwinListItemDelete(), item parameters and item images
+	 * 						are not supported by a virtual list.
+	 *
+	 * @api
+	 */
+	void gwinListSetVirtual(GHandle gh, GListItemFunction fn, void *param, int count);
+
+	/**
+	 * @brief				Change the number of items in a virtual list
+	 *
+	 * @pre					GWIN_LIST_VIRTUAL must be set to true in your gfxconf.h
+	 *
+	 * @param[in] gh		The widget handle (must be a virtual list handle)
+	 * @param[in] count		The number of items
+	 *
+	 * @note				The selection and the view of the items that remain are kept.
+	 *
+	 * @api
+	 */
+	void gwinListSetCount(GHandle gh, int count);
+#endif
+
 #if GWIN_NEED_LIST_IMAGES || defined(__DOXYGEN__)
 	/**
 	 * @brief				Set the image for a list item
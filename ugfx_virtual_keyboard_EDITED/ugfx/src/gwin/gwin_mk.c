@@ -10,6 +10,7 @@
 #include "gwin_wm.c"
 #include "gwin_console.c"
 #include "gwin_graph.c"
+#include "gwin_chart.c"
 #include "gwin_button.c"
 #include "gwin_slider.c"
 #include "gwin_checkbox.c"
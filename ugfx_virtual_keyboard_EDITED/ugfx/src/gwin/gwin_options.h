@@ -79,6 +79,13 @@
 	#ifndef GWIN_NEED_GRAPH
 		#define GWIN_NEED_GRAPH		FALSE
 	#endif
+	/**
+	 * @brief   Should streaming chart functions be included.
+	 * @details	Defaults to FALSE
+	 */
+	#ifndef GWIN_NEED_CHART
+		#define GWIN_NEED_CHART		FALSE
+	#endif
 	/**
 	 * @brief   Should gl3d functions be included.
 	 * @details	Defaults to FALSE
@@ -202,18 +209,26 @@
 	/**
 	 * @brief	Redraw all windows in a single operation
 	 * @details	Defaults to FALSE
-	 * @note	Windows are normally redraw one per gtimer cycle.
-	 * 			Setting this option causes all windows to be redrawn in
-	 * 			a single gtimer cycle. Note that this can
-	 * 			cause extended blocking times on the timer thread but may
-	 * 			speed up redraw slightly.
-	 * @note	This is only relevant if GWIN_REDRAW_IMMEDIATE is FALSE.
-	 * 			Everything always gets redrawn in a single operation if
-	 * 			GWIN_REDRAW_IMMEDIATE is TRUE.
+	 * @note	The window manager now repaints all the damaged screen area
+	 * 			in a single gtimer cycle so this option has no effect. It is
+	 * 			kept so that existing configurations still compile.
 	 */
 	#ifndef GWIN_REDRAW_SINGLEOP
 		#define GWIN_REDRAW_SINGLEOP	FALSE
 	#endif
+	/**
+	 * @brief	The number of rectangles used to track the damaged screen area
+	 * @details	Defaults to 16
+	 * @note	The window manager repaints only the damaged parts of the screen that
+	 * 			each window leaves uncovered. When the damage needs more rectangles than
+	 * 			this it is merged into its bounding box, which repaints more than needed.
+	 * @note	This must be at least GDISP_TOTAL_DISPLAYS. Each rectangle costs 12 bytes
+	 * 			plus 48 bytes of scratch space.
+	 * @note	This is only relevant if GWIN_NEED_WINDOWMANAGER is TRUE.
+	 */
+	#ifndef GWIN_DAMAGE_RECTS
+		#define GWIN_DAMAGE_RECTS		16
+	#endif
 	/**
 	 * @brief   Buttons should not insist the mouse is over the button on mouse release
 	 * @details	Defaults to FALSE
@@ -323,6 +338,15 @@
 	#ifndef GWIN_LABEL_ATTRIBUTE
 	 	#define GWIN_LABEL_ATTRIBUTE			FALSE
 	#endif
+	/**
+	 * @brief	Enable the API to show integers in the label widget
+	 * @details	Defaults to FALSE
+	 * @note	A label showing a number lays its characters out in cells of equal width
+	 *			so that a new value repaints only the characters that changed.
+	 */
+	#ifndef GWIN_LABEL_NUMBER
+	 	#define GWIN_LABEL_NUMBER				FALSE
+	#endif
 	/**
 	 * @brief	Enable the API to use images in items in the list widget
 	 * @details	Defaults to FALSE
@@ -330,6 +354,21 @@
 	#ifndef GWIN_NEED_LIST_IMAGES
 	 	#define GWIN_NEED_LIST_IMAGES			FALSE
 	#endif
+	/**
+	 * @brief	Enable the API to have the application supply the items of a list widget
+	 * @details	Defaults to FALSE
+	 * @note	A virtual list stores no items. It asks for the text of the rows it is drawing.
+	 */
+	#ifndef GWIN_LIST_VIRTUAL
+	 	#define GWIN_LIST_VIRTUAL				FALSE
+	#endif
+	/**
+	 * @brief	The maximum number of series in a chart window
+	 * @details	Defaults to 4
+	 */
+	#ifndef GWIN_CHART_MAX_SERIES
+	 	#define GWIN_CHART_MAX_SERIES			4
+	#endif
 	/**
 	 * @brief	Enable the API to automatically increment the progressbar over time
 	 * @details	Defaults to FALSE
@@ -21,7 +21,7 @@
 	#if !GFX_USE_GDISP
 		#error "GWIN: GFX_USE_GDISP must be TRUE when using GWIN"
 	#endif
-	#if !GDISP_NEED_CLIP
+	#if !GDISP_NEED_CLIP && !GWIN_NEED_WINDOWMANAGER
 		#if GFX_DISPLAY_RULE_WARNINGS
 			#warning "GWIN: Drawing can occur outside the defined windows as GDISP_NEED_CLIP is FALSE"
 		#endif
@@ -98,6 +98,16 @@
 			#undef GFX_USE_GTIMER
 			#define GFX_USE_GTIMER		TRUE
 		#endif
+		#if !GDISP_NEED_CLIP
+			#if GFX_DISPLAY_RULE_WARNINGS
+				#warning "GWIN: GDISP_NEED_CLIP is required if GWIN_NEED_WINDOWMANAGER is TRUE. It has been turned on for you."
+			#endif
+			#undef GDISP_NEED_CLIP
+			#define GDISP_NEED_CLIP		TRUE
+		#endif
+		#if GWIN_DAMAGE_RECTS < GDISP_TOTAL_DISPLAYS
+			#error "GWIN: GWIN_DAMAGE_RECTS must be at least GDISP_TOTAL_DISPLAYS."
+		#endif
 	#endif
 
 	// Rules for individual objects
@@ -118,6 +128,11 @@
 			#error "GWIN: GDISP_NEED_IMAGE is required when GWIN_NEED_IMAGE is TRUE."
 		#endif
 	#endif
+	#if GWIN_NEED_CHART
+		#if !GDISP_NEED_TEXT
+			#error "GWIN: GDISP_NEED_TEXT is required if GWIN_NEED_CHART is TRUE."
+		#endif
+	#endif
 	#if GWIN_NEED_CONSOLE
 		#if !GDISP_NEED_TEXT
 			#error "GWIN: GDISP_NEED_TEXT is required if GWIN_NEED_CONSOLE is TRUE."
@@ -502,9 +502,23 @@ const GWidgetStyle *gwinGetDefaultStyle(void) {
 }
 
 void gwinSetText(GHandle gh, const char *text, bool_t useAlloc) {
+	bool_t	same;
+
 	if (!(gh->flags & GWIN_FLG_WIDGET))
 		return;
 
+	// Nothing to redraw if the text is the same.
+	// The same pointer may have been written to since it was drawn so it always counts as a change.
+	if (!text)
+		text = "";
+	same = gw->text && gw->text != text && !strcmp(gw->text, text);
+	if (same && (!useAlloc || (gh->flags & GWIN_FLG_ALLOCTXT))) {
+		// Our copy is as good as the new one
+		if (!(gh->flags & GWIN_FLG_ALLOCTXT))
+			gw->text = text;
+		return;
+	}
+
 	// Dispose of the old string
 	if ((gh->flags & GWIN_FLG_ALLOCTXT)) {
 		gh->flags &= ~GWIN_FLG_ALLOCTXT;
@@ -527,7 +541,8 @@ void gwinSetText(GHandle gh, const char *text, bool_t useAlloc) {
 		gw->text = (const char *)str;
 	} else
 		gw->text = text;
-	_gwinUpdate(gh);
+	if (!same)
+		_gwinUpdate(gh);
 }
 
 #if GFX_USE_GFILE && GFILE_NEED_PRINTG && GFILE_NEED_STRINGS
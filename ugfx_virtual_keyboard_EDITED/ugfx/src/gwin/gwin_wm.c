@@ -83,6 +83,19 @@
 		gh->flags &= ~(GWIN_FLG_NEEDREDRAW|GWIN_FLG_BGREDRAW);
 	}
 
+	void _gwinUpdateArea(GHandle gh, coord_t x, coord_t y, coord_t cx, coord_t cy) {
+		(void) x; (void) y; (void) cx; (void) cy;
+
+		// Without a window manager the whole window is redrawn
+		_gwinUpdate(gh);
+	}
+
+	void _gwinScrollArea(GHandle gh, coord_t x, coord_t y, coord_t cx, coord_t cy, int lines) {
+		(void) x; (void) y; (void) cx; (void) cy; (void) lines;
+
+		_gwinUpdate(gh);
+	}
+
 	bool_t _gwinDrawStart(GHandle gh) {
 		if (!(gh->flags & GWIN_FLG_SYSVISIBLE))
 			return FALSE;
@@ -96,6 +109,21 @@
 		exitLock(gh);
 	}
 
+	#if GDISP_NEED_CLIP
+		void _gwinSetClip(GHandle gh, coord_t x, coord_t y, coord_t cx, coord_t cy) {
+			coord_t		x1, y1;
+
+			x1 = x+cx; y1 = y+cy;
+			if (x < gh->x)					x = gh->x;
+			if (y < gh->y)					y = gh->y;
+			if (x1 > gh->x+gh->width)		x1 = gh->x+gh->width;
+			if (y1 > gh->y+gh->height)		y1 = gh->y+gh->height;
+			if (x1 < x)						x1 = x;
+			if (y1 < y)						y1 = y;
+			gdispGSetClip(gh->display, x, y, x1-x, y1-y);
+		}
+	#endif
+
 	void gwinSetVisible(GHandle gh, bool_t visible) {
 		if (visible) {
 			if (!(gh->flags & GWIN_FLG_VISIBLE)) {
@@ -176,6 +204,20 @@ static volatile uint8_t		RedrawPending;
 	#define DOREDRAW_VISIBLES		0x02
 	#define DOREDRAW_FLASHRUNNING	0x04
 
+// The damaged screen area is a list of disjoint rectangles. Each window paints the part of it
+//	that no window above covers, so each damaged pixel is painted once by the top-most window.
+typedef struct DamageRect {
+	GDisplay *				display;
+	coord_t					x0, y0, x1, y1;
+} DamageRect;
+static DamageRect			Damage[GWIN_DAMAGE_RECTS];
+static unsigned				DamageCnt;
+static DamageRect			DamageBox;							// Bounding box of all the damage
+static DamageRect			Pieces[GWIN_DAMAGE_RECTS*4];		// The part of the damage being painted
+static unsigned				PieceCnt;
+static const DamageRect *	PaintRect;							// The piece being painted or 0
+static GWindowDamageStats	DamageStats;
+
 
 /*-----------------------------------------------
  * Window Routines
@@ -222,8 +264,190 @@ void _gwmDeinit(void)
 	}
 #endif
 
+/*-----------------------------------------------
+ * Damage Region Routines
+ *-----------------------------------------------*/
+
+// Cut c out of the rectangles in p. Returns FALSE if there is no room for the extra pieces
+//	in which case p still covers everything it should but may also overlap c.
+static bool_t DamageCut(DamageRect *p, unsigned *pcnt, unsigned max, const DamageRect *c) {
+	DamageRect	r;
+	unsigned	i, n;
+
+	for(i = 0, n = *pcnt; i < n; ) {
+		r = p[i];
+		if (r.display != c->display || r.x0 >= c->x1 || r.x1 <= c->x0 || r.y0 >= c->y1 || r.y1 <= c->y0) {
+			i++;
+			continue;
+		}
+
+		// A rectangle can be replaced by up to four
+		if (n+3 > max) {
+			*pcnt = n;
+			return FALSE;
+		}
+		p[i] = p[--n];
+		if (r.y0 < c->y0) { p[n] = r; p[n++].y1 = c->y0; r.y0 = c->y0; }
+		if (r.y1 > c->y1) { p[n] = r; p[n++].y0 = c->y1; r.y1 = c->y1; }
+		if (r.x0 < c->x0) { p[n] = r; p[n++].x1 = c->x0; }
+		if (r.x1 > c->x1) { p[n] = r; p[n++].x0 = c->x1; }
+	}
+	*pcnt = n;
+	return TRUE;
+}
+
+static void DamageAdd(GDisplay *g, coord_t x, coord_t y, coord_t cx, coord_t cy) {
+	DamageRect	nr;
+	unsigned	i;
+
+	if (cx <= 0 || cy <= 0)
+		return;
+	nr.display = g;
+	nr.x0 = x; nr.x1 = x+cx;
+	nr.y0 = y; nr.y1 = y+cy;
+
+	// Add just the part that is not already damaged
+	Pieces[0] = nr;
+	PieceCnt = 1;
+	for(i = 0; i < DamageCnt && PieceCnt; i++) {
+		if (!DamageCut(Pieces, &PieceCnt, GWIN_DAMAGE_RECTS*4, &Damage[i]))
+			break;
+	}
+	if (i >= DamageCnt || !PieceCnt) {
+		if (DamageCnt+PieceCnt <= GWIN_DAMAGE_RECTS) {
+			for(i = 0; i < PieceCnt; i++)
+				Damage[DamageCnt++] = Pieces[i];
+			goto growbox;
+		}
+	}
+
+	// Too fragmented - replace the damage on this display with its bounding box
+	DamageStats.Overflows++;
+	for(i = 0; i < DamageCnt; ) {
+		if (Damage[i].display != g) {
+			i++;
+			continue;
+		}
+		if (Damage[i].x0 < nr.x0)	nr.x0 = Damage[i].x0;
+		if (Damage[i].y0 < nr.y0)	nr.y0 = Damage[i].y0;
+		if (Damage[i].x1 > nr.x1)	nr.x1 = Damage[i].x1;
+		if (Damage[i].y1 > nr.y1)	nr.y1 = Damage[i].y1;
+		Damage[i] = Damage[--DamageCnt];
+	}
+	Damage[DamageCnt++] = nr;
+
+growbox:
+	if (DamageCnt == 1) {
+		DamageBox = Damage[0];
+		return;
+	}
+	if (nr.x0 < DamageBox.x0)	DamageBox.x0 = nr.x0;
+	if (nr.y0 < DamageBox.y0)	DamageBox.y0 = nr.y0;
+	if (nr.x1 > DamageBox.x1)	DamageBox.x1 = nr.x1;
+	if (nr.y1 > DamageBox.y1)	DamageBox.y1 = nr.y1;
+}
+
+// Does the window cover its whole area when it draws
+static bool_t IsOpaque(GHandle gh) {
+	#if GWIN_NEED_WIDGET
+		if ((gh->flags & GWIN_FLG_WIDGET)) {
+			#if GWIN_NEED_CONTAINER
+				if (((GWidgetObject *)gh)->fnDraw == gwinContainerDraw_Transparent)
+					return FALSE;
+			#endif
+			#if GWIN_NEED_FRAME
+				if (((GWidgetObject *)gh)->fnDraw == gwinFrameDraw_Transparent)
+					return FALSE;
+			#endif
+			#if GWIN_NEED_TABSET
+				if (((GWidgetObject *)gh)->fnDraw == gwinTabsetDraw_Transparent)
+					return FALSE;
+			#endif
+		}
+	#endif
+	(void) gh;
+	return TRUE;
+}
+
+// Put in Pieces the damage that a window (or the background if gh is 0) has to paint
+static void DamageVisible(GHandle gh) {
+	DamageRect	w;
+	GHandle		gx;
+	unsigned	i;
+
+	PieceCnt = 0;
+	for(i = 0; i < DamageCnt; i++) {
+		if (gh) {
+			if (Damage[i].display != gh->display
+					|| Damage[i].x0 >= gh->x+gh->width || Damage[i].x1 <= gh->x
+					|| Damage[i].y0 >= gh->y+gh->height || Damage[i].y1 <= gh->y)
+				continue;
+			Pieces[PieceCnt].display = gh->display;
+			Pieces[PieceCnt].x0 = Damage[i].x0 > gh->x ? Damage[i].x0 : gh->x;
+			Pieces[PieceCnt].y0 = Damage[i].y0 > gh->y ? Damage[i].y0 : gh->y;
+			Pieces[PieceCnt].x1 = Damage[i].x1 < gh->x+gh->width ? Damage[i].x1 : gh->x+gh->width;
+			Pieces[PieceCnt].y1 = Damage[i].y1 < gh->y+gh->height ? Damage[i].y1 : gh->y+gh->height;
+			PieceCnt++;
+		} else
+			Pieces[PieceCnt++] = Damage[i];
+	}
+
+	// Cut out the windows above
+	for(gx = gwinGetNextWindow(gh); gx && PieceCnt; gx = gwinGetNextWindow(gx)) {
+		if (!(gx->flags & GWIN_FLG_SYSVISIBLE) || !IsOpaque(gx))
+			continue;
+		w.display = gx->display;
+		w.x0 = gx->x; w.x1 = gx->x+gx->width;
+		w.y0 = gx->y; w.y1 = gx->y+gx->height;
+		if (!DamageCut(Pieces, &PieceCnt, GWIN_DAMAGE_RECTS*4, &w))
+			break;			// Paint some extra - the windows above paint over it afterwards
+	}
+}
+
+// Paint the Pieces of a window (or the background if gh is 0)
+static void DamagePaint(GHandle gh) {
+	unsigned	i;
+
+	for(i = 0; i < PieceCnt; i++) {
+		PaintRect = &Pieces[i];
+		gdispGSetClip(PaintRect->display, PaintRect->x0, PaintRect->y0, PaintRect->x1-PaintRect->x0, PaintRect->y1-PaintRect->y0);
+		if (gh)
+			_GWINwm->vmt->Redraw(gh);
+		else
+			gdispGFillArea(PaintRect->display, PaintRect->x0, PaintRect->y0, PaintRect->x1-PaintRect->x0, PaintRect->y1-PaintRect->y0, gwinGetDefaultBgColor());
+		gdispGUnsetClip(PaintRect->display);
+		DamageStats.PaintedPixels += (uint32_t)(PaintRect->x1-PaintRect->x0) * (PaintRect->y1-PaintRect->y0);
+	}
+	PaintRect = 0;
+}
+
+void _gwinSetClip(GHandle gh, coord_t x, coord_t y, coord_t cx, coord_t cy) {
+	coord_t		x0, y0, x1, y1;
+
+	// Stay inside the piece being painted or else the window
+	if (PaintRect) {
+		x0 = PaintRect->x0; y0 = PaintRect->y0;
+		x1 = PaintRect->x1; y1 = PaintRect->y1;
+	} else {
+		x0 = gh->x; y0 = gh->y;
+		x1 = gh->x+gh->width; y1 = gh->y+gh->height;
+	}
+	if (x > x0)			x0 = x;
+	if (y > y0)			y0 = y;
+	if (x+cx < x1)		x1 = x+cx;
+	if (y+cy < y1)		y1 = y+cy;
+	if (x1 < x0)		x1 = x0;
+	if (y1 < y0)		y1 = y0;
+	gdispGSetClip(gh->display, x0, y0, x1-x0, y1-y0);
+}
+
+void gwinGetDamageStats(GWindowDamageStats *pstats) {
+	*pstats = DamageStats;
+}
+
 void _gwinFlushRedraws(GRedrawMethod how) {
 	GHandle		gh;
+	unsigned	i;
 
 	// Do we really need to do anything?
 	if (!RedrawPending)
@@ -236,71 +460,64 @@ void _gwinFlushRedraws(GRedrawMethod how) {
 		// Someone is drawing - They will do the redraw when they are finished
 		return;
 
-	// Do loss of visibility first
-	while ((RedrawPending & DOREDRAW_INVISIBLES)) {
-		RedrawPending &= ~DOREDRAW_INVISIBLES;				// Catch new requests
+	while ((RedrawPending & (DOREDRAW_INVISIBLES|DOREDRAW_VISIBLES))) {
+		RedrawPending &= ~(DOREDRAW_INVISIBLES|DOREDRAW_VISIBLES);		// Catch new requests
 
+		// Turn the windows marked for redraw into damage.
+		//	Hidden windows damage the area they uncover, visible ones their own area.
 		for(gh = gwinGetNextWindow(0); gh; gh = gwinGetNextWindow(gh)) {
-			if ((gh->flags & (GWIN_FLG_NEEDREDRAW|GWIN_FLG_SYSVISIBLE)) != GWIN_FLG_NEEDREDRAW)
+			if (!(gh->flags & GWIN_FLG_NEEDREDRAW))
 				continue;
-
-			// Do the redraw
-			#if GDISP_NEED_CLIP
-				gdispGSetClip(gh->display, gh->x, gh->y, gh->width, gh->height);
-				_GWINwm->vmt->Redraw(gh);
-				gdispGUnsetClip(gh->display);
-			#else
-				_GWINwm->vmt->Redraw(gh);
-			#endif
-
-			// Postpone further redraws
-			#if !GWIN_REDRAW_IMMEDIATE && !GWIN_REDRAW_SINGLEOP
-				if (how == REDRAW_NOWAIT) {
-					RedrawPending |= DOREDRAW_INVISIBLES;
-					TriggerRedraw();
-					goto releaselock;
-				}
-			#endif
+			if ((gh->flags & GWIN_FLG_SYSVISIBLE)) {
+				// Windows that can't redraw themselves only repaint when they are being cleared
+				if (gh->vmt->Redraw || (gh->flags & GWIN_FLG_BGREDRAW))
+					DamageAdd(gh->display, gh->x, gh->y, gh->width, gh->height);
+				gh->flags &= ~GWIN_FLG_NEEDREDRAW;
+			} else {
+				if ((gh->flags & GWIN_FLG_BGREDRAW))
+					DamageAdd(gh->display, gh->x, gh->y, gh->width, gh->height);
+				gh->flags &= ~(GWIN_FLG_NEEDREDRAW|GWIN_FLG_BGREDRAW);
+			}
 		}
-	}
+		if (!DamageCnt)
+			continue;
 
-	// Do the visible windows next
-	while ((RedrawPending & DOREDRAW_VISIBLES)) {
-		RedrawPending &= ~DOREDRAW_VISIBLES;				// Catch new requests
+		DamageStats.Frames++;
+		DamageStats.DamagedPixels = 0;
+		DamageStats.PaintedPixels = 0;
+		for(i = 0; i < DamageCnt; i++)
+			DamageStats.DamagedPixels += (uint32_t)(Damage[i].x1-Damage[i].x0) * (Damage[i].y1-Damage[i].y0);
 
+		// Paint from the bottom up - the background first
+		DamageVisible(0);
+		DamagePaint(0);
 		for(gh = gwinGetNextWindow(0); gh; gh = gwinGetNextWindow(gh)) {
-			if ((gh->flags & (GWIN_FLG_NEEDREDRAW|GWIN_FLG_SYSVISIBLE)) != (GWIN_FLG_NEEDREDRAW|GWIN_FLG_SYSVISIBLE))
+			if (!(gh->flags & GWIN_FLG_SYSVISIBLE))
 				continue;
+			if (gh->x >= DamageBox.x1 || gh->x+gh->width <= DamageBox.x0 || gh->y >= DamageBox.y1 || gh->y+gh->height <= DamageBox.y0) {
+				DamageStats.WindowsSkipped++;
+				continue;
+			}
+			DamageVisible(gh);
+			if (!PieceCnt) {
+				DamageStats.WindowsCulled++;
+				continue;
+			}
+			DamageStats.WindowsPainted++;
+			DamagePaint(gh);
 
-			// Do the redraw
-			#if GDISP_NEED_CLIP
-				gdispGSetClip(gh->display, gh->x, gh->y, gh->width, gh->height);
-				_GWINwm->vmt->Redraw(gh);
-				gdispGUnsetClip(gh->display);
-			#else
-				_GWINwm->vmt->Redraw(gh);
-			#endif
-
-			// Postpone further redraws (if there are any and the options are set right)
-			#if !GWIN_REDRAW_IMMEDIATE && !GWIN_REDRAW_SINGLEOP
-				if (how == REDRAW_NOWAIT) {
-					while((gh = gwinGetNextWindow(gh))) {
-						if ((gh->flags & (GWIN_FLG_NEEDREDRAW|GWIN_FLG_SYSVISIBLE)) == (GWIN_FLG_NEEDREDRAW|GWIN_FLG_SYSVISIBLE)) {
-							RedrawPending |= DOREDRAW_VISIBLES;
-							TriggerRedraw();
-							break;
-						}
-					}
-					goto releaselock;
-				}
-			#endif
+			// A window that was cleared rather than redrawn needs to know
+			if ((gh->flags & GWIN_FLG_BGREDRAW)) {
+				gh->flags &= ~GWIN_FLG_BGREDRAW;
+				if (!gh->vmt->Redraw && gh->vmt->AfterClear)
+					gh->vmt->AfterClear(gh);
+			}
 		}
+		DamageStats.TotalDamaged += DamageStats.DamagedPixels;
+		DamageStats.TotalPainted += DamageStats.PaintedPixels;
+		DamageCnt = 0;
 	}
 
-	#if !GWIN_REDRAW_IMMEDIATE && !GWIN_REDRAW_SINGLEOP
-		releaselock:
-	#endif
-
 	// Release the lock
 	if (how == REDRAW_WAIT || how == REDRAW_NOWAIT)
 		gfxSemSignal(&gwinsem);
@@ -319,6 +536,76 @@ void _gwinUpdate(GHandle gh) {
 	TriggerRedraw();
 }
 
+void _gwinUpdateArea(GHandle gh, coord_t x, coord_t y, coord_t cx, coord_t cy) {
+	// Only redraw if visible and not already being redrawn in full
+	if ((gh->flags & (GWIN_FLG_SYSVISIBLE|GWIN_FLG_NEEDREDRAW)) != GWIN_FLG_SYSVISIBLE)
+		return;
+
+	// Keep it inside the window
+	if (x < gh->x)						{ cx -= gh->x - x; x = gh->x; }
+	if (y < gh->y)						{ cy -= gh->y - y; y = gh->y; }
+	if (x+cx > gh->x+gh->width)			cx = gh->x+gh->width - x;
+	if (y+cy > gh->y+gh->height)		cy = gh->y+gh->height - y;
+
+	// The damage can only be changed with the drawing lock
+	gfxSemWait(&gwinsem, TIME_INFINITE);
+	DamageAdd(gh->display, x, y, cx, cy);
+	RedrawPending |= DOREDRAW_VISIBLES;
+	gfxSemSignal(&gwinsem);
+
+	// Asynchronous redraw
+	TriggerRedraw();
+}
+
+void _gwinScrollArea(GHandle gh, coord_t x, coord_t y, coord_t cx, coord_t cy, int lines) {
+	#if GDISP_NEED_SCROLL
+		GHandle		gx;
+		coord_t		abslines;
+	#endif
+
+	// Only redraw if visible and not already being redrawn in full
+	if ((gh->flags & (GWIN_FLG_SYSVISIBLE|GWIN_FLG_NEEDREDRAW)) != GWIN_FLG_SYSVISIBLE || !lines)
+		return;
+
+	// Keep it inside the window
+	if (x < gh->x)						{ cx -= gh->x - x; x = gh->x; }
+	if (y < gh->y)						{ cy -= gh->y - y; y = gh->y; }
+	if (x+cx > gh->x+gh->width)			cx = gh->x+gh->width - x;
+	if (y+cy > gh->y+gh->height)		cy = gh->y+gh->height - y;
+	if (cx <= 0 || cy <= 0)
+		return;
+
+	gfxSemWait(&gwinsem, TIME_INFINITE);
+
+	#if GDISP_NEED_SCROLL
+		// The pixels on the display can only be moved if they are up to date and nothing is over them
+		abslines = lines < 0 ? -lines : lines;
+		if (abslines < cy && !DamageCnt && !(RedrawPending & (DOREDRAW_INVISIBLES|DOREDRAW_VISIBLES))) {
+			for(gx = gwinGetNextWindow(gh); gx; gx = gwinGetNextWindow(gx)) {
+				if ((gx->flags & GWIN_FLG_SYSVISIBLE) && gx->display == gh->display
+						&& gx->x < x+cx && gx->x+gx->width > x && gx->y < y+cy && gx->y+gx->height > y)
+					break;
+			}
+			if (!gx) {
+				gdispGVerticalScroll(gh->display, x, y, cx, cy, lines, gh->bgcolor);
+				DamageStats.ScrolledPixels += (uint32_t)cx * (cy - abslines);
+
+				// Only the uncovered lines are left to paint
+				if (lines > 0)
+					y += cy - abslines;
+				cy = abslines;
+			}
+		}
+	#endif
+
+	DamageAdd(gh->display, x, y, cx, cy);
+	RedrawPending |= DOREDRAW_VISIBLES;
+	gfxSemSignal(&gwinsem);
+
+	// Asynchronous redraw
+	TriggerRedraw();
+}
+
 #if GWIN_NEED_CONTAINERS
 	void _gwinRippleVisibility(void) {
 		GHandle		gh;
@@ -678,9 +965,6 @@ GHandle gwinGetNextWindow(GHandle gh) {
  * "Null" Window Manager Routines
  *-----------------------------------------------*/
 
-// This is a parent reveal operation
-#define GWIN_FLG_PARENTREVEAL		(GWIN_FIRST_WM_FLAG << 0)
-
 // Minimum dimensions
 #define MIN_WIN_WIDTH	3
 #define MIN_WIN_HEIGHT	3
@@ -746,80 +1030,13 @@ static void WM_Delete(GHandle gh) {
 }
 
 static void WM_Redraw(GHandle gh) {
-	#if GWIN_NEED_CONTAINERS
-		redo_redraw:
-	#endif
-	if ((gh->flags & GWIN_FLG_SYSVISIBLE)) {
-		if (gh->vmt->Redraw)
-			gh->vmt->Redraw(gh);
-		else if ((gh->flags & GWIN_FLG_BGREDRAW)) {
-			// We can't redraw but we want full coverage so just clear the area
-			gdispGFillArea(gh->display, gh->x, gh->y, gh->width, gh->height, gh->bgcolor);
-
-			// Only do an after clear if this is not a parent reveal
-			if (!(gh->flags & GWIN_FLG_PARENTREVEAL) && gh->vmt->AfterClear)
-				gh->vmt->AfterClear(gh);
-		}
-
-		#if GWIN_NEED_CONTAINERS
-			// If this is container but not a parent reveal, mark any visible children for redraw
-			//	We redraw our children here as we have overwritten them in redrawing the parent
-			//	as GDISP/GWIN doesn't support complex clipping regions.
-			if ((gh->flags & (GWIN_FLG_CONTAINER|GWIN_FLG_PARENTREVEAL)) == GWIN_FLG_CONTAINER) {
-
-				// Container redraw is done
-				gh->flags &= ~(GWIN_FLG_NEEDREDRAW|GWIN_FLG_BGREDRAW|GWIN_FLG_PARENTREVEAL);
-
-				for(gh = gwinGetFirstChild(gh); gh; gh = gwinGetSibling(gh))
-					_gwinUpdate(gh);
-				return;
-			}
-		#endif
-
-	} else {
-		if ((gh->flags & GWIN_FLG_BGREDRAW)) {
-			GHandle		gx;
-
-			#if GWIN_NEED_CONTAINERS
-				if (gh->parent) {
-					// Child redraw is done
-					gh->flags &= ~(GWIN_FLG_NEEDREDRAW|GWIN_FLG_BGREDRAW|GWIN_FLG_PARENTREVEAL);
-
-
-					// Get the parent to redraw the area
-					gh = gh->parent;
-
-					// The parent is already marked for redraw - don't do it now.
-					if ((gh->flags & GWIN_FLG_NEEDREDRAW))
-						return;
-
-					// Use the existing clipping region and redraw now
-					gh->flags |= (GWIN_FLG_BGREDRAW|GWIN_FLG_PARENTREVEAL);
-					goto redo_redraw;
-				}
-			#endif
-
-			// Clear the area to the background color
-			gdispGFillArea(gh->display, gh->x, gh->y, gh->width, gh->height, gwinGetDefaultBgColor());
-
-			// Now loop over all windows looking for overlaps. Redraw them if they overlap the newly exposed area.
-			for(gx = gwinGetNextWindow(0); gx; gx = gwinGetNextWindow(gx)) {
-				if ((gx->flags & GWIN_FLG_SYSVISIBLE)
-						&& gx->display == gh->display
-						&& gx->x < gh->x+gh->width && gx->y < gh->y+gh->height && gx->x+gx->width >= gh->x && gx->y+gx->height >= gh->y) {
-					if (gx->vmt->Redraw)
-						gx->vmt->Redraw(gx);
-					else
-						// We can't redraw this window but we want full coverage so just clear the area
-						gdispGFillArea(gx->display, gx->x, gx->y, gx->width, gx->height, gx->bgcolor);
-				}
-			}
-
-		}
-	}
-
-	// Redraw is done
-	gh->flags &= ~(GWIN_FLG_NEEDREDRAW|GWIN_FLG_BGREDRAW|GWIN_FLG_PARENTREVEAL);
+	// Paint the window inside the current clip. The flush has already worked out which part of
+	//	the damage the window owns so uncovered areas and children are looked after there.
+	if (gh->vmt->Redraw)
+		gh->vmt->Redraw(gh);
+	else
+		// We can't redraw but we want full coverage so just clear the area
+		gdispGFillArea(gh->display, gh->x, gh->y, gh->width, gh->height, gh->bgcolor);
 }
 
 static void WM_Size(GHandle gh, coord_t w, coord_t h) {
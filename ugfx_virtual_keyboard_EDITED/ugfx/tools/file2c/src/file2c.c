@@ -40,6 +40,15 @@ static char *basenameof(char *fname) {
 	return fname;
 }
 
+/* FNV-1a of the name, the ROM file system indexes directory entries by it */
+static unsigned long namehash(const char *fname) {
+	unsigned long h;
+
+	for(h = 2166136261UL; *fname; fname++)
+		h = ((h ^ (unsigned char)*fname) * 16777619UL) & 0xFFFFFFFFUL;
+	return h;
+}
+
 static char *clean4c(char *fname) {
 	char *p;
 
@@ -195,7 +204,7 @@ size_t		i;
 	/* Add the directory entry if required */
 	if (opt_romdir) {
 		fprintf(f_output, "\n#ifdef ROMFS_DIRENTRY_HEAD\n");
-		fprintf(f_output, "\t%s%sROMFS_DIRENTRY %s_dir = { 0, 0, ROMFS_DIRENTRY_HEAD, \"%s\", %u, %s };\n", opt_static, opt_const, opt_arrayname, opt_dirname, totallen, opt_arrayname);
+		fprintf(f_output, "\t%s%sROMFS_DIRENTRY %s_dir = { 0, 0, ROMFS_DIRENTRY_HEAD, \"%s\", %u, %s, 0x%08lX };\n", opt_static, opt_const, opt_arrayname, opt_dirname, totallen, opt_arrayname, namehash(opt_dirname));
 		fprintf(f_output, "\t#undef ROMFS_DIRENTRY_HEAD\n\t#define ROMFS_DIRENTRY_HEAD &%s_dir\n#endif\n", opt_arrayname);
 	}
 
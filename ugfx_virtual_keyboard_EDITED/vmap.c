@@ -0,0 +1,441 @@
+#include "vmap.h"
+#include "sdram.h"
+#include "trace.h"
+#include "stm32fxxx_hal.h"
+#include <math.h>
+
+#define VMAP_SLOTS						(SDRAM_VMAP_SIZE / VMAP_TILE_BYTES)
+#define VMAP_VISIBLE					36			// 6x6 tiles, enough for rotated map area at every zoom
+#define VMAP_MISSING_ENTRIES	64
+#define VMAP_HEADER_BYTES			12
+#define VMAP_FEATURE_BYTES		6
+#define VMAP_ESCAPE						-128
+#define VMAP_ZOOMS						(VMAP_MAX_ZOOM - VMAP_MIN_ZOOM + 1)
+#define VMAP_ROUND_WIDTH			4				// Lines this wide get round joins, narrower gaps are not visible
+
+typedef enum {
+	VMAP_EMPTY,
+	VMAP_READY
+} vmap_state_t;
+
+typedef struct {
+	uint32_t x;
+	uint32_t y;
+	uint8_t zoom;
+	uint8_t state;
+	uint32_t used;						// Draw in which tile was last used, for LRU
+	uint32_t size;
+	uint8_t *data;						// Tile file as read from SD
+} vmap_slot_t;
+
+typedef struct {
+	uint32_t x;
+	uint32_t y;
+	uint8_t zoom;
+} vmap_id_t;
+
+typedef struct {
+	uint32_t x;
+	uint32_t y;
+	int32_t distance;
+	vmap_slot_t *slot;
+} vmap_request_t;
+
+typedef struct {
+	color_t color;
+	uint8_t width[VMAP_ZOOMS];	// Line width at display zoom 12 to 18, 0 hides class, areas are only tested for 0
+} vmap_style_t;
+
+static const vmap_style_t styles[VMAP_CLASSES] = {
+	{HTML2COLOR(0xAAD3DF), {1, 1, 1, 1, 1, 1, 1}},			// Water
+	{HTML2COLOR(0xC8FACC), {1, 1, 1, 1, 1, 1, 1}},			// Park
+	{HTML2COLOR(0xADD19E), {1, 1, 1, 1, 1, 1, 1}},			// Forest
+	{HTML2COLOR(0xE0DFDF), {0, 0, 1, 1, 1, 1, 1}},			// Residential
+	{HTML2COLOR(0xEBDBE8), {0, 0, 1, 1, 1, 1, 1}},			// Industrial
+	{HTML2COLOR(0xAAD3DF), {1, 1, 2, 2, 3, 4, 6}},			// River
+	{HTML2COLOR(0x9C8C7C), {0, 0, 0, 1, 1, 2, 2}},			// Path
+	{HTML2COLOR(0x3F6FD8), {0, 1, 1, 2, 2, 3, 4}},			// Cycleway
+	{HTML2COLOR(0xFFFFFF), {0, 1, 1, 2, 3, 5, 8}},			// Minor road
+	{HTML2COLOR(0xF7FABF), {1, 1, 2, 3, 4, 6, 10}},			// Secondary road
+	{HTML2COLOR(0xFCD6A4), {1, 2, 3, 4, 5, 8, 12}},			// Primary road
+	{HTML2COLOR(0xE892A2), {2, 2, 3, 4, 6, 9, 14}}			// Motorway
+};
+
+static vmap_slot_t slots[VMAP_SLOTS];
+static vmap_id_t missing[VMAP_MISSING_ENTRIES];
+static uint32_t missingNext;
+static uint32_t frame;
+static bool checked;
+static bool available;
+
+static point points[VMAP_MAX_POINTS];
+static char tilePath[40];
+static vmap_stats_t stats;
+
+static vmap_slot_t *vmapFind(uint8_t zoom, uint32_t x, uint32_t y);
+static vmap_slot_t *vmapLoad(uint8_t zoom, uint32_t x, uint32_t y);
+static bool vmapIsMissing(uint8_t zoom, uint32_t x, uint32_t y);
+static void vmapSetMissing(uint8_t zoom, uint32_t x, uint32_t y);
+static void vmapDrawFeatures(const vmap_slot_t *slot, bool lines, const MatrixFixed2D *m, uint8_t zoom, coord_t x, coord_t y, coord_t cx, coord_t cy);
+static uint32_t vmapDecode(const uint8_t *data, const uint8_t *end, uint32_t count);
+static bool vmapVisible(uint32_t count, coord_t margin, coord_t x, coord_t y, coord_t cx, coord_t cy);
+static void vmapDrawLine(uint32_t count, color_t color, coord_t width);
+static int16_t vmapRead16(const uint8_t *p);
+static uint32_t vmapRead32(const uint8_t *p);
+
+void vmapInit(){
+	uint32_t i;
+
+	for(i = 0; i < VMAP_SLOTS; i++){
+		slots[i].data = (uint8_t *)(uintptr_t)(SDRAM_VMAP_ADDR + i * VMAP_TILE_BYTES);
+		slots[i].state = VMAP_EMPTY;
+	}
+	for(i = 0; i < VMAP_MISSING_ENTRIES; i++){
+		missing[i].zoom = 0xFF;
+	}
+}
+
+bool vmapAvailable(){
+	// Checked once, SD card is not swapped while running
+	if(!checked){
+		available = gfileExists(VMAP_DIR);
+		checked = true;
+	}
+	return available;
+}
+
+bool vmapDraw(const proj_world_t *center, uint8_t zoom, int16_t rotation, coord_t centerX, coord_t centerY, coord_t x, coord_t y, coord_t cx, coord_t cy){
+	vmap_request_t requests[VMAP_VISIBLE], request;
+	MatrixFixed2D rot, base, m;
+	coord_t clipX, clipY, clipCX, clipCY;
+	uint8_t dataZoom, shift, tileShift;
+	int32_t left, right, top, bottom, minX, maxX, minY, maxY, tx, ty, dx, dy, last;
+	int64_t wx, wy;
+	fixed fx, fy;
+	uint32_t i, j, n = 0, loads = 0, elapsed, start = HAL_GetTick();
+	bool complete = true;
+
+	if(zoom < VMAP_MIN_ZOOM){
+		zoom = VMAP_MIN_ZOOM;
+	}else if(zoom > VMAP_MAX_ZOOM){
+		zoom = VMAP_MAX_ZOOM;
+	}
+	dataZoom = VMAP_MIN_ZOOM + ((zoom - VMAP_MIN_ZOOM) & ~1);
+	if(dataZoom > VMAP_MAX_DATA_ZOOM){
+		dataZoom = VMAP_MAX_DATA_ZOOM;
+	}
+	shift = PROJ_PIXEL_SHIFT(zoom);
+	tileShift = PROJ_TILE_SHIFT(dataZoom);
+	last = (1 << dataZoom) - 1;
+
+	// Map area around marker in pixels, rotated map needs the circle through its furthest corner
+	left = x - centerX;
+	right = x + cx - centerX;
+	top = y - centerY;
+	bottom = y + cy - centerY;
+	if(rotation != 0){
+		dx = right > -left ? right : -left;
+		dy = bottom > -top ? bottom : -top;
+		right = bottom = (int32_t)sqrtf((float)(dx * dx + dy * dy)) + 1;
+		left = top = -right;
+	}
+	minX = (int32_t)(((int64_t)center->x + (int64_t)left * ((int64_t)1 << shift)) >> tileShift);
+	maxX = (int32_t)(((int64_t)center->x + (int64_t)right * ((int64_t)1 << shift)) >> tileShift);
+	minY = (int32_t)(((int64_t)center->y + (int64_t)top * ((int64_t)1 << shift)) >> tileShift);
+	maxY = (int32_t)(((int64_t)center->y + (int64_t)bottom * ((int64_t)1 << shift)) >> tileShift);
+
+	// Visible tiles sorted by distance of their centre from marker, so nearest are loaded first
+	for(ty = minY < 0 ? 0 : minY; ty <= maxY && ty <= last; ty++){
+		for(tx = minX < 0 ? 0 : minX; tx <= maxX && tx <= last; tx++){
+			if(n == VMAP_VISIBLE){
+				continue;
+			}
+			request.x = tx;
+			request.y = ty;
+			dx = (int32_t)((((int64_t)tx << tileShift) + ((int64_t)1 << (tileShift - 1)) - center->x) >> shift);
+			dy = (int32_t)((((int64_t)ty << tileShift) + ((int64_t)1 << (tileShift - 1)) - center->y) >> shift);
+			request.distance = dx * dx + dy * dy;
+			request.slot = NULL;
+			for(j = n++; j > 0 && requests[j - 1].distance > request.distance; j--){
+				requests[j] = requests[j - 1];
+			}
+			requests[j] = request;
+		}
+	}
+
+	frame++;
+	stats.Draws++;
+	for(i = 0; i < n; i++){
+		requests[i].slot = vmapFind(dataZoom, requests[i].x, requests[i].y);
+		if(requests[i].slot != NULL){
+			stats.Hits++;
+		}else if(!vmapIsMissing(dataZoom, requests[i].x, requests[i].y)){
+			// Limited SD reads per draw, tiles left out are drawn by next draws
+			if(loads < VMAP_LOADS_PER_DRAW){
+				requests[i].slot = vmapLoad(dataZoom, requests[i].x, requests[i].y);
+				loads++;
+			}else{
+				complete = false;
+			}
+		}
+	}
+
+	// Tile units to screen: rotate about marker, scale to pixels at this zoom, then move to marker
+	gmiscMatrixFixed2DApplyRotation(&rot, NULL, rotation);
+	gmiscMatrixFixed2DApplyScale(&base, &rot, FIXED(1) >> (shift - tileShift + VMAP_EXTENT_SHIFT),
+		FIXED(1) >> (shift - tileShift + VMAP_EXTENT_SHIFT));
+	gmiscMatrixFixed2DApplyTranslation(&base, &base, FIXED(centerX), FIXED(centerY));
+
+	// Clip set by the window manager is put back afterwards
+	gdispGetClip(&clipX, &clipY, &clipCX, &clipCY);
+	gdispSetClip(x, y, cx, cy);
+	gdispFillArea(x, y, cx, cy, VMAP_BACKGROUND);
+	// Areas of all tiles first so no area covers a line crossing from the next tile
+	for(j = 0; j < 2; j++){
+		for(i = 0; i < n; i++){
+			if(requests[i].slot == NULL){
+				continue;
+			}
+			wx = ((int64_t)requests[i].x << tileShift) - center->x;
+			wy = ((int64_t)requests[i].y << tileShift) - center->y;
+			fx = (fixed)((wx * FIXED(1)) >> shift);
+			fy = (fixed)((wy * FIXED(1)) >> shift);
+			gmiscMatrixFixed2DApplyTranslation(&m, &base, FIXEDMUL(rot.a00, fx) + FIXEDMUL(rot.a01, fy),
+				FIXEDMUL(rot.a10, fx) + FIXEDMUL(rot.a11, fy));
+			vmapDrawFeatures(requests[i].slot, j == 1, &m, zoom, x, y, cx, cy);
+		}
+	}
+	gdispSetClip(clipX, clipY, clipCX, clipCY);
+
+	elapsed = HAL_GetTick() - start;
+	stats.LastDrawMS = elapsed;
+	if(elapsed > stats.MaxDrawMS){
+		stats.MaxDrawMS = elapsed;
+	}
+	return complete;
+}
+
+void vmapGetStats(vmap_stats_t *st){
+	*st = stats;
+}
+
+static vmap_slot_t *vmapFind(uint8_t zoom, uint32_t x, uint32_t y){
+	uint32_t i;
+
+	for(i = 0; i < VMAP_SLOTS; i++){
+		if(slots[i].state == VMAP_READY && slots[i].zoom == zoom && slots[i].x == x && slots[i].y == y){
+			slots[i].used = frame;
+			return &slots[i];
+		}
+	}
+	return NULL;
+}
+
+static vmap_slot_t *vmapLoad(uint8_t zoom, uint32_t x, uint32_t y){
+	vmap_slot_t *slot = NULL;
+	GFILE *file;
+	long int size;
+	uint32_t i;
+
+	// Empty slot or least recently used one not needed by this draw
+	for(i = 0; i < VMAP_SLOTS; i++){
+		if(slots[i].state == VMAP_EMPTY){
+			slot = &slots[i];
+			break;
+		}
+		if(slots[i].used != frame && (slot == NULL || frame - slots[i].used > frame - slot->used)){
+			slot = &slots[i];
+		}
+	}
+	if(slot == NULL){
+		return NULL;
+	}
+
+	formatString(tilePath, sizeof(tilePath), VMAP_PATH, zoom, x, y);
+	file = gfileOpen(tilePath, "r");
+	if(file == NULL){
+		vmapSetMissing(zoom, x, y);
+		return NULL;
+	}
+	size = gfileGetSize(file);
+	if(slot->state == VMAP_READY){
+		stats.Evictions++;
+	}
+	slot->state = VMAP_EMPTY;
+	if(size < VMAP_HEADER_BYTES || size > VMAP_TILE_BYTES || gfileRead(file, slot->data, size) != (size_t)size){
+		gfileClose(file);
+		TRACE("Vector tile %s not read\n", tilePath);
+		vmapSetMissing(zoom, x, y);
+		return NULL;
+	}
+	gfileClose(file);
+
+	if(slot->data[0] != 'V' || slot->data[1] != 'M' || slot->data[2] != VMAP_VERSION || slot->data[3] != zoom ||
+		vmapRead32(slot->data + 8) < VMAP_HEADER_BYTES || vmapRead32(slot->data + 8) > (uint32_t)size){
+		TRACE("Vector tile %s not valid\n", tilePath);
+		vmapSetMissing(zoom, x, y);
+		return NULL;
+	}
+
+	slot->zoom = zoom;
+	slot->x = x;
+	slot->y = y;
+	slot->size = size;
+	slot->state = VMAP_READY;
+	slot->used = frame;
+	stats.Loads++;
+	return slot;
+}
+
+static bool vmapIsMissing(uint8_t zoom, uint32_t x, uint32_t y){
+	uint32_t i;
+
+	for(i = 0; i < VMAP_MISSING_ENTRIES; i++){
+		if(missing[i].zoom == zoom && missing[i].x == x && missing[i].y == y){
+			return true;
+		}
+	}
+	return false;
+}
+
+static void vmapSetMissing(uint8_t zoom, uint32_t x, uint32_t y){
+	missing[missingNext].zoom = zoom;
+	missing[missingNext].x = x;
+	missing[missingNext].y = y;
+	missingNext = (missingNext + 1) % VMAP_MISSING_ENTRIES;
+	stats.Missing++;
+}
+
+static void vmapDrawFeatures(const vmap_slot_t *slot, bool lines, const MatrixFixed2D *m, uint8_t zoom, coord_t x, coord_t y, coord_t cx, coord_t cy){
+	const uint8_t *feature, *p, *end;
+	const vmap_style_t *style;
+	uint32_t features, count;
+	uint8_t width;
+
+	if(lines){
+		features = (uint16_t)vmapRead16(slot->data + 6);
+		p = slot->data + vmapRead32(slot->data + 8);
+		end = slot->data + slot->size;
+	}else{
+		features = (uint16_t)vmapRead16(slot->data + 4);
+		p = slot->data + VMAP_HEADER_BYTES;
+		end = slot->data + vmapRead32(slot->data + 8);
+	}
+
+	for(; features > 0 && p + VMAP_FEATURE_BYTES <= end; features--){
+		feature = p;
+		p += VMAP_FEATURE_BYTES + (uint16_t)vmapRead16(feature + 4);
+		if(p > end){
+			break;
+		}
+
+		// Level of detail, converter sets min zoom of small features and style hides whole classes
+		width = feature[0] < VMAP_CLASSES ? styles[feature[0]].width[zoom - VMAP_MIN_ZOOM] : 0;
+		if(width == 0 || feature[1] > zoom){
+			stats.LodSkips++;
+			continue;
+		}
+		style = &styles[feature[0]];
+
+		count = vmapDecode(feature + VMAP_FEATURE_BYTES, p, (uint16_t)vmapRead16(feature + 2));
+		if(count < (lines ? 2 : 3)){
+			continue;
+		}
+		gmiscMatrixFixed2DApplyToPoints(points, points, m, count);
+		stats.Points += count;
+		if(!vmapVisible(count, lines ? width : 0, x, y, cx, cy)){
+			stats.Culled++;
+			continue;
+		}
+
+		if(lines){
+			vmapDrawLine(count, style->color, width);
+		}else{
+			gdispFillConvexPoly(0, 0, points, count, style->color);
+		}
+		stats.Features++;
+	}
+}
+
+static uint32_t vmapDecode(const uint8_t *data, const uint8_t *end, uint32_t count){
+	int32_t px, py;
+	uint32_t n;
+
+	if(data + 4 > end || count == 0){
+		return 0;
+	}
+	px = vmapRead16(data);
+	py = vmapRead16(data + 2);
+	data += 4;
+	points[0].x = px;
+	points[0].y = py;
+
+	for(n = 1; n < count && n < VMAP_MAX_POINTS && data + 2 <= end; n++){
+		if((int8_t)data[0] == VMAP_ESCAPE){
+			if(data + 5 > end){
+				break;
+			}
+			px += vmapRead16(data + 1);
+			py += vmapRead16(data + 3);
+			data += 5;
+		}else{
+			px += (int8_t)data[0];
+			py += (int8_t)data[1];
+			data += 2;
+		}
+		points[n].x = px;
+		points[n].y = py;
+	}
+	return n;
+}
+
+static bool vmapVisible(uint32_t count, coord_t margin, coord_t x, coord_t y, coord_t cx, coord_t cy){
+	coord_t minX, maxX, minY, maxY;
+	uint32_t i;
+
+	minX = maxX = points[0].x;
+	minY = maxY = points[0].y;
+	for(i = 1; i < count; i++){
+		if(points[i].x < minX){
+			minX = points[i].x;
+		}else if(points[i].x > maxX){
+			maxX = points[i].x;
+		}
+		if(points[i].y < minY){
+			minY = points[i].y;
+		}else if(points[i].y > maxY){
+			maxY = points[i].y;
+		}
+	}
+
+	// Features that shrink to a single pixel are left out
+	if(minX == maxX && minY == maxY){
+		return false;
+	}
+	return maxX + margin >= x && minX - margin < x + cx && maxY + margin >= y && minY - margin < y + cy;
+}
+
+static void vmapDrawLine(uint32_t count, color_t color, coord_t width){
+	uint32_t i, prev = 0;
+
+	// Segments shorter than a pixel are merged into the next one
+	for(i = 1; i < count; i++){
+		if(points[i].x == points[prev].x && points[i].y == points[prev].y){
+			continue;
+		}
+		if(width == 1){
+			gdispDrawLine(points[prev].x, points[prev].y, points[i].x, points[i].y, color);
+		}else{
+			gdispDrawThickLine(points[prev].x, points[prev].y, points[i].x, points[i].y, color, width, width >= VMAP_ROUND_WIDTH);
+		}
+		prev = i;
+	}
+}
+
+static int16_t vmapRead16(const uint8_t *p){
+	return (int16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t vmapRead32(const uint8_t *p){
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
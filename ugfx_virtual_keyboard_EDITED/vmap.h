@@ -0,0 +1,75 @@
+#ifndef _VMAP_H_
+#define _VMAP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "gfx.h"
+#include "projection.h"
+
+// Vector map tiles, drawn instead of PNG tiles when VMAP_DIR is on SD card.
+//
+// Tiles are cut at data zooms 12, 14 and 16, each one is drawn at its own zoom and the next one or two:
+// display zoom 12-13 uses data zoom 12, 14-15 uses 14, 16-18 uses 16. Converter generalises
+// geometry for each data zoom, so this is the coarse level of detail.
+//
+// File layout, little endian:
+//	header		uint8 'V', 'M', version, data zoom
+//						uint16 area features, uint16 line features
+//						uint32 byte offset of first line feature
+//	feature		uint8 class (vmap_class_t), uint8 min display zoom
+//						uint16 points, uint16 bytes of point data that follow
+//	points		int16 x, y of first point, then int8 dx, dy of each next point
+//						dx of -128 escapes to int16 dx, dy for long steps
+//
+// Coordinates are quantised to VMAP_EXTENT units across a tile with y down, points may lie
+// up to VMAP_EXTENT / 8 outside the tile so lines join across tile edges. Areas are split into
+// convex pieces by the converter and drawn before all lines, both in the order of the file.
+#define VMAP_DIR								"Vector"
+#define VMAP_PATH								"Vector/%d/%d/%d.vmt"
+#define VMAP_VERSION						1
+#define VMAP_MIN_ZOOM						12
+#define VMAP_MAX_ZOOM						18
+#define VMAP_MAX_DATA_ZOOM			16
+#define VMAP_EXTENT_SHIFT				12
+#define VMAP_EXTENT							(1 << VMAP_EXTENT_SHIFT)
+#define VMAP_TILE_BYTES					16384				// Largest tile file, also size of a cache slot
+#define VMAP_MAX_POINTS					1024				// Longest feature, rest of its points are skipped
+#define VMAP_LOADS_PER_DRAW			4						// SD reads allowed per draw, rest are drawn by next draws
+#define VMAP_BACKGROUND					HTML2COLOR(0xEAE6DC)
+
+typedef enum {
+	VMAP_CLASS_WATER,
+	VMAP_CLASS_PARK,
+	VMAP_CLASS_FOREST,
+	VMAP_CLASS_RESIDENTIAL,
+	VMAP_CLASS_INDUSTRIAL,
+	VMAP_CLASS_RIVER,
+	VMAP_CLASS_PATH,
+	VMAP_CLASS_CYCLEWAY,
+	VMAP_CLASS_MINOR,
+	VMAP_CLASS_SECONDARY,
+	VMAP_CLASS_PRIMARY,
+	VMAP_CLASS_MOTORWAY,
+	VMAP_CLASSES
+} vmap_class_t;
+
+typedef struct {
+	uint32_t Draws;
+	uint32_t Hits;							// Tiles drawn from cache
+	uint32_t Loads;							// Tiles read from SD
+	uint32_t Missing;						// Tiles not on SD or not valid, remembered so they are not opened again
+	uint32_t Evictions;
+	uint32_t Features;					// Features drawn
+	uint32_t LodSkips;					// Features skipped by min zoom or style at this zoom
+	uint32_t Culled;						// Features outside map area or smaller than a pixel
+	uint32_t Points;						// Points transformed
+	uint32_t LastDrawMS;
+	uint32_t MaxDrawMS;
+} vmap_stats_t;
+
+void vmapInit(void);
+bool vmapAvailable(void);
+bool vmapDraw(const proj_world_t *center, uint8_t zoom, int16_t rotation, coord_t centerX, coord_t centerY, coord_t x, coord_t y, coord_t cx, coord_t cy);
+void vmapGetStats(vmap_stats_t *stats);
+
+#endif /* _VMAP_H_ */